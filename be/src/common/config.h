@@ -159,6 +159,9 @@ namespace config {
     CONF_Int32(etl_thread_pool_size, "8");
     // number of etl thread pool size
     CONF_Int32(etl_thread_pool_queue_size, "256");
+    // bytes of rows buffered by one dpp translator before they are sorted
+    // and spilled to tmp dir as one run, runs are merged when loading finished
+    CONF_Int64(etl_sort_spill_threshold_bytes, "1073741824");
     // port on which to run Palo test backend
     CONF_Int32(port, "20001");
     // default thrift client connect timeout(in seconds)
@@ -169,10 +172,23 @@ namespace config {
     CONF_Int32(palo_scanner_queue_size, "1024");
     // single read execute fragment row size
     CONF_Int32(palo_scanner_row_num, "16384");
+    // read duplicate key tablets column by column into a batch instead of row by row
+    CONF_Bool(enable_columnar_scan, "true");
+    // max row count of one columnar scan batch
+    CONF_Int32(columnar_scan_batch_size, "1024");
     // number of max scan keys
     CONF_Int32(palo_max_scan_key_num, "1024");
     // return_row / total_row
     CONF_Int32(palo_max_pushdown_conjuncts_return_rate, "90");
+    // max build rows of a hash join for which the runtime filter pushed down to
+    // the probe side scan has a bloom filter, only min/max are pushed down beyond
+    CONF_Int64(runtime_filter_max_build_rows, "16777216");
+    // a broadcast hash join with more build rows than this pushes a runtime filter
+    // down to the probe side scan instead of an in predicate
+    CONF_Int64(runtime_filter_min_build_rows, "1024");
+    // max time a scan node waits for the runtime filters of partitioned hash joins
+    // before it starts scanning without them
+    CONF_Int32(runtime_filter_wait_time_ms, "1000");
     // (Advanced) Maximum size of per-query receive-side buffer
     CONF_Int32(exchg_node_buffer_size_bytes, "10485760");
     // insert sort threadhold for sorter
@@ -181,16 +197,31 @@ namespace config {
     CONF_Int32(sorter_block_size, "8388608");
     // push_write_mbytes_per_sec
     CONF_Int32(push_write_mbytes_per_sec, "10");
+    // threads shared by all push tasks of this node to write segment-sized chunks of one
+    // pushed file in parallel, set to 0 to convert every pushed file in a single thread
+    CONF_Int32(push_convert_thread_num, "8");
+    // max chunks of one pushed file written at the same time, which also bounds memory
+    // of rows buffered by one push task to this many segments
+    CONF_Int32(push_convert_chunk_num_per_push, "4");
     CONF_Int32(base_expansion_write_mbytes_per_sec, "5");
 
-    CONF_Int64(column_dictionary_key_ration_threshold, "0");
-    CONF_Int64(column_dictionary_key_size_threshold, "0");
+    // string columns are dictionary encoded when the number of distinct values is
+    // less than column_dictionary_key_ration_threshold percent of the rows and less than
+    // column_dictionary_key_size_threshold. set either one to 0 to disable dictionary encoding
+    CONF_Int64(column_dictionary_key_ration_threshold, "20");
+    CONF_Int64(column_dictionary_key_size_threshold, "65536");
+    // evaluate conditions on dictionary encoded string columns once per dictionary entry
+    // and filter rows by dictionary code when reading in columnar batch
+    CONF_Bool(enable_dictionary_filter, "true");
     // if true, output IR after optimization passes
     CONF_Bool(dump_ir, "false");
     // if set, saves the generated IR to the output file.
     CONF_String(module_output, "");
     // memory_limiation_per_thread_for_schema_change unit GB
     CONF_Int32(memory_limiation_per_thread_for_schema_change, "2");
+    // threads shared by all schema changes and rollups of this node to sort row blocks and
+    // write sorted runs in parallel, set to 0 to sort in the thread of schema change
+    CONF_Int32(schema_change_sort_thread_num, "4");
 
     CONF_Int64(max_unpacked_row_block_size, "104857600");
 
@@ -203,6 +234,14 @@ namespace config {
     CONF_Int32(min_percentage_of_error_disk, "50");
     CONF_Int32(default_num_rows_per_data_block, "1024");
     CONF_Int32(default_num_rows_per_column_file_block, "1024");
+    // 新建列存表使用的压缩方式, 可选lz4, zstd, adaptive
+    CONF_String(default_column_file_compress_kind, "lz4");
+    // zstd的压缩级别, 1~19, 级别越高压缩率越高, 压缩速度越慢, 对解压速度影响不大
+    CONF_Int32(zstd_compression_level, "3");
+    // adaptive压缩时, 压缩后至少要节省的空间比例(百分比), 否则该流不压缩
+    CONF_Int32(adaptive_compress_min_saving_percent, "10");
+    // adaptive压缩时, zstd相比lz4至少要多节省的空间比例(百分比), 否则使用lz4
+    CONF_Int32(adaptive_compress_zstd_min_gain_percent, "15");
     CONF_Int32(max_tablet_num_per_shard, "1024");
     // garbage sweep policy
     CONF_Int32(max_garbage_sweep_interval, "86400");
@@ -219,7 +258,30 @@ namespace config {
     CONF_Int64(be_policy_end_time, "7");
     //file descriptors cache, by default, cache 30720 descriptors
     CONF_Int32(file_descriptor_cache_capacity, "30720");
+    // threads shared by all root paths to load tablet headers at startup
+    CONF_Int32(load_tablet_thread_num, "16");
     CONF_Int64(index_stream_cache_capacity, "10737418240");
+    // map short key index files into memory instead of copying them to heap when loading.
+    // every index file takes one mapping, so enable it only when vm.max_map_count is
+    // much larger than the number of segments on this backend
+    CONF_Bool(short_key_index_use_mmap, "false");
+    // cache of decompressed column data shared by queries, set to 0 to disable
+    CONF_Int64(page_cache_capacity, "1073741824");
+    // a page is cached only when it is read again while its key is still among the
+    // recently missed keys, so that big scans do not flush hot pages. the missed keys
+    // take at most page_cache_admission_capacity bytes. set to 0 to cache every page read
+    CONF_Int64(page_cache_admission_capacity, "67108864");
+    // asynchronously advise the kernel to read ahead the data streams a segment reader
+    // is going to read, adjacent stream ranges within segment_prefetch_coalesce_bytes
+    // are advised together
+    CONF_Bool(enable_segment_prefetch, "true");
+    CONF_Int32(segment_prefetch_thread_num, "8");
+    CONF_Int64(segment_prefetch_coalesce_bytes, "65536");
+    // size of a single readahead advice
+    CONF_Int64(segment_prefetch_chunk_bytes, "1048576");
+    // max bytes being prefetched at the same time by all segment readers of a fragment
+    // instance, every segment reader may still prefetch one chunk beyond it
+    CONF_Int64(segment_prefetch_max_inflight_bytes, "8388608");
     CONF_Int64(max_packed_row_block_size, "20971520");
     CONF_Int32(cumulative_write_mbytes_per_sec, "100");
     CONF_Int64(ce_policy_delta_files_number, "5");
@@ -229,6 +291,16 @@ namespace config {
     CONF_Int64(be_policy_cumulative_files_number, "5");
     CONF_Double(be_policy_cumulative_base_ratio, "0.3");
     CONF_Int64(be_policy_be_interval_seconds, "604800");
+    // base and cumulative expansion candidates of all tables are rescored at this interval
+    CONF_Int32(expansion_candidate_update_interval_sec, "60");
+    // in the expansion score, this many bytes to merge weigh as much as one version to merge
+    CONF_Int64(expansion_score_bytes_per_delta, "104857600");
+    // threads shared by all base and cumulative expansions of this node to merge key ranges
+    // of one table in parallel, set to 0 to merge every table in a single thread
+    CONF_Int32(expansion_merge_thread_num, "4");
+    // a table is split into key ranges for parallel merge only when every range has at least
+    // this many row blocks in the largest input version
+    CONF_Int32(expansion_merge_min_row_blocks, "4096");
     CONF_Int32(cumulative_source_overflow_ratio, "5");
     CONF_Int32(delete_delta_expire_time, "1440");
     // Port to start debug webserver on
@@ -288,8 +360,23 @@ namespace config {
     CONF_String(pprof_profile_dir, "${PALO_HOME}/log")
 
     // for partition
+    // If true, hash joins partition their input and spill partitions to disk when
+    // the memory limit is hit. Null-aware left anti joins are not affected.
     CONF_Bool(enable_partitioned_hash_join, "false")
     CONF_Bool(enable_partitioned_aggregation, "false")
+    // If true, a partitioned aggregation whose output is merged later stops growing the
+    // hash table of a partition that does not reduce its input enough, and passes the
+    // rows of that partition through as intermediate tuples.
+    CONF_Bool(enable_streaming_preaggregation, "true")
+    // Number of threads a grouping AggregationNode uses to aggregate its input into
+    // thread local hash tables, which are then merged partition by partition in parallel.
+    // 0 or 1 aggregates on the fragment thread.
+    CONF_Int32(aggregation_parallel_threads, "0")
+    // Threads of the pool shared by parallel aggregation of all queries, only created
+    // when aggregation_parallel_threads > 1. Work that does not fit in the queue runs
+    // on the fragment thread instead.
+    CONF_Int32(aggregation_thread_pool_thread_num, "16")
+    CONF_Int32(aggregation_thread_pool_queue_size, "64")
 
     // for kudu
     // "The maximum size of the row batch queue, for Kudu scanners."
@@ -21,14 +21,17 @@
 #include "exec/aggregation_node.h"
 
 #include <math.h>
+#include <algorithm>
 #include <sstream>
 #include <boost/functional/hash.hpp>
 #include <thrift/protocol/TDebugProtocol.h>
 #include <x86intrin.h>
 #include <gperftools/profiler.h>
+#include <boost/bind.hpp>
 
 #include "codegen/codegen_anyval.h"
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
 #include "exec/hash_table.hpp"
 #include "exprs/agg_fn_evaluator.h"
 #include "exprs/expr.h"
@@ -36,6 +39,7 @@
 #include "gen_cpp/Exprs_types.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/descriptors.h"
+#include "runtime/exec_env.h"
 #include "runtime/mem_pool.h"
 #include "runtime/raw_value.h"
 #include "runtime/row_batch.h"
@@ -43,6 +47,8 @@
 #include "runtime/string_value.hpp"
 #include "runtime/tuple.h"
 #include "runtime/tuple_row.h"
+#include "util/bit_util.h"
+#include "util/count_down_latch.hpp"
 #include "util/debug_util.h"
 #include "util/runtime_profile.h"
 
@@ -67,6 +73,7 @@ AggregationNode::AggregationNode(
             _intermediate_tuple_desc(NULL),
             _output_tuple_id(tnode.agg_node.output_tuple_id),
             _output_tuple_desc(NULL),
+            _output_partition(0),
             _singleton_output_tuple(NULL),
             //_tuple_pool(new MemPool()),
             //
@@ -75,7 +82,8 @@ AggregationNode::AggregationNode(
             _needs_finalize(tnode.agg_node.need_finalize),
             _build_timer(NULL),
             _get_results_timer(NULL),
-            _hash_table_buckets_counter(NULL) {
+            _hash_table_buckets_counter(NULL),
+            _merge_timer(NULL) {
 }
 
 AggregationNode::~AggregationNode() {
@@ -93,6 +101,7 @@ Status AggregationNode::init(const TPlanNode& tnode) {
             _pool, tnode.agg_node.aggregate_functions[i], &evaluator);
         _aggregate_evaluators.push_back(evaluator);
     }
+    _aggregate_functions = tnode.agg_node.aggregate_functions;
     return Status::OK;
 }
 
@@ -160,7 +169,24 @@ Status AggregationNode::prepare(RuntimeState* state) {
         _singleton_output_tuple = construct_intermediate_tuple();
     }
 
-    if (state->codegen_level() > 0) {
+    // Batches are handed to other threads, so the child must not reuse the memory of
+    // a returned batch, which holds for olap scan node.
+    bool parallel = config::aggregation_parallel_threads > 1
+        && !_probe_expr_ctxs.empty()
+        && (limit() == -1 || !_aggregate_evaluators.empty())
+        && child(0)->type() == TPlanNodeType::OLAP_SCAN_NODE;
+    for (int i = 0; i < _aggregate_evaluators.size(); ++i) {
+        if (_aggregate_evaluators[i]->is_multi_distinct()) {
+            parallel = false;
+        }
+    }
+    if (parallel) {
+        _merge_timer = ADD_TIMER(runtime_profile(), "MergeTime");
+        RETURN_IF_ERROR(prepare_parallel(state, config::aggregation_parallel_threads));
+    }
+
+    // The codegen'd batch loop updates this node's hash table only.
+    if (_parallel_states.empty() && state->codegen_level() > 0) {
         LlvmCodeGen* codegen = NULL;
         RETURN_IF_ERROR(state->get_codegen(&codegen));
         Function* update_tuple_fn = codegen_update_tuple(state);
@@ -192,6 +218,10 @@ Status AggregationNode::open(RuntimeState* state) {
 
     RETURN_IF_ERROR(_children[0]->open(state));
 
+    if (!_parallel_states.empty()) {
+        return open_parallel(state);
+    }
+
     RowBatch batch(_children[0]->row_desc(), state->batch_size(), mem_tracker());
     int64_t num_input_rows = 0;
     int64_t num_agg_rows = 0;
@@ -279,7 +309,7 @@ Status AggregationNode::get_next(RuntimeState* state, RowBatch* row_batch, bool*
 
     int count = 0;
     const int N = state->batch_size();
-    while (!_output_iterator.at_end() && !row_batch->at_capacity()) {
+    while (!output_at_end() && !row_batch->at_capacity()) {
         // This loop can go on for a long time if the conjuncts are very selective. Do query
         // maintenance every N iterations.
         if (count++ % N == 0) {
@@ -306,8 +336,8 @@ Status AggregationNode::get_next(RuntimeState* state, RowBatch* row_batch, bool*
         _output_iterator.next<false>();
     }
 
-    *eos = _output_iterator.at_end() || reached_limit();
-    if (*eos) {
+    *eos = output_at_end() || reached_limit();
+    if (*eos && _parallel_states.empty()) {
         if (memory_used_counter() != NULL && _hash_tbl.get() != NULL &&
                 _hash_table_buckets_counter != NULL) {
             COUNTER_SET(memory_used_counter(),
@@ -332,16 +362,43 @@ Status AggregationNode::close(RuntimeState* state) {
     if (_needs_finalize && _output_tuple_desc != NULL) {
         dummy_dst = Tuple::create(_output_tuple_desc->byte_size(), _tuple_pool.get());
     }
-    while (!_output_iterator.at_end()) {
+    while (!output_at_end()) {
         Tuple* tuple = _output_iterator.get_row()->get_tuple(0);
         if (_needs_finalize) {
-            AggFnEvaluator::finalize(_aggregate_evaluators, _agg_fn_ctxs, tuple, dummy_dst);
+            AggFnEvaluator::finalize(output_evaluators(), output_agg_fn_ctxs(), tuple, dummy_dst);
         } else {
-            AggFnEvaluator::serialize(_aggregate_evaluators, _agg_fn_ctxs, tuple);
+            AggFnEvaluator::serialize(output_evaluators(), output_agg_fn_ctxs(), tuple);
         }
         _output_iterator.next<false>();
     }
 
+    for (int i = 0; i < _parallel_states.size(); ++i) {
+        ParallelAggState* agg_state = _parallel_states[i];
+        for (int j = 0; j < agg_state->evaluators.size(); ++j) {
+            agg_state->evaluators[j]->close(state);
+            if (agg_state->agg_fn_ctxs[j] != NULL && agg_state->agg_fn_ctxs[j]->impl()) {
+                agg_state->agg_fn_ctxs[j]->impl()->close();
+            }
+        }
+        if (agg_state->hash_tbl.get() != NULL) {
+            agg_state->hash_tbl->close();
+        }
+        if (agg_state->merged_tbl.get() != NULL) {
+            agg_state->merged_tbl->close();
+        }
+        // Merged tuples point to grouping values in the pools of other states,
+        // so pools are freed after all hash tables are closed.
+        Expr::close(agg_state->probe_expr_ctxs, state);
+        Expr::close(agg_state->build_expr_ctxs, state);
+        Expr::close(agg_state->merge_probe_expr_ctxs, state);
+        Expr::close(agg_state->merge_build_expr_ctxs, state);
+    }
+    for (int i = 0; i < _parallel_states.size(); ++i) {
+        if (_parallel_states[i]->tuple_pool.get() != NULL) {
+            _parallel_states[i]->tuple_pool->free_all();
+        }
+    }
+
     for (int i = 0; i < _aggregate_evaluators.size(); ++i) {
         _aggregate_evaluators[i]->close(state);
         if (!_agg_fn_ctxs.empty() && _agg_fn_ctxs[i] && _agg_fn_ctxs[i]->impl()) {
@@ -362,29 +419,32 @@ Status AggregationNode::close(RuntimeState* state) {
     return ExecNode::close(state);
 }
 
-Tuple* AggregationNode::construct_intermediate_tuple() {
-    Tuple* agg_tuple = Tuple::create(_intermediate_tuple_desc->byte_size(), _tuple_pool.get());
+Tuple* AggregationNode::construct_intermediate_tuple(
+        HashTable* hash_tbl, MemPool* pool,
+        const std::vector<AggFnEvaluator*>& evaluators,
+        const std::vector<palo_udf::FunctionContext*>& agg_fn_ctxs) {
+    Tuple* agg_tuple = Tuple::create(_intermediate_tuple_desc->byte_size(), pool);
     vector<SlotDescriptor*>::const_iterator slot_desc = _intermediate_tuple_desc->slots().begin();
 
     // copy grouping values
     for (int i = 0; i < _probe_expr_ctxs.size(); ++i, ++slot_desc) {
-        if (_hash_tbl->last_expr_value_null(i)) {
+        if (hash_tbl->last_expr_value_null(i)) {
             agg_tuple->set_null((*slot_desc)->null_indicator_offset());
         } else {
-            void* src = _hash_tbl->last_expr_value(i);
+            void* src = hash_tbl->last_expr_value(i);
             void* dst = agg_tuple->get_slot((*slot_desc)->tuple_offset());
-            RawValue::write(src, dst, (*slot_desc)->type(), _tuple_pool.get());
+            RawValue::write(src, dst, (*slot_desc)->type(), pool);
         }
     }
 
     // Initialize aggregate output.
-    for (int i = 0; i < _aggregate_evaluators.size(); ++i, ++slot_desc) {
+    for (int i = 0; i < evaluators.size(); ++i, ++slot_desc) {
         while (!(*slot_desc)->is_materialized()) {
             ++slot_desc;
         }
 
-        AggFnEvaluator* evaluator = _aggregate_evaluators[i];
-        evaluator->init(_agg_fn_ctxs[i], agg_tuple);
+        AggFnEvaluator* evaluator = evaluators[i];
+        evaluator->init(agg_fn_ctxs[i], agg_tuple);
 
         // Codegen specific path.
         // To minimize branching on the UpdateAggTuple path, initialize the result value
@@ -447,9 +507,9 @@ Tuple* AggregationNode::finalize_tuple(Tuple* tuple, MemPool* pool) {
         dst = Tuple::create(_output_tuple_desc->byte_size(), pool);
     }
     if (_needs_finalize) {
-        AggFnEvaluator::finalize(_aggregate_evaluators, _agg_fn_ctxs, tuple, dst);
+        AggFnEvaluator::finalize(output_evaluators(), output_agg_fn_ctxs(), tuple, dst);
     } else {
-        AggFnEvaluator::serialize(_aggregate_evaluators, _agg_fn_ctxs, tuple);
+        AggFnEvaluator::serialize(output_evaluators(), output_agg_fn_ctxs(), tuple);
     }
     // Copy grouping values from tuple to dst.
     // TODO: Codegen this.
@@ -467,6 +527,290 @@ Tuple* AggregationNode::finalize_tuple(Tuple* tuple, MemPool* pool) {
     return dst;
 }
 
+Status AggregationNode::prepare_parallel(RuntimeState* state, int num_threads) {
+    for (int i = 0; i < num_threads; ++i) {
+        ParallelAggState* agg_state = _pool->add(new ParallelAggState());
+        _parallel_states.push_back(agg_state);
+        agg_state->tuple_pool.reset(new MemPool(mem_tracker(), 0));
+        agg_state->partitions.resize(num_threads);
+        agg_state->agg_fn_ctxs.resize(_aggregate_functions.size(), NULL);
+
+        int j = _probe_expr_ctxs.size();
+        for (int k = 0; k < _aggregate_functions.size(); ++k, ++j) {
+            AggFnEvaluator* evaluator = NULL;
+            RETURN_IF_ERROR(AggFnEvaluator::create(_pool, _aggregate_functions[k], &evaluator));
+            agg_state->evaluators.push_back(evaluator);
+            RETURN_IF_ERROR(evaluator->prepare(
+                    state, child(0)->row_desc(), agg_state->tuple_pool.get(),
+                    _intermediate_tuple_desc->slots()[j], _output_tuple_desc->slots()[j],
+                    mem_tracker(), &agg_state->agg_fn_ctxs[k]));
+            state->obj_pool()->add(agg_state->agg_fn_ctxs[k]);
+        }
+    }
+    return Status::OK;
+}
+
+Status AggregationNode::open_parallel(RuntimeState* state) {
+    int num_threads = _parallel_states.size();
+    for (int i = 0; i < num_threads; ++i) {
+        ParallelAggState* agg_state = _parallel_states[i];
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                _probe_expr_ctxs, state, &agg_state->probe_expr_ctxs));
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                _build_expr_ctxs, state, &agg_state->build_expr_ctxs));
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                _build_expr_ctxs, state, &agg_state->merge_probe_expr_ctxs));
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                _build_expr_ctxs, state, &agg_state->merge_build_expr_ctxs));
+        for (int j = 0; j < agg_state->evaluators.size(); ++j) {
+            RETURN_IF_ERROR(agg_state->evaluators[j]->open(state, agg_state->agg_fn_ctxs[j]));
+        }
+        agg_state->hash_tbl.reset(new HashTable(
+                agg_state->build_expr_ctxs, agg_state->probe_expr_ctxs, 1, true, id(),
+                mem_tracker(), 1024));
+    }
+
+    // Aggregation runs on the threads of the shared pool, so the number of threads is
+    // bounded whatever the number of queries. A state whose task does not fit in the
+    // pool queue gets no input. If no task fits, the fragment thread aggregates into
+    // the first state itself.
+    ThreadPool* thread_pool = state->exec_env()->aggregation_thread_pool();
+    // Bounded, so that the child is not read far ahead of the aggregation threads.
+    BlockingQueue<RowBatch*> batch_queue(num_threads * 2);
+    CountDownLatch latch(num_threads);
+    int num_tasks = 0;
+    for (int i = 0; i < num_threads; ++i) {
+        if (thread_pool != NULL && thread_pool->try_offer(
+                    boost::bind(&AggregationNode::parallel_aggregate, this, state,
+                                _parallel_states[i], &batch_queue, &latch))) {
+            ++num_tasks;
+        } else {
+            latch.count_down();
+        }
+    }
+
+    Status status = Status::OK;
+    while (true) {
+        bool eos = false;
+        RowBatch* batch = new RowBatch(
+            _children[0]->row_desc(), state->batch_size(), mem_tracker());
+        // Errors of the aggregation threads are set in 'state' too.
+        if (state->is_cancelled()) {
+            status = Status::CANCELLED;
+        } else {
+            status = state->check_query_state();
+        }
+        if (status.ok()) {
+            status = _children[0]->get_next(state, batch, &eos);
+        }
+        if (!status.ok()) {
+            delete batch;
+            break;
+        }
+        if (num_tasks == 0) {
+            aggregate_batch(_parallel_states[0], batch);
+            delete batch;
+        } else if (!batch_queue.blocking_put(batch)) {
+            delete batch;
+        }
+        if (eos) {
+            break;
+        }
+    }
+    // Tasks drain the queue before they finish.
+    batch_queue.shutdown();
+    latch.await();
+    if (num_tasks == 0 && status.ok()) {
+        partition_groups(_parallel_states[0]);
+    }
+    RETURN_IF_ERROR(status);
+    for (int i = 0; i < num_threads; ++i) {
+        RETURN_IF_ERROR(_parallel_states[i]->status);
+    }
+
+    int64_t num_input_rows = 0;
+    int64_t num_agg_rows = 0;
+    for (int i = 0; i < num_threads; ++i) {
+        num_input_rows += _parallel_states[i]->num_input_rows;
+        num_agg_rows += _parallel_states[i]->hash_tbl->size();
+    }
+
+    {
+        SCOPED_TIMER(_merge_timer);
+        // Partitions whose task does not fit in the pool queue are merged here.
+        CountDownLatch merge_latch(num_threads);
+        for (int i = 0; i < num_threads; ++i) {
+            if (thread_pool == NULL || !thread_pool->try_offer(
+                        boost::bind(&AggregationNode::merge_partition, this, state, i,
+                                    &merge_latch))) {
+                merge_partition(state, i, &merge_latch);
+            }
+        }
+        merge_latch.await();
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        RETURN_IF_ERROR(_parallel_states[i]->status);
+    }
+    RETURN_IF_ERROR(state->check_query_state());
+
+    int64_t num_buckets = 0;
+    int64_t memory_used = 0;
+    int64_t num_merged_rows = 0;
+    for (int i = 0; i < num_threads; ++i) {
+        ParallelAggState* agg_state = _parallel_states[i];
+        num_buckets += agg_state->merged_tbl->num_buckets();
+        num_merged_rows += agg_state->merged_tbl->size();
+        memory_used += agg_state->tuple_pool->peak_allocated_bytes()
+            + agg_state->hash_tbl->byte_size() + agg_state->merged_tbl->byte_size();
+    }
+    COUNTER_SET(_hash_table_buckets_counter, num_buckets);
+    COUNTER_SET(memory_used_counter(), memory_used);
+
+    VLOG_ROW << "id=" << id() << " aggregated " << num_input_rows << " input rows into "
+              << num_agg_rows << " rows in " << num_tasks << " threads, merged into "
+              << num_merged_rows << " output rows";
+    _output_partition = 0;
+    _output_iterator = _parallel_states[0]->merged_tbl->begin();
+    return Status::OK;
+}
+
+void AggregationNode::parallel_aggregate(
+        RuntimeState* state, ParallelAggState* agg_state,
+        BlockingQueue<RowBatch*>* batch_queue, CountDownLatch* latch) {
+    RowBatch* batch = NULL;
+    while (batch_queue->blocking_get(&batch)) {
+        // After an error batches are only freed, so that the fragment thread is never
+        // blocked on a full queue.
+        if (agg_state->status.ok()) {
+            if (state->is_cancelled()) {
+                agg_state->status = Status::CANCELLED;
+            } else {
+                aggregate_batch(agg_state, batch);
+                agg_state->status = state->check_query_state();
+            }
+        }
+        delete batch;
+    }
+    if (agg_state->status.ok()) {
+        partition_groups(agg_state);
+    }
+    latch->count_down();
+}
+
+void AggregationNode::aggregate_batch(ParallelAggState* agg_state, RowBatch* batch) {
+    HashTable* hash_tbl = agg_state->hash_tbl.get();
+    for (int i = 0; i < batch->num_rows(); ++i) {
+        TupleRow* row = batch->get_row(i);
+        Tuple* agg_tuple = NULL;
+        HashTable::Iterator it = hash_tbl->find(row);
+
+        if (it.at_end()) {
+            agg_tuple = construct_intermediate_tuple(
+                hash_tbl, agg_state->tuple_pool.get(),
+                agg_state->evaluators, agg_state->agg_fn_ctxs);
+            hash_tbl->insert(reinterpret_cast<TupleRow*>(&agg_tuple));
+        } else {
+            agg_tuple = it.get_row()->get_tuple(0);
+        }
+
+        AggFnEvaluator::add(agg_state->evaluators, agg_state->agg_fn_ctxs, row, agg_tuple);
+    }
+    agg_state->num_input_rows += batch->num_rows();
+}
+
+void AggregationNode::partition_groups(ParallelAggState* agg_state) {
+    HashTable* hash_tbl = agg_state->hash_tbl.get();
+    for (HashTable::Iterator it = hash_tbl->begin(); !it.at_end(); it.next<false>()) {
+        Tuple* tuple = it.get_row()->get_tuple(0);
+        agg_state->partitions[partition_of(tuple)].push_back(tuple);
+    }
+}
+
+void AggregationNode::merge_partition(
+        RuntimeState* state, int partition, CountDownLatch* latch) {
+    ParallelAggState* agg_state = _parallel_states[partition];
+    int64_t num_rows = 0;
+    for (int i = 0; i < _parallel_states.size(); ++i) {
+        num_rows += _parallel_states[i]->partitions[partition].size();
+    }
+    agg_state->merged_tbl.reset(new HashTable(
+            agg_state->merge_build_expr_ctxs, agg_state->merge_probe_expr_ctxs, 1, true, id(),
+            mem_tracker(), BitUtil::next_power_of_two(std::max(num_rows, static_cast<int64_t>(1024)))));
+    HashTable* merged_tbl = agg_state->merged_tbl.get();
+
+    // Own groups are distinct and are inserted as they are. Groups of other threads
+    // are merged into a tuple of this state, so that all tuples in 'merged_tbl' are
+    // finalized by the evaluators that initialized them.
+    std::vector<Tuple*>& own_tuples = agg_state->partitions[partition];
+    for (int i = 0; i < own_tuples.size(); ++i) {
+        merged_tbl->insert(reinterpret_cast<TupleRow*>(&own_tuples[i]));
+    }
+
+    const std::vector<SlotDescriptor*>& slots = _intermediate_tuple_desc->slots();
+    for (int i = 0; i < _parallel_states.size() && agg_state->status.ok(); ++i) {
+        if (i == partition) {
+            continue;
+        }
+        std::vector<Tuple*>& tuples = _parallel_states[i]->partitions[partition];
+        for (int j = 0; j < tuples.size(); ++j) {
+            Tuple* src = tuples[j];
+            Tuple* dst = NULL;
+            HashTable::Iterator it = merged_tbl->find(reinterpret_cast<TupleRow*>(&src));
+            if (it.at_end()) {
+                dst = Tuple::create(
+                    _intermediate_tuple_desc->byte_size(), agg_state->tuple_pool.get());
+                // Grouping values stay in the pool of state 'i' until close().
+                for (int k = 0; k < _probe_expr_ctxs.size(); ++k) {
+                    void* src_slot = NULL;
+                    if (!src->is_null(slots[k]->null_indicator_offset())) {
+                        src_slot = src->get_slot(slots[k]->tuple_offset());
+                    }
+                    RawValue::write(src_slot, dst, slots[k], NULL);
+                }
+                AggFnEvaluator::init(agg_state->evaluators, agg_state->agg_fn_ctxs, dst);
+                merged_tbl->insert(reinterpret_cast<TupleRow*>(&dst));
+            } else {
+                dst = it.get_row()->get_tuple(0);
+            }
+            for (int k = 0; k < agg_state->evaluators.size(); ++k) {
+                agg_state->evaluators[k]->merge(agg_state->agg_fn_ctxs[k], src, dst);
+            }
+        }
+        // Stop early on cancellation or when the memory limit is exceeded.
+        if (state->is_cancelled()) {
+            agg_state->status = Status::CANCELLED;
+        } else {
+            agg_state->status = state->check_query_state();
+        }
+    }
+    latch->count_down();
+}
+
+int AggregationNode::partition_of(Tuple* tuple) const {
+    uint32_t hash = HashUtil::FNV_SEED;
+    const std::vector<SlotDescriptor*>& slots = _intermediate_tuple_desc->slots();
+    for (int i = 0; i < _probe_expr_ctxs.size(); ++i) {
+        void* slot = NULL;
+        if (!tuple->is_null(slots[i]->null_indicator_offset())) {
+            slot = tuple->get_slot(slots[i]->tuple_offset());
+        }
+        hash = RawValue::get_hash_value_fvn(slot, slots[i]->type(), hash);
+    }
+    return hash % _parallel_states.size();
+}
+
+bool AggregationNode::output_at_end() {
+    while (_output_iterator.at_end()
+            && _output_partition + 1 < static_cast<int>(_parallel_states.size())) {
+        ++_output_partition;
+        HashTable* merged_tbl = _parallel_states[_output_partition]->merged_tbl.get();
+        if (merged_tbl != NULL) {
+            _output_iterator = merged_tbl->begin();
+        }
+    }
+    return _output_iterator.at_end();
+}
+
 void AggregationNode::debug_string(int indentation_level, std::stringstream* out) const {
     *out << std::string(indentation_level * 2, ' ');
     *out << "AggregationNode(intermediate_tuple_id=" << _intermediate_tuple_id
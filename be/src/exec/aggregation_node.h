@@ -30,6 +30,7 @@
 #include "runtime/free_list.hpp"
 #include "runtime/mem_pool.h"
 #include "runtime/string_value.h"
+#include "util/blocking_queue.hpp"
 
 namespace llvm {
 class Function;
@@ -38,6 +39,7 @@ class Function;
 namespace palo {
 
 class AggFnEvaluator;
+class CountDownLatch;
 class LlvmCodeGen;
 class RowBatch;
 class RuntimeState;
@@ -74,11 +76,45 @@ public:
 
     static const char* _s_llvm_class_name;
 private:
+    // State of one thread of parallel aggregation. The thread aggregates the child
+    // batches it gets into its own hash table with its own exprs and evaluators. Its
+    // groups are then radix partitioned by hash, and partition i of all threads is
+    // merged into 'merged_tbl' of the i-th state by the i-th merge thread.
+    struct ParallelAggState {
+        std::vector<ExprContext*> probe_expr_ctxs;
+        std::vector<ExprContext*> build_expr_ctxs;
+        // Both are SlotRefs on the intermediate tuple, used to probe 'merged_tbl'.
+        std::vector<ExprContext*> merge_probe_expr_ctxs;
+        std::vector<ExprContext*> merge_build_expr_ctxs;
+        std::vector<AggFnEvaluator*> evaluators;
+        std::vector<palo_udf::FunctionContext*> agg_fn_ctxs;
+        boost::scoped_ptr<MemPool> tuple_pool;
+        boost::scoped_ptr<HashTable> hash_tbl;
+        boost::scoped_ptr<HashTable> merged_tbl;
+        // Intermediate tuples of 'hash_tbl' of each partition.
+        std::vector<std::vector<Tuple*> > partitions;
+        int64_t num_input_rows;
+        // First error of the task that aggregates or merges into this state.
+        Status status;
+
+        ParallelAggState() : num_input_rows(0) {}
+    };
+
     boost::scoped_ptr<HashTable> _hash_tbl;
     HashTable::Iterator _output_iterator;
 
     std::vector<AggFnEvaluator*> _aggregate_evaluators;
 
+    // Copy of tnode.agg_node.aggregate_functions, to create evaluators of each
+    // parallel aggregation thread.
+    std::vector<TExpr> _aggregate_functions;
+
+    // Empty if the input is aggregated on the fragment thread, otherwise one state
+    // per thread. Output is read from 'merged_tbl' of each state in order.
+    std::vector<ParallelAggState*> _parallel_states;
+    // Index into _parallel_states of the partition _output_iterator is on.
+    int _output_partition;
+
     /// FunctionContext for each agg fn and backing pool.
     std::vector<palo_udf::FunctionContext*> _agg_fn_ctxs;
     boost::scoped_ptr<MemPool> _agg_fn_pool;
@@ -122,11 +158,23 @@ private:
     RuntimeProfile::Counter* _hash_table_buckets_counter;
     // Load factor in hash table
     RuntimeProfile::Counter* _hash_table_load_factor_counter;
+    // Time spent merging thread local hash tables in parallel mode
+    RuntimeProfile::Counter* _merge_timer;
 
     // Constructs a new aggregation output tuple (allocated from _tuple_pool),
     // initialized to grouping values computed over '_current_row'.
     // Aggregation expr slots are set to their initial values.
-    Tuple* construct_intermediate_tuple();
+    Tuple* construct_intermediate_tuple() {
+        return construct_intermediate_tuple(
+            _hash_tbl.get(), _tuple_pool.get(), _aggregate_evaluators, _agg_fn_ctxs);
+    }
+
+    // Same as above, with grouping values taken from the last row evaluated by
+    // 'hash_tbl' and aggregation slots initialized by 'evaluators'.
+    Tuple* construct_intermediate_tuple(
+        HashTable* hash_tbl, MemPool* pool,
+        const std::vector<AggFnEvaluator*>& evaluators,
+        const std::vector<palo_udf::FunctionContext*>& agg_fn_ctxs);
 
     // Updates the aggregation output tuple 'tuple' with aggregation values
     // computed over 'row'.
@@ -136,6 +184,50 @@ private:
     // aggregate values
     Tuple* finalize_tuple(Tuple* tuple, MemPool* pool);
 
+    // Returns true if there is no output row left. In parallel mode this moves
+    // _output_iterator to the next non-empty merged partition.
+    bool output_at_end();
+
+    // Evaluators and function contexts that own the tuples of _output_iterator.
+    const std::vector<AggFnEvaluator*>& output_evaluators() const {
+        return _parallel_states.empty() ?
+            _aggregate_evaluators : _parallel_states[_output_partition]->evaluators;
+    }
+    const std::vector<palo_udf::FunctionContext*>& output_agg_fn_ctxs() const {
+        return _parallel_states.empty() ?
+            _agg_fn_ctxs : _parallel_states[_output_partition]->agg_fn_ctxs;
+    }
+
+    // Creates the evaluators of each parallel aggregation thread. Called by prepare()
+    // when config::aggregation_parallel_threads > 1 and the aggregation can run in
+    // parallel: there is a grouping, no limit without aggregate functions and no
+    // multi distinct aggregate function, whose evaluator keeps state across tuples.
+    Status prepare_parallel(RuntimeState* state, int num_threads);
+
+    // Reads all child batches and hands them to aggregation tasks on the aggregation
+    // thread pool of ExecEnv, then merges the thread local hash tables partition by
+    // partition. Returns the first error of the fragment thread or of any task.
+    Status open_parallel(RuntimeState* state);
+
+    // Aggregation task: aggregates batches from 'batch_queue' until it is shut down
+    // and drained, then partitions its groups and counts down 'latch'. The first error
+    // is kept in agg_state->status.
+    void parallel_aggregate(RuntimeState* state, ParallelAggState* agg_state,
+                            BlockingQueue<RowBatch*>* batch_queue, CountDownLatch* latch);
+
+    // Aggregates the rows of 'batch' into the hash table of 'agg_state'.
+    void aggregate_batch(ParallelAggState* agg_state, RowBatch* batch);
+
+    // Appends the groups of the hash table of 'agg_state' to its partitions.
+    void partition_groups(ParallelAggState* agg_state);
+
+    // Merge task: merges partition 'partition' of all states into 'merged_tbl' of
+    // _parallel_states[partition], then counts down 'latch'.
+    void merge_partition(RuntimeState* state, int partition, CountDownLatch* latch);
+
+    // Returns the partition of the grouping values of intermediate tuple 'tuple'.
+    int partition_of(Tuple* tuple) const;
+
     // Do the aggregation for all tuple rows in the batch
     void process_row_batch_no_grouping(RowBatch* batch, MemPool* pool);
     void process_row_batch_with_grouping(RowBatch* batch, MemPool* pool);
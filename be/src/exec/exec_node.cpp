@@ -34,6 +34,7 @@
 #include "exec/csv_scan_node.h"
 #include "exec/pre_aggregation_node.h"
 #include "exec/hash_join_node.h"
+#include "exec/partitioned_hash_join_node.h"
 #include "exec/broker_scan_node.h"
 #include "exec/cross_join_node.h"
 #include "exec/empty_set_node.h"
@@ -341,7 +342,15 @@ Status ExecNode::create_node(ObjectPool* pool, const TPlanNode& tnode,
           *node = pool->add(new PreAggregationNode(pool, tnode, descs));
           return Status::OK;*/
     case TPlanNodeType::HASH_JOIN_NODE:
-        *node = pool->add(new HashJoinNode(pool, tnode, descs));
+        // Null-aware anti join is not supported by the partitioned join, and it does not
+        // push the build side down to the scan node as IN predicates.
+        if (config::enable_partitioned_hash_join
+                && tnode.hash_join_node.join_op != TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN
+                && !tnode.hash_join_node.is_push_down) {
+            *node = pool->add(new PartitionedHashJoinNode(pool, tnode, descs));
+        } else {
+            *node = pool->add(new HashJoinNode(pool, tnode, descs));
+        }
         return Status::OK;
 
     case TPlanNodeType::CROSS_JOIN_NODE:
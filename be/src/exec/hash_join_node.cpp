@@ -23,12 +23,17 @@
 #include <sstream>
 
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
 #include "exec/hash_table.hpp"
 #include "exprs/expr.h"
 #include "exprs/in_predicate.h"
+#include "exprs/runtime_filter_predicate.h"
 #include "exprs/slot_ref.h"
+#include "runtime/exec_env.h"
 #include "runtime/row_batch.h"
+#include "runtime/runtime_filter_mgr.h"
 #include "runtime/runtime_state.h"
+#include "util/bit_util.h"
 #include "util/debug_util.h"
 #include "util/runtime_profile.h"
 #include "gen_cpp/PlanNodes_types.h"
@@ -80,6 +85,16 @@ Status HashJoinNode::init(const TPlanNode& tnode) {
         Expr::create_expr_trees(_pool, tnode.hash_join_node.other_join_conjuncts,
                               &_other_join_conjunct_ctxs));
 
+    if (tnode.hash_join_node.__isset.runtime_filters) {
+        _runtime_filter_descs = tnode.hash_join_node.runtime_filters;
+        for (int i = 0; i < _runtime_filter_descs.size(); ++i) {
+            if (_runtime_filter_descs[i].expr_order < 0
+                    || _runtime_filter_descs[i].expr_order >= eq_join_conjuncts.size()) {
+                return Status("Invalid eq join conjunct of runtime filter.");
+            }
+        }
+    }
+
     return Status::OK;
 }
 
@@ -93,6 +108,8 @@ Status HashJoinNode::prepare(RuntimeState* state) {
         ADD_TIMER(runtime_profile(), "PushDownTime");
     _push_compute_timer =
         ADD_TIMER(runtime_profile(), "PushDownComputeTime");
+    _publish_runtime_filter_timer =
+        ADD_TIMER(runtime_profile(), "PublishRuntimeFilterTime");
     _probe_timer =
         ADD_TIMER(runtime_profile(), "ProbeTime");
     _build_row_counter =
@@ -205,7 +222,95 @@ Status HashJoinNode::close(RuntimeState* state) {
     }
 #endif
 
-    return ExecNode::close(state);
+    // The probe side scan checks the bloom filters until it is closed with the children.
+    Status status = ExecNode::close(state);
+    for (int i = 0; i < _runtime_filters.size(); ++i) {
+        _runtime_filters[i]->release_bloom_filter();
+    }
+    return status;
+}
+
+Status HashJoinNode::build_runtime_filters(RuntimeState* state) {
+    SCOPED_TIMER(_push_compute_timer);
+    // Only min and max are checked if the bloom filter would be too large.
+    int64_t bloom_filter_values = _hash_tbl->size();
+    if (bloom_filter_values > config::runtime_filter_max_build_rows) {
+        bloom_filter_values = 0;
+    }
+
+    std::vector<int> expr_orders;
+    for (int i = 0; i < _probe_expr_ctxs.size(); ++i) {
+        expr_orders.push_back(i);
+    }
+    std::vector<RuntimeFilterPredicate*> filters;
+    RETURN_IF_ERROR(create_runtime_filters(state, expr_orders, bloom_filter_values, &filters));
+
+    for (int i = 0; i < filters.size(); ++i) {
+        VLOG(1) << "push down runtime filter " << filters[i]->debug_string();
+        _push_down_expr_ctxs.push_back(_pool->add(new ExprContext(filters[i])));
+    }
+    return Status::OK;
+}
+
+Status HashJoinNode::create_runtime_filters(
+        RuntimeState* state, const std::vector<int>& expr_orders,
+        int64_t bloom_filter_values, std::vector<RuntimeFilterPredicate*>* filters) {
+    for (int i = 0; i < expr_orders.size(); ++i) {
+        ExprContext* probe_expr_ctx = _probe_expr_ctxs[expr_orders[i]];
+        RuntimeFilterPredicate* filter = RuntimeFilterPredicate::create(_pool);
+        RETURN_IF_ERROR(filter->prepare(
+                state, probe_expr_ctx->root()->type(), bloom_filter_values, mem_tracker()));
+        filter->add_child(Expr::copy(_pool, probe_expr_ctx->root()));
+        _runtime_filters.push_back(filter);
+        filters->push_back(filter);
+    }
+
+    HashTable::Iterator iter = _hash_tbl->begin();
+    while (iter.has_next()) {
+        TupleRow* row = iter.get_row();
+        for (int i = 0; i < expr_orders.size(); ++i) {
+            (*filters)[i]->insert(_build_expr_ctxs[expr_orders[i]]->get_value(row));
+        }
+        iter.next<false>();
+    }
+    return Status::OK;
+}
+
+void HashJoinNode::publish_runtime_filters(RuntimeState* state) {
+    SCOPED_TIMER(_publish_runtime_filter_timer);
+    // The scan node ors the bloom filters of all the instances if they have the same
+    // size, which is more likely if the sizes are rounded up.
+    int64_t bloom_filter_values = _hash_tbl->size();
+    if (bloom_filter_values > config::runtime_filter_max_build_rows) {
+        bloom_filter_values = 0;
+    } else if (bloom_filter_values > 0) {
+        bloom_filter_values = BitUtil::next_power_of_two(bloom_filter_values);
+    }
+
+    std::vector<int> expr_orders;
+    for (int i = 0; i < _runtime_filter_descs.size(); ++i) {
+        expr_orders.push_back(_runtime_filter_descs[i].expr_order);
+    }
+    std::vector<RuntimeFilterPredicate*> filters;
+    Status status = create_runtime_filters(state, expr_orders, bloom_filter_values, &filters);
+    if (!status.ok()) {
+        LOG(WARNING) << "Failed to build runtime filters: " << status.get_error_msg();
+        return;
+    }
+
+    for (int i = 0; i < filters.size(); ++i) {
+        int filter_id = _runtime_filter_descs[i].filter_id;
+        std::map<int, std::vector<TPlanFragmentDestination> >::const_iterator destinations =
+            _runtime_filter_destinations.find(filter_id);
+        if (destinations == _runtime_filter_destinations.end()) {
+            continue;
+        }
+        VLOG(1) << "publish runtime filter " << filter_id << " " << filters[i]->debug_string();
+        TRuntimeFilter filter;
+        filters[i]->to_thrift(&filter);
+        filters[i]->release_bloom_filter();
+        state->exec_env()->runtime_filter_mgr()->send(filter_id, filter, destinations->second);
+    }
 }
 
 void HashJoinNode::build_side_thread(RuntimeState* state, boost::promise<Status>* status) {
@@ -301,12 +406,19 @@ Status HashJoinNode::open(RuntimeState* state) {
             return Status::OK;
         }
 
-        if (_hash_tbl->size() > 500 * 1024) {
+        // Too many values for an InPredicate, push down runtime filters instead.
+        bool use_runtime_filter = false;
+        if (_hash_tbl->size() > config::runtime_filter_min_build_rows) {
             _is_push_down = false;
+            use_runtime_filter = true;
         }
 
-        // TODO: this is used for Code Check, Remove this later
-        if (_is_push_down || 0 != child(1)->conjunct_ctxs().size()) {
+        if (use_runtime_filter) {
+            RETURN_IF_ERROR(build_runtime_filters(state));
+            SCOPED_TIMER(_push_down_timer);
+            push_down_predicate(state, &_push_down_expr_ctxs);
+        } else if (_is_push_down || 0 != child(1)->conjunct_ctxs().size()) {
+            // TODO: this is used for Code Check, Remove this later
             for (int i = 0; i < _probe_expr_ctxs.size(); ++i) {
                 TExprNode node;
                 node.__set_node_type(TExprNodeType::IN_PRED);
@@ -374,6 +486,12 @@ Status HashJoinNode::open(RuntimeState* state) {
         // If this return first, build thread will use 'thread_status'
         // which is already destructor and then coredump.
         RETURN_IF_ERROR(open_status);
+
+        // The probe side scans of other fragments hold off their scanners until the
+        // filters arrive or config::runtime_filter_wait_time_ms passed.
+        if (!_runtime_filter_descs.empty()) {
+            publish_runtime_filters(state);
+        }
     }
 
     // seed probe batch and _current_probe_row, etc.
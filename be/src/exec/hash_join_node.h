@@ -24,16 +24,19 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/thread.hpp>
+#include <map>
 #include <string>
 
 #include "exec/exec_node.h"
 #include "exec/hash_table.h"
+#include "gen_cpp/PaloInternalService_types.h"
 #include "gen_cpp/PlanNodes_types.h"
 
 namespace palo {
 
 class MemPool;
 class RowBatch;
+class RuntimeFilterPredicate;
 class TupleRow;
 
 // Node for in-memory hash joins:
@@ -61,6 +64,13 @@ public:
     virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
     virtual Status close(RuntimeState* state);
 
+    // Instances of the scan nodes applying the filters of _runtime_filter_descs, by
+    // filter id. Set by PlanFragmentExecutor before prepare().
+    void set_runtime_filter_destinations(
+            const std::map<int, std::vector<TPlanFragmentDestination> >& destinations) {
+        _runtime_filter_destinations = destinations;
+    }
+
     static const char* _s_llvm_class_name;
 
 protected:
@@ -82,6 +92,13 @@ private:
     std::vector<ExprContext*> _probe_expr_ctxs;
     std::vector<ExprContext*> _build_expr_ctxs;
     std::list<ExprContext*> _push_down_expr_ctxs;
+    // Filters built by build_runtime_filters(), their bloom filters are released in close()
+    std::vector<RuntimeFilterPredicate*> _runtime_filters;
+
+    // Filters published to the scan nodes of the probe side fragment by
+    // publish_runtime_filters(), planned by FE for partitioned joins.
+    std::vector<TRuntimeFilterDesc> _runtime_filter_descs;
+    std::map<int, std::vector<TPlanFragmentDestination> > _runtime_filter_destinations;
 
     // non-equi-join conjuncts from the JOIN clause
     std::vector<ExprContext*> _other_join_conjunct_ctxs;
@@ -136,6 +153,7 @@ private:
     RuntimeProfile::Counter* _build_timer;   // time to build hash table
     RuntimeProfile::Counter* _push_down_timer;   // time to build hash table
     RuntimeProfile::Counter* _push_compute_timer;
+    RuntimeProfile::Counter* _publish_runtime_filter_timer;
     RuntimeProfile::Counter* _probe_timer;   // time to probe
     RuntimeProfile::Counter* _build_row_counter;   // num build rows
     RuntimeProfile::Counter* _probe_row_counter;   // num probe rows
@@ -152,6 +170,23 @@ private:
     // same time.
     Status construct_hash_table(RuntimeState* state);
 
+    // Builds a RuntimeFilterPredicate over each probe expr from the values in
+    // _hash_tbl and adds it to _push_down_expr_ctxs. Used instead of InPredicates
+    // when the build side is too large.
+    Status build_runtime_filters(RuntimeState* state);
+
+    // Creates a RuntimeFilterPredicate over the probe expr of each eq join conjunct in
+    // 'expr_orders' with a bloom filter sized for 'bloom_filter_values', and inserts
+    // the values of _hash_tbl.
+    Status create_runtime_filters(
+            RuntimeState* state, const std::vector<int>& expr_orders,
+            int64_t bloom_filter_values, std::vector<RuntimeFilterPredicate*>* filters);
+
+    // Builds the filters of _runtime_filter_descs and sends them to the instances in
+    // _runtime_filter_destinations. Failures are only logged, the scan nodes then
+    // start without the filters.
+    void publish_runtime_filters(RuntimeState* state);
+
     // GetNext helper function for the common join cases: Inner join, left semi and left
     // outer
     Status left_join_get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
@@ -31,8 +31,10 @@
 #include "exprs/expr.h"
 #include "exprs/binary_predicate.h"
 #include "exprs/in_predicate.h"
+#include "exprs/runtime_filter_predicate.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/exec_env.h"
+#include "runtime/runtime_filter_mgr.h"
 #include "runtime/runtime_state.h"
 #include "runtime/row_batch.h"
 #include "runtime/string_value.h"
@@ -43,6 +45,7 @@
 #include "agent/cgroups_mgr.h"
 #include "common/resource_tls.h"
 #include "olap/olap_reader.h"
+#include <boost/thread/thread_time.hpp>
 #include <boost/variant.hpp>
 
 using llvm::Function;
@@ -67,6 +70,7 @@ OlapScanNode::OlapScanNode(ObjectPool* pool, const TPlanNode& tnode, const Descr
         _use_pushdown_conjuncts(true),
         _wait_duration(0, 0, 1, 0),
         _status(Status::OK),
+        _runtime_filters_registered(false),
         _resource_info(nullptr),
         _buffered_bytes(0),
         _running_thread(0),
@@ -87,6 +91,16 @@ Status OlapScanNode::init(const TPlanNode& tnode) {
     } else {
         _is_result_order = false;
     }
+
+    if (tnode.olap_scan_node.__isset.runtime_filters) {
+        _runtime_filter_descs = tnode.olap_scan_node.runtime_filters;
+        for (int i = 0; i < _runtime_filter_descs.size(); ++i) {
+            ExprContext* ctx = NULL;
+            RETURN_IF_ERROR(Expr::create_expr_tree(
+                    _pool, _runtime_filter_descs[i].target_expr, &ctx));
+            _runtime_filter_target_ctxs.push_back(ctx);
+        }
+    }
     return Status::OK;
 }
 
@@ -107,6 +121,16 @@ Status OlapScanNode::prepare(RuntimeState* state) {
         ADD_COUNTER(runtime_profile(), "DirectFilterReturnCount ", TUnit::UNIT);
     _tablet_counter =
         ADD_COUNTER(runtime_profile(), "TabletCount ", TUnit::UNIT);
+    // Rows converted from column batches straight into row batches, and how
+    // many of them still had to be moved to fill the gap of a filtered row.
+    _block_convert_timer = ADD_TIMER(_runtime_profile, "BlockConvertTime");
+    _block_rows_counter =
+        ADD_COUNTER(runtime_profile(), "RowsReadByBlock", TUnit::UNIT);
+    _block_moved_tuples_counter =
+        ADD_COUNTER(runtime_profile(), "BlockTuplesMoved", TUnit::UNIT);
+    _runtime_filter_wait_timer = ADD_TIMER(_runtime_profile, "RuntimeFilterWaitTime");
+    _runtime_filters_applied_counter =
+        ADD_COUNTER(runtime_profile(), "RuntimeFiltersApplied", TUnit::UNIT);
 
     _tuple_desc = state->desc_tbl().get_tuple_descriptor(_tuple_id);
     if (_tuple_desc == NULL) {
@@ -139,6 +163,20 @@ Status OlapScanNode::prepare(RuntimeState* state) {
         }
     }
 
+    // Register the filters before any producer may be done with them, those published
+    // earlier are kept by RuntimeFilterMgr anyway.
+    for (int i = 0; i < _runtime_filter_descs.size(); ++i) {
+        int filter_id = _runtime_filter_descs[i].filter_id;
+        std::map<int, int>::const_iterator num_producers =
+            _runtime_filter_num_producers.find(filter_id);
+        if (num_producers == _runtime_filter_num_producers.end()) {
+            continue;
+        }
+        state->exec_env()->runtime_filter_mgr()->register_filter(
+            state->fragment_instance_id(), filter_id, num_producers->second);
+        _runtime_filters_registered = true;
+    }
+
     _runtime_state = state;
     return Status::OK;
 }
@@ -318,6 +356,11 @@ Status OlapScanNode::close(RuntimeState* state) {
         scanner->close(state);
     }
 
+    unregister_runtime_filters(state);
+    for (auto filter : _runtime_filters) {
+        filter->release_bloom_filter();
+    }
+
     VLOG(1) << "OlapScanNode::close()";
     return ExecNode::close(state);
 }
@@ -340,6 +383,11 @@ Status OlapScanNode::set_scan_ranges(const std::vector<TScanRangeParams>& scan_r
 Status OlapScanNode::start_scan(RuntimeState* state) {
     RETURN_IF_CANCELLED(state);
 
+    if (_runtime_filters_registered) {
+        VLOG(1) << "ApplyRuntimeFilters";
+        RETURN_IF_ERROR(apply_runtime_filters(state));
+    }
+
     VLOG(1) << "NormalizeConjuncts";
     // 1. Convert conjuncts to ColumnValueRange in each column
     RETURN_IF_ERROR(normalize_conjuncts());
@@ -367,6 +415,73 @@ Status OlapScanNode::start_scan(RuntimeState* state) {
     return Status::OK;
 }
 
+Status OlapScanNode::apply_runtime_filters(RuntimeState* state) {
+    RuntimeFilterMgr* runtime_filter_mgr = state->exec_env()->runtime_filter_mgr();
+    // All the filters are waited for at the same time.
+    boost::system_time deadline = boost::get_system_time()
+        + boost::posix_time::milliseconds(config::runtime_filter_wait_time_ms);
+    Status status = Status::OK;
+    for (int i = 0; i < _runtime_filter_descs.size() && status.ok(); ++i) {
+        int filter_id = _runtime_filter_descs[i].filter_id;
+        if (_runtime_filter_num_producers.count(filter_id) == 0) {
+            continue;
+        }
+        std::vector<TRuntimeFilter> published_filters;
+        bool is_complete = false;
+        {
+            SCOPED_TIMER(_runtime_filter_wait_timer);
+            is_complete = runtime_filter_mgr->wait_for(
+                state->fragment_instance_id(), filter_id, deadline, &published_filters);
+        }
+        if (!is_complete) {
+            // Some instances did not publish in time, the union of the others would
+            // filter out their rows.
+            VLOG(1) << "runtime filter " << filter_id << " is not complete, skip it";
+            continue;
+        }
+
+        Expr* target_expr = _runtime_filter_target_ctxs[i]->root();
+        RuntimeFilterPredicate* filter = RuntimeFilterPredicate::create(_pool);
+        _runtime_filters.push_back(filter);
+        status = filter->prepare(state, target_expr->type(), 0, mem_tracker());
+        for (int j = 0; j < published_filters.size() && status.ok(); ++j) {
+            status = filter->merge(published_filters[j]);
+        }
+        if (!status.ok()) {
+            break;
+        }
+        filter->add_child(target_expr);
+
+        ExprContext* ctx = _pool->add(new ExprContext(filter));
+        status = ctx->prepare(state, row_desc(), expr_mem_tracker());
+        if (status.ok()) {
+            status = ctx->open(state);
+        }
+        if (status.ok()) {
+            VLOG(1) << "apply runtime filter " << filter_id << " " << filter->debug_string();
+            _conjunct_ctxs.push_back(ctx);
+            COUNTER_UPDATE(_runtime_filters_applied_counter, 1);
+        }
+    }
+    unregister_runtime_filters(state);
+    return status;
+}
+
+void OlapScanNode::unregister_runtime_filters(RuntimeState* state) {
+    if (!_runtime_filters_registered) {
+        return;
+    }
+    for (int i = 0; i < _runtime_filter_descs.size(); ++i) {
+        int filter_id = _runtime_filter_descs[i].filter_id;
+        if (_runtime_filter_num_producers.count(filter_id) == 0) {
+            continue;
+        }
+        state->exec_env()->runtime_filter_mgr()->unregister_filter(
+            state->fragment_instance_id(), filter_id);
+    }
+    _runtime_filters_registered = false;
+}
+
 Status OlapScanNode::normalize_conjuncts() {
     std::vector<SlotDescriptor*> slots = _tuple_desc->slots();
 
@@ -702,7 +817,10 @@ Status OlapScanNode::normalize_predicate(ColumnValueRange<T>& range, SlotDescrip
     // 2. Normalize BinaryPredicate , add to ColumnValueRange
     RETURN_IF_ERROR(normalize_binary_predicate(slot, &range));
 
-    // 3. Add range to Column->ColumnValueRange map
+    // 3. Normalize min/max of RuntimeFilterPredicate pushed down by HashJoinNode
+    RETURN_IF_ERROR(normalize_runtime_filter_predicate(slot, &range));
+
+    // 4. Add range to Column->ColumnValueRange map
     _column_value_ranges[slot->col_name()] = range;
 
     return Status::OK;
@@ -993,6 +1111,75 @@ Status OlapScanNode::normalize_binary_predicate(SlotDescriptor* slot, ColumnValu
     return Status::OK;
 }
 
+template<class T>
+Status OlapScanNode::normalize_runtime_filter_predicate(
+        SlotDescriptor* slot, ColumnValueRange<T>* range) {
+    for (int conj_idx = 0; conj_idx < _conjunct_ctxs.size(); ++conj_idx) {
+        Expr* root_expr = _conjunct_ctxs[conj_idx]->root();
+        if (TExprNodeType::RUNTIME_FILTER_PRED != root_expr->node_type()) {
+            continue;
+        }
+        RuntimeFilterPredicate* pred = dynamic_cast<RuntimeFilterPredicate*>(root_expr);
+        if (Expr::type_without_cast(pred->get_child(0)) != TExprNodeType::SLOT_REF) {
+            continue;
+        }
+        if (pred->get_child(0)->type() != slot->type()) {
+            if (!ignore_cast(slot, pred->get_child(0))) {
+                continue;
+            }
+        }
+
+        std::vector<SlotId> slot_ids;
+        if (1 != pred->get_child(0)->get_slot_ids(&slot_ids) || slot_ids[0] != slot->id()) {
+            continue;
+        }
+        // Empty build side, the predicate itself filters all rows.
+        if (pred->min_value() == NULL) {
+            continue;
+        }
+
+        // The filter stays in conjuncts to check the bloom filter per row, only
+        // [min, max] is given to OlapEngine to prune data by zone map and scan key.
+        void* values[2] = {
+            const_cast<void*>(pred->min_value()), const_cast<void*>(pred->max_value())};
+        SQLFilterOp ops[2] = {FILTER_LARGER_OR_EQUAL, FILTER_LESS_OR_EQUAL};
+        for (int i = 0; i < 2; ++i) {
+            switch (slot->type().type) {
+            case TYPE_TINYINT: {
+                int32_t v = *reinterpret_cast<int8_t*>(values[i]);
+                range->add_range(ops[i], *reinterpret_cast<T*>(&v));
+                break;
+            }
+            case TYPE_DATE: {
+                DateTimeValue date_value = *reinterpret_cast<DateTimeValue*>(values[i]);
+                date_value.cast_to_date();
+                range->add_range(ops[i], *reinterpret_cast<T*>(&date_value));
+                break;
+            }
+            case TYPE_DECIMAL:
+            case TYPE_CHAR:
+            case TYPE_VARCHAR:
+            case TYPE_HLL:
+            case TYPE_DATETIME:
+            case TYPE_SMALLINT:
+            case TYPE_INT:
+            case TYPE_BIGINT:
+            case TYPE_LARGEINT: {
+                range->add_range(ops[i], *reinterpret_cast<T*>(values[i]));
+                break;
+            }
+            default: {
+                break;
+            }
+            }
+        }
+
+        VLOG(1) << slot->col_name() << " runtime filter: " << pred->debug_string();
+    }
+
+    return Status::OK;
+}
+
 bool OlapScanNode::select_scan_range(boost::shared_ptr<PaloScanRange> scan_range) {
     std::map<std::string, ColumnValueRangeType>::iterator iter
         = _column_value_ranges.begin();
@@ -1528,6 +1715,9 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
 
     bool _use_pushdown_conjuncts = true;
     int64_t total_rows_reader_counter = 0;
+    // Column batch reads convert several tuples at once right into the tuple
+    // buffer of the row batch, the conjuncts are then evaluated in place.
+    bool read_by_block = scanner->is_read_by_block();
     while (!eos && total_rows_reader_counter < config::palo_scanner_row_num) {
         // 1. Allocate one row batch
         // RowBatch *row_batch = new RowBatch(this->row_desc(), state->batch_size(), mem_tracker());
@@ -1543,6 +1733,14 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
         int direct_return_counter = 0;
         int pushdown_return_counter = 0;
         int rows_read_counter = 0;
+        // Tuples converted from the current column batch, starting at the first
+        // free tuple of tuple_buf. A tuple only has to be moved once some row
+        // before it has been filtered.
+        Tuple* block_tuples = NULL;
+        int block_tuple_num = 0;
+        int block_tuple_index = 0;
+        int block_rows_counter = 0;
+        int block_moved_tuples_counter = 0;
         // 3. Read data to each tuple
         while (true) {
             // 3.1 Break if RowBatch is Full, Try to read new RowBatch
@@ -1558,15 +1756,49 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
                 break;
             }
             // 3.3 Read tuple from OlapEngine
-            status = scanner->get_next(tuple, &total_rows_reader_counter, &eos);
-            if (UNLIKELY(!status.ok())) {
-                LOG(ERROR) << "Scan thread read OlapScanner failed!";
-                eos = true;
-                break;
-            }
-            if (UNLIKELY(eos)) {
-                // this scanner read all data, break;
-                break;
+            if (read_by_block) {
+                if (block_tuple_index >= block_tuple_num) {
+                    SCOPED_TIMER(_block_convert_timer);
+                    block_tuples = tuple;
+                    block_tuple_index = 0;
+                    status = scanner->get_next_tuples(
+                            block_tuples, state->batch_size() - row_batch->num_rows(),
+                            &block_tuple_num, &total_rows_reader_counter, &eos);
+                    block_rows_counter += block_tuple_num;
+                }
+                if (UNLIKELY(!status.ok())) {
+                    LOG(ERROR) << "Scan thread read OlapScanner failed!";
+                    eos = true;
+                    break;
+                }
+                if (UNLIKELY(eos)) {
+                    // this scanner read all data, break;
+                    break;
+                }
+                if (block_tuple_index >= block_tuple_num) {
+                    // empty column batch
+                    continue;
+                }
+
+                Tuple* block_tuple = reinterpret_cast<Tuple*>(
+                        reinterpret_cast<uint8_t*>(block_tuples)
+                        + block_tuple_index * _tuple_desc->byte_size());
+                ++block_tuple_index;
+                if (block_tuple != tuple) {
+                    memory_copy(tuple, block_tuple, _tuple_desc->byte_size());
+                    ++block_moved_tuples_counter;
+                }
+            } else {
+                status = scanner->get_next(tuple, &total_rows_reader_counter, &eos);
+                if (UNLIKELY(!status.ok())) {
+                    LOG(ERROR) << "Scan thread read OlapScanner failed!";
+                    eos = true;
+                    break;
+                }
+                if (UNLIKELY(eos)) {
+                    // this scanner read all data, break;
+                    break;
+                }
             }
 
             if (VLOG_ROW_IS_ON) {
@@ -1640,7 +1872,9 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
             } while (0);
 
             ++rows_read_counter;
-            if (total_rows_reader_counter >= config::palo_scanner_row_num) {
+            // rows left in the column batch would be lost if we stopped here
+            if (total_rows_reader_counter >= config::palo_scanner_row_num
+                    && block_tuple_index >= block_tuple_num) {
                 break;
             }
         }
@@ -1649,6 +1883,8 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
         COUNTER_UPDATE(_pushdown_return_counter, pushdown_return_counter);
         COUNTER_UPDATE(_direct_return_counter, direct_return_counter);
         COUNTER_UPDATE(this->rows_read_counter(), rows_read_counter);
+        COUNTER_UPDATE(_block_rows_counter, block_rows_counter);
+        COUNTER_UPDATE(_block_moved_tuples_counter, block_moved_tuples_counter);
 
         // 4. if status not ok, change status_.
         if (UNLIKELY(0 == row_batch->num_rows())) {
@@ -27,6 +27,7 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include <map>
 #include <queue>
 
 #include "exec/olap_common.h"
@@ -41,6 +42,8 @@
 
 namespace palo {
 
+class RuntimeFilterPredicate;
+
 enum TransferStatus {
     READ_ROWBATCH = 1,
     INIT_HEAP = 2,
@@ -62,6 +65,12 @@ public:
     virtual Status close(RuntimeState* state);
     virtual Status set_scan_ranges(const std::vector<TScanRangeParams>& scan_ranges);
 
+    // Number of hash join instances publishing each runtime filter applied by this
+    // node, by filter id. Filters without producers are not waited for.
+    void set_runtime_filter_num_producers(const std::map<int, int>& num_producers) {
+        _runtime_filter_num_producers = num_producers;
+    }
+
 protected:
     typedef struct {
         Tuple* tuple;
@@ -135,6 +144,11 @@ protected:
     }
 
     Status start_scan(RuntimeState* state);
+    // Waits at most config::runtime_filter_wait_time_ms for the runtime filters
+    // published by the hash joins of other fragments and adds the complete ones to
+    // the conjuncts, so that their min and max are normalized like the others.
+    Status apply_runtime_filters(RuntimeState* state);
+    void unregister_runtime_filters(RuntimeState* state);
     Status normalize_conjuncts();
     Status build_olap_filters();
     Status select_scan_ranges();
@@ -157,6 +171,9 @@ protected:
     template<class T>
     Status normalize_binary_predicate(SlotDescriptor* slot, ColumnValueRange<T>* range);
 
+    template<class T>
+    Status normalize_runtime_filter_predicate(SlotDescriptor* slot, ColumnValueRange<T>* range);
+
     bool select_scan_range(boost::shared_ptr<PaloScanRange> scan_range);
     Status get_sub_scan_range(
         boost::shared_ptr<PaloScanRange> scan_range,
@@ -295,6 +312,21 @@ private:
     RuntimeProfile::Counter* _pushdown_return_counter;
     RuntimeProfile::Counter* _direct_return_counter;
     RuntimeProfile::Counter* _tablet_counter;
+    RuntimeProfile::Counter* _block_convert_timer;
+    RuntimeProfile::Counter* _block_rows_counter;
+    RuntimeProfile::Counter* _block_moved_tuples_counter;
+    RuntimeProfile::Counter* _runtime_filter_wait_timer;
+    RuntimeProfile::Counter* _runtime_filters_applied_counter;
+
+    // Runtime filters planned by FE for this node, the target exprs are evaluated
+    // on the rows of this node, in the same order.
+    std::vector<TRuntimeFilterTargetDesc> _runtime_filter_descs;
+    std::vector<ExprContext*> _runtime_filter_target_ctxs;
+    std::map<int, int> _runtime_filter_num_producers;
+    // Whether the filters are still registered to RuntimeFilterMgr.
+    bool _runtime_filters_registered;
+    // Filters added to the conjuncts, their bloom filters are released in close().
+    std::vector<RuntimeFilterPredicate*> _runtime_filters;
 
     RuntimeProfile* _scanner_profile;
 
@@ -165,6 +165,23 @@ Status OlapScanner::get_next(Tuple* tuple, int64_t* raw_rows_read, bool* eof) {
     return Status::OK;
 }
 
+bool OlapScanner::is_read_by_block() const {
+    return _reader->is_read_by_block();
+}
+
+Status OlapScanner::get_next_tuples(Tuple* tuples, int max_tuples, int* num_tuples,
+                                    int64_t* raw_rows_read, bool* eof) {
+    if (!_reader->next_tuples(tuples, max_tuples, num_tuples, raw_rows_read, eof).ok()) {
+        if (MemTracker::limit_exceeded(*_runtime_state->mem_trackers())) {
+            LOG(ERROR) << "Memory limit exceeded.";
+            return Status("Internal Error: Memory limit exceeded.");
+        }
+        LOG(ERROR) << "read storage fail.";
+        return Status("Internal Error: read storage fail.");
+    }
+    return Status::OK;
+}
+
 Status OlapScanner::close(RuntimeState* state) {
     _reader.reset();
     Expr::close(_row_conjunct_ctxs, state);
@@ -69,6 +69,15 @@ public:
 
     Status get_next(Tuple* tuple, int64_t* raw_rows_read, bool* eof);
 
+    // Whether the tablet is read by column batches, see OLAPReader::is_read_by_block.
+    bool is_read_by_block() const;
+
+    // Convert up to max_tuples rows of the current column batch directly into
+    // 'tuples', which are laid out contiguously (e.g. the tuple buffer of a
+    // RowBatch). *num_tuples may be 0 without eof when a batch is empty.
+    Status get_next_tuples(Tuple* tuples, int max_tuples, int* num_tuples,
+                           int64_t* raw_rows_read, bool* eof);
+
     Status close(RuntimeState* state);
 
     RuntimeState* runtime_state() {
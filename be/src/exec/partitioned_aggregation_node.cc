@@ -26,6 +26,7 @@
 
 #include "codegen/codegen_anyval.h"
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
 #include "exec/partitioned_hash_table.inline.h"
 #include "exprs/agg_fn_evaluator.h"
 #include "exprs/expr.h"
@@ -51,6 +52,26 @@ using std::list;
 
 namespace palo {
 
+// Minimum reduction, i.e. number of input rows per group, the hash table of a partition
+// must achieve in streaming mode to keep growing beyond a size. Sizes are for the hash
+// tables of all partitions together, since they are probed by the same input.
+struct StreamingHtMinReductionEntry {
+    int64_t min_ht_mem;
+    double streaming_ht_min_reduction;
+};
+
+static const StreamingHtMinReductionEntry STREAMING_HT_MIN_REDUCTION[] = {
+    // Always grow while the hash tables fit in L2 cache.
+    { 0, 0.0 },
+    // Grow to L3 cache size if there is some reduction.
+    { 256 * 1024, 1.1 },
+    // Grow into main memory only if the reduction is good.
+    { 2 * 1024 * 1024, 2.0 },
+};
+
+static const int STREAMING_HT_MIN_REDUCTION_SIZE =
+    sizeof(STREAMING_HT_MIN_REDUCTION) / sizeof(STREAMING_HT_MIN_REDUCTION[0]);
+
 const char* PartitionedAggregationNode::_s_llvm_class_name =
         "class.palo::PartitionedAggregationNode";
 
@@ -63,6 +84,8 @@ PartitionedAggregationNode::PartitionedAggregationNode(
         _output_tuple_desc(NULL),
         _needs_finalize(tnode.agg_node.need_finalize),
         _needs_serialize(false),
+        _is_streaming_preagg(false),
+        _child_eos(false),
         _block_mgr_client(NULL),
         _output_partition(NULL),
         _process_row_batch_fn(NULL),
@@ -74,6 +97,8 @@ PartitionedAggregationNode::PartitionedAggregationNode(
         // _max_partition_level(NULL),
         _num_row_repartitioned(NULL),
         _num_repartitions(NULL),
+        _num_passthrough_rows(NULL),
+        _num_streaming_partitions(NULL),
         _singleton_output_tuple(NULL),
         _singleton_output_tuple_returned(true),
         _partition_pool(new ObjectPool()) {
@@ -156,6 +181,10 @@ Status PartitionedAggregationNode::prepare(RuntimeState* state) {
             Expr::prepare(_build_expr_ctxs, state, *_intermediate_row_desc, expr_mem_tracker()));
     // AddExprCtxsToFree(_build_expr_ctxs);
 
+    // Passed through rows are serialized and their string results copied into the output
+    // batch. A string intermediate without serialize would keep memory allocated by init
+    // or update in the function context, so such aggregations are not streamed.
+    bool can_pass_through = true;
     int j = _probe_expr_ctxs.size();
     for (int i = 0; i < _aggregate_evaluators.size(); ++i, ++j) {
         // Skip non-materialized slots; we don't have evaluators instantiated for those.
@@ -176,6 +205,28 @@ Status PartitionedAggregationNode::prepare(RuntimeState* state) {
         _agg_fn_ctxs.push_back(agg_fn_ctx);
         state->obj_pool()->add(agg_fn_ctx);
         _needs_serialize |= _aggregate_evaluators[i]->supports_serialize();
+        if (_intermediate_tuple_desc->slots()[j]->type().is_string_type()
+                && !_aggregate_evaluators[i]->supports_serialize()) {
+            can_pass_through = false;
+        }
+    }
+
+    // Rows may only be passed through if the output is merged later. Multi distinct
+    // evaluators keep state for each tuple, so they are not streamed.
+    _is_streaming_preagg = config::enable_streaming_preaggregation && can_pass_through
+        && !_needs_finalize && !_probe_expr_ctxs.empty()
+        && limit() == -1 && _conjunct_ctxs.empty();
+    for (int i = 0; i < _aggregate_evaluators.size(); ++i) {
+        if (_aggregate_evaluators[i]->is_merge()
+                || _aggregate_evaluators[i]->is_multi_distinct()) {
+            _is_streaming_preagg = false;
+        }
+    }
+    if (_is_streaming_preagg) {
+        _num_passthrough_rows = ADD_COUNTER(
+                runtime_profile(), "RowsPassedThrough", TUnit::UNIT);
+        _num_streaming_partitions = ADD_COUNTER(
+                runtime_profile(), "StreamingPartitions", TUnit::UNIT);
     }
 
     if (_probe_expr_ctxs.empty()) {
@@ -231,6 +282,10 @@ Status PartitionedAggregationNode::open(RuntimeState* state) {
 
     // Read all the rows from the child and process them.
     RETURN_IF_ERROR(_children[0]->open(state));
+    if (_is_streaming_preagg) {
+        // Input is read in get_next().
+        return Status::OK;
+    }
     RowBatch batch(_children[0]->row_desc(), state->batch_size(), mem_tracker());
     bool eos = false;
     do {
@@ -313,6 +368,16 @@ Status PartitionedAggregationNode::get_next(RuntimeState* state, RowBatch* row_b
         return Status::OK;
     }
 
+    if (_is_streaming_preagg && !_child_eos) {
+        RETURN_IF_ERROR(get_rows_streaming(state, row_batch));
+        if (row_batch->num_rows() > 0) {
+            COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+            *eos = false;
+            return Status::OK;
+        }
+        DCHECK(_child_eos);
+    }
+
     if (_output_iterator.at_end()) {
         // Done with this partition, move onto the next one.
         if (_output_partition != NULL) {
@@ -402,6 +467,7 @@ Status PartitionedAggregationNode::reset(RuntimeState* state) {
         _singleton_output_tuple_returned = false;
     } else {
         // Reset the HT and the partitions for this grouping agg.
+        _child_eos = false;
         _ht_ctx->set_level(0);
         close_partitions();
         create_hash_partitions(0);
@@ -887,6 +953,92 @@ Status PartitionedAggregationNode::check_and_resize_hash_partitions(int num_rows
     return Status::OK;
 }
 
+Status PartitionedAggregationNode::get_rows_streaming(RuntimeState* state, RowBatch* row_batch) {
+    // A child batch is only processed into an empty output batch of at least the same
+    // capacity, so that all rows passed through from it fit.
+    if (row_batch->num_rows() > 0) {
+        return Status::OK;
+    }
+    if (_child_batch.get() == NULL) {
+        _child_batch.reset(new RowBatch(
+                _children[0]->row_desc(), row_batch->capacity(), mem_tracker()));
+    }
+
+    while (row_batch->num_rows() == 0 && !_child_eos) {
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(state->check_query_state());
+        RETURN_IF_ERROR(_children[0]->get_next(state, _child_batch.get(), &_child_eos));
+
+        SCOPED_TIMER(_build_timer);
+        RETURN_IF_ERROR(process_batch_streaming(_child_batch.get(), row_batch, _ht_ctx.get()));
+        _num_rows_returned += row_batch->num_rows();
+        COUNTER_UPDATE(_num_passthrough_rows, row_batch->num_rows());
+        // Passed through tuples are copied into 'row_batch'.
+        _child_batch->reset();
+    }
+
+    if (_child_eos) {
+        child(0)->close(state);
+        _child_batch.reset();
+        RETURN_IF_ERROR(move_hash_partitions(child(0)->rows_returned()));
+    }
+    return Status::OK;
+}
+
+void PartitionedAggregationNode::check_and_resize_streaming_partitions(int num_rows,
+        PartitionedHashTableCtx* ht_ctx) {
+    for (int i = 0; i < PARTITION_FANOUT; ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_spilled() || partition->is_streaming) {
+            continue;
+        }
+        if (should_expand_preagg_hash_table(partition)) {
+            SCOPED_TIMER(_ht_resize_timer);
+            // A pre-aggregation does not spill, it passes rows through instead.
+            if (partition->hash_tbl->check_and_resize(num_rows, ht_ctx)) {
+                continue;
+            }
+        }
+        partition->is_streaming = true;
+        COUNTER_UPDATE(_num_streaming_partitions, 1);
+    }
+}
+
+bool PartitionedAggregationNode::should_expand_preagg_hash_table(
+        const Partition* partition) const {
+    int64_t ht_rows = partition->hash_tbl->size();
+    if (ht_rows == 0) {
+        return true;
+    }
+    int64_t ht_mem = partition->hash_tbl->current_mem_size() * PARTITION_FANOUT;
+    int cache_level = 0;
+    while (cache_level + 1 < STREAMING_HT_MIN_REDUCTION_SIZE
+            && ht_mem >= STREAMING_HT_MIN_REDUCTION[cache_level + 1].min_ht_mem) {
+        ++cache_level;
+    }
+    double reduction = static_cast<double>(partition->num_input_rows) / ht_rows;
+    return reduction > STREAMING_HT_MIN_REDUCTION[cache_level].streaming_ht_min_reduction;
+}
+
+void PartitionedAggregationNode::copy_serialized_strings(Tuple* tuple, MemPool* pool) {
+    const vector<SlotDescriptor*>& slots = _intermediate_tuple_desc->slots();
+    for (int i = _probe_expr_ctxs.size(); i < slots.size(); ++i) {
+        const SlotDescriptor* slot_desc = slots[i];
+        if (!slot_desc->is_materialized() || !slot_desc->type().is_string_type()
+                || tuple->is_null(slot_desc->null_indicator_offset())) {
+            continue;
+        }
+        StringValue* sv = reinterpret_cast<StringValue*>(
+                tuple->get_slot(slot_desc->tuple_offset()));
+        if (sv->len == 0) {
+            continue;
+        }
+        char* copy = reinterpret_cast<char*>(pool->allocate(sv->len));
+        memcpy(copy, sv->ptr, sv->len);
+        sv->ptr = copy;
+    }
+}
+
 int64_t PartitionedAggregationNode::largest_spilled_partition() const {
     int64_t max_rows = 0;
     for (int i = 0; i < _hash_partitions.size(); ++i) {
@@ -30,6 +30,7 @@
 #include "runtime/buffered_tuple_stream2.h"
 #include "runtime/descriptors.h"  // for TupleId
 #include "runtime/mem_pool.h"
+#include "runtime/row_batch.h"
 #include "runtime/string_value.h"
 
 namespace llvm {
@@ -169,6 +170,17 @@ private:
     // Contains any evaluators that require the serialize step.
     bool _needs_serialize;
 
+    // True if this is a pre-aggregation whose output is merged by another aggregation.
+    // Then the input is aggregated while it is read in get_next(), and a partition
+    // whose hash table does not reduce the input enough stops growing: rows that do not
+    // match one of its groups are returned as serialized intermediate tuples instead.
+    bool _is_streaming_preagg;
+
+    // Batch of child rows being processed in streaming mode, and whether the child
+    // returned eos.
+    boost::scoped_ptr<RowBatch> _child_batch;
+    bool _child_eos;
+
     std::vector<AggFnEvaluator*> _aggregate_evaluators;
 
     // FunctionContext for each aggregate function and backing MemPool. String data
@@ -238,6 +250,12 @@ private:
     // Number of partitions that have been spilled.
     RuntimeProfile::Counter* _num_spilled_partitions;
 
+    // Number of input rows passed through in streaming mode.
+    RuntimeProfile::Counter* _num_passthrough_rows;
+
+    // Number of partitions that stopped growing in streaming mode.
+    RuntimeProfile::Counter* _num_streaming_partitions;
+
     // The largest fraction after repartitioning. This is expected to be
     // 1 / PARTITION_FANOUT. A value much larger indicates skew.
     // RuntimeProfile::HighWaterMarkCounter* _largest_partition_percent;
@@ -278,7 +296,8 @@ private:
     // initially use small buffers.
     struct Partition {
         Partition(PartitionedAggregationNode* parent, int level) :
-                parent(parent), is_closed(false), level(level) {}
+                parent(parent), is_closed(false), level(level),
+                is_streaming(false), num_input_rows(0) {}
 
         // Initializes aggregated_row_stream and unaggregated_row_stream, reserving
         // one buffer for each. The buffers backing these streams are reserved, so this
@@ -315,6 +334,13 @@ private:
         // etc.
         const int level;
 
+        // Only used in streaming mode. If true, the hash table no longer grows and input
+        // rows not matching a group in it are passed through.
+        bool is_streaming;
+
+        // Number of input rows hashed to this partition in streaming mode.
+        int64_t num_input_rows;
+
         // Hash table for this partition.
         // Can be NULL if this partition is no longer maintaining a hash table (i.e.
         // is spilled).
@@ -374,6 +400,29 @@ private:
     Tuple* get_output_tuple(const std::vector<palo_udf::FunctionContext*>& agg_fn_ctxs,
             Tuple* tuple, MemPool* pool);
 
+    // Aggregates 'in_batch' into the partitions in streaming mode. Rows that are not
+    // aggregated are added to 'out_batch' as serialized intermediate tuples, which must
+    // have room for all rows of 'in_batch'.
+    Status process_batch_streaming(RowBatch* in_batch, RowBatch* out_batch,
+            PartitionedHashTableCtx* ht_ctx);
+
+    // Copies the string results of the aggregate functions in the serialized 'tuple' into
+    // 'pool', so that the local allocations of the function contexts can be freed.
+    void copy_serialized_strings(Tuple* tuple, MemPool* pool);
+
+    // Reads child batches in streaming mode until some rows are passed through to
+    // 'row_batch' or the child reaches eos. On eos the partitions are moved to
+    // _aggregated_partitions to be returned as in the non-streaming case.
+    Status get_rows_streaming(RuntimeState* state, RowBatch* row_batch);
+
+    // Before processing 'num_rows' rows in streaming mode, resizes the hash tables of
+    // the partitions that should still grow, and switches the others to streaming.
+    void check_and_resize_streaming_partitions(int num_rows, PartitionedHashTableCtx* ht_ctx);
+
+    // Returns true if the hash table of 'partition' reduced its input enough for its size
+    // to keep growing.
+    bool should_expand_preagg_hash_table(const Partition* partition) const;
+
     // Do the aggregation for all tuple rows in the batch when there is no grouping.
     // The PartitionedHashTableCtx argument is unused, but included so the signature matches that of
     // process_batch() for codegen. This function is replaced by codegen.
@@ -24,6 +24,7 @@
 #include "runtime/buffered_tuple_stream2.inline.h"
 #include "runtime/row_batch.h"
 #include "runtime/tuple_row.h"
+#include "udf/udf_internal.h"
 
 namespace palo {
 
@@ -138,6 +139,66 @@ Status PartitionedAggregationNode::append_spilled_row(Partition* partition, Tupl
     return append_spilled_row(stream, row);
 }
 
+Status PartitionedAggregationNode::process_batch_streaming(
+        RowBatch* in_batch, RowBatch* out_batch, PartitionedHashTableCtx* ht_ctx) {
+    DCHECK(_is_streaming_preagg);
+    DCHECK_LE(in_batch->num_rows(), out_batch->capacity() - out_batch->num_rows());
+    int num_rows = in_batch->num_rows();
+    check_and_resize_streaming_partitions(num_rows, ht_ctx);
+
+    for (int i = 0; i < num_rows; ++i) {
+        TupleRow* row = in_batch->get_row(i);
+        uint32_t hash = 0;
+        if (!ht_ctx->eval_and_hash_probe(row, &hash)) {
+            continue;
+        }
+
+        Partition* partition = _hash_partitions[hash >> (32 - NUM_PARTITIONING_BITS)];
+        ++partition->num_input_rows;
+        if (!partition->is_spilled()) {
+            bool found = false;
+            PartitionedHashTable::Iterator it =
+                partition->hash_tbl->find_bucket(ht_ctx, hash, &found);
+            if (found) {
+                update_tuple(&partition->agg_fn_ctxs[0], it.get_tuple(), row);
+                continue;
+            }
+            if (!partition->is_streaming && !it.at_end()) {
+                Tuple* intermediate_tuple = construct_intermediate_tuple(partition->agg_fn_ctxs,
+                        NULL, partition->aggregated_row_stream.get(), &_process_batch_status);
+                if (LIKELY(intermediate_tuple != NULL)) {
+                    update_tuple(&partition->agg_fn_ctxs[0], intermediate_tuple, row);
+                    it.set_tuple(intermediate_tuple, hash);
+                    continue;
+                }
+                RETURN_IF_ERROR(_process_batch_status);
+                // No memory left for the partition's stream, stop growing it.
+                partition->is_streaming = true;
+                COUNTER_UPDATE(_num_streaming_partitions, 1);
+            }
+        }
+
+        // Pass the row through as a serialized intermediate tuple of its own.
+        int row_idx = out_batch->add_row();
+        TupleRow* out_row = out_batch->get_row(row_idx);
+        Tuple* intermediate_tuple = construct_intermediate_tuple(
+                _agg_fn_ctxs, out_batch->tuple_data_pool(), NULL, NULL);
+        update_tuple(&_agg_fn_ctxs[0], intermediate_tuple, row);
+        Tuple* output_tuple = get_output_tuple(
+                _agg_fn_ctxs, intermediate_tuple, out_batch->tuple_data_pool());
+        copy_serialized_strings(output_tuple, out_batch->tuple_data_pool());
+        out_row->set_tuple(0, output_tuple);
+        out_batch->commit_last_row();
+    }
+
+    // The serialized strings of passed through rows are owned by 'out_batch' now, free
+    // the local allocations of serialize so that they do not grow with the input.
+    for (int i = 0; i < _agg_fn_ctxs.size(); ++i) {
+        _agg_fn_ctxs[i]->impl()->free_local_allocations();
+    }
+    return Status::OK;
+}
+
 Status PartitionedAggregationNode::process_batch_false(
         RowBatch* batch, PartitionedHashTableCtx* ht_ctx) {
     return process_batch<false>(batch, ht_ctx);
@@ -0,0 +1,875 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/partitioned_hash_join_node.h"
+
+#include <sstream>
+
+#include "exec/partitioned_hash_table.inline.h"
+#include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "exprs/runtime_filter_predicate.h"
+#include "runtime/buffered_tuple_stream2.inline.h"
+#include "runtime/descriptors.h"
+#include "runtime/exec_env.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_filter_mgr.h"
+#include "runtime/runtime_state.h"
+#include "runtime/tuple_row.h"
+#include "util/debug_util.h"
+#include "util/runtime_profile.h"
+
+#include "gen_cpp/PlanNodes_types.h"
+
+using std::list;
+
+namespace palo {
+
+PartitionedHashJoinNode::PartitionedHashJoinNode(
+        ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
+        ExecNode(pool, tnode, descs),
+        _join_op(tnode.hash_join_node.join_op),
+        _runtime_state(NULL),
+        _block_mgr_client(NULL),
+        _state(PARTITIONING_BUILD),
+        _partition_pool(new ObjectPool()),
+        _input_partition(NULL),
+        _output_build_started(false),
+        _probe_batch_pos(0),
+        _probe_side_eos(false),
+        _current_probe_row(NULL),
+        _matched_probe(false),
+        _eos(false),
+        _probe_tuple_row_size(0),
+        _build_tuple_row_size(0),
+        _build_timer(NULL),
+        _build_hash_table_timer(NULL),
+        _probe_timer(NULL),
+        _build_row_counter(NULL),
+        _probe_row_counter(NULL),
+        _partitions_created(NULL),
+        _num_spilled_partitions(NULL),
+        _num_repartitions(NULL),
+        _num_build_rows_partitioned(NULL),
+        _num_probe_rows_partitioned(NULL),
+        _num_hash_buckets(NULL),
+        _max_partition_level(NULL) {
+    DCHECK_EQ(PARTITION_FANOUT, 1 << NUM_PARTITIONING_BITS);
+    _match_all_probe =
+        (_join_op == TJoinOp::LEFT_OUTER_JOIN || _join_op == TJoinOp::FULL_OUTER_JOIN);
+    _match_one_build = (_join_op == TJoinOp::LEFT_SEMI_JOIN);
+    _match_all_build =
+        (_join_op == TJoinOp::RIGHT_OUTER_JOIN || _join_op == TJoinOp::FULL_OUTER_JOIN);
+}
+
+Status PartitionedHashJoinNode::init(const TPlanNode& tnode) {
+    RETURN_IF_ERROR(ExecNode::init(tnode));
+    DCHECK(tnode.__isset.hash_join_node);
+    DCHECK_NE(_join_op, TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN);
+    const vector<TEqJoinCondition>& eq_join_conjuncts = tnode.hash_join_node.eq_join_conjuncts;
+
+    for (int i = 0; i < eq_join_conjuncts.size(); ++i) {
+        ExprContext* ctx = NULL;
+        RETURN_IF_ERROR(Expr::create_expr_tree(_pool, eq_join_conjuncts[i].left, &ctx));
+        _probe_expr_ctxs.push_back(ctx);
+        RETURN_IF_ERROR(Expr::create_expr_tree(_pool, eq_join_conjuncts[i].right, &ctx));
+        _build_expr_ctxs.push_back(ctx);
+    }
+
+    RETURN_IF_ERROR(
+        Expr::create_expr_trees(_pool, tnode.hash_join_node.other_join_conjuncts,
+                              &_other_join_conjunct_ctxs));
+
+    if (tnode.hash_join_node.__isset.runtime_filters) {
+        _runtime_filter_descs = tnode.hash_join_node.runtime_filters;
+        for (int i = 0; i < _runtime_filter_descs.size(); ++i) {
+            if (_runtime_filter_descs[i].expr_order < 0
+                    || _runtime_filter_descs[i].expr_order >= eq_join_conjuncts.size()) {
+                return Status("Invalid eq join conjunct of runtime filter.");
+            }
+        }
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::prepare(RuntimeState* state) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    RETURN_IF_ERROR(ExecNode::prepare(state));
+    _runtime_state = state;
+
+    _build_timer = ADD_TIMER(runtime_profile(), "BuildTime");
+    _build_hash_table_timer = ADD_TIMER(runtime_profile(), "BuildHashTableTime");
+    _probe_timer = ADD_TIMER(runtime_profile(), "ProbeTime");
+    _build_row_counter = ADD_COUNTER(runtime_profile(), "BuildRows", TUnit::UNIT);
+    _probe_row_counter = ADD_COUNTER(runtime_profile(), "ProbeRows", TUnit::UNIT);
+    _partitions_created = ADD_COUNTER(runtime_profile(), "PartitionsCreated", TUnit::UNIT);
+    _num_spilled_partitions = ADD_COUNTER(
+            runtime_profile(), "SpilledPartitions", TUnit::UNIT);
+    _num_repartitions = ADD_COUNTER(runtime_profile(), "NumRepartitions", TUnit::UNIT);
+    _num_build_rows_partitioned = ADD_COUNTER(
+            runtime_profile(), "BuildRowsPartitioned", TUnit::UNIT);
+    _num_probe_rows_partitioned = ADD_COUNTER(
+            runtime_profile(), "ProbeRowsPartitioned", TUnit::UNIT);
+    _num_hash_buckets = ADD_COUNTER(runtime_profile(), "HashBuckets", TUnit::UNIT);
+    _max_partition_level = ADD_COUNTER(runtime_profile(), "MaxPartitionLevel", TUnit::UNIT);
+
+    // build and probe exprs are evaluated in the context of the rows produced by our
+    // right and left children, respectively
+    RETURN_IF_ERROR(Expr::prepare(
+            _build_expr_ctxs, state, child(1)->row_desc(), expr_mem_tracker()));
+    RETURN_IF_ERROR(Expr::prepare(
+            _probe_expr_ctxs, state, child(0)->row_desc(), expr_mem_tracker()));
+
+    // _other_join_conjuncts are evaluated in the context of the rows produced by this node
+    RETURN_IF_ERROR(Expr::prepare(
+            _other_join_conjunct_ctxs, state, _row_descriptor, expr_mem_tracker()));
+
+    int num_probe_tuples = child(0)->row_desc().tuple_descriptors().size();
+    int num_build_tuples = child(1)->row_desc().tuple_descriptors().size();
+    _probe_tuple_row_size = num_probe_tuples * sizeof(Tuple*);
+    _build_tuple_row_size = num_build_tuples * sizeof(Tuple*);
+
+    // Build rows with NULL join keys never match, but they have to be kept if unmatched
+    // build rows are returned. Probe rows with NULL join keys are never looked up.
+    _ht_ctx.reset(new PartitionedHashTableCtx(_build_expr_ctxs, _probe_expr_ctxs,
+                need_to_output_unmatched_build(), false /* finds_nulls */,
+                state->fragment_hash_seed(), MAX_PARTITION_DEPTH, num_build_tuples));
+    RETURN_IF_ERROR(state->block_mgr2()->register_client(
+                min_required_buffers(), mem_tracker(), state, &_block_mgr_client));
+
+    _probe_batch.reset(new RowBatch(child(0)->row_desc(), state->batch_size(), mem_tracker()));
+
+    for (int i = 0; i < _runtime_filter_descs.size(); ++i) {
+        Expr* probe_expr = _probe_expr_ctxs[_runtime_filter_descs[i].expr_order]->root();
+        RuntimeFilterPredicate* filter = RuntimeFilterPredicate::create(_pool);
+        RETURN_IF_ERROR(filter->prepare(state, probe_expr->type(), 0, mem_tracker()));
+        filter->add_child(Expr::copy(_pool, probe_expr));
+        _runtime_filters.push_back(filter);
+    }
+
+    return Status::OK;
+}
+
+void PartitionedHashJoinNode::build_side_thread(
+        RuntimeState* state, boost::promise<Status>* status) {
+    status->set_value(construct_build_side(state));
+    // Release the thread token as soon as possible (before the main thread joins
+    // on it).
+    state->resource_pool()->release_thread_token(false);
+}
+
+Status PartitionedHashJoinNode::open(RuntimeState* state) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    RETURN_IF_ERROR(ExecNode::open(state));
+    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
+    RETURN_IF_CANCELLED(state);
+    RETURN_IF_ERROR(Expr::open(_build_expr_ctxs, state));
+    RETURN_IF_ERROR(Expr::open(_probe_expr_ctxs, state));
+    RETURN_IF_ERROR(Expr::open(_other_join_conjunct_ctxs, state));
+
+    _state = PARTITIONING_BUILD;
+    _eos = false;
+
+    // Same as HashJoinNode, construct the build side in a separate thread if we can get
+    // a thread token, so that the probe child can do any initialisation in parallel.
+    boost::promise<Status> thread_status;
+    if (state->resource_pool()->try_acquire_thread_token()) {
+        add_runtime_exec_option("Hash Table Built Asynchronously");
+        boost::thread(bind(&PartitionedHashJoinNode::build_side_thread,
+                    this, state, &thread_status));
+    } else {
+        thread_status.set_value(construct_build_side(state));
+    }
+
+    // Don't exit even if we see an error, we still need to wait for the build thread
+    // to finish.
+    Status open_status = child(0)->open(state);
+    RETURN_IF_ERROR(thread_status.get_future().get());
+    RETURN_IF_ERROR(open_status);
+
+    if (!_runtime_filters.empty()) {
+        publish_runtime_filters(state);
+    }
+
+    _state = PROCESSING_PROBE;
+    _probe_batch_pos = 0;
+    _probe_side_eos = false;
+    _current_probe_row = NULL;
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::construct_build_side(RuntimeState* state) {
+    RETURN_IF_ERROR(child(1)->open(state));
+    RETURN_IF_ERROR(create_hash_partitions(0));
+
+    // The build rows are copied into the partitions' streams, so the batch can be
+    // reused right away.
+    RowBatch build_batch(child(1)->row_desc(), state->batch_size(), mem_tracker());
+    bool eos = false;
+    do {
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(state->check_query_state());
+        RETURN_IF_ERROR(child(1)->get_next(state, &build_batch, &eos));
+        SCOPED_TIMER(_build_timer);
+        RETURN_IF_ERROR(process_build_batch(&build_batch));
+        insert_runtime_filters(&build_batch);
+        COUNTER_UPDATE(_build_row_counter, build_batch.num_rows());
+        build_batch.reset();
+    } while (!eos);
+
+    // We have consumed all of the input from the build child.
+    child(1)->close(state);
+    return build_hash_tables(state);
+}
+
+void PartitionedHashJoinNode::insert_runtime_filters(RowBatch* build_batch) {
+    for (int i = 0; i < _runtime_filters.size(); ++i) {
+        ExprContext* build_expr_ctx = _build_expr_ctxs[_runtime_filter_descs[i].expr_order];
+        for (int j = 0; j < build_batch->num_rows(); ++j) {
+            _runtime_filters[i]->insert(build_expr_ctx->get_value(build_batch->get_row(j)));
+        }
+    }
+}
+
+void PartitionedHashJoinNode::publish_runtime_filters(RuntimeState* state) {
+    for (int i = 0; i < _runtime_filters.size(); ++i) {
+        int filter_id = _runtime_filter_descs[i].filter_id;
+        std::map<int, std::vector<TPlanFragmentDestination> >::const_iterator destinations =
+            _runtime_filter_destinations.find(filter_id);
+        if (destinations == _runtime_filter_destinations.end()) {
+            continue;
+        }
+        VLOG(1) << "publish runtime filter " << filter_id << " "
+                << _runtime_filters[i]->debug_string();
+        TRuntimeFilter filter;
+        _runtime_filters[i]->to_thrift(&filter);
+        state->exec_env()->runtime_filter_mgr()->send(filter_id, filter, destinations->second);
+    }
+}
+
+Status PartitionedHashJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* eos) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
+    RETURN_IF_CANCELLED(state);
+
+    if (reached_limit() || _eos) {
+        *eos = true;
+        return Status::OK;
+    }
+
+    while (!_eos) {
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(state->check_query_state());
+
+        if (!_output_build_partitions.empty()) {
+            RETURN_IF_ERROR(output_unmatched_build(out_batch));
+            if (out_batch->at_capacity() || reached_limit()) {
+                break;
+            }
+            continue;
+        }
+
+        if (_current_probe_row != NULL || _probe_batch_pos < _probe_batch->num_rows()) {
+            // Compute max rows that should be added to out_batch
+            int64_t max_added_rows = out_batch->capacity() - out_batch->num_rows();
+            if (limit() != -1) {
+                max_added_rows = std::min(max_added_rows, limit() - rows_returned());
+            }
+            int rows_added = 0;
+            {
+                SCOPED_TIMER(_probe_timer);
+                rows_added = process_probe_batch(out_batch, max_added_rows, &_process_status);
+            }
+            if (UNLIKELY(rows_added < 0)) {
+                return _process_status;
+            }
+            _num_rows_returned += rows_added;
+            COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+            if (reached_limit() || out_batch->is_full()) {
+                break;
+            }
+        }
+
+        // Done with the current probe batch, pass on its resources, out_batch might
+        // still need them.
+        _probe_batch->transfer_resource_ownership(out_batch);
+        _probe_batch_pos = 0;
+        if (out_batch->at_capacity()) {
+            break;
+        }
+
+        if (!_probe_side_eos) {
+            RETURN_IF_ERROR(next_probe_batch(state));
+            continue;
+        }
+
+        // The current probe input is done.
+        RETURN_IF_ERROR(clean_up_hash_partitions(out_batch));
+        if (_output_build_partitions.empty() && _spilled_partitions.empty()) {
+            _eos = true;
+            break;
+        }
+        if (out_batch->at_capacity()) {
+            break;
+        }
+        if (_output_build_partitions.empty()) {
+            RETURN_IF_ERROR(prepare_next_partition(state));
+        }
+    }
+
+    COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+    *eos = _eos || reached_limit();
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::close(RuntimeState* state) {
+    if (is_closed()) {
+        return Status::OK;
+    }
+    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::CLOSE));
+
+    // Must reset _probe_batch in close() to release resources
+    _probe_batch.reset();
+    close_partitions();
+    if (_ht_ctx.get() != NULL) {
+        _ht_ctx->close();
+    }
+    if (_block_mgr_client != NULL) {
+        state->block_mgr2()->clear_reservations(_block_mgr_client);
+    }
+
+    Expr::close(_build_expr_ctxs, state);
+    Expr::close(_probe_expr_ctxs, state);
+    Expr::close(_other_join_conjunct_ctxs, state);
+    return ExecNode::close(state);
+}
+
+Status PartitionedHashJoinNode::Partition::init_build_stream() {
+    RuntimeState* state = parent->_runtime_state;
+    build_rows.reset(new BufferedTupleStream2(state, parent->child(1)->row_desc(),
+                state->block_mgr2(), parent->_block_mgr_client,
+                true /* use_initial_small_buffers */, false /* read_write */));
+    return build_rows->init(parent->id(), parent->runtime_profile(), true);
+}
+
+Status PartitionedHashJoinNode::Partition::init_probe_stream(bool* got_buffer) {
+    if (probe_rows.get() == NULL) {
+        RuntimeState* state = parent->_runtime_state;
+        probe_rows.reset(new BufferedTupleStream2(state, parent->child(0)->row_desc(),
+                    state->block_mgr2(), parent->_block_mgr_client,
+                    true /* use_initial_small_buffers */, false /* read_write */));
+        // This stream is only used to spill, no need to ever have this pinned.
+        RETURN_IF_ERROR(probe_rows->init(parent->id(), parent->runtime_profile(), false));
+    }
+    // Probe rows are appended while hash tables hold matched flags, so nothing can be
+    // spilled by then. Switch to an IO-sized buffer now, after that adding a row never
+    // needs more memory.
+    return probe_rows->switch_to_io_buffers(got_buffer);
+}
+
+Status PartitionedHashJoinNode::Partition::build_hash_table(RuntimeState* state, bool* built) {
+    DCHECK(!is_closed);
+    DCHECK(hash_tbl.get() == NULL);
+    DCHECK(build_rows->is_pinned());
+    *built = false;
+
+    // We use the upper NUM_PARTITIONING_BITS bits to pick the partition so only the
+    // remaining bits can be used for the hash table.
+    static const int64_t PHJ_MIN_HASH_TABLE_SZ = 1024;
+    int64_t num_buckets = std::max(
+            PartitionedHashTable::EstimateNumBuckets(build_rows->num_rows()),
+            PHJ_MIN_HASH_TABLE_SZ);
+    hash_tbl.reset(PartitionedHashTable::create(state, parent->_block_mgr_client,
+                parent->child(1)->row_desc().tuple_descriptors().size(), build_rows.get(),
+                1 << (32 - NUM_PARTITIONING_BITS), num_buckets));
+    if (!hash_tbl->init()) {
+        hash_tbl->close();
+        hash_tbl.reset();
+        return Status::OK;
+    }
+
+    bool got_read_buffer = true;
+    RETURN_IF_ERROR(build_rows->prepare_for_read(false, &got_read_buffer));
+    DCHECK(got_read_buffer) << "Stream is pinned";
+
+    PartitionedHashTableCtx* ctx = parent->_ht_ctx.get();
+    RowBatch batch(parent->child(1)->row_desc(), state->batch_size(), parent->mem_tracker());
+    std::vector<BufferedTupleStream2::RowIdx> indices;
+    bool eos = false;
+    while (!eos) {
+        RETURN_IF_ERROR(build_rows->get_next(&batch, &eos, &indices));
+        DCHECK_EQ(batch.num_rows(), indices.size());
+        if (!hash_tbl->check_and_resize(batch.num_rows(), ctx)) {
+            hash_tbl->close();
+            hash_tbl.reset();
+            return Status::OK;
+        }
+        for (int i = 0; i < batch.num_rows(); ++i) {
+            TupleRow* row = batch.get_row(i);
+            uint32_t hash = 0;
+            if (!ctx->eval_and_hash_build(row, &hash)) {
+                continue;
+            }
+            if (UNLIKELY(!hash_tbl->insert(ctx, indices[i], row, hash))) {
+                hash_tbl->close();
+                hash_tbl.reset();
+                return Status::OK;
+            }
+        }
+        batch.reset();
+    }
+    COUNTER_UPDATE(parent->_num_hash_buckets, hash_tbl->num_buckets());
+    *built = true;
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::Partition::spill() {
+    DCHECK(!is_closed);
+    DCHECK(!is_spilled);
+
+    if (hash_tbl.get() != NULL) {
+        hash_tbl->close();
+        hash_tbl.reset();
+    }
+
+    if (build_rows->has_write_block()) {
+        // Still partitioning the build input. Try to switch to IO-sized buffers to avoid
+        // allocating small buffers for the spilled partition, we'll try again when the
+        // small buffers are full.
+        bool got_buffer = true;
+        if (build_rows->using_small_buffers()) {
+            RETURN_IF_ERROR(build_rows->switch_to_io_buffers(&got_buffer));
+        }
+        RETURN_IF_ERROR(build_rows->unpin_stream(false));
+        if (!got_buffer) {
+            VLOG_QUERY << "Not enough memory to switch to IO-sized buffer for partition "
+                << this << " of join=" << parent->_id;
+        }
+    } else {
+        // All build rows are in the stream, nothing will be appended any more.
+        RETURN_IF_ERROR(build_rows->unpin_stream(true));
+    }
+    is_spilled = true;
+
+    COUNTER_UPDATE(parent->_num_spilled_partitions, 1);
+    if (parent->_num_spilled_partitions->value() == 1) {
+        parent->add_runtime_exec_option("Spilled");
+    }
+    return Status::OK;
+}
+
+void PartitionedHashJoinNode::Partition::close(RowBatch* batch) {
+    if (is_closed) {
+        return;
+    }
+    is_closed = true;
+    if (hash_tbl.get() != NULL) {
+        hash_tbl->close();
+        hash_tbl.reset();
+    }
+    if (build_rows.get() != NULL) {
+        if (batch == NULL) {
+            build_rows->close();
+        } else {
+            batch->add_tuple_stream(build_rows.release());
+        }
+    }
+    if (probe_rows.get() != NULL) {
+        if (batch == NULL) {
+            probe_rows->close();
+        } else {
+            batch->add_tuple_stream(probe_rows.release());
+        }
+    }
+}
+
+Status PartitionedHashJoinNode::create_hash_partitions(int level) {
+    if (level >= MAX_PARTITION_DEPTH) {
+        std::stringstream error_msg;
+        error_msg << "Cannot perform hash join at node with id " << _id << '.'
+                << " The input data was partitioned the maximum number of "
+                << MAX_PARTITION_DEPTH << " times."
+                << " This could mean there is significant skew in the data or the memory limit is"
+                << " set too low.";
+        return _runtime_state->set_mem_limit_exceeded(error_msg.str());
+    }
+    _ht_ctx->set_level(level);
+
+    DCHECK(_hash_partitions.empty());
+    for (int i = 0; i < PARTITION_FANOUT; ++i) {
+        Partition* new_partition = new Partition(this, level);
+        DCHECK(new_partition != NULL);
+        _hash_partitions.push_back(_partition_pool->add(new_partition));
+        RETURN_IF_ERROR(new_partition->init_build_stream());
+    }
+    COUNTER_UPDATE(_partitions_created, PARTITION_FANOUT);
+    if (level > _max_partition_level->value()) {
+        COUNTER_SET(_max_partition_level, level);
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::append_row(BufferedTupleStream2* stream, TupleRow* row) {
+    while (true) {
+        if (LIKELY(stream->add_row(row, &_process_status))) {
+            return Status::OK;
+        }
+        // Adding fails iff either we hit an error or there was no buffer.
+        RETURN_IF_ERROR(_process_status);
+        if (stream->using_small_buffers()) {
+            bool got_buffer = false;
+            RETURN_IF_ERROR(stream->switch_to_io_buffers(&got_buffer));
+            if (got_buffer) {
+                continue;
+            }
+        }
+        // Free some memory and try again. Every call spills one more partition, so this
+        // loop either succeeds or runs out of partitions to spill.
+        RETURN_IF_ERROR(spill_partition());
+    }
+}
+
+Status PartitionedHashJoinNode::spill_partition() {
+    int64_t max_freed_mem = 0;
+    int partition_idx = -1;
+
+    // Iterate over the partitions and pick the largest partition that is not spilled.
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_closed || partition->is_spilled) {
+            continue;
+        }
+        int64_t mem = partition->in_mem_size();
+        if (mem > max_freed_mem) {
+            max_freed_mem = mem;
+            partition_idx = i;
+        }
+    }
+    if (partition_idx == -1) {
+        // Could not find a partition to spill. This means the mem limit was just too low.
+        return _runtime_state->block_mgr2()->mem_limit_too_low_error(_block_mgr_client, id());
+    }
+    return _hash_partitions[partition_idx]->spill();
+}
+
+Status PartitionedHashJoinNode::build_hash_tables(RuntimeState* state) {
+    SCOPED_TIMER(_build_hash_table_timer);
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_spilled) {
+            continue;
+        }
+        bool built = false;
+        RETURN_IF_ERROR(partition->build_hash_table(state, &built));
+        if (!built) {
+            RETURN_IF_ERROR(partition->spill());
+        }
+    }
+
+    // Every spilled partition needs a probe stream with an IO-sized buffer before the
+    // first probe row is processed. Spilling another partition may be needed to get
+    // one, in which case we start over since that partition needs a stream as well.
+    int i = 0;
+    while (i < _hash_partitions.size()) {
+        Partition* partition = _hash_partitions[i];
+        if (!partition->is_spilled) {
+            ++i;
+            continue;
+        }
+        // No more build rows will be appended, release the write block first.
+        RETURN_IF_ERROR(partition->build_rows->unpin_stream(true));
+        bool got_buffer = false;
+        RETURN_IF_ERROR(partition->init_probe_stream(&got_buffer));
+        if (got_buffer) {
+            ++i;
+            continue;
+        }
+        RETURN_IF_ERROR(spill_partition());
+        i = 0;
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::next_probe_batch(RuntimeState* state) {
+    _probe_batch->reset();
+    _probe_batch_pos = 0;
+    if (_input_partition == NULL) {
+        RETURN_IF_ERROR(child(0)->get_next(state, _probe_batch.get(), &_probe_side_eos));
+        COUNTER_UPDATE(_probe_row_counter, _probe_batch->num_rows());
+    } else {
+        RETURN_IF_ERROR(_input_partition->probe_rows->get_next(
+                    _probe_batch.get(), &_probe_side_eos));
+        if (_state == REPARTITIONING) {
+            COUNTER_UPDATE(_num_probe_rows_partitioned, _probe_batch->num_rows());
+        }
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::clean_up_hash_partitions(RowBatch* batch) {
+    if (_state == PROBING_SPILLED_PARTITION) {
+        DCHECK(_hash_partitions.empty());
+        if (_input_partition != NULL) {
+            if (need_to_output_unmatched_build()) {
+                _output_build_partitions.push_back(_input_partition);
+            } else {
+                _input_partition->close(batch);
+            }
+            _input_partition = NULL;
+        }
+        return Status::OK;
+    }
+
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_closed) {
+            continue;
+        }
+        if (partition->is_spilled) {
+            // Skip the partitions that cannot produce any rows.
+            bool no_probe_rows = partition->probe_rows->num_rows() == 0;
+            bool no_build_rows = partition->build_rows->num_rows() == 0;
+            if ((no_probe_rows && !need_to_output_unmatched_build())
+                    || (no_build_rows && !_match_all_probe
+                        && _join_op != TJoinOp::LEFT_ANTI_JOIN)) {
+                partition->close(NULL);
+                continue;
+            }
+            RETURN_IF_ERROR(partition->probe_rows->unpin_stream(true));
+            // Push new created partitions at the front. This means a depth first walk
+            // (more finely partitioned partitions are processed first). This allows us
+            // to delete blocks earlier and bottom out the recursion earlier.
+            _spilled_partitions.push_front(partition);
+        } else if (need_to_output_unmatched_build()) {
+            _output_build_partitions.push_back(partition);
+        } else {
+            partition->close(batch);
+        }
+    }
+    _hash_partitions.clear();
+
+    if (_input_partition != NULL) {
+        // Done repartitioning the probe rows of the input partition.
+        _input_partition->close(batch);
+        _input_partition = NULL;
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::output_unmatched_build(RowBatch* out_batch) {
+    DCHECK(!_output_build_partitions.empty());
+    Partition* partition = _output_build_partitions.front();
+    DCHECK(partition->hash_tbl.get() != NULL);
+    if (!_output_build_started) {
+        if (partition->hash_tbl->size() == 0) {
+            _output_build_iterator = partition->hash_tbl->End();
+        } else {
+            _output_build_iterator = partition->hash_tbl->first_unmatched(_ht_ctx.get());
+        }
+        _output_build_started = true;
+    }
+
+    ExprContext* const* conjunct_ctxs = &_conjunct_ctxs[0];
+    int num_conjunct_ctxs = _conjunct_ctxs.size();
+    while (!out_batch->at_capacity() && !_output_build_iterator.at_end()) {
+        TupleRow* build_row = _output_build_iterator.get_row();
+        int row_idx = out_batch->add_row();
+        TupleRow* out_row = out_batch->get_row(row_idx);
+        create_output_row(out_row, NULL, build_row);
+        _output_build_iterator.next_unmatched();
+        if (eval_conjuncts(conjunct_ctxs, num_conjunct_ctxs, out_row)) {
+            out_batch->commit_last_row();
+            VLOG_ROW << "match row: " << print_row(out_row, row_desc());
+            ++_num_rows_returned;
+            if (reached_limit()) {
+                break;
+            }
+        }
+    }
+    COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+
+    if (_output_build_iterator.at_end()) {
+        // The returned rows reference the build stream, hand it over to out_batch.
+        partition->close(out_batch);
+        _output_build_partitions.pop_front();
+        _output_build_started = false;
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::prepare_next_partition(RuntimeState* state) {
+    DCHECK(_input_partition == NULL);
+    DCHECK(_hash_partitions.empty());
+    DCHECK(!_spilled_partitions.empty());
+    _input_partition = _spilled_partitions.front();
+    _spilled_partitions.pop_front();
+    DCHECK(_input_partition->is_spilled);
+
+    // The partition holds about 1 / PARTITION_FANOUT of its parent's build rows, so it
+    // often fits in memory now. Try to build its hash table directly before paying for
+    // another round of repartitioning.
+    _ht_ctx->set_level(_input_partition->level);
+    bool pinned = false;
+    RETURN_IF_ERROR(_input_partition->build_rows->pin_stream(false, &pinned));
+    if (pinned) {
+        bool built = false;
+        {
+            SCOPED_TIMER(_build_hash_table_timer);
+            RETURN_IF_ERROR(_input_partition->build_hash_table(state, &built));
+        }
+        if (built) {
+            bool got_buffer = true;
+            RETURN_IF_ERROR(_input_partition->probe_rows->prepare_for_read(true, &got_buffer));
+            if (got_buffer) {
+                _input_partition->is_spilled = false;
+                _state = PROBING_SPILLED_PARTITION;
+                _probe_side_eos = false;
+                return Status::OK;
+            }
+            _input_partition->hash_tbl->close();
+            _input_partition->hash_tbl.reset();
+        }
+        RETURN_IF_ERROR(_input_partition->build_rows->unpin_stream(true));
+    }
+
+    RETURN_IF_ERROR(repartition_build_input(state));
+    _state = REPARTITIONING;
+    _probe_side_eos = false;
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::repartition_build_input(RuntimeState* state) {
+    COUNTER_UPDATE(_num_repartitions, 1);
+    RETURN_IF_ERROR(create_hash_partitions(_input_partition->level + 1));
+
+    BufferedTupleStream2* build_rows = _input_partition->build_rows.get();
+    while (true) {
+        bool got_buffer = true;
+        RETURN_IF_ERROR(build_rows->prepare_for_read(true, &got_buffer));
+        if (got_buffer) {
+            break;
+        }
+        // Did not have a buffer to read the input stream. Spill and try again.
+        RETURN_IF_ERROR(spill_partition());
+    }
+
+    RowBatch build_batch(child(1)->row_desc(), state->batch_size(), mem_tracker());
+    bool eos = false;
+    while (!eos) {
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(build_rows->get_next(&build_batch, &eos));
+        SCOPED_TIMER(_build_timer);
+        RETURN_IF_ERROR(process_build_batch(&build_batch));
+        build_batch.reset();
+    }
+    int64_t num_input_rows = build_rows->num_rows();
+    COUNTER_UPDATE(_num_build_rows_partitioned, num_input_rows);
+    build_rows->close();
+
+    // Reserve the buffer to read the probe rows before building the hash tables, since
+    // spilling is not possible any more once probing has started.
+    RETURN_IF_ERROR(prepare_spilled_probe_read());
+    RETURN_IF_ERROR(build_hash_tables(state));
+
+    // Check if there was any reduction in the size of partitions after repartitioning.
+    int64_t largest_partition = 0;
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_spilled) {
+            largest_partition = std::max(largest_partition, partition->build_rows->num_rows());
+        }
+    }
+    if (num_input_rows > 0 && largest_partition == num_input_rows) {
+        Status status = Status::MEM_LIMIT_EXCEEDED;
+        std::stringstream error_msg;
+        error_msg << "Cannot perform hash join at node with id " << _id << ". "
+                << "Repartitioning did not reduce the size of a spilled partition. "
+                << "Repartitioning level " << _input_partition->level + 1
+                << ". Number of rows " << num_input_rows << " .";
+        status.add_error_msg(error_msg.str());
+        return status;
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::prepare_spilled_probe_read() {
+    BufferedTupleStream2* probe_rows = _input_partition->probe_rows.get();
+    while (true) {
+        bool got_buffer = true;
+        RETURN_IF_ERROR(probe_rows->prepare_for_read(true, &got_buffer));
+        if (got_buffer) {
+            return Status::OK;
+        }
+        RETURN_IF_ERROR(spill_partition());
+    }
+}
+
+void PartitionedHashJoinNode::close_partitions() {
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        _hash_partitions[i]->close(NULL);
+    }
+    for (list<Partition*>::iterator it = _spilled_partitions.begin();
+            it != _spilled_partitions.end(); ++it) {
+        (*it)->close(NULL);
+    }
+    for (list<Partition*>::iterator it = _output_build_partitions.begin();
+            it != _output_build_partitions.end(); ++it) {
+        (*it)->close(NULL);
+    }
+    if (_input_partition != NULL) {
+        _input_partition->close(NULL);
+        _input_partition = NULL;
+    }
+    _hash_partitions.clear();
+    _spilled_partitions.clear();
+    _output_build_partitions.clear();
+    _partition_pool->clear();
+}
+
+void PartitionedHashJoinNode::create_output_row(
+        TupleRow* out, TupleRow* probe, TupleRow* build) {
+    uint8_t* out_ptr = reinterpret_cast<uint8_t*>(out);
+    if (probe == NULL) {
+        memset(out_ptr, 0, _probe_tuple_row_size);
+    } else {
+        memcpy(out_ptr, probe, _probe_tuple_row_size);
+    }
+
+    if (build == NULL) {
+        memset(out_ptr + _probe_tuple_row_size, 0, _build_tuple_row_size);
+    } else {
+        memcpy(out_ptr + _probe_tuple_row_size, build, _build_tuple_row_size);
+    }
+}
+
+void PartitionedHashJoinNode::debug_string(
+        int indentation_level, std::stringstream* out) const {
+    *out << std::string(indentation_level * 2, ' ');
+    *out << "PartitionedHashJoinNode(join_op=" << _join_op
+        << " state=" << _state
+        << " hash_partitions=" << _hash_partitions.size()
+        << " spilled_partitions=" << _spilled_partitions.size()
+        << " probe_exprs=" << Expr::debug_string(_probe_expr_ctxs)
+        << " build_exprs=" << Expr::debug_string(_build_expr_ctxs);
+    ExecNode::debug_string(indentation_level, out);
+    *out << ")";
+}
+
+}
@@ -0,0 +1,338 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_EXEC_PARTITIONED_HASH_JOIN_NODE_H
+#define BDG_PALO_BE_SRC_EXEC_PARTITIONED_HASH_JOIN_NODE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "exec/exec_node.h"
+#include "exec/partitioned_hash_table.h"
+#include "runtime/buffered_block_mgr2.h"
+#include "runtime/buffered_tuple_stream2.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "gen_cpp/PlanNodes_types.h"
+
+namespace palo {
+
+class ExprContext;
+class RowBatch;
+class RuntimeFilterPredicate;
+class TupleRow;
+
+// Node for partitioned hash joins that can spill to disk under memory pressure.
+// The algorithm has the same shape as PartitionedAggregationNode:
+//  1. Rows from the build input (child(1), or a spilled partition) are hashed and
+//     appended to one of PARTITION_FANOUT build streams (_hash_partitions). The upper
+//     NUM_PARTITIONING_BITS bits of the hash pick the partition, the remaining bits
+//     are used by the partition's hash table.
+//  2. When a build stream cannot get a buffer, the largest in-memory partition is
+//     spilled: its stream is unpinned and written to disk by BufferedBlockMgr2.
+//  3. Once the build input is consumed, a hash table is built for every partition that
+//     is still in memory; partitions that do not fit are spilled as well. Spilled
+//     partitions get a probe stream.
+//  4. Probe rows (child(0), or the probe stream of a spilled partition) are hashed the
+//     same way. Rows of in-memory partitions are joined right away, rows of spilled
+//     partitions are appended to the partition's probe stream.
+//  5. When the probe input is consumed, unmatched build rows of in-memory partitions
+//     are returned for right outer, full outer and right anti joins. Spilled partitions
+//     are then processed one by one: if the build side fits in memory now, its hash
+//     table is built directly; otherwise it is repartitioned with the next hash seed
+//     and we go back to 1.
+//
+// Spilling is only done before the first probe row is processed, so the matched flags
+// of the hash tables never have to be written out.
+//
+// Unlike HashJoinNode the build side is not pushed down to the scan nodes as IN
+// predicates, and NULL_AWARE_LEFT_ANTI_JOIN is not supported. Joins which need either
+// of them are still executed by HashJoinNode, see ExecNode::create_node().
+// The runtime filters planned for the probe side fragment only check min and max, as
+// the build side may not fit in memory.
+class PartitionedHashJoinNode : public ExecNode {
+public:
+    PartitionedHashJoinNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
+    // a null dtor to pass codestyle check
+    virtual ~PartitionedHashJoinNode() {}
+
+    virtual Status init(const TPlanNode& tnode);
+    virtual Status prepare(RuntimeState* state);
+    virtual Status open(RuntimeState* state);
+    virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
+    virtual Status close(RuntimeState* state);
+
+    // Same as HashJoinNode::set_runtime_filter_destinations().
+    void set_runtime_filter_destinations(
+            const std::map<int, std::vector<TPlanFragmentDestination> >& destinations) {
+        _runtime_filter_destinations = destinations;
+    }
+
+protected:
+    virtual void debug_string(int indentation_level, std::stringstream* out) const;
+
+private:
+    struct Partition;
+
+    // Number of partitions to create at each level. Must be a power of 2.
+    static const int PARTITION_FANOUT = 16;
+
+    // Needs to be the log(PARTITION_FANOUT).
+    static const int NUM_PARTITIONING_BITS = 4;
+
+    // Maximum number of times we will repartition. Note that we need to have at least
+    // as many SEED_PRIMES in PartitionedHashTableCtx.
+    static const int MAX_PARTITION_DEPTH = 16;
+
+    enum HashJoinState {
+        // Partitioning the build input into _hash_partitions.
+        PARTITIONING_BUILD,
+        // Probing with rows from child(0).
+        PROCESSING_PROBE,
+        // Probing the hash table of _input_partition, a spilled partition whose build
+        // rows fit in memory, with the rows of its probe stream.
+        PROBING_SPILLED_PARTITION,
+        // Probing the repartitioned build side of _input_partition with the rows of its
+        // probe stream.
+        REPARTITIONING
+    };
+
+    // A partition of the build and probe input. Partitions start with small buffers
+    // (regardless of the level) to keep the memory footprint of small joins low.
+    struct Partition {
+        Partition(PartitionedHashJoinNode* parent, int level) :
+                parent(parent), is_closed(false), is_spilled(false), level(level) {}
+
+        // Creates build_rows and reserves its first buffer.
+        Status init_build_stream();
+
+        // Creates probe_rows with an IO-sized write buffer. *got_buffer is false if
+        // there was no buffer for the stream.
+        Status init_probe_stream(bool* got_buffer);
+
+        // Builds the hash table over the (pinned) build_rows. *built is false if there
+        // was not enough memory, in which case the partition is left without hash table.
+        Status build_hash_table(RuntimeState* state, bool* built);
+
+        // Drops the hash table and unpins build_rows.
+        Status spill();
+
+        // Closes the streams and the hash table. Idempotent. If 'batch' is non-NULL, the
+        // streams are attached to it since the rows returned so far may still reference
+        // them.
+        void close(RowBatch* batch);
+
+        // Bytes that are freed if this partition is spilled.
+        int64_t in_mem_size() const {
+            int64_t size = build_rows->bytes_in_mem(false);
+            if (hash_tbl.get() != NULL) {
+                size += hash_tbl->byte_size();
+            }
+            return size;
+        }
+
+        PartitionedHashJoinNode* parent;
+
+        bool is_closed;
+        bool is_spilled;
+
+        // Number of times rows of this partition have been repartitioned. Partitions
+        // created from the children's input have level 0.
+        const int level;
+
+        // Build rows of this partition. Pinned unless the partition is spilled.
+        boost::scoped_ptr<BufferedTupleStream2> build_rows;
+
+        // Probe rows of a spilled partition. Always unpinned.
+        boost::scoped_ptr<BufferedTupleStream2> probe_rows;
+
+        // Hash table over build_rows, NULL if spilled.
+        boost::scoped_ptr<PartitionedHashTable> hash_tbl;
+    };
+
+    // Supervises construct_build_side in a separate thread, and
+    // returns its status in the promise parameter.
+    void build_side_thread(RuntimeState* state, boost::promise<Status>* status);
+
+    // Consumes all rows of child(1) into _hash_partitions and prepares for probing.
+    Status construct_build_side(RuntimeState* state);
+
+    // Partitions the rows of 'build_batch' into the build streams of _hash_partitions.
+    Status process_build_batch(RowBatch* build_batch);
+
+    // Adds the build values of 'build_batch' to _runtime_filters.
+    void insert_runtime_filters(RowBatch* build_batch);
+
+    // Sends _runtime_filters to the instances in _runtime_filter_destinations.
+    void publish_runtime_filters(RuntimeState* state);
+
+    // Builds the hash tables of all in-memory partitions of _hash_partitions, spilling
+    // the ones that do not fit, and creates the probe streams of spilled partitions.
+    Status build_hash_tables(RuntimeState* state);
+
+    // Creates PARTITION_FANOUT new partitions of 'level' in _hash_partitions.
+    Status create_hash_partitions(int level);
+
+    // Appends 'row' to 'stream', switching to IO-sized buffers and spilling partitions
+    // as necessary.
+    Status append_row(BufferedTupleStream2* stream, TupleRow* row);
+
+    // Spills the in-memory partition of _hash_partitions that uses most memory.
+    Status spill_partition();
+
+    // Gets the next probe batch into _probe_batch, from child(0) or from the probe stream
+    // of _input_partition.
+    Status next_probe_batch(RuntimeState* state);
+
+    // Joins the rows of _probe_batch starting at _probe_batch_pos and adds the results to
+    // 'out_batch'. Rows that hash to a spilled partition are appended to its probe
+    // stream. Returns the number of rows added, or -1 with *status set on error.
+    // Stops when 'out_batch' is full or 'max_added_rows' rows have been added.
+    int process_probe_batch(RowBatch* out_batch, int max_added_rows, Status* status);
+
+    // Called when the current probe input is consumed. Moves spilled partitions to
+    // _spilled_partitions, the ones with unmatched build rows to return to
+    // _output_build_partitions, and closes the rest, attaching their streams to 'batch'.
+    Status clean_up_hash_partitions(RowBatch* batch);
+
+    // Returns the unmatched build rows of the front of _output_build_partitions.
+    Status output_unmatched_build(RowBatch* out_batch);
+
+    // Takes the next partition from _spilled_partitions and prepares to probe it, either
+    // by building its hash table in memory or by repartitioning it.
+    Status prepare_next_partition(RuntimeState* state);
+
+    // Repartitions the build rows of _input_partition into _hash_partitions.
+    Status repartition_build_input(RuntimeState* state);
+
+    // Prepares the probe stream of _input_partition for reading.
+    Status prepare_spilled_probe_read();
+
+    // Returns the partition 'hash' belongs to in the current state.
+    Partition* partition_of(uint32_t hash) {
+        if (_state == PROBING_SPILLED_PARTITION) {
+            return _input_partition;
+        }
+        return _hash_partitions[hash >> (32 - NUM_PARTITIONING_BITS)];
+    }
+
+    // Returns true if build rows that were never matched are returned.
+    bool need_to_output_unmatched_build() const {
+        return _join_op == TJoinOp::RIGHT_OUTER_JOIN
+                || _join_op == TJoinOp::FULL_OUTER_JOIN
+                || _join_op == TJoinOp::RIGHT_ANTI_JOIN;
+    }
+
+    // Closes all the partitions owned by this node.
+    void close_partitions();
+
+    // Write combined row, consisting of probe_row and build_row, to out_row.
+    void create_output_row(TupleRow* out_row, TupleRow* probe_row, TupleRow* build_row);
+
+    // We need one buffer per partition for the build streams and one for the probe
+    // streams of spilled partitions, plus one buffer for each of the build and probe
+    // streams of the spilled partition being processed.
+    int min_required_buffers() const {
+        return 2 * PARTITION_FANOUT + 2;
+    }
+
+    TJoinOp::type _join_op;
+
+    // derived from _join_op
+    bool _match_all_probe;  // output all rows coming from the probe input
+    bool _match_one_build;  // match at most one build row to each probe row
+    bool _match_all_build;  // output all rows coming from the build input
+
+    // our equi-join predicates "<lhs> = <rhs>" are separated into
+    // _build_exprs (over child(1)) and _probe_exprs (over child(0))
+    std::vector<ExprContext*> _probe_expr_ctxs;
+    std::vector<ExprContext*> _build_expr_ctxs;
+
+    // non-equi-join conjuncts from the JOIN clause
+    std::vector<ExprContext*> _other_join_conjunct_ctxs;
+
+    // Filters published to the scan nodes of the probe side fragment once the build
+    // side is consumed, _runtime_filters[i] is built for _runtime_filter_descs[i].
+    std::vector<TRuntimeFilterDesc> _runtime_filter_descs;
+    std::map<int, std::vector<TPlanFragmentDestination> > _runtime_filter_destinations;
+    std::vector<RuntimeFilterPredicate*> _runtime_filters;
+
+    RuntimeState* _runtime_state;
+    BufferedBlockMgr2::Client* _block_mgr_client;
+
+    // Used for hashing and comparing rows of all partitions.
+    boost::scoped_ptr<PartitionedHashTableCtx> _ht_ctx;
+
+    HashJoinState _state;
+
+    // Status of process_probe_batch(), which returns the number of rows added instead.
+    Status _process_status;
+
+    // Object pool that holds the Partition objects.
+    boost::scoped_ptr<ObjectPool> _partition_pool;
+
+    // Partitions the current build/probe input is partitioned into.
+    std::vector<Partition*> _hash_partitions;
+
+    // Spilled partitions that need to be processed.
+    std::list<Partition*> _spilled_partitions;
+
+    // In-memory partitions whose unmatched build rows still need to be returned.
+    std::list<Partition*> _output_build_partitions;
+
+    // The spilled partition being processed, NULL while processing child(0).
+    Partition* _input_partition;
+
+    // Iterator over the unmatched build rows of _output_build_partitions.front().
+    PartitionedHashTable::Iterator _output_build_iterator;
+    bool _output_build_started;
+
+    boost::scoped_ptr<RowBatch> _probe_batch;
+    int _probe_batch_pos;  // current scan pos in _probe_batch
+    bool _probe_side_eos;  // if true, the current probe input has no more rows
+    TupleRow* _current_probe_row;
+    bool _matched_probe;  // if true, we have matched the current probe row
+    PartitionedHashTable::Iterator _hash_tbl_iterator;
+    bool _eos;  // if true, nothing left to return in get_next()
+
+    // Size of the TupleRow (just the Tuple ptrs) from the build (right) and probe (left)
+    // sides.
+    int _probe_tuple_row_size;
+    int _build_tuple_row_size;
+
+    RuntimeProfile::Counter* _build_timer;   // time to partition the build side
+    RuntimeProfile::Counter* _build_hash_table_timer;   // time to build hash tables
+    RuntimeProfile::Counter* _probe_timer;   // time to probe
+    RuntimeProfile::Counter* _build_row_counter;   // num build rows
+    RuntimeProfile::Counter* _probe_row_counter;   // num probe rows
+    RuntimeProfile::Counter* _partitions_created;
+    RuntimeProfile::Counter* _num_spilled_partitions;
+    RuntimeProfile::Counter* _num_repartitions;
+    RuntimeProfile::Counter* _num_build_rows_partitioned;
+    RuntimeProfile::Counter* _num_probe_rows_partitioned;
+    RuntimeProfile::Counter* _num_hash_buckets;
+    RuntimeProfile::Counter* _max_partition_level;
+};
+
+}
+
+#endif
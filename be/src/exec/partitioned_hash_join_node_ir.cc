@@ -0,0 +1,184 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/partitioned_hash_join_node.h"
+
+#include "exec/partitioned_hash_table.inline.h"
+#include "runtime/buffered_tuple_stream2.inline.h"
+#include "runtime/row_batch.h"
+#include "runtime/tuple_row.h"
+
+namespace palo {
+
+int PartitionedHashJoinNode::process_probe_batch(
+        RowBatch* out_batch, int max_added_rows, Status* status) {
+    DCHECK_GT(max_added_rows, 0);
+    int row_idx = out_batch->add_rows(max_added_rows);
+    DCHECK(row_idx != RowBatch::INVALID_ROW_INDEX);
+    uint8_t* out_row_mem = reinterpret_cast<uint8_t*>(out_batch->get_row(row_idx));
+    TupleRow* out_row = reinterpret_cast<TupleRow*>(out_row_mem);
+
+    int rows_returned = 0;
+    int probe_rows = _probe_batch->num_rows();
+
+    ExprContext* const* other_conjunct_ctxs = &_other_join_conjunct_ctxs[0];
+    int num_other_conjunct_ctxs = _other_join_conjunct_ctxs.size();
+
+    ExprContext* const* conjunct_ctxs = &_conjunct_ctxs[0];
+    int num_conjunct_ctxs = _conjunct_ctxs.size();
+
+    PartitionedHashTableCtx* ht_ctx = _ht_ctx.get();
+
+    while (true) {
+        if (_current_probe_row != NULL) {
+            // Create output row for each matching build row
+            while (!_hash_tbl_iterator.at_end()) {
+                if ((_join_op == TJoinOp::RIGHT_SEMI_JOIN
+                            || _join_op == TJoinOp::RIGHT_ANTI_JOIN)
+                        && _hash_tbl_iterator.is_matched()) {
+                    // We have already matched this build row, continue to next match.
+                    _hash_tbl_iterator.next_duplicate();
+                    continue;
+                }
+
+                TupleRow* matched_build_row = _hash_tbl_iterator.get_row();
+                create_output_row(out_row, _current_probe_row, matched_build_row);
+                if (!eval_conjuncts(other_conjunct_ctxs, num_other_conjunct_ctxs, out_row)) {
+                    _hash_tbl_iterator.next_duplicate();
+                    continue;
+                }
+
+                // we have a match for the purpose of the (outer?) join as soon as we
+                // satisfy the JOIN clause conjuncts
+                _matched_probe = true;
+                if (_match_all_build || _join_op == TJoinOp::RIGHT_SEMI_JOIN
+                        || _join_op == TJoinOp::RIGHT_ANTI_JOIN) {
+                    // remember that we matched this build row
+                    _hash_tbl_iterator.set_matched();
+                }
+
+                // left_anti_join: equal match won't return
+                if (_join_op == TJoinOp::LEFT_ANTI_JOIN) {
+                    _hash_tbl_iterator.set_at_end();
+                    break;
+                }
+                // right_anti_join: matched build rows are never returned
+                if (_join_op == TJoinOp::RIGHT_ANTI_JOIN) {
+                    _hash_tbl_iterator.next_duplicate();
+                    continue;
+                }
+
+                // Handle left semi-join
+                if (_match_one_build) {
+                    _hash_tbl_iterator.set_at_end();
+                } else {
+                    _hash_tbl_iterator.next_duplicate();
+                }
+
+                if (eval_conjuncts(conjunct_ctxs, num_conjunct_ctxs, out_row)) {
+                    ++rows_returned;
+
+                    // Filled up out batch or hit limit
+                    if (UNLIKELY(rows_returned == max_added_rows)) {
+                        goto end;
+                    }
+
+                    // Advance to next out row
+                    out_row_mem += out_batch->row_byte_size();
+                    out_row = reinterpret_cast<TupleRow*>(out_row_mem);
+                }
+            }
+
+            // Handle left outer-join and left anti-join
+            if (!_matched_probe
+                    && (_match_all_probe || _join_op == TJoinOp::LEFT_ANTI_JOIN)) {
+                create_output_row(out_row, _current_probe_row, NULL);
+                _matched_probe = true;
+
+                if (eval_conjuncts(conjunct_ctxs, num_conjunct_ctxs, out_row)) {
+                    ++rows_returned;
+
+                    if (UNLIKELY(rows_returned == max_added_rows)) {
+                        _current_probe_row = NULL;
+                        goto end;
+                    }
+
+                    // Advance to next out row
+                    out_row_mem += out_batch->row_byte_size();
+                    out_row = reinterpret_cast<TupleRow*>(out_row_mem);
+                }
+            }
+            _current_probe_row = NULL;
+        }
+
+        // Advance to the next probe row
+        if (UNLIKELY(_probe_batch_pos == probe_rows)) {
+            goto end;
+        }
+        TupleRow* probe_row = _probe_batch->get_row(_probe_batch_pos++);
+        _matched_probe = false;
+        _hash_tbl_iterator.set_at_end();
+
+        uint32_t hash = 0;
+        if (!ht_ctx->eval_and_hash_probe(probe_row, &hash)) {
+            // A NULL join key never matches, but the row may still be returned by
+            // outer and anti joins.
+            _current_probe_row = probe_row;
+            continue;
+        }
+
+        Partition* partition = partition_of(hash);
+        if (partition->is_spilled) {
+            // The build side of this partition is on disk, keep the probe row for
+            // later. The stream has an IO-sized buffer reserved, see build_hash_tables().
+            if (UNLIKELY(!partition->probe_rows->add_row(probe_row, status))) {
+                if (status->ok()) {
+                    *status = Status("Failed to append a probe row to a spilled partition");
+                }
+                out_batch->commit_rows(rows_returned);
+                return -1;
+            }
+            continue;
+        }
+        _hash_tbl_iterator = partition->hash_tbl->find(ht_ctx, hash);
+        _current_probe_row = probe_row;
+    }
+
+end:
+    out_batch->commit_rows(rows_returned);
+    return rows_returned;
+}
+
+Status PartitionedHashJoinNode::process_build_batch(RowBatch* build_batch) {
+    PartitionedHashTableCtx* ht_ctx = _ht_ctx.get();
+    for (int i = 0; i < build_batch->num_rows(); ++i) {
+        TupleRow* build_row = build_batch->get_row(i);
+        uint32_t hash = 0;
+        if (!ht_ctx->eval_and_hash_build(build_row, &hash)) {
+            // Rows with NULL join keys are only needed to return unmatched build rows.
+            continue;
+        }
+        Partition* partition = _hash_partitions[hash >> (32 - NUM_PARTITIONING_BITS)];
+        RETURN_IF_ERROR(append_row(partition->build_rows.get(), build_row));
+    }
+    return Status::OK;
+}
+
+}
@@ -0,0 +1,401 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_SRC_EXEC_SWISS_HASH_TABLE_H
+#define BDG_PALO_BE_SRC_EXEC_SWISS_HASH_TABLE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "common/compiler_util.h"
+#include "common/logging.h"
+#include "gutil/macros.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/string_value.hpp"
+#include "util/bit_util.h"
+#include "util/hash_util.hpp"
+
+namespace palo {
+
+// Hash functions for SwissHashTable. The table takes the group from the high bits
+// and the tag from the low 7 bits of the hash, so all 64 bits have to be mixed.
+// Integer keys, the common case of single column joins and group bys, are mixed
+// with a few multiplications instead of hashing their bytes.
+template<typename Key>
+struct SwissHash {
+    uint64_t operator()(const Key& key) const {
+        return HashUtil::murmur_hash64A(&key, sizeof(Key), 0);
+    }
+};
+
+// Finalizer of MurmurHash3, a bijection so distinct integers never collide.
+inline uint64_t swiss_hash_mix(uint64_t v) {
+    v ^= v >> 33;
+    v *= 0xff51afd7ed558ccdULL;
+    v ^= v >> 33;
+    v *= 0xc4ceb9fe1a85ec53ULL;
+    v ^= v >> 33;
+    return v;
+}
+
+#define SWISS_HASH_INTEGER(TYPE) \
+    template<> \
+    struct SwissHash<TYPE> { \
+        uint64_t operator()(TYPE key) const { \
+            return swiss_hash_mix(static_cast<uint64_t>(key)); \
+        } \
+    };
+
+SWISS_HASH_INTEGER(int8_t)
+SWISS_HASH_INTEGER(uint8_t)
+SWISS_HASH_INTEGER(int16_t)
+SWISS_HASH_INTEGER(uint16_t)
+SWISS_HASH_INTEGER(int32_t)
+SWISS_HASH_INTEGER(uint32_t)
+SWISS_HASH_INTEGER(int64_t)
+SWISS_HASH_INTEGER(uint64_t)
+
+#undef SWISS_HASH_INTEGER
+
+template<>
+struct SwissHash<__int128> {
+    uint64_t operator()(__int128 key) const {
+        uint64_t low = static_cast<uint64_t>(key);
+        uint64_t high = static_cast<uint64_t>(key >> 64);
+        return swiss_hash_mix(low ^ swiss_hash_mix(high));
+    }
+};
+
+template<>
+struct SwissHash<StringValue> {
+    uint64_t operator()(const StringValue& key) const {
+        return HashUtil::murmur_hash64A(key.ptr, key.len, 0);
+    }
+};
+
+// Open addressing hash table with the hash tags stored inline, in the style of
+// Swiss tables.
+//
+// Slots are split into groups of GROUP_SIZE. For each slot, a control byte holds
+// EMPTY or the low 7 bits (the tag) of the hash of the key in the slot. A lookup
+// starts at the group picked by the high bits of the hash and compares the tag
+// with all the control bytes of the group in one SSE2 instruction, so keys are only
+// compared for slots whose tag matches (1/128 of the others). Groups are probed
+// linearly until one has an empty slot. The table is kept at most 7/8 full.
+//
+// Compared to HashTable and PartitionedHashTable, there are no nodes in separate
+// memory: a lookup usually reads one group of control bytes and one slot. Lookups of
+// a batch of keys can prefetch all their groups first, see find_batch().
+//
+// Keys are unique. Joins with duplicate build keys can keep the head of a list of
+// build rows in the value. Key and Value are copied with memcpy when the table
+// grows, so they must be trivially copyable, e.g. integers, StringValue or TupleRow*
+// pointing to memory owned by the caller. Removing is not supported. The table is
+// not thread safe.
+template<typename Key, typename Value,
+         typename Hash = SwissHash<Key>, typename Equal = std::equal_to<Key> >
+class SwissHashTable {
+public:
+    struct Entry {
+        Key key;
+        Value value;
+    };
+
+    static const int GROUP_SIZE = 16;
+
+    // Number of keys find_batch() hashes and prefetches before probing.
+    static const int BATCH_SIZE = 32;
+
+    // Memory is tracked against 'mem_tracker', which must outlive the table.
+    // init() sizes the table to hold 'expected_size' keys without growing.
+    SwissHashTable(MemTracker* mem_tracker, int64_t expected_size = 0) :
+            _mem_tracker(mem_tracker),
+            _expected_size(expected_size),
+            _ctrl(NULL),
+            _slots(NULL),
+            _num_groups(0),
+            _size(0),
+            _max_size(0) {
+        DCHECK(mem_tracker != NULL);
+    }
+
+    ~SwissHashTable() {
+        if (_ctrl != NULL) {
+            free_arrays(_ctrl, _slots, _num_groups);
+        }
+    }
+
+    // Allocates the initial groups. Must be called before any other function.
+    // Returns false if the memory limit of the mem tracker would be exceeded or the
+    // allocation fails, in which case nothing is consumed.
+    bool init() {
+        DCHECK(_ctrl == NULL);
+        int64_t num_groups = 1;
+        if (_expected_size > 0) {
+            // At most 7/8 of the slots are used.
+            int64_t num_slots = _expected_size + _expected_size / 7 + 1;
+            num_groups = BitUtil::next_power_of_two(
+                    (num_slots + GROUP_SIZE - 1) / GROUP_SIZE);
+        }
+        return allocate(num_groups);
+    }
+
+    int64_t size() const {
+        return _size;
+    }
+
+    int64_t capacity() const {
+        return _num_groups * GROUP_SIZE;
+    }
+
+    // Bytes of the control bytes and slots.
+    int64_t byte_size() const {
+        return _num_groups * GROUP_SIZE * (1 + sizeof(Entry));
+    }
+
+    uint64_t hash(const Key& key) const {
+        return _hash(key);
+    }
+
+    // Returns the entry of 'key', NULL if it is not in the table.
+    Entry* ALWAYS_INLINE find(const Key& key) {
+        return find(key, _hash(key));
+    }
+
+    // Same as above, with 'hash' being hash(key).
+    Entry* ALWAYS_INLINE find(const Key& key, uint64_t hash) {
+        int8_t tag = tag_of(hash);
+        int64_t group = group_of(hash);
+        while (true) {
+            uint32_t mask = match(group, tag);
+            while (mask != 0) {
+                Entry* entry = &_slots[group * GROUP_SIZE + __builtin_ctz(mask)];
+                if (LIKELY(_equal(entry->key, key))) {
+                    return entry;
+                }
+                mask &= mask - 1;
+            }
+            if (LIKELY(match(group, EMPTY) != 0)) {
+                return NULL;
+            }
+            group = (group + 1) & (_num_groups - 1);
+        }
+    }
+
+    // Returns the entry of 'key', inserting it if it is not in the table. *inserted is
+    // set to whether it was inserted, in which case the value is value-initialized.
+    // Pointers to entries are invalidated when an insert grows the table. Returns NULL
+    // if the table is full and cannot grow because of the memory limit, the table is
+    // left unchanged then.
+    Entry* ALWAYS_INLINE insert(const Key& key, bool* inserted) {
+        return insert(key, _hash(key), inserted);
+    }
+
+    // Same as above, with 'hash' being hash(key).
+    Entry* ALWAYS_INLINE insert(const Key& key, uint64_t hash, bool* inserted) {
+        if (UNLIKELY(_size >= _max_size)) {
+            if (UNLIKELY(!resize(_num_groups * 2))) {
+                // Keys already in the table are still returned, only new keys fail.
+                Entry* entry = find(key, hash);
+                if (entry != NULL) {
+                    *inserted = false;
+                }
+                return entry;
+            }
+        }
+        int8_t tag = tag_of(hash);
+        int64_t group = group_of(hash);
+        while (true) {
+            uint32_t mask = match(group, tag);
+            while (mask != 0) {
+                Entry* entry = &_slots[group * GROUP_SIZE + __builtin_ctz(mask)];
+                if (LIKELY(_equal(entry->key, key))) {
+                    *inserted = false;
+                    return entry;
+                }
+                mask &= mask - 1;
+            }
+            uint32_t empty_mask = match(group, EMPTY);
+            if (LIKELY(empty_mask != 0)) {
+                // Nothing is ever removed, so the key is not in a later group.
+                int64_t slot = group * GROUP_SIZE + __builtin_ctz(empty_mask);
+                _ctrl[slot] = tag;
+                Entry* entry = &_slots[slot];
+                entry->key = key;
+                entry->value = Value();
+                ++_size;
+                *inserted = true;
+                return entry;
+            }
+            group = (group + 1) & (_num_groups - 1);
+        }
+    }
+
+    // Prefetches the memory find(key, hash) and insert(key, hash) start with.
+    void ALWAYS_INLINE prefetch(uint64_t hash) const {
+        int64_t group = group_of(hash);
+        __builtin_prefetch(_ctrl + group * GROUP_SIZE);
+        __builtin_prefetch(_slots + group * GROUP_SIZE);
+    }
+
+    // Looks up 'num_keys' keys and sets entries[i] to the entry of keys[i], or NULL.
+    // Keys are hashed and their groups prefetched BATCH_SIZE at a time before
+    // probing, so the cache misses of a batch overlap instead of being serialized.
+    void find_batch(const Key* keys, int num_keys, Entry** entries) {
+        uint64_t hashes[BATCH_SIZE];
+        for (int begin = 0; begin < num_keys; begin += BATCH_SIZE) {
+            int n = std::min(num_keys - begin, static_cast<int>(BATCH_SIZE));
+            for (int i = 0; i < n; ++i) {
+                hashes[i] = _hash(keys[begin + i]);
+                prefetch(hashes[i]);
+            }
+            for (int i = 0; i < n; ++i) {
+                entries[begin + i] = find(keys[begin + i], hashes[i]);
+            }
+        }
+    }
+
+    // Calls fn(Entry*) for every entry, in no particular order.
+    template<typename Fn>
+    void for_each(Fn fn) {
+        int64_t num_slots = capacity();
+        for (int64_t i = 0; i < num_slots; ++i) {
+            if (_ctrl[i] != EMPTY) {
+                fn(&_slots[i]);
+            }
+        }
+    }
+
+private:
+    static const int8_t EMPTY = -128;
+
+    static int8_t tag_of(uint64_t hash) {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    int64_t group_of(uint64_t hash) const {
+        return (hash >> 7) & (_num_groups - 1);
+    }
+
+    // Bit i of the result is set if control byte i of 'group' equals 'value'.
+    uint32_t ALWAYS_INLINE match(int64_t group, int8_t value) const {
+        const int8_t* ctrl = _ctrl + group * GROUP_SIZE;
+#ifdef __SSE2__
+        __m128i ctrl_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_bytes, _mm_set1_epi8(value)));
+#else
+        uint32_t mask = 0;
+        for (int i = 0; i < GROUP_SIZE; ++i) {
+            mask |= static_cast<uint32_t>(ctrl[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Replaces the arrays with empty ones of 'num_groups' groups, the old arrays are
+    // neither freed nor released. Returns false without changing anything if the
+    // memory limit would be exceeded or malloc fails.
+    bool allocate(int64_t num_groups) {
+        int64_t num_slots = num_groups * GROUP_SIZE;
+        int64_t bytes = num_slots * (1 + sizeof(Entry));
+        if (!_mem_tracker->try_consume(bytes)) {
+            return false;
+        }
+        int8_t* ctrl = reinterpret_cast<int8_t*>(malloc(num_slots));
+        Entry* slots = reinterpret_cast<Entry*>(malloc(num_slots * sizeof(Entry)));
+        if (UNLIKELY(ctrl == NULL || slots == NULL)) {
+            LOG(WARNING) << "Failed to allocate " << bytes << " bytes for hash table.";
+            free_arrays(ctrl, slots, num_groups);
+            return false;
+        }
+        memset(ctrl, EMPTY, num_slots);
+        _ctrl = ctrl;
+        _slots = slots;
+        _num_groups = num_groups;
+        _max_size = num_slots - num_slots / 8;
+        return true;
+    }
+
+    void free_arrays(int8_t* ctrl, Entry* slots, int64_t num_groups) {
+        free(ctrl);
+        free(slots);
+        _mem_tracker->release(num_groups * GROUP_SIZE * (1 + sizeof(Entry)));
+    }
+
+    // Moves all entries to new arrays of 'num_groups' groups. Returns false and keeps
+    // the current arrays if they cannot be allocated.
+    bool resize(int64_t num_groups) {
+        int8_t* old_ctrl = _ctrl;
+        Entry* old_slots = _slots;
+        int64_t old_num_groups = _num_groups;
+        if (!allocate(num_groups)) {
+            return false;
+        }
+
+        int64_t old_num_slots = old_num_groups * GROUP_SIZE;
+        for (int64_t i = 0; i < old_num_slots; ++i) {
+            if (old_ctrl[i] == EMPTY) {
+                continue;
+            }
+            // The keys are known to be distinct, only look for an empty slot.
+            uint64_t hash = _hash(old_slots[i].key);
+            int64_t group = group_of(hash);
+            uint32_t empty_mask = match(group, EMPTY);
+            while (empty_mask == 0) {
+                group = (group + 1) & (_num_groups - 1);
+                empty_mask = match(group, EMPTY);
+            }
+            int64_t slot = group * GROUP_SIZE + __builtin_ctz(empty_mask);
+            _ctrl[slot] = tag_of(hash);
+            memcpy(&_slots[slot], &old_slots[i], sizeof(Entry));
+        }
+        free_arrays(old_ctrl, old_slots, old_num_groups);
+        return true;
+    }
+
+    MemTracker* _mem_tracker;
+    int64_t _expected_size;
+    Hash _hash;
+    Equal _equal;
+
+    // GROUP_SIZE control bytes per group, EMPTY or the tag of the slot.
+    int8_t* _ctrl;
+    Entry* _slots;
+
+    // Always a power of 2.
+    int64_t _num_groups;
+    int64_t _size;
+    // Size at which the table grows.
+    int64_t _max_size;
+
+    DISALLOW_COPY_AND_ASSIGN(SwissHashTable);
+};
+
+}
+
+#endif
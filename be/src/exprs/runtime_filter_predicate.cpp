@@ -0,0 +1,354 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exprs/runtime_filter_predicate.h"
+
+#include <memory>
+#include <new>
+#include <sstream>
+
+#include "gen_cpp/PaloInternalService_types.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/raw_value.h"
+#include "runtime/runtime_state.h"
+
+namespace palo {
+
+// Seeds of the two halves of the bloom filter hash. Different from the seeds
+// used to partition data, so the values of one partition still spread over the
+// whole filter.
+static const uint32_t RUNTIME_FILTER_SEED_HIGH = 0x2a4a5e1bU;
+static const uint32_t RUNTIME_FILTER_SEED_LOW = 0x61c88647U;
+
+RuntimeFilterPredicate::RuntimeFilterPredicate(const TExprNode& node) :
+        Predicate(node),
+        _is_prepare(false),
+        _filter(new Filter()) {
+}
+
+RuntimeFilterPredicate::~RuntimeFilterPredicate() {
+}
+
+RuntimeFilterPredicate* RuntimeFilterPredicate::create(ObjectPool* pool) {
+    TExprNode node;
+    node.__set_node_type(TExprNodeType::RUNTIME_FILTER_PRED);
+    TScalarType tscalar_type;
+    tscalar_type.__set_type(TPrimitiveType::BOOLEAN);
+    TTypeNode ttype_node;
+    ttype_node.__set_type(TTypeNodeType::SCALAR);
+    ttype_node.__set_scalar_type(tscalar_type);
+    TTypeDesc t_type_desc;
+    t_type_desc.types.push_back(ttype_node);
+    node.__set_type(t_type_desc);
+    return pool->add(new RuntimeFilterPredicate(node));
+}
+
+Status RuntimeFilterPredicate::prepare(
+        RuntimeState* state, const TypeDescriptor& type,
+        int64_t expected_values, MemTracker* mem_tracker) {
+    if (_is_prepare) {
+        return Status::OK;
+    }
+    switch (type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_LARGEINT:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_DATE:
+    case TYPE_DATETIME:
+    case TYPE_DECIMAL:
+    case TYPE_CHAR:
+    case TYPE_VARCHAR:
+    case TYPE_HLL:
+        break;
+    default:
+        return Status("Unknown column type.");
+    }
+    _filter->type = type;
+    _filter->mem_tracker = mem_tracker;
+    if (expected_values > 0) {
+        std::unique_ptr<column_file::BloomFilter> bloom_filter(new column_file::BloomFilter());
+        if (!bloom_filter->init(expected_values)) {
+            return Status("Failed to allocate bloom filter.");
+        }
+        int64_t bytes = bloom_filter->bit_set_data_len() * sizeof(uint64_t);
+        if (!mem_tracker->try_consume(bytes)) {
+            // The filter is still correct with min and max only, just less selective.
+            LOG(INFO) << "Bloom filter of " << bytes << " bytes exceeds the memory limit, "
+                    << "only min and max are checked.";
+        } else {
+            _filter->bloom_filters.push_back(bloom_filter.release());
+            _filter->bloom_filter_bytes = bytes;
+        }
+    }
+    _is_prepare = true;
+    return Status::OK;
+}
+
+Status RuntimeFilterPredicate::prepare(
+        RuntimeState* state, const RowDescriptor& row_desc, ExprContext* context) {
+    if (_children.size() != 1) {
+        return Status("RuntimeFilterPredicate needs exactly one child.");
+    }
+    RETURN_IF_ERROR(_children[0]->prepare(state, row_desc, context));
+    if (!_is_prepare) {
+        return Status("RuntimeFilterPredicate is not prepared with the value type.");
+    }
+    return Status::OK;
+}
+
+void RuntimeFilterPredicate::release_bloom_filter() {
+    Filter* filter = _filter.get();
+    if (filter->bloom_filters.empty()) {
+        return;
+    }
+    filter->bloom_filters.clear();
+    filter->mem_tracker->release(filter->bloom_filter_bytes);
+    filter->bloom_filter_bytes = 0;
+}
+
+void RuntimeFilterPredicate::to_thrift(TRuntimeFilter* t_filter) const {
+    const Filter* filter = _filter.get();
+    if (filter->min_value == NULL) {
+        return;
+    }
+    value_to_string(filter->min_value, filter->type, &t_filter->min_value);
+    value_to_string(filter->max_value, filter->type, &t_filter->max_value);
+    t_filter->__isset.min_value = true;
+    t_filter->__isset.max_value = true;
+    if (filter->bloom_filters.size() == 1) {
+        const column_file::BloomFilter& bloom_filter = filter->bloom_filters[0];
+        t_filter->bloom_filter_bits.assign(
+                reinterpret_cast<const char*>(bloom_filter.bit_set_data()),
+                bloom_filter.bit_set_data_len() * sizeof(uint64_t));
+        t_filter->__set_bloom_filter_hash_functions(bloom_filter.hash_function_num());
+        t_filter->__isset.bloom_filter_bits = true;
+    }
+}
+
+Status RuntimeFilterPredicate::merge(const TRuntimeFilter& t_filter) {
+    if (!t_filter.__isset.min_value) {
+        // Nothing to add from an empty build side.
+        return Status::OK;
+    }
+    Filter* filter = _filter.get();
+    ExprValue min_storage;
+    ExprValue max_storage;
+    void* min_value = string_to_value(t_filter.min_value, filter->type, &min_storage);
+    void* max_value = string_to_value(t_filter.max_value, filter->type, &max_storage);
+    if (min_value == NULL || max_value == NULL) {
+        return Status("Runtime filter values do not match the filtered type.");
+    }
+
+    // The values of this filter which passed before may only be caught by min and max
+    // now, so the bloom filters are kept only if both sides have one.
+    bool was_empty = filter->min_value == NULL;
+    if (!t_filter.__isset.bloom_filter_bits) {
+        release_bloom_filter();
+        filter->min_max_only = true;
+    } else if (!was_empty && filter->bloom_filters.empty()) {
+        filter->min_max_only = true;
+    } else if (!filter->min_max_only) {
+        uint32_t data_len = t_filter.bloom_filter_bits.size() / sizeof(uint64_t);
+        if (data_len == 0 || data_len * sizeof(uint64_t) != t_filter.bloom_filter_bits.size()
+                || t_filter.bloom_filter_hash_functions <= 0) {
+            return Status("Invalid runtime filter bloom filter.");
+        }
+        uint64_t* data = new(std::nothrow) uint64_t[data_len];
+        if (data == NULL) {
+            return Status("Failed to allocate bloom filter.");
+        }
+        memcpy(data, t_filter.bloom_filter_bits.data(), t_filter.bloom_filter_bits.size());
+        // The bit set of the bloom filter frees 'data'.
+        std::unique_ptr<column_file::BloomFilter> bloom_filter(new column_file::BloomFilter());
+        bloom_filter->init(data, data_len, t_filter.bloom_filter_hash_functions);
+        merge_bloom_filter(bloom_filter.release());
+    }
+
+    if (was_empty || RawValue::compare(min_value, filter->min_value, filter->type) < 0) {
+        filter->min_value = copy_value(min_value, filter->type, &filter->min_storage);
+    }
+    if (was_empty || RawValue::compare(max_value, filter->max_value, filter->type) > 0) {
+        filter->max_value = copy_value(max_value, filter->type, &filter->max_storage);
+    }
+    return Status::OK;
+}
+
+void RuntimeFilterPredicate::merge_bloom_filter(column_file::BloomFilter* bloom_filter) {
+    std::unique_ptr<column_file::BloomFilter> owner(bloom_filter);
+    Filter* filter = _filter.get();
+    for (int i = 0; i < filter->bloom_filters.size(); ++i) {
+        if (filter->bloom_filters[i].merge(*bloom_filter)) {
+            return;
+        }
+    }
+    int64_t bytes = bloom_filter->bit_set_data_len() * sizeof(uint64_t);
+    if (!filter->mem_tracker->try_consume(bytes)) {
+        LOG(INFO) << "Bloom filter of " << bytes << " bytes exceeds the memory limit, "
+                << "only min and max are checked.";
+        release_bloom_filter();
+        filter->min_max_only = true;
+        return;
+    }
+    filter->bloom_filters.push_back(owner.release());
+    filter->bloom_filter_bytes += bytes;
+}
+
+uint64_t RuntimeFilterPredicate::hash(const void* value, const TypeDescriptor& type) {
+    uint64_t high = RawValue::get_hash_value_fvn(value, type, RUNTIME_FILTER_SEED_HIGH);
+    uint64_t low = RawValue::get_hash_value_fvn(value, type, RUNTIME_FILTER_SEED_LOW);
+    return (high << 32) | low;
+}
+
+void* RuntimeFilterPredicate::copy_value(
+        const void* value, const TypeDescriptor& type, ExprValue* storage) {
+    switch (type.type) {
+    case TYPE_BOOLEAN:
+        storage->bool_val = *reinterpret_cast<const bool*>(value);
+        return &storage->bool_val;
+    case TYPE_TINYINT:
+        storage->tinyint_val = *reinterpret_cast<const int8_t*>(value);
+        return &storage->tinyint_val;
+    case TYPE_SMALLINT:
+        storage->smallint_val = *reinterpret_cast<const int16_t*>(value);
+        return &storage->smallint_val;
+    case TYPE_INT:
+        storage->int_val = *reinterpret_cast<const int32_t*>(value);
+        return &storage->int_val;
+    case TYPE_BIGINT:
+        storage->bigint_val = *reinterpret_cast<const int64_t*>(value);
+        return &storage->bigint_val;
+    case TYPE_LARGEINT:
+        memcpy(&storage->large_int_val, value, sizeof(__int128));
+        return &storage->large_int_val;
+    case TYPE_FLOAT:
+        storage->float_val = *reinterpret_cast<const float*>(value);
+        return &storage->float_val;
+    case TYPE_DOUBLE:
+        storage->double_val = *reinterpret_cast<const double*>(value);
+        return &storage->double_val;
+    case TYPE_DATE:
+    case TYPE_DATETIME:
+        storage->datetime_val = *reinterpret_cast<const DateTimeValue*>(value);
+        return &storage->datetime_val;
+    case TYPE_DECIMAL:
+        storage->decimal_val = *reinterpret_cast<const DecimalValue*>(value);
+        return &storage->decimal_val;
+    case TYPE_CHAR:
+    case TYPE_VARCHAR:
+    case TYPE_HLL: {
+        const StringValue* string_value = reinterpret_cast<const StringValue*>(value);
+        storage->string_data.assign(string_value->ptr, string_value->len);
+        storage->string_val.ptr = const_cast<char*>(storage->string_data.data());
+        storage->string_val.len = storage->string_data.size();
+        return &storage->string_val;
+    }
+    default:
+        DCHECK(false) << "invalid type: " << type;
+        return NULL;
+    }
+}
+
+void RuntimeFilterPredicate::value_to_string(
+        const void* value, const TypeDescriptor& type, std::string* data) {
+    if (type.is_string_type()) {
+        const StringValue* string_value = reinterpret_cast<const StringValue*>(value);
+        data->assign(string_value->ptr, string_value->len);
+    } else {
+        data->assign(reinterpret_cast<const char*>(value), type.get_slot_size());
+    }
+}
+
+void* RuntimeFilterPredicate::string_to_value(
+        const std::string& data, const TypeDescriptor& type, ExprValue* storage) {
+    if (type.is_string_type()) {
+        StringValue string_value(const_cast<char*>(data.data()), data.size());
+        return copy_value(&string_value, type, storage);
+    }
+    if (data.size() != type.get_slot_size()) {
+        return NULL;
+    }
+    return copy_value(data.data(), type, storage);
+}
+
+void RuntimeFilterPredicate::insert(void* value) {
+    if (NULL == value) {
+        return;
+    }
+    Filter* filter = _filter.get();
+    DCHECK_LE(filter->bloom_filters.size(), 1);
+    if (!filter->bloom_filters.empty()) {
+        filter->bloom_filters[0].add_hash(hash(value, filter->type));
+    }
+    if (filter->min_value == NULL
+            || RawValue::compare(value, filter->min_value, filter->type) < 0) {
+        filter->min_value = copy_value(value, filter->type, &filter->min_storage);
+    }
+    if (filter->max_value == NULL
+            || RawValue::compare(value, filter->max_value, filter->type) > 0) {
+        filter->max_value = copy_value(value, filter->type, &filter->max_storage);
+    }
+}
+
+BooleanVal RuntimeFilterPredicate::get_boolean_val(ExprContext* ctx, TupleRow* row) {
+    void* value = ctx->get_value(_children[0], row);
+    if (value == NULL) {
+        return BooleanVal::null();
+    }
+    const Filter* filter = _filter.get();
+    if (filter->min_value == NULL) {
+        // Empty build side, nothing can match.
+        return BooleanVal(false);
+    }
+    if (RawValue::compare(value, filter->min_value, filter->type) < 0
+            || RawValue::compare(value, filter->max_value, filter->type) > 0) {
+        return BooleanVal(false);
+    }
+    if (filter->bloom_filters.empty()) {
+        return BooleanVal(true);
+    }
+    uint64_t hash_value = hash(value, filter->type);
+    for (int i = 0; i < filter->bloom_filters.size(); ++i) {
+        if (filter->bloom_filters[i].test_hash(hash_value)) {
+            return BooleanVal(true);
+        }
+    }
+    return BooleanVal(false);
+}
+
+std::string RuntimeFilterPredicate::debug_string() const {
+    std::stringstream out;
+    out << "RuntimeFilterPredicate(" << get_child(0)->debug_string()
+        << " bloom_filter=" << has_bloom_filter();
+    if (_filter->min_value != NULL) {
+        out << " min=";
+        RawValue::print_value(_filter->min_value, _filter->type, -1, &out);
+        out << " max=";
+        RawValue::print_value(_filter->max_value, _filter->type, -1, &out);
+    }
+    out << ")";
+    return out.str();
+}
+
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_RUNTIME_FILTER_PREDICATE_H
+#define BDG_PALO_BE_SRC_QUERY_EXPRS_RUNTIME_FILTER_PREDICATE_H
+
+#include <string>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "exprs/expr_value.h"
+#include "exprs/predicate.h"
+#include "olap/column_file/bloom_filter.hpp"
+
+namespace palo {
+
+class MemTracker;
+class TRuntimeFilter;
+
+// Filter on the probe side of a hash join built from the values of the build side
+// join expr, used when there are too many values for an InPredicate.
+// A row passes if its value is within [min, max] of the build values and is in the
+// bloom filter (if there is one). Values of the build side always pass, so the
+// predicate can be pushed down to the probe side scan like an InPredicate. NULL
+// never passes since it never matches in a join.
+//
+// Like InPredicate, it is not created from thrift but by HashJoinNode:
+// create(), prepare() with the type of the probe expr, add the probe expr as the
+// only child, and insert() every build value. The bloom filter is released by
+// release_bloom_filter() once the probe side is closed.
+//
+// A partitioned hash join publishes the filter of each of its instances to the
+// scan nodes of the probe side fragment with to_thrift(). The scan node prepares a
+// filter without bloom filter and merge()s the filters of all the instances into it,
+// the result passes the values of any instance.
+class RuntimeFilterPredicate : public Predicate {
+public:
+    // Creates a filter in 'pool', which is still to be prepared.
+    static RuntimeFilterPredicate* create(ObjectPool* pool);
+
+    virtual ~RuntimeFilterPredicate();
+    virtual Expr* clone(ObjectPool* pool) const override {
+        return pool->add(new RuntimeFilterPredicate(*this));
+    }
+
+    // 'expected_values' is the number of values to be inserted, the bloom filter is
+    // sized for it. No bloom filter is built if 'expected_values' is 0, then only
+    // min and max are checked. The memory of the bloom filter is consumed from
+    // 'mem_tracker', if that exceeds the limit there is no bloom filter either.
+    Status prepare(RuntimeState* state, const TypeDescriptor& type,
+                   int64_t expected_values, MemTracker* mem_tracker);
+    virtual Status prepare(
+        RuntimeState* state, const RowDescriptor& row_desc, ExprContext* context);
+
+    virtual BooleanVal get_boolean_val(ExprContext* context, TupleRow* row);
+
+    virtual Status get_codegend_compute_fn(RuntimeState* state, llvm::Function** fn) override {
+        return get_codegend_compute_fn_wrapper(state, fn);
+    }
+
+    // Add one value of the build side. NULL is ignored.
+    void insert(void* value);
+
+    // Smallest and largest inserted value, NULL if nothing was inserted.
+    const void* min_value() const {
+        return _filter->min_value;
+    }
+    const void* max_value() const {
+        return _filter->max_value;
+    }
+
+    bool has_bloom_filter() const {
+        return !_filter->bloom_filters.empty();
+    }
+
+    // Frees the bloom filters and releases their memory from the mem tracker given to
+    // prepare(). Only min and max are checked afterwards, for all the clones.
+    void release_bloom_filter();
+
+    // Serializes min, max and the bloom filter to publish them to another backend.
+    void to_thrift(TRuntimeFilter* filter) const;
+
+    // Adds the values of a filter built by another hash join instance, serialized by
+    // to_thrift() with the same type. Bloom filters of the same size are or-ed, others
+    // are kept side by side. Once a filter without bloom filter is merged only min
+    // and max are checked.
+    Status merge(const TRuntimeFilter& filter);
+
+    virtual std::string debug_string() const;
+
+protected:
+    friend class Expr;
+    friend class HashJoinNode;
+    friend class RuntimeFilterPredicateTest;
+
+    RuntimeFilterPredicate(const TExprNode& node);
+
+private:
+    // Shared by the clones of the predicate in each scanner. Only written before
+    // the predicate is pushed down.
+    struct Filter {
+        Filter() :
+                min_max_only(false), mem_tracker(NULL), bloom_filter_bytes(0),
+                min_value(NULL), max_value(NULL) {}
+
+        TypeDescriptor type;
+        // A value passes if any of them contains it, empty if only min and max are
+        // checked. insert() uses the only one built by prepare(), there are more only
+        // after merge().
+        boost::ptr_vector<column_file::BloomFilter> bloom_filters;
+        // Set by merge() once a filter without bloom filter was merged.
+        bool min_max_only;
+        // Tracks the bloom_filter_bytes of bloom_filters.
+        MemTracker* mem_tracker;
+        int64_t bloom_filter_bytes;
+        // Point into min_storage and max_storage.
+        void* min_value;
+        void* max_value;
+        ExprValue min_storage;
+        ExprValue max_storage;
+    };
+
+    // 64 bits hash of 'value' for the bloom filter.
+    static uint64_t hash(const void* value, const TypeDescriptor& type);
+
+    // Copies 'value' into 'storage' and returns the pointer to the copy.
+    static void* copy_value(const void* value, const TypeDescriptor& type, ExprValue* storage);
+
+    // Serializes 'value' for TRuntimeFilter, and back into 'storage'. Returns NULL if
+    // 'data' does not hold a value of 'type'.
+    static void value_to_string(const void* value, const TypeDescriptor& type, std::string* data);
+    static void* string_to_value(
+        const std::string& data, const TypeDescriptor& type, ExprValue* storage);
+
+    // Adds the bloom filter of a merged filter, takes the ownership of 'bloom_filter'.
+    void merge_bloom_filter(column_file::BloomFilter* bloom_filter);
+
+    bool _is_prepare;
+    boost::shared_ptr<Filter> _filter;
+};
+
+}
+
+#endif
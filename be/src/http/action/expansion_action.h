@@ -0,0 +1,45 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_HTTP_ACTION_EXPANSION_ACTION_H
+#define BDG_PALO_BE_SRC_HTTP_ACTION_EXPANSION_ACTION_H
+
+#include "http/http_handler.h"
+
+namespace palo {
+
+class ExecEnv;
+
+// Show the base and cumulative expansion candidates of this BE ordered by score,
+// and the expansions running on each disk.
+class ExpansionAction : public HttpHandler {
+public:
+    ExpansionAction(ExecEnv* exec_env);
+
+    virtual ~ExpansionAction() {};
+
+    virtual void handle(HttpRequest *req, HttpChannel *channel);
+
+private:
+    ExecEnv* _exec_env;
+};
+
+} // end namespace palo
+
+#endif // BDG_PALO_BE_SRC_HTTP_ACTION_EXPANSION_ACTION_H
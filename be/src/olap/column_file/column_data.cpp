@@ -226,7 +226,17 @@ OLAPStatus ColumnData::_seek_to_block(const RowBlockPosition& block_pos, bool wi
     }
 
     OLAP_LOG_DEBUG("###---### seek from %u to %u", block_pos.data_offset, end_block);
-    return _segment_reader->seek_to_block(block_pos.data_offset, end_block, without_filter);
+    uint64_t skipped_blocks = _segment_reader->get_skipped_blocks();
+    res = _segment_reader->seek_to_block(block_pos.data_offset, end_block, without_filter);
+    if (_profile != NULL) {
+        RuntimeProfile::Counter* skipped_blocks_counter =
+                _profile->get_counter("BlocksSkippedByIndex");
+        if (skipped_blocks_counter != NULL) {
+            COUNTER_UPDATE(skipped_blocks_counter,
+                    _segment_reader->get_skipped_blocks() - skipped_blocks);
+        }
+    }
+    return res;
 }
 
 OLAPStatus ColumnData::_find_position_by_short_key(
@@ -598,6 +608,68 @@ OLAPStatus ColumnData::get_row_batch(
             batch_row_num, block_row_num, return_columns);
 }
 
+OLAPStatus ColumnData::get_first_block(VectorizedRowBatch* batch) {
+    batch->reset();
+    if (olap_index()->num_segments() == 0) {
+        set_eof(true);
+        return OLAP_SUCCESS;
+    }
+
+    RowBlockPosition block_pos;
+    block_pos.segment = 0u;
+    block_pos.data_offset = 0u;
+
+    OLAPStatus res = _seek_to_block(block_pos, false);
+    if (OLAP_SUCCESS != res) {
+        if (OLAP_ERR_DATA_EOF == res) {
+            set_eof(true);
+            return OLAP_SUCCESS;
+        }
+
+        OLAP_LOG_WARNING("fail to seek to first block. [res=%d]", res);
+        return res;
+    }
+
+    return get_next_block(batch);
+}
+
+OLAPStatus ColumnData::get_next_block(VectorizedRowBatch* batch) {
+    batch->reset();
+    if (eof()) {
+        return OLAP_SUCCESS;
+    }
+
+    while (true) {
+        OLAPStatus res = _segment_reader->get_block(batch, false);
+        if (OLAP_SUCCESS == res) {
+            return OLAP_SUCCESS;
+        } else if (OLAP_ERR_DATA_EOF != res) {
+            OLAP_LOG_WARNING("fail to read block from segment. [res=%d segment=%u]",
+                    res, _current_segment);
+            return res;
+        }
+
+        // 当前segment已读完, 继续读下一个segment
+        if (_current_segment + 1 >= _olap_index->num_segments()) {
+            set_eof(true);
+            return OLAP_SUCCESS;
+        }
+
+        RowBlockPosition block_pos;
+        block_pos.segment = _current_segment + 1;
+        block_pos.data_offset = 0u;
+        res = _seek_to_block(block_pos, false);
+        if (OLAP_ERR_DATA_EOF == res) {
+            set_eof(true);
+            return OLAP_SUCCESS;
+        } else if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to seek to next segment. [res=%d segment=%u]",
+                    res, block_pos.segment);
+            return res;
+        }
+    }
+}
+
 OLAPStatus ColumnData::get_first_row_block(RowBlock** row_block) {
     OLAPStatus res;
 
@@ -62,6 +62,9 @@ public:
     virtual OLAPStatus get_first_row_block(RowBlock** row_block);
     virtual OLAPStatus get_next_row_block(RowBlock** row_block);
 
+    virtual OLAPStatus get_first_block(VectorizedRowBatch* batch);
+    virtual OLAPStatus get_next_block(VectorizedRowBatch* batch);
+
     virtual OLAPStatus get_row_batch(
             uint8_t* batch_buf,
             uint32_t batch_buf_len,
@@ -22,6 +22,7 @@
 #include "olap/column_file/bit_field_reader.h"
 #include "olap/column_file/column_reader.h"
 #include "olap/column_file/file_stream.h"
+#include "olap/olap_cond.h"
 #include "olap/olap_define.h"
 
 
@@ -232,6 +233,79 @@ OLAPStatus StringColumnDirectReader::next(char* buffer, uint32_t* length) {
     return res;
 }
 
+OLAPStatus StringColumnDirectReader::next_batch(
+        const bool* is_null,
+        uint32_t size,
+        StringValue* values,
+        MemPool* mem_pool) {
+    uint32_t value_count = size;
+    if (NULL != is_null) {
+        value_count = 0;
+        for (uint32_t i = 0; i < size; ++i) {
+            value_count += !is_null[i];
+        }
+    }
+
+    int64_t* lengths = reinterpret_cast<int64_t*>(
+            mem_pool->allocate(sizeof(int64_t) * value_count));
+    if (NULL == lengths) {
+        OLAP_LOG_WARNING("fail to malloc string lengths. [value_count=%u]", value_count);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    OLAPStatus res = _length_reader->next_batch(lengths, value_count);
+    if (OLAP_SUCCESS != res) {
+        if (OLAP_ERR_DATA_EOF == res) {
+            _eof = true;
+        }
+
+        OLAP_LOG_WARNING("fail to read string lengths. [res=%d]", res);
+        return res;
+    }
+
+    uint64_t total_length = 0;
+    for (uint32_t i = 0; i < value_count; ++i) {
+        total_length += lengths[i];
+    }
+
+    // 整批数据一次读入, 避免逐行读取
+    char* data = NULL;
+    if (total_length > 0) {
+        data = reinterpret_cast<char*>(mem_pool->allocate(total_length));
+        if (NULL == data) {
+            OLAP_LOG_WARNING("fail to malloc string data. [size=%lu]", total_length);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+    }
+
+    uint64_t read_length = 0;
+    while (read_length < total_length) {
+        uint64_t buf_size = total_length - read_length;
+        res = _data_stream->read(data + read_length, &buf_size);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read string data. [res=%d]", res);
+            return res;
+        }
+
+        read_length += buf_size;
+    }
+
+    uint32_t value_index = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        if (NULL != is_null && is_null[i]) {
+            values[i].ptr = NULL;
+            values[i].len = 0;
+            continue;
+        }
+
+        values[i].ptr = data;
+        values[i].len = lengths[value_index];
+        data += lengths[value_index++];
+    }
+
+    return OLAP_SUCCESS;
+}
+
 StringColumnDictionaryReader::StringColumnDictionaryReader(
         uint32_t column_unique_id,
         uint32_t dictionary_size) : 
@@ -242,6 +316,8 @@ StringColumnDictionaryReader::StringColumnDictionaryReader(
         //_offset_dictionary(NULL),
         //_dictionary_data_buffer(NULL),
         _read_buffer(NULL),
+        _evaluated_cond(NULL),
+        _null_passed(false),
         _data_reader(NULL) {
 
 }
@@ -535,6 +611,155 @@ OLAPStatus StringColumnDictionaryReader::next(char* buffer, uint32_t* length) {
     return OLAP_SUCCESS;
 }
 
+OLAPStatus StringColumnDictionaryReader::next_batch(
+        const bool* is_null,
+        uint32_t size,
+        StringValue* values,
+        MemPool* mem_pool) {
+    uint32_t value_count = size;
+    if (NULL != is_null) {
+        value_count = 0;
+        for (uint32_t i = 0; i < size; ++i) {
+            value_count += !is_null[i];
+        }
+    }
+
+    int64_t* codes = reinterpret_cast<int64_t*>(mem_pool->allocate(sizeof(int64_t) * value_count));
+    if (NULL == codes) {
+        OLAP_LOG_WARNING("fail to malloc dictionary codes. [value_count=%u]", value_count);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    OLAPStatus res = _data_reader->next_batch(codes, value_count);
+    if (OLAP_SUCCESS != res) {
+        if (OLAP_ERR_DATA_EOF == res) {
+            _eof = true;
+        }
+
+        OLAP_LOG_WARNING("fail to read dictionary codes. [res=%d]", res);
+        return res;
+    }
+
+    int64_t dictionary_size = _dictionary.size();
+    uint32_t code_index = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        if (NULL != is_null && is_null[i]) {
+            values[i].ptr = NULL;
+            values[i].len = 0;
+            continue;
+        }
+
+        int64_t code = codes[code_index++];
+        if (code < 0 || code >= dictionary_size) {
+            OLAP_LOG_WARNING("value may indicated an invalid dictionary entry. "
+                    "[value = %ld, dictionary_size = %ld]", code, dictionary_size);
+            return OLAP_ERR_BUFFER_OVERFLOW;
+        }
+
+        values[i].ptr = const_cast<char*>(_dictionary[code].data());
+        values[i].len = _dictionary[code].size();
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus StringColumnDictionaryReader::next_codes_with_filter(
+        const bool* is_null,
+        uint32_t size,
+        const CondColumn& cond,
+        const FieldInfo& field_info,
+        int64_t* codes,
+        bool* selected) {
+    OLAPStatus res = _eval_dictionary(cond, field_info);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    uint32_t value_count = size;
+    if (NULL != is_null) {
+        value_count = 0;
+        for (uint32_t i = 0; i < size; ++i) {
+            value_count += !is_null[i];
+        }
+    }
+
+    res = _data_reader->next_batch(codes, value_count);
+    if (OLAP_SUCCESS != res) {
+        if (OLAP_ERR_DATA_EOF == res) {
+            _eof = true;
+        }
+
+        OLAP_LOG_WARNING("fail to read dictionary codes. [res=%d]", res);
+        return res;
+    }
+
+    // 非NULL行的字典码紧凑存放在codes头部, 从后向前展开到各自的行
+    int64_t dictionary_size = _dictionary.size();
+    int64_t code_index = static_cast<int64_t>(value_count) - 1;
+    for (int64_t i = static_cast<int64_t>(size) - 1; i >= 0; --i) {
+        if (NULL != is_null && is_null[i]) {
+            codes[i] = -1;
+            selected[i] = selected[i] && _null_passed;
+            continue;
+        }
+
+        int64_t code = codes[code_index--];
+        if (code < 0 || code >= dictionary_size) {
+            OLAP_LOG_WARNING("value may indicated an invalid dictionary entry. "
+                    "[value = %ld, dictionary_size = %ld]", code, dictionary_size);
+            return OLAP_ERR_BUFFER_OVERFLOW;
+        }
+
+        codes[i] = code;
+        selected[i] = selected[i] && _code_passed[code];
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus StringColumnDictionaryReader::_eval_dictionary(
+        const CondColumn& cond, const FieldInfo& field_info) {
+    if (&cond == _evaluated_cond) {
+        return OLAP_SUCCESS;
+    }
+
+    if (OLAP_FIELD_TYPE_CHAR != field_info.type && OLAP_FIELD_TYPE_VARCHAR != field_info.type) {
+        OLAP_LOG_WARNING("dictionary filter only supports char and varchar. [type=%d]",
+                field_info.type);
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    Field* field = Field::create(field_info);
+    if (NULL == field || !field->allocate()) {
+        OLAP_LOG_WARNING("fail to create field for dictionary. [type=%d]", field_info.type);
+        SAFE_DELETE(field);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    // 字典中的值各不相同, 每个值只需要求值一次
+    _code_passed.resize(_dictionary.size());
+    for (size_t code = 0; code < _dictionary.size(); ++code) {
+        const std::string& value = _dictionary[code];
+        if (OLAP_FIELD_TYPE_CHAR == field_info.type) {
+            size_t length = std::min(value.size(), static_cast<size_t>(field_info.length));
+            memset(field->buf(), 0, field_info.length);
+            memcpy(field->buf(), value.c_str(), length);
+        } else {
+            static_cast<VarCharField*>(field)->from_storage_length(value.c_str(), value.size());
+        }
+
+        field->set_not_null();
+        _code_passed[code] = cond.eval(field);
+    }
+
+    field->set_null();
+    _null_passed = cond.eval(field);
+
+    SAFE_DELETE(field);
+    _evaluated_cond = &cond;
+    return OLAP_SUCCESS;
+}
+
 ColumnReader::ColumnReader(uint32_t column_id, uint32_t column_unique_id) : 
         _value_present(false),
         _column_id(column_id),
@@ -568,7 +793,7 @@ ColumnReader* ColumnReader::create(uint32_t column_id,
                 return new(std::nothrow) NullValueReader(column_id, column_unique_id);
             } else {
                 return new(std::nothrow) DefaultValueReader(column_id, column_unique_id,
-                        field_info.default_value);
+                        field_info.default_value, field_info);
             }
         } else if (field_info.is_allow_null) {
             OLAP_LOG_DEBUG("create NullValueReader: %s", field_info.name.c_str());
@@ -829,6 +1054,148 @@ uint64_t ColumnReader::_count_none_nulls(uint64_t rows) {
     }
 }
 
+OLAPStatus ColumnReader::next_batch(
+        ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+    if (NULL == _present_reader) {
+        column_vector->set_no_nulls(true);
+        column_vector->set_is_null(NULL);
+        return OLAP_SUCCESS;
+    }
+
+    bool* is_null = reinterpret_cast<bool*>(mem_pool->allocate(sizeof(bool) * size));
+    if (NULL == is_null) {
+        OLAP_LOG_WARNING("fail to malloc null flags. [size=%u]", size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    // 整批读出present流, 再原地转换为null标记
+    char* present = reinterpret_cast<char*>(is_null);
+    OLAPStatus res = _present_reader->next_batch(present, size);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to read present stream. [res=%d column_unique_id=%u]",
+                res, _column_unique_id);
+        return res;
+    }
+
+    bool no_nulls = true;
+    for (uint32_t i = 0; i < size; ++i) {
+        is_null[i] = (1 == present[i]);
+        no_nulls &= !is_null[i];
+    }
+
+    column_vector->set_no_nulls(no_nulls);
+    column_vector->set_is_null(is_null);
+    return OLAP_SUCCESS;
+}
+
+uint32_t ColumnReader::_count_none_nulls_in_batch(ColumnVector* column_vector, uint32_t size) {
+    if (column_vector->no_nulls()) {
+        return size;
+    }
+
+    uint32_t count = 0;
+    bool* is_null = column_vector->is_null();
+    for (uint32_t i = 0; i < size; ++i) {
+        count += !is_null[i];
+    }
+
+    return count;
+}
+
+void ColumnReader::_expand_none_null_values(ColumnVector* column_vector,
+        uint32_t size,
+        uint32_t value_count,
+        size_t value_size,
+        char* values) {
+    if (column_vector->no_nulls()) {
+        return;
+    }
+
+    // 从后向前移动, 保证未移动的值不会被覆盖
+    bool* is_null = column_vector->is_null();
+    int64_t value_index = static_cast<int64_t>(value_count) - 1;
+    for (int64_t i = static_cast<int64_t>(size) - 1; i >= 0; --i) {
+        if (is_null[i]) {
+            memset(values + i * value_size, 0, value_size);
+        } else {
+            if (i != value_index) {
+                memcpy(values + i * value_size, values + value_index * value_size, value_size);
+            }
+            --value_index;
+        }
+    }
+}
+
+OLAPStatus DefaultValueReader::next_batch(
+        ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+    if (NULL == _default_field) {
+        _default_field = Field::create(_field_info);
+        if (NULL == _default_field || !_default_field->allocate()) {
+            OLAP_LOG_WARNING("fail to create default value field. [column_id=%u]", _column_id);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        OLAPStatus res = _default_field->from_string(_default_value);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to convert default value. [res=%d value='%s']",
+                    res, _default_value.c_str());
+            return res;
+        }
+    }
+
+    column_vector->set_no_nulls(true);
+    column_vector->set_is_null(NULL);
+
+    if (OLAP_FIELD_TYPE_VARCHAR == _field_info.type || OLAP_FIELD_TYPE_HLL == _field_info.type) {
+        StringValue* values = reinterpret_cast<StringValue*>(
+                mem_pool->allocate(sizeof(StringValue) * size));
+        if (NULL == values) {
+            OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]",
+                    sizeof(StringValue) * size);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        // 所有行共用同一份默认值
+        StringValue value(_default_field->buf() + sizeof(VarCharField::LengthValueType),
+                *reinterpret_cast<VarCharField::LengthValueType*>(_default_field->buf()));
+        for (uint32_t i = 0; i < size; ++i) {
+            values[i] = value;
+        }
+
+        column_vector->set_col_data(values);
+        return OLAP_SUCCESS;
+    }
+
+    size_t value_size = _field_info.length;
+    char* values = reinterpret_cast<char*>(mem_pool->allocate(value_size * size));
+    if (NULL == values) {
+        OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]", value_size * size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    for (uint32_t i = 0; i < size; ++i) {
+        memcpy(values + i * value_size, _default_field->buf(), value_size);
+    }
+
+    column_vector->set_col_data(values);
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus NullValueReader::next_batch(
+        ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+    bool* is_null = reinterpret_cast<bool*>(mem_pool->allocate(sizeof(bool) * size));
+    if (NULL == is_null) {
+        OLAP_LOG_WARNING("fail to malloc null flags. [size=%u]", size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    memset(is_null, 1, sizeof(bool) * size);
+    column_vector->set_no_nulls(false);
+    column_vector->set_is_null(is_null);
+    column_vector->set_col_data(NULL);
+    return OLAP_SUCCESS;
+}
+
 TinyColumnReader::TinyColumnReader(uint32_t column_id, uint32_t column_unique_id) : 
         ColumnReader(column_id, column_unique_id),
         _eof(false),
@@ -939,6 +1306,31 @@ OLAPStatus TinyColumnReader::next() {
     return res;
 }
 
+OLAPStatus TinyColumnReader::next_batch(
+        ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+    OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    char* values = reinterpret_cast<char*>(mem_pool->allocate(size));
+    if (NULL == values) {
+        OLAP_LOG_WARNING("fail to malloc batch values. [size=%u]", size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    uint32_t value_count = _count_none_nulls_in_batch(column_vector, size);
+    res = _data_reader->next_batch(values, value_count);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to read tiny batch. [res=%d]", res);
+        return res;
+    }
+
+    _expand_none_null_values(column_vector, size, value_count, sizeof(char), values);
+    column_vector->set_col_data(values);
+    return OLAP_SUCCESS;
+}
+
 DecimalColumnReader::DecimalColumnReader(uint32_t column_id, uint32_t column_unique_id) : 
         ColumnReader(column_id, column_unique_id),
         _int_reader(NULL),
@@ -1124,6 +1516,61 @@ OLAPStatus DecimalColumnReader::next() {
     */
 }
 
+OLAPStatus DecimalColumnReader::next_batch(
+        ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+    OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    DecimalBuf* values = reinterpret_cast<DecimalBuf*>(
+            mem_pool->allocate(sizeof(DecimalBuf) * size));
+    if (NULL == values) {
+        OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]", sizeof(DecimalBuf) * size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    // 整数部分和小数部分分别整批解码, 再按null标记合并
+    uint32_t value_count = _count_none_nulls_in_batch(column_vector, size);
+    int64_t* parts = reinterpret_cast<int64_t*>(
+            mem_pool->allocate(sizeof(int64_t) * value_count * 2));
+    if (NULL == parts) {
+        OLAP_LOG_WARNING("fail to malloc decimal parts. [value_count=%u]", value_count);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    int64_t* int_parts = parts;
+    int64_t* frac_parts = parts + value_count;
+    res = _int_reader->next_batch(int_parts, value_count);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to read decimal int part");
+        return res;
+    }
+
+    res = _frac_reader->next_batch(frac_parts, value_count);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to read decimal frac part");
+        return res;
+    }
+
+    bool* is_null = column_vector->is_null();
+    bool no_nulls = column_vector->no_nulls();
+    uint32_t value_index = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        if (!no_nulls && is_null[i]) {
+            values[i]._int = 0;
+            values[i]._frac = 0;
+        } else {
+            values[i]._int = int_parts[value_index];
+            values[i]._frac = frac_parts[value_index];
+            ++value_index;
+        }
+    }
+
+    column_vector->set_col_data(values);
+    return OLAP_SUCCESS;
+}
+
 LargeIntColumnReader::LargeIntColumnReader(uint32_t column_id, uint32_t column_unique_id) : 
         ColumnReader(column_id, column_unique_id),
         _high_reader(NULL),
@@ -1294,5 +1741,151 @@ OLAPStatus LargeIntColumnReader::next() {
     */
 }
 
+OLAPStatus LargeIntColumnReader::next_batch(
+        ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+    OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    int128_t* values = reinterpret_cast<int128_t*>(
+            mem_pool->allocate(sizeof(int128_t) * size));
+    if (NULL == values) {
+        OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]", sizeof(int128_t) * size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    // 高低两部分分别整批解码, 再按null标记合并
+    uint32_t value_count = _count_none_nulls_in_batch(column_vector, size);
+    int64_t* parts = reinterpret_cast<int64_t*>(
+            mem_pool->allocate(sizeof(int64_t) * value_count * 2));
+    if (NULL == parts) {
+        OLAP_LOG_WARNING("fail to malloc large int parts. [value_count=%u]", value_count);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    int64_t* high_parts = parts;
+    int64_t* low_parts = parts + value_count;
+    res = _high_reader->next_batch(high_parts, value_count);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to read large int high part. [res=%d]", res);
+        return res;
+    }
+
+    res = _low_reader->next_batch(low_parts, value_count);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to read large int low part. [res=%d]", res);
+        return res;
+    }
+
+    bool* is_null = column_vector->is_null();
+    bool no_nulls = column_vector->no_nulls();
+    uint32_t value_index = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        if (!no_nulls && is_null[i]) {
+            values[i] = 0;
+        } else {
+            // 与逐行读取时的内存布局保持一致: 先high后low
+            int64_t* value = reinterpret_cast<int64_t*>(&values[i]);
+            value[0] = high_parts[value_index];
+            value[1] = low_parts[value_index];
+            ++value_index;
+        }
+    }
+
+    column_vector->set_col_data(values);
+    return OLAP_SUCCESS;
+}
+
+template <>
+OLAPStatus FixLengthStringColumnReader<StringColumnDictionaryReader>::next_batch_with_filter(
+        ColumnVector* column_vector,
+        uint32_t size,
+        MemPool* mem_pool,
+        const CondColumn& cond,
+        const FieldInfo& field_info,
+        bool* selected) {
+    OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    int64_t* codes = reinterpret_cast<int64_t*>(mem_pool->allocate(sizeof(int64_t) * size));
+    char* values = reinterpret_cast<char*>(mem_pool->allocate(_string_length * size));
+    if (NULL == codes || NULL == values) {
+        OLAP_LOG_WARNING("fail to malloc batch values. [size=%u]", size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    const bool* is_null = column_vector->no_nulls() ? NULL : column_vector->is_null();
+    res = _reader.next_codes_with_filter(is_null, size, cond, field_info, codes, selected);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to filter fixed string batch. [res=%d]", res);
+        return res;
+    }
+
+    // 只物化满足条件的行
+    const std::vector<std::string>& dictionary = _reader.dictionary();
+    char* value = values;
+    for (uint32_t i = 0; i < size; ++i, value += _string_length) {
+        size_t length = 0;
+        if (selected[i] && codes[i] >= 0) {
+            const std::string& item = dictionary[codes[i]];
+            length = std::min(item.size(), static_cast<size_t>(_string_length));
+            memcpy(value, item.c_str(), length);
+        }
+        memset(value + length, 0, _string_length - length);
+    }
+
+    column_vector->set_col_data(values);
+    return OLAP_SUCCESS;
+}
+
+template <>
+OLAPStatus VarStringColumnReader<StringColumnDictionaryReader>::next_batch_with_filter(
+        ColumnVector* column_vector,
+        uint32_t size,
+        MemPool* mem_pool,
+        const CondColumn& cond,
+        const FieldInfo& field_info,
+        bool* selected) {
+    OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    int64_t* codes = reinterpret_cast<int64_t*>(mem_pool->allocate(sizeof(int64_t) * size));
+    StringValue* values = reinterpret_cast<StringValue*>(
+            mem_pool->allocate(sizeof(StringValue) * size));
+    if (NULL == codes || NULL == values) {
+        OLAP_LOG_WARNING("fail to malloc batch values. [size=%u]", size);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    const bool* is_null = column_vector->no_nulls() ? NULL : column_vector->is_null();
+    res = _reader.next_codes_with_filter(is_null, size, cond, field_info, codes, selected);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to filter varchar batch. [res=%d]", res);
+        return res;
+    }
+
+    // 满足条件的行直接指向字典项, 同StringColumnDictionaryReader::next_batch
+    const std::vector<std::string>& dictionary = _reader.dictionary();
+    for (uint32_t i = 0; i < size; ++i) {
+        values[i].ptr = NULL;
+        values[i].len = 0;
+        if (!selected[i] || codes[i] < 0) {
+            continue;
+        }
+
+        const std::string& item = dictionary[codes[i]];
+        values[i].ptr = const_cast<char*>(item.data());
+        values[i].len = item.size();
+    }
+
+    column_vector->set_col_data(values);
+    return OLAP_SUCCESS;
+}
+
 }  // namespace column_file
 }  // namespace palo
@@ -20,6 +20,8 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COLUMN_READER_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COLUMN_READER_H
 
+#include <algorithm>
+
 #include "olap/column_file/byte_buffer.h"
 #include "olap/column_file/file_stream.h"
 #include "olap/column_file/run_length_byte_reader.h"
@@ -29,8 +31,14 @@
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
 #include "olap/row_cursor.h"
+#include "runtime/mem_pool.h"
+#include "runtime/string_value.h"
+#include "runtime/vectorized_row_batch.h"
 
 namespace palo {
+
+class CondColumn;
+
 namespace column_file {
 
 class StreamName;
@@ -88,6 +96,11 @@ public:
     OLAPStatus skip(uint64_t row_count);
     // 返回当前行的数据，通过将内部指针移向下一行
     OLAPStatus next(int64_t* value);
+    // 连续读取num_values行数据, 按run批量解码
+    template <typename T>
+    OLAPStatus next_batch(T* values, uint32_t num_values) {
+        return _data_reader->next_batch(values, num_values);
+    }
     bool eof() {
         return _eof;
     }
@@ -111,6 +124,12 @@ public:
     // buffer - 返回数据的缓冲区
     // length - 输入时作为缓存区大小，返回时给出字符串的大小
     OLAPStatus next(char* buffer, uint32_t* length);
+    // 批量读取size行, is_null为NULL表示没有NULL行, NULL行返回空串.
+    // 先整批解码长度, 再把全部数据一次读入mem_pool, values指向其中
+    OLAPStatus next_batch(const bool* is_null,
+            uint32_t size,
+            StringValue* values,
+            MemPool* mem_pool);
 
     size_t get_buffer_size() {
         return sizeof(RunLengthByteReader);
@@ -139,16 +158,42 @@ public:
     OLAPStatus seek(PositionProvider* positions);
     OLAPStatus skip(uint64_t row_count);
     OLAPStatus next(char* buffer, uint32_t* length);
+    // 接口同StringColumnDirectReader::next_batch, 整批解码字典码,
+    // values直接指向字典项, 不拷贝字符串, 在读取下一个segment前有效
+    OLAPStatus next_batch(const bool* is_null,
+            uint32_t size,
+            StringValue* values,
+            MemPool* mem_pool);
+
+    // 读取size行的字典码写入codes, 不拷贝字符串. is_null为NULL表示没有NULL行,
+    // NULL行的字典码为-1. 每个字典项只求值一次cond, 不满足cond的行在selected中置为false
+    OLAPStatus next_codes_with_filter(const bool* is_null,
+            uint32_t size,
+            const CondColumn& cond,
+            const FieldInfo& field_info,
+            int64_t* codes,
+            bool* selected);
+
+    const std::vector<std::string>& dictionary() const {
+        return _dictionary;
+    }
 
     size_t get_buffer_size() {
         return sizeof(RunLengthByteReader) + _dictionary_size;
     }
 
 private:
+    // 对每个字典项及NULL值求值cond, 结果保存在_code_passed和_null_passed中,
+    // 对同一个cond重复调用时直接返回
+    OLAPStatus _eval_dictionary(const CondColumn& cond, const FieldInfo& field_info);
+
     bool _eof;
     uint32_t _dictionary_size;
     uint32_t _column_unique_id;
     char* _read_buffer;
+    const CondColumn* _evaluated_cond;   // _code_passed对应的cond
+    std::vector<uint8_t> _code_passed;   // 每个字典项是否满足cond
+    bool _null_passed;
     //uint64_t _dictionary_size;
     //uint64_t* _offset_dictionary;   // 用来查找响应数据的数字对应的offset
     //ByteBuffer* _dictionary_data_buffer;   // 保存dict数据
@@ -216,6 +261,23 @@ public:
         return OLAP_SUCCESS;
     }
 
+    // 连续读取size行至column_vector, 不经过RowCursor.
+    // 数据从mem_pool中分配, 定长类型按存储格式连续存放, VARCHAR/HLL为StringValue数组.
+    // 基类只读取NULL标记, 子类在此之后解码非NULL行的数据, NULL行的数据填0
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool);
+
+    // 与next_batch相同, 同时用cond过滤读出的行: 不满足cond的行在selected中置为false,
+    // selected为false的行不物化数据. 目前只有字典编码的字符串列支持, 对每个字典项只求值
+    // 一次cond, 再按各行的字典码过滤. 其他列返回OLAP_ERR_FUNC_NOT_IMPLEMENTED, 不读取数据
+    virtual OLAPStatus next_batch_with_filter(ColumnVector* column_vector,
+            uint32_t size,
+            MemPool* mem_pool,
+            const CondColumn& cond,
+            const FieldInfo& field_info,
+            bool* selected) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
     uint32_t column_unique_id() {
         return _column_unique_id;
     }
@@ -234,6 +296,17 @@ protected:
     // 但实际上对于
     uint64_t _count_none_nulls(uint64_t rows);
 
+    // 根据next_batch读出的NULL标记, 将紧凑存放在values头部的value_count个非NULL值
+    // 原地展开到各自的行上, NULL行填0
+    void _expand_none_null_values(ColumnVector* column_vector,
+            uint32_t size,
+            uint32_t value_count,
+            size_t value_size,
+            char* values);
+
+    // 返回next_batch读出的非NULL行数
+    uint32_t _count_none_nulls_in_batch(ColumnVector* column_vector, uint32_t size);
+
     bool _value_present;
     uint32_t _column_id;        // column在schema内的id
     uint32_t _column_unique_id; // column的唯一id
@@ -243,9 +316,17 @@ protected:
 
 class DefaultValueReader : public ColumnReader {
 public:
-    DefaultValueReader(uint32_t column_id, uint32_t column_unique_id, std::string default_value) :
+    DefaultValueReader(uint32_t column_id,
+            uint32_t column_unique_id,
+            std::string default_value,
+            const FieldInfo& field_info) :
         ColumnReader(column_id, column_unique_id),
-        _default_value(default_value) {
+        _default_value(default_value),
+        _field_info(field_info),
+        _default_field(NULL) {
+    }
+    virtual ~DefaultValueReader() {
+        SAFE_DELETE(_default_field);
     }
     virtual OLAPStatus init(std::map<StreamName, ReadOnlyFileStream*>* streams) {
         return OLAP_SUCCESS;
@@ -263,8 +344,11 @@ public:
     virtual OLAPStatus next() {
         return OLAP_SUCCESS;
     }
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool);
 private:
     std::string _default_value;
+    FieldInfo _field_info;
+    Field* _default_field;   // 默认值的存储格式, 第一次next_batch时生成
 };
 
 class NullValueReader : public ColumnReader {
@@ -289,6 +373,7 @@ public:
         _value_present = true;
         return OLAP_SUCCESS;
     }
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool);
 };
 
 // 对于Tiny类型, 使用Byte作为存储
@@ -340,6 +425,8 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool);
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthByteReader);
     }
@@ -434,6 +521,19 @@ public:
             std::vector<uint32_t>& offset) {
         T* return_value = reinterpret_cast<T*>(batch_buf + offset.front());
 
+        // 没有NULL值时整段解码, 不再逐行调用next
+        if (NULL == _present_reader) {
+            if (start_row_in_block < batch_size) {
+                OLAPStatus res = _reader.next_batch(return_value, batch_size - start_row_in_block);
+
+                if (OLAP_ERR_DATA_EOF == res) {
+                    _eof = true;
+                }
+            }
+
+            return OLAP_SUCCESS;
+        }
+
         for (uint32_t i = start_row_in_block; i < batch_size; i++) {
             OLAPStatus res = ColumnReader::next();
 
@@ -457,6 +557,33 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+        OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+
+        T* values = reinterpret_cast<T*>(mem_pool->allocate(sizeof(T) * size));
+        if (NULL == values) {
+            OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]", sizeof(T) * size);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        // 先把非NULL值连续解码到values头部, 再展开到各自的行
+        uint32_t value_count = _count_none_nulls_in_batch(column_vector, size);
+        res = _reader.next_batch(values, value_count);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read integer batch. [res=%d]", res);
+            return res;
+        }
+
+        _expand_none_null_values(column_vector, size, value_count, sizeof(T),
+                reinterpret_cast<char*>(values));
+
+        column_vector->set_col_data(values);
+        return OLAP_SUCCESS;
+    }
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthIntegerReader);
     }
@@ -583,6 +710,57 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+        OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+
+        char* values = reinterpret_cast<char*>(mem_pool->allocate(_string_length * size));
+        if (NULL == values) {
+            OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]",
+                    static_cast<size_t>(_string_length) * size);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        StringValue* strings = reinterpret_cast<StringValue*>(
+                mem_pool->allocate(sizeof(StringValue) * size));
+        if (NULL == strings) {
+            OLAP_LOG_WARNING("fail to malloc batch strings. [size=%lu]",
+                    sizeof(StringValue) * size);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        const bool* is_null = column_vector->no_nulls() ? NULL : column_vector->is_null();
+        res = _reader.next_batch(is_null, size, strings, mem_pool);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read fixed string batch. [res=%d]", res);
+            return res;
+        }
+
+        // 定长字符串按_string_length对齐, 不足部分补0
+        char* value = values;
+        for (uint32_t i = 0; i < size; ++i, value += _string_length) {
+            size_t length = std::min(static_cast<size_t>(strings[i].len),
+                    static_cast<size_t>(_string_length));
+            memcpy(value, strings[i].ptr, length);
+            memset(value + length, 0, _string_length - length);
+        }
+
+        column_vector->set_col_data(values);
+        return OLAP_SUCCESS;
+    }
+
+    // 只有字典编码时支持, 见下方的特化
+    virtual OLAPStatus next_batch_with_filter(ColumnVector* column_vector,
+            uint32_t size,
+            MemPool* mem_pool,
+            const CondColumn& cond,
+            const FieldInfo& field_info,
+            bool* selected) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
     virtual size_t get_buffer_size() {
         return _reader.get_buffer_size() + _string_length;
     }
@@ -710,6 +888,41 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+        OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+
+        StringValue* values = reinterpret_cast<StringValue*>(
+                mem_pool->allocate(sizeof(StringValue) * size));
+        if (NULL == values) {
+            OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]",
+                    sizeof(StringValue) * size);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        const bool* is_null = column_vector->no_nulls() ? NULL : column_vector->is_null();
+        res = _reader.next_batch(is_null, size, values, mem_pool);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read varchar batch. [res=%d]", res);
+            return res;
+        }
+
+        column_vector->set_col_data(values);
+        return OLAP_SUCCESS;
+    }
+
+    // 只有字典编码时支持, 见下方的特化
+    virtual OLAPStatus next_batch_with_filter(ColumnVector* column_vector,
+            uint32_t size,
+            MemPool* mem_pool,
+            const CondColumn& cond,
+            const FieldInfo& field_info,
+            bool* selected) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
     virtual size_t get_buffer_size() {
         return _reader.get_buffer_size() + _max_length;
     }
@@ -721,6 +934,25 @@ private:
     VarCharField::LengthValueType* _real_length;
 };
 
+// 字典编码的字符串列按字典码过滤, 只为满足条件的行物化字符串
+template <>
+OLAPStatus FixLengthStringColumnReader<StringColumnDictionaryReader>::next_batch_with_filter(
+        ColumnVector* column_vector,
+        uint32_t size,
+        MemPool* mem_pool,
+        const CondColumn& cond,
+        const FieldInfo& field_info,
+        bool* selected);
+
+template <>
+OLAPStatus VarStringColumnReader<StringColumnDictionaryReader>::next_batch_with_filter(
+        ColumnVector* column_vector,
+        uint32_t size,
+        MemPool* mem_pool,
+        const CondColumn& cond,
+        const FieldInfo& field_info,
+        bool* selected);
+
 template <typename FLOAT_TYPE>
 class FloatintPointColumnReader : public ColumnReader {
 public:
@@ -857,6 +1089,40 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool) {
+        if (NULL == _data_stream) {
+            OLAP_LOG_WARNING("reader not init.");
+            return OLAP_ERR_NOT_INITED;
+        }
+
+        OLAPStatus res = ColumnReader::next_batch(column_vector, size, mem_pool);
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+
+        char* values = reinterpret_cast<char*>(mem_pool->allocate(sizeof(FLOAT_TYPE) * size));
+        if (NULL == values) {
+            OLAP_LOG_WARNING("fail to malloc batch values. [size=%lu]",
+                    sizeof(FLOAT_TYPE) * size);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        // 浮点数按原始字节存储, 非NULL值可以一次读出后再展开
+        uint32_t value_count = _count_none_nulls_in_batch(column_vector, size);
+        uint64_t length = sizeof(FLOAT_TYPE) * value_count;
+        if (length > 0) {
+            res = _data_stream->read(values, &length);
+            if (OLAP_SUCCESS != res || length != sizeof(FLOAT_TYPE) * value_count) {
+                OLAP_LOG_WARNING("fail to read float batch. [res=%d length=%lu]", res, length);
+                return OLAP_SUCCESS != res ? res : OLAP_ERR_DATA_EOF;
+            }
+        }
+
+        _expand_none_null_values(column_vector, size, value_count, sizeof(FLOAT_TYPE), values);
+        column_vector->set_col_data(values);
+        return OLAP_SUCCESS;
+    }
+
 protected:
     bool _eof;
     ReadOnlyFileStream* _data_stream;
@@ -897,6 +1163,8 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool);
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthByteReader) * 2;
     }
@@ -945,6 +1213,8 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(ColumnVector* column_vector, uint32_t size, MemPool* mem_pool);
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthByteReader) * 2;
     }
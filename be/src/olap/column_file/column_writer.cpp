@@ -602,6 +602,7 @@ VarStringColumnWriter::VarStringColumnWriter(
         double bf_fpp) : 
         ColumnWriter(column_id, stream_factory, field_info, num_rows_per_row_block, bf_fpp),
         _use_dictionary_encoding(false),
+        _is_building_dictionary(false),
         _dict_total_size(0),
         _dict_stream(NULL),
         _length_writer(NULL),
@@ -641,6 +642,10 @@ OLAPStatus VarStringColumnWriter::init() {
         return OLAP_ERR_MALLOC_ERROR;
     }
 
+    // 阈值为0时不使用字典编码, 否则先缓存数据并建立字典, 直到finalize时再决定编码方式
+    _is_building_dictionary = config::column_dictionary_key_size_threshold > 0
+            && config::column_dictionary_key_ration_threshold > 0;
+
     record_position();
     return OLAP_SUCCESS;
 }
@@ -667,42 +672,51 @@ OLAPStatus VarStringColumnWriter::write(RowCursor* row_cursor) {
 
 OLAPStatus VarStringColumnWriter::write(const char* str, uint32_t len) {
     OLAPStatus res = OLAP_SUCCESS;
-    // zdb shield the dictionary coding
-    std::string key(str, len);
 
-    if (OLAP_SUCCESS != (res = _data_stream->write(key.c_str(),
-                               key.length()))) {
+    if (_is_building_dictionary) {
+        std::string key(str, len);
+        StringDict::iterator it;
+        it = _string_dict.find(DictKey(key));
+
+        if (it == _string_dict.end()) {
+            uint32_t key_id = _string_keys.size();
+            _string_keys.push_back(key);
+            _string_dict[DictKey(_string_keys.back())] = key_id;
+            _string_id.push_back(key_id);
+            _dict_total_size += key.length();
+        } else {
+            _string_id.push_back(it->second);
+        }
+
+        // 不同的值过多, 字典编码已没有收益, 将缓存的数据按直接编码写出,
+        // 之后的数据直接写入流中, 不再占用内存
+        if (_string_keys.size() >= static_cast<uint64_t>(
+                    config::column_dictionary_key_size_threshold)) {
+            if (OLAP_SUCCESS != (res = _switch_to_direct_encoding())) {
+                OLAP_LOG_WARNING("fail to switch to direct encoding.");
+                return res;
+            }
+        }
+
+        return OLAP_SUCCESS;
+    }
+
+    if (OLAP_SUCCESS != (res = _data_stream->write(str, len))) {
         OLAP_LOG_WARNING("fail to write string content.");
         return res;
     }
 
-    if (OLAP_SUCCESS != (res = _length_writer->write(key.length()))) {
+    if (OLAP_SUCCESS != (res = _length_writer->write(len))) {
         OLAP_LOG_WARNING("fail to write string length.");
         return res;
     }
 
-#if 0
-    std::string key(str, len);
-    StringDict::iterator it;
-    it = _string_dict.find(DictKey(key));
-
-    if (it == _string_dict.end()) {
-        uint32_t key_id = _string_keys.size();
-        _string_keys.push_back(key);
-        _string_dict[DictKey(_string_keys.back())] = key_id;
-        _string_id.push_back(key_id);
-        _dict_total_size += key.length();
-    } else {
-        _string_id.push_back(it->second);
-    }
-
-#endif
     return OLAP_SUCCESS;
 }
 
 uint64_t VarStringColumnWriter::estimate_buffered_memory() {
-    // the length of _string_id is short after RLE
-    return _dict_total_size;
+    // 字典的key在_string_keys和_string_dict中各存一份
+    return _dict_total_size * 2 + _string_id.size() * sizeof(uint32_t);
 }
 
 OLAPStatus VarStringColumnWriter::_finalize_dict_encoding() {
@@ -754,19 +768,18 @@ OLAPStatus VarStringColumnWriter::_finalize_dict_encoding() {
 }
 
 OLAPStatus VarStringColumnWriter::_finalize_direct_encoding() {
-    //OLAPStatus res = OLAP_SUCCESS;
-    //uint32_t block_id = 0;
-
-    _dict_stream->suppress();
-#if 0
+    OLAPStatus res = OLAP_SUCCESS;
+    uint32_t block_id = 0;
 
     for (uint32_t i = 0; i <= _string_id.size(); i++) {
         // 与其他类型不同，string的record position会向_block_row_count写入条目
         // 而其他类型在下一次调用create_index_row_entry之前是没有影响的。
-        while (block_id < _block_row_count.size() - 1 &&
-                i == _block_row_count[block_id]) {
-            _data_stream->get_position(index()->mutable_entry(block_id));
-            _length_writer->get_position(index()->mutable_entry(block_id));
+        // 最后一个条目对应尚未加入index的当前block, 写入index_entry()
+        while (block_id < _block_row_count.size() && i == _block_row_count[block_id]) {
+            PositionEntryWriter* entry = block_id < index()->entry_size() ?
+                    index()->mutable_entry(block_id) : index_entry();
+            _data_stream->get_position(entry);
+            _length_writer->get_position(entry, false);
             block_id++;
         }
 
@@ -786,7 +799,21 @@ OLAPStatus VarStringColumnWriter::_finalize_direct_encoding() {
         }
     }
 
-#endif
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus VarStringColumnWriter::_switch_to_direct_encoding() {
+    OLAPStatus res = _finalize_direct_encoding();
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    _is_building_dictionary = false;
+    _string_keys.clear();
+    _string_dict.clear();
+    _string_id.clear();
+    _block_row_count.clear();
+    _dict_total_size = 0;
     return OLAP_SUCCESS;
 }
 
@@ -796,7 +823,7 @@ OLAPStatus VarStringColumnWriter::finalize(ColumnDataHeaderMessage* header) {
     uint64_t size_threshold = config::column_dictionary_key_size_threshold;
 
     // the dictionary condition:1 key size < size threshold; 2 key ratio < ratio threshold
-    _use_dictionary_encoding =
+    _use_dictionary_encoding = _is_building_dictionary &&
         (_string_keys.size() < size_threshold) &&
         (_string_keys.size() * 100UL < _string_id.size() * ratio_threshold);
 
@@ -807,11 +834,16 @@ OLAPStatus VarStringColumnWriter::finalize(ColumnDataHeaderMessage* header) {
             return res;
         }
     } else {
-        res = _finalize_direct_encoding();
-        if (OLAP_SUCCESS != res) {
-            OLAP_LOG_WARNING("fail to finalize direct enconding.");
-            return res;
+        // 已经切换为直接编码时数据都已写入流中, 只需丢弃字典流
+        if (_is_building_dictionary) {
+            res = _finalize_direct_encoding();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to finalize direct enconding.");
+                return res;
+            }
         }
+
+        _dict_stream->suppress();
     }
 
     // 已经完成Index的补写, ColumnWriter::finalize会写入header
@@ -860,10 +892,13 @@ void VarStringColumnWriter::save_encoding(ColumnEncodingMessage* encoding) {
 // 利用该信息向Index中追加stream的位置信息
 void VarStringColumnWriter::record_position() {
     ColumnWriter::record_position();
-    _block_row_count.push_back(_string_id.size());
-    //zdb shield dictionary coding
-    _data_stream->get_position(index_entry());
-    _length_writer->get_position(index_entry(), false);
+
+    if (_is_building_dictionary) {
+        _block_row_count.push_back(_string_id.size());
+    } else {
+        _data_stream->get_position(index_entry());
+        _length_writer->get_position(index_entry(), false);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -421,9 +421,14 @@ private:
     typedef std::map<DictKey, uint32_t> StringDict;
 private:
     OLAPStatus _finalize_dict_encoding();
+    // 将缓存的数据按直接编码写入流中, 并补写各block的位置
     OLAPStatus _finalize_direct_encoding();
+    // 写入过程中放弃字典编码, 释放缓存的数据
+    OLAPStatus _switch_to_direct_encoding();
 private:
     bool _use_dictionary_encoding;
+    // 是否仍在缓存数据并建立字典, 为false时数据直接写入流中
+    bool _is_building_dictionary;
     std::vector<uint32_t> _string_id;
     std::vector<std::string> _string_keys;
     StringDict _string_dict;
@@ -101,5 +101,70 @@ OLAPStatus lz4_decompress(ByteBuffer* in, ByteBuffer* out) {
     return res;
 }
 
+OLAPStatus zstd_compress(ByteBuffer* in, ByteBuffer* out, bool* smaller) {
+    size_t out_length = 0;
+    OLAPStatus res = OLAP_SUCCESS;
+    *smaller = false;
+    res = olap_compress(&(in->array()[in->position()]),
+            in->remaining(),
+            &(out->array()[out->position()]),
+            out->remaining(),
+            &out_length,
+            OLAP_COMP_ZSTD);
+
+    if (OLAP_SUCCESS == res) {
+        if (out_length < in->remaining()) {
+            *smaller = true;
+            out->set_position(out->position() + out_length);
+        }
+    }
+
+    return res;
+}
+
+OLAPStatus zstd_decompress(ByteBuffer* in, ByteBuffer* out) {
+    size_t out_length = 0;
+    OLAPStatus res = OLAP_SUCCESS;
+    res = olap_decompress(&(in->array()[in->position()]),
+            in->remaining(),
+            &(out->array()[out->position()]),
+            out->remaining(),
+            &out_length,
+            OLAP_COMP_ZSTD);
+
+    if (OLAP_SUCCESS == res) {
+        out->set_limit(out_length);
+    }
+
+    return res;
+}
+
+OLAPStatus get_decompressor(CompressKind compress_kind, Decompressor* decompressor) {
+    switch (compress_kind) {
+    case COMPRESS_NONE:
+    case COMPRESS_ADAPTIVE:
+        *decompressor = NULL;
+        break;
+
+    case COMPRESS_LZO:
+        *decompressor = lzo_decompress;
+        break;
+
+    case COMPRESS_LZ4:
+        *decompressor = lz4_decompress;
+        break;
+
+    case COMPRESS_ZSTD:
+        *decompressor = zstd_decompress;
+        break;
+
+    default:
+        OLAP_LOG_WARNING("unknown compress kind. [kind=%d]", compress_kind);
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    return OLAP_SUCCESS;
+}
+
 }  // namespace column_file
 }  // namespace palo
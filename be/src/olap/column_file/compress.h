@@ -20,6 +20,8 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COMPRESS_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COMPRESS_H
 
+#include <gen_cpp/olap_common.pb.h>
+
 #include "olap/olap_define.h"
 
 namespace palo {
@@ -52,6 +54,16 @@ OLAPStatus lzo_decompress(ByteBuffer* in, ByteBuffer* out);
 OLAPStatus lz4_compress(ByteBuffer* in, ByteBuffer* out, bool* smaller);
 OLAPStatus lz4_decompress(ByteBuffer* in, ByteBuffer* out);
 
+// 压缩级别由config::zstd_compression_level指定
+OLAPStatus zstd_compress(ByteBuffer* in, ByteBuffer* out, bool* smaller);
+OLAPStatus zstd_decompress(ByteBuffer* in, ByteBuffer* out);
+
+// 获取压缩方式对应的解压函数, COMPRESS_NONE和COMPRESS_ADAPTIVE得到NULL,
+// 后者的每条流使用各自记录的压缩方式
+// Returns:
+//     OLAP_ERR_INPUT_PARAMETER_ERROR - 未知的压缩方式
+OLAPStatus get_decompressor(CompressKind compress_kind, Decompressor* decompressor);
+
 }  // namespace column_file
 }  // namespace palo
 #endif // BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COMPRESS_H
@@ -0,0 +1,187 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/column_file/file_prefetcher.h"
+
+#include <fcntl.h>
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+#include "util/thread_pool.hpp"
+
+namespace palo {
+namespace column_file {
+
+FilePrefetcher::FilePrefetcher(FileHandler* file_handler,
+                               ThreadPool* thread_pool,
+                               std::atomic<int64_t>* inflight_bytes) :
+        _file_handler(file_handler),
+        _thread_pool(thread_pool),
+        _next_chunk(0),
+        _max_inflight_bytes(0),
+        _local_inflight_bytes(0),
+        _inflight_bytes(NULL != inflight_bytes ? inflight_bytes : &_local_inflight_bytes),
+        _running(0),
+        _prefetched_bytes(0),
+        _cancelled(false),
+        _cond(_mutex) {}
+
+FilePrefetcher::~FilePrefetcher() {
+    cancel();
+}
+
+void FilePrefetcher::add_range(uint64_t offset, uint64_t length) {
+    if (length > 0) {
+        _ranges.push_back(Range(offset, length));
+    }
+}
+
+void FilePrefetcher::submit(
+        uint64_t coalesce_bytes, uint64_t chunk_bytes, uint64_t max_inflight_bytes) {
+    std::sort(_ranges.begin(), _ranges.end(), [](const Range& a, const Range& b) {
+        return a.offset < b.offset;
+    });
+
+    // 合并相邻或重叠的区间, 中间的空洞也一并读出, 以减少小的随机读
+    std::vector<Range> merged;
+    for (const Range& range : _ranges) {
+        if (!merged.empty()
+                && range.offset <= merged.back().offset + merged.back().length + coalesce_bytes) {
+            uint64_t end = std::max(merged.back().offset + merged.back().length,
+                                    range.offset + range.length);
+            merged.back().length = end - merged.back().offset;
+        } else {
+            merged.push_back(range);
+        }
+    }
+    _ranges.clear();
+
+    chunk_bytes = std::max(chunk_bytes, 1UL);
+    for (const Range& range : merged) {
+        for (uint64_t offset = 0; offset < range.length; offset += chunk_bytes) {
+            _chunks.push_back(Range(range.offset + offset,
+                                    std::min(chunk_bytes, range.length - offset)));
+        }
+    }
+
+    std::vector<size_t> chunk_indices;
+    {
+        AutoMutexLock lock(&_mutex);
+        _max_inflight_bytes = max_inflight_bytes;
+        _pick_chunks(&chunk_indices);
+    }
+    _offer_chunks(chunk_indices);
+}
+
+void FilePrefetcher::cancel() {
+    AutoMutexLock lock(&_mutex);
+    _cancelled = true;
+    while (_running > 0) {
+        _cond.wait();
+    }
+}
+
+uint64_t FilePrefetcher::prefetched_bytes() {
+    AutoMutexLock lock(&_mutex);
+    return _prefetched_bytes;
+}
+
+void FilePrefetcher::_pick_chunks(std::vector<size_t>* chunk_indices) {
+    if (NULL == _thread_pool) {
+        return;
+    }
+
+    // 至少保证一个chunk在读, 即使共用的计数已经超过max_inflight_bytes.
+    // 计数可能被其他FilePrefetcher同时修改, 先加上再检查, 超出时退回
+    while (!_cancelled && _next_chunk < _chunks.size()) {
+        int64_t length = _chunks[_next_chunk].length;
+        int64_t inflight_bytes = _inflight_bytes->fetch_add(length) + length;
+        if (0 != _running && inflight_bytes > static_cast<int64_t>(_max_inflight_bytes)) {
+            _inflight_bytes->fetch_sub(length);
+            break;
+        }
+
+        ++_running;
+        chunk_indices->push_back(_next_chunk);
+        ++_next_chunk;
+    }
+}
+
+void FilePrefetcher::_offer_chunks(const std::vector<size_t>& chunk_indices) {
+    for (size_t i = 0; i < chunk_indices.size(); ++i) {
+        size_t chunk_index = chunk_indices[i];
+        if (_thread_pool->try_offer(boost::bind(&FilePrefetcher::_prefetch, this, chunk_index))) {
+            continue;
+        }
+
+        // 线程池已满, 放弃剩余的预读, 数据仍会在读取时同步读出
+        AutoMutexLock lock(&_mutex);
+        for (size_t j = i; j < chunk_indices.size(); ++j) {
+            _inflight_bytes->fetch_sub(_chunks[chunk_indices[j]].length);
+            --_running;
+        }
+        _cancelled = true;
+        _cond.notify_all();
+        OLAP_LOG_DEBUG("prefetch thread pool is full, stop prefetching. [file='%s']",
+                       _file_handler->file_name().c_str());
+        return;
+    }
+}
+
+void FilePrefetcher::_prefetch(size_t chunk_index) {
+    const Range& chunk = _chunks[chunk_index];
+    bool cancelled = false;
+    {
+        AutoMutexLock lock(&_mutex);
+        cancelled = _cancelled;
+    }
+
+    // 只提交内核预读, 数据进入page cache, 不读到用户态
+    int err = 0;
+    if (!cancelled) {
+        err = posix_fadvise(_file_handler->fd(), chunk.offset, chunk.length,
+                            POSIX_FADV_WILLNEED);
+    }
+
+    std::vector<size_t> chunk_indices;
+    {
+        AutoMutexLock lock(&_mutex);
+        _inflight_bytes->fetch_sub(chunk.length);
+        if (0 == err && !cancelled) {
+            _prefetched_bytes += chunk.length;
+        } else if (0 != err) {
+            OLAP_LOG_WARNING("fail to prefetch file, stop prefetching. "
+                             "[file='%s' offset=%lu length=%lu err=%d]",
+                             _file_handler->file_name().c_str(),
+                             chunk.offset, chunk.length, err);
+            _cancelled = true;
+        }
+
+        _pick_chunks(&chunk_indices);
+        // _running在提交新的chunk之后再减少, 保证cancel返回时不会再有新的预读
+        --_running;
+        _cond.notify_all();
+    }
+    _offer_chunks(chunk_indices);
+}
+
+}  // namespace column_file
+}  // namespace palo
@@ -0,0 +1,112 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_FILE_PREFETCHER_H
+#define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_FILE_PREFETCHER_H
+
+#include <atomic>
+#include <vector>
+
+#include "olap/file_helper.h"
+#include "olap/olap_define.h"
+#include "olap/utils.h"
+
+namespace palo {
+
+class ThreadPool;
+
+namespace column_file {
+
+// 异步预读文件中即将被读取的区间, 使数据在ReadOnlyFileStream真正读取之前已经
+// 进入page cache, 避免扫描线程逐个压缩块同步地等待磁盘.
+//
+// 使用方式: add_range添加所有需要的区间后调用submit, 相邻(间隔不超过coalesce_bytes)
+// 的区间会被合并, 合并后的区间按chunk_bytes切分后提交到线程池, 由线程池通过
+// posix_fadvise(POSIX_FADV_WILLNEED)让内核预读, 不需要额外的buffer.
+// 同时在预读的字节数记在inflight_bytes中, 多个FilePrefetcher可以共用一个计数
+// (如同一个fragment实例的所有segment reader), 总量不超过max_inflight_bytes,
+// 但每个FilePrefetcher总可以有一个chunk在预读. 预读只是优化, 失败或者线程池
+// 繁忙时直接放弃.
+class FilePrefetcher {
+public:
+    struct Range {
+        Range(uint64_t offset_, uint64_t length_) : offset(offset_), length(length_) {}
+
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    // inflight_bytes为NULL时只限制本FilePrefetcher同时在预读的字节数
+    FilePrefetcher(FileHandler* file_handler,
+                   ThreadPool* thread_pool,
+                   std::atomic<int64_t>* inflight_bytes);
+
+    // 会等待正在进行的预读结束, 因此需在file_handler关闭之前析构
+    ~FilePrefetcher();
+
+    // 添加一段需要预读的区间, 需在submit之前调用
+    void add_range(uint64_t offset, uint64_t length);
+
+    // 合并区间并开始异步预读, 只能调用一次
+    void submit(uint64_t coalesce_bytes, uint64_t chunk_bytes, uint64_t max_inflight_bytes);
+
+    // 不再提交新的预读, 并等待正在进行的预读结束
+    void cancel();
+
+    // 合并切分后的预读区间, 按offset排序
+    const std::vector<Range>& chunks() const {
+        return _chunks;
+    }
+
+    uint64_t prefetched_bytes();
+
+private:
+    // 在持有_mutex时调用, 返回本次可以提交的chunk
+    void _pick_chunks(std::vector<size_t>* chunk_indices);
+
+    // 将chunk提交到线程池, 不能持有_mutex, 否则线程池满时可能死锁
+    void _offer_chunks(const std::vector<size_t>& chunk_indices);
+
+    // 在线程池中执行
+    void _prefetch(size_t chunk_index);
+
+    FileHandler* _file_handler;
+    ThreadPool* _thread_pool;
+
+    std::vector<Range> _ranges;
+    std::vector<Range> _chunks;
+    size_t _next_chunk;
+
+    uint64_t _max_inflight_bytes;
+    std::atomic<int64_t> _local_inflight_bytes;
+    std::atomic<int64_t>* _inflight_bytes;   // 指向共用的计数或_local_inflight_bytes
+    uint32_t _running;
+    uint64_t _prefetched_bytes;
+    bool _cancelled;
+
+    MutexLock _mutex;
+    Condition _cond;
+
+    DISALLOW_COPY_AND_ASSIGN(FilePrefetcher);
+};
+
+}  // namespace column_file
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_FILE_PREFETCHER_H
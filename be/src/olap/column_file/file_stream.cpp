@@ -21,6 +21,7 @@
 
 #include "olap/column_file/byte_buffer.h"
 #include "olap/column_file/out_stream.h"
+#include "olap/column_file/page_cache.h"
 
 namespace palo {
 namespace column_file {
@@ -34,6 +35,9 @@ ReadOnlyFileStream::ReadOnlyFileStream(
         _compressed_helper(NULL),
         _uncompressed(NULL),
         _shared_buffer(shared_buffer),
+        _page_cache(NULL),
+        _page_cache_key_prefix(NULL),
+        _cached_page(NULL),
         _decompressor(decompressor),
         _compress_buffer_size(compress_buffer_size + sizeof(StreamHead)),
         _current_compress_position(std::numeric_limits<uint64_t>::max()) {
@@ -50,6 +54,9 @@ ReadOnlyFileStream::ReadOnlyFileStream(
         _compressed_helper(NULL),
         _uncompressed(NULL),
         _shared_buffer(shared_buffer),
+        _page_cache(NULL),
+        _page_cache_key_prefix(NULL),
+        _cached_page(NULL),
         _decompressor(decompressor),
         _compress_buffer_size(compress_buffer_size + sizeof(StreamHead)),
         _current_compress_position(std::numeric_limits<uint64_t>::max()) {
@@ -65,8 +72,12 @@ OLAPStatus ReadOnlyFileStream::_assure_data() {
         return OLAP_ERR_COLUMN_STREAM_EOF;
     }
 
-    StreamHead header;
     size_t file_cursor_used = _file_cursor.position();
+    if (NULL != _page_cache && _read_cached_page(file_cursor_used)) {
+        return OLAP_SUCCESS;
+    }
+
+    StreamHead header;
     OLAPStatus res = _file_cursor.read(reinterpret_cast<char*>(&header), sizeof(header));
 
     if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
@@ -99,9 +110,40 @@ OLAPStatus ReadOnlyFileStream::_assure_data() {
 
     _uncompressed = _compressed_helper;
     _current_compress_position = file_cursor_used;
+
+    if (NULL != _page_cache) {
+        _page_cache->insert(*_page_cache_key_prefix,
+                            _file_cursor.offset() + file_cursor_used,
+                            _file_cursor.position() - file_cursor_used,
+                            *_uncompressed);
+    }
+
     return res;
 }
 
+bool ReadOnlyFileStream::_read_cached_page(size_t file_cursor_used) {
+    uint64_t compressed_length = 0;
+    ByteBuffer* page = _page_cache->lookup(*_page_cache_key_prefix,
+                                           _file_cursor.offset() + file_cursor_used,
+                                           &compressed_length);
+    if (NULL == page) {
+        return false;
+    }
+
+    if (OLAP_SUCCESS != _file_cursor.seek(file_cursor_used + compressed_length)) {
+        OLAP_LOG_WARNING("cached page is out of stream, ignore it. [position=%lu length=%lu]",
+                         file_cursor_used, compressed_length);
+        SAFE_DELETE(page);
+        return false;
+    }
+
+    SAFE_DELETE(_cached_page);
+    _cached_page = page;
+    _uncompressed = _cached_page;
+    _current_compress_position = file_cursor_used;
+    return true;
+}
+
 // 设置读取的位置
 OLAPStatus ReadOnlyFileStream::seek(PositionProvider* position) {
     OLAPStatus res = OLAP_SUCCESS;
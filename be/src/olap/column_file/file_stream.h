@@ -25,6 +25,7 @@
 #include <iostream>
 #include <istream>
 #include <streambuf>
+#include <string>
 #include <vector>
 
 #include "olap/column_file/byte_buffer.h"
@@ -36,6 +37,8 @@
 namespace palo {
 namespace column_file {
 
+class PageCache;
+
 // 定义输入数据流接口
 class ReadOnlyFileStream {
 public:
@@ -68,6 +71,14 @@ public:
 
     ~ReadOnlyFileStream() {
         SAFE_DELETE(_compressed_helper);
+        SAFE_DELETE(_cached_page);
+    }
+
+    // 设置后解压的数据块会从page_cache中读取或放入page_cache,
+    // key_prefix标识了所在的segment, 需在流的生命周期内有效
+    void set_page_cache(PageCache* page_cache, const std::string* key_prefix) {
+        _page_cache = page_cache;
+        _page_cache_key_prefix = key_prefix;
     }
 
     inline OLAPStatus init() {
@@ -108,6 +119,11 @@ public:
         return _file_cursor.length();
     }
 
+    // 返回流在文件中的起始位置
+    uint64_t stream_offset() {
+        return _file_cursor.offset();
+    }
+
     bool eof() {
         if (_uncompressed == NULL) {
             return _file_cursor.eof();
@@ -181,6 +197,10 @@ private:
             return _length;
         }
 
+        size_t offset() {
+            return _offset;
+        }
+
         inline bool eof() {
             return _used == _length;
         }
@@ -203,11 +223,18 @@ private:
     OLAPStatus _assure_data();
     OLAPStatus _fill_compressed(size_t length);
 
+    // 从page cache中读取位于file_cursor_used的数据块, 未命中时返回false
+    bool _read_cached_page(size_t file_cursor_used);
+
     FileCursor _file_cursor;
     ByteBuffer* _compressed_helper;
     ByteBuffer* _uncompressed;
     ByteBuffer** _shared_buffer;
 
+    PageCache* _page_cache;
+    const std::string* _page_cache_key_prefix;
+    ByteBuffer* _cached_page;           // 引用page cache中的数据块
+
     Decompressor _decompressor;
     size_t _compress_buffer_size;
     size_t _current_compress_position;
@@ -19,6 +19,7 @@
 
 #include "olap/column_file/out_stream.h"
 
+#include "common/config.h"
 #include "olap/column_file/byte_buffer.h"
 #include "olap/file_helper.h"
 #include "olap/utils.h"
@@ -43,6 +44,15 @@ OutStreamFactory::OutStreamFactory(CompressKind compress_kind, uint32_t stream_b
         _compressor = lz4_compress;
         break;
 
+    case COMPRESS_ZSTD:
+        _compressor = zstd_compress;
+        break;
+
+    case COMPRESS_ADAPTIVE:
+        // 每条流在OutStream中自行选择
+        _compressor = NULL;
+        break;
+
     default:
         OLAP_LOG_FATAL("unknown compress kind. [kind=%d]", compress_kind);
     }
@@ -63,6 +73,9 @@ OutStream* OutStreamFactory::create_stream(
         stream = new(std::nothrow) OutStream(_stream_buffer_size, NULL);
     } else {
         stream = new(std::nothrow) OutStream(_stream_buffer_size, _compressor);
+        if (NULL != stream && COMPRESS_ADAPTIVE == _compress_kind) {
+            stream->set_adaptive_compress();
+        }
     }
 
     if (NULL == stream) {
@@ -82,7 +95,10 @@ OutStream::OutStream(uint32_t buffer_size, Compressor compressor) :
         _current(NULL),
         _compressed(NULL),
         _overflow(NULL),
-        _spilled_bytes(0) {}
+        _spilled_bytes(0),
+        _is_adaptive_compress(false),
+        _is_compressor_chosen(false),
+        _compress_kind(COMPRESS_NONE) {}
 
 OutStream::~OutStream() {
     SAFE_DELETE(_current);
@@ -186,6 +202,68 @@ OLAPStatus OutStream::_make_sure_output_buffer() {
     return OLAP_SUCCESS;
 }
 
+CompressKind OutStream::choose_compress_kind(
+        uint64_t raw_size, uint64_t lz4_size, uint64_t zstd_size) {
+    uint64_t max_size = raw_size * (100 - config::adaptive_compress_min_saving_percent) / 100;
+    // zstd需要比lz4节省足够多的空间, 否则使用解压更快的lz4
+    bool zstd_gain_enough = zstd_size
+            <= lz4_size * (100 - config::adaptive_compress_zstd_min_gain_percent) / 100;
+    if (zstd_size <= max_size && zstd_gain_enough) {
+        return COMPRESS_ZSTD;
+    } else if (lz4_size <= max_size) {
+        return COMPRESS_LZ4;
+    }
+
+    return COMPRESS_NONE;
+}
+
+OLAPStatus OutStream::_choose_compressor() {
+    _is_compressor_chosen = true;
+
+    uint64_t raw_size = _current->position() - sizeof(StreamHead);
+    ByteBuffer* sample_input = ByteBuffer::reference_buffer(_current, sizeof(StreamHead), raw_size);
+    ByteBuffer* sample_output = ByteBuffer::create(_buffer_size + sizeof(StreamHead));
+    if (NULL == sample_input || NULL == sample_output) {
+        SAFE_DELETE(sample_input);
+        SAFE_DELETE(sample_output);
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    // 只比较压缩后的大小, 同样的数据总是选择同样的压缩方式
+    Compressor compressors[] = {lz4_compress, zstd_compress};
+    uint64_t sizes[] = {raw_size, raw_size};
+    for (size_t i = 0; i < sizeof(compressors) / sizeof(Compressor); ++i) {
+        sample_input->set_position(0);
+        sample_output->set_position(0);
+        sample_output->set_limit(sample_output->capacity());
+        // 没有变小或者压缩失败的, 按照不压缩处理
+        bool smaller = false;
+        if (OLAP_SUCCESS == compressors[i](sample_input, sample_output, &smaller) && smaller) {
+            sizes[i] = sample_output->position();
+        }
+    }
+
+    SAFE_DELETE(sample_input);
+    SAFE_DELETE(sample_output);
+
+    _compress_kind = choose_compress_kind(raw_size, sizes[0], sizes[1]);
+    switch (_compress_kind) {
+    case COMPRESS_LZ4:
+        _compressor = lz4_compress;
+        break;
+    case COMPRESS_ZSTD:
+        _compressor = zstd_compress;
+        break;
+    default:
+        _compressor = NULL;
+        break;
+    }
+
+    OLAP_LOG_DEBUG("choose compressor for stream. [kind=%d raw=%lu lz4=%lu zstd=%lu]",
+            _compress_kind, raw_size, sizes[0], sizes[1]);
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus OutStream::_spill() {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -193,6 +271,13 @@ OLAPStatus OutStream::_spill() {
         return OLAP_SUCCESS;
     }
 
+    if (_is_adaptive_compress && !_is_compressor_chosen) {
+        if (OLAP_SUCCESS != (res = _choose_compressor())) {
+            OLAP_LOG_WARNING("fail to choose compressor. [res=%d]", res);
+            return res;
+        }
+    }
+
     // 如果不压缩，直接读取current，注意output之后 current会被清空并设置为NULL
     if (_compressor == NULL) {
         _current->flip();
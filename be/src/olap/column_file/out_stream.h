@@ -75,6 +75,23 @@ public:
     bool is_suppressed() const {
         return _is_suppressed;
     }
+
+    // 启用adaptive压缩, 第一次输出数据时用第一块数据分别试压lz4和zstd,
+    // 根据压缩后的大小为整条流选择NONE/LZ4/ZSTD, 必须在写入数据前调用
+    void set_adaptive_compress() {
+        _is_adaptive_compress = true;
+    }
+    bool is_adaptive_compress() const {
+        return _is_adaptive_compress;
+    }
+    // adaptive压缩时流最终使用的压缩方式, 在flush之后才有意义
+    CompressKind compress_kind() const {
+        return _compress_kind;
+    }
+    // 根据同一块数据的原始大小和lz4, zstd压缩后的大小选择压缩方式:
+    // 都没有节省足够的空间时不压缩, zstd比lz4节省足够多时用zstd, 否则用lz4
+    static CompressKind choose_compress_kind(
+            uint64_t raw_size, uint64_t lz4_size, uint64_t zstd_size);
     void suppress() {
         _is_suppressed = true;
     }
@@ -108,6 +125,7 @@ private:
     void _output_uncompress();
     void _output_compressed();
     OLAPStatus _make_sure_output_buffer();
+    OLAPStatus _choose_compressor();
 
     uint32_t _buffer_size;                   // 压缩块大小
     Compressor _compressor;                  // 压缩函数,如果为NULL表示不压缩
@@ -117,6 +135,9 @@ private:
     ByteBuffer* _compressed;                 // 即将输出到output_buffers中的字节
     ByteBuffer* _overflow;                   // _output中放不下的字节
     uint64_t _spilled_bytes;                 // 已经输出到output的字节数
+    bool _is_adaptive_compress;              // 是否根据采样结果选择压缩函数
+    bool _is_compressor_chosen;              // adaptive压缩时是否已经选择了压缩函数
+    CompressKind _compress_kind;             // adaptive压缩时选择的压缩方式
 
     DISALLOW_COPY_AND_ASSIGN(OutStream);
 };
@@ -0,0 +1,159 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/column_file/page_cache.h"
+
+#include "util/palo_metrics.h"
+
+namespace palo {
+namespace column_file {
+
+PageCache::PageCache(size_t capacity, size_t admission_capacity) :
+        _cache(new_lru_cache(capacity)),
+        _admission_keys(NULL) {
+    if (admission_capacity > 0) {
+        _admission_keys = new_lru_cache(admission_capacity);
+    }
+}
+
+PageCache::~PageCache() {
+    // ShardedLRUCache析构时不会释放元素, 先清理没有被引用的数据块
+    if (NULL != _cache) {
+        _cache->prune();
+    }
+    SAFE_DELETE(_cache);
+
+    if (NULL != _admission_keys) {
+        _admission_keys->prune();
+    }
+    SAFE_DELETE(_admission_keys);
+}
+
+std::string PageCache::key_prefix(const std::string& file_name, const Version& version) {
+    std::string prefix = file_name;
+    prefix.append(reinterpret_cast<const char*>(&version.first), sizeof(version.first));
+    prefix.append(reinterpret_cast<const char*>(&version.second), sizeof(version.second));
+    return prefix;
+}
+
+CacheKey PageCache::_construct_key(
+        char* buf, size_t len, const std::string& prefix, uint64_t offset) {
+    char* current = buf;
+    size_t remain_len = len;
+    OLAP_CACHE_STRING_TO_BUF(current, prefix, remain_len);
+    OLAP_CACHE_NUMERIC_TO_BUF(current, offset, remain_len);
+
+    return CacheKey(buf, len - remain_len);
+}
+
+void PageCache::_delete_cached_page(const CacheKey& key, void* value) {
+    CachedPage* page = reinterpret_cast<CachedPage*>(value);
+    SAFE_DELETE(page);
+}
+
+ByteBuffer* PageCache::lookup(
+        const std::string& prefix, uint64_t offset, uint64_t* compressed_length) {
+    char key_buf[OLAP_LRU_CACHE_MAX_KEY_LENTH];
+    CacheKey key = _construct_key(key_buf, sizeof(key_buf), prefix, offset);
+    if (key.empty()) {
+        return NULL;
+    }
+
+    if (NULL != PaloMetrics::page_cache_lookup_count()) {
+        PaloMetrics::page_cache_lookup_count()->increment(1);
+    }
+
+    Cache::Handle* handle = _cache->lookup(key);
+    if (NULL == handle) {
+        return NULL;
+    }
+
+    // 引用的ByteBuffer共享缓存中的内存, 因此不需要一直持有handle
+    CachedPage* page = reinterpret_cast<CachedPage*>(_cache->value(handle));
+    ByteBuffer* buffer = ByteBuffer::reference_buffer(page->buffer, 0, page->buffer->limit());
+    *compressed_length = page->compressed_length;
+    _cache->release(handle);
+
+    if (NULL != buffer && NULL != PaloMetrics::page_cache_hit_count()) {
+        PaloMetrics::page_cache_hit_count()->increment(1);
+    }
+
+    return buffer;
+}
+
+void PageCache::insert(const std::string& prefix,
+                       uint64_t offset,
+                       uint64_t compressed_length,
+                       const ByteBuffer& page) {
+    if (0 == page.limit()) {
+        return;
+    }
+
+    char key_buf[OLAP_LRU_CACHE_MAX_KEY_LENTH];
+    CacheKey key = _construct_key(key_buf, sizeof(key_buf), prefix, offset);
+    if (key.empty() || !_admit(key)) {
+        return;
+    }
+
+    CachedPage* cached_page = new(std::nothrow) CachedPage();
+    if (NULL == cached_page) {
+        OLAP_LOG_WARNING("fail to malloc cached page.");
+        return;
+    }
+
+    cached_page->compressed_length = compressed_length;
+    cached_page->buffer = ByteBuffer::create(page.limit());
+    if (NULL == cached_page->buffer
+            || OLAP_SUCCESS != cached_page->buffer->put(page.array(), page.limit())) {
+        OLAP_LOG_WARNING("fail to copy page to cache. [size=%lu]", page.limit());
+        SAFE_DELETE(cached_page);
+        return;
+    }
+    cached_page->buffer->flip();
+
+    Cache::Handle* handle = _cache->insert(
+            key, cached_page, page.limit(), &_delete_cached_page);
+    if (NULL != handle) {
+        _cache->release(handle);
+    }
+}
+
+bool PageCache::_admit(const CacheKey& key) {
+    if (NULL == _admission_keys) {
+        return true;
+    }
+
+    Cache::Handle* handle = _admission_keys->lookup(key);
+    if (NULL != handle) {
+        _admission_keys->release(handle);
+        _admission_keys->erase(key);
+        return true;
+    }
+
+    // key保存在LRUHandle的末尾, 按handle的实际大小计费
+    size_t charge = sizeof(LRUHandle) - 1 + key.size();
+    handle = _admission_keys->insert(key, NULL, charge, &_delete_admission_key);
+    if (NULL != handle) {
+        _admission_keys->release(handle);
+    }
+    return false;
+}
+
+}  // namespace column_file
+}  // namespace palo
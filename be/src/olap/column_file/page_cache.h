@@ -0,0 +1,98 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_PAGE_CACHE_H
+#define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_PAGE_CACHE_H
+
+#include <string>
+
+#include "olap/column_file/byte_buffer.h"
+#include "olap/lru_cache.h"
+#include "olap/olap_define.h"
+
+namespace palo {
+namespace column_file {
+
+// 跨查询共享的解压后数据块缓存, 以(文件, 版本, 压缩块在文件中的位置)为key.
+// 同一个文件中每条流的压缩块位置各不相同, 因此位置同时标识了流和块.
+//
+// 为避免一次性的大查询把热点数据挤出缓存, 数据块在第一次被读取时只记录key,
+// 在最近未命中的key被淘汰前再次被读取时才放入缓存. 记录的key按实际占用的内存
+// 计费, 总共不超过admission_capacity字节; admission_capacity为0时不做准入控制.
+class PageCache {
+public:
+    PageCache(size_t capacity, size_t admission_capacity);
+    ~PageCache();
+
+    // key的前缀, 同一个segment的所有数据块共享
+    static std::string key_prefix(const std::string& file_name, const Version& version);
+
+    // 命中时返回缓存的数据块的一个引用, position为0, limit为数据长度,
+    // compressed_length返回该块在文件中占用的长度; 未命中返回NULL.
+    // 调用者获得返回的ByteBuffer的所有权
+    ByteBuffer* lookup(const std::string& prefix, uint64_t offset, uint64_t* compressed_length);
+
+    // 将数据块[0, page->limit())拷贝一份放入缓存, 未通过准入控制时不放入
+    void insert(const std::string& prefix,
+                uint64_t offset,
+                uint64_t compressed_length,
+                const ByteBuffer& page);
+
+    size_t get_memory_usage() {
+        return _cache->get_memory_usage();
+    }
+
+    // 准入控制记录的key占用的内存
+    size_t get_admission_memory_usage() {
+        return NULL == _admission_keys ? 0 : _admission_keys->get_memory_usage();
+    }
+
+private:
+    struct CachedPage {
+        CachedPage() : buffer(NULL), compressed_length(0) {}
+
+        ~CachedPage() {
+            SAFE_DELETE(buffer);
+        }
+
+        ByteBuffer* buffer;
+        uint64_t compressed_length;
+    };
+
+    static CacheKey _construct_key(
+            char* buf, size_t len, const std::string& prefix, uint64_t offset);
+
+    static void _delete_cached_page(const CacheKey& key, void* value);
+
+    static void _delete_admission_key(const CacheKey& key, void* value) {}
+
+    // 第一次被读取时返回false并记录key, 之后返回true
+    bool _admit(const CacheKey& key);
+
+    Cache* _cache;
+    // 只保存key, 每个key的charge为它在LRUHandle中占用的内存
+    Cache* _admission_keys;
+
+    DISALLOW_COPY_AND_ASSIGN(PageCache);
+};
+
+}  // namespace column_file
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_PAGE_CACHE_H
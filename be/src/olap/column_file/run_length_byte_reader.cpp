@@ -19,6 +19,10 @@
 
 #include "olap/column_file/run_length_byte_reader.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "olap/column_file/column_reader.h"
 #include "olap/column_file/in_stream.h"
 
@@ -97,6 +101,34 @@ OLAPStatus RunLengthByteReader::next(char* value) {
     return res;
 }
 
+OLAPStatus RunLengthByteReader::next_batch(char* values, uint64_t num_values) {
+    OLAPStatus res = OLAP_SUCCESS;
+
+    while (num_values > 0) {
+        if (_used == _num_literals) {
+            res = _read_values();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read values.[res = %d]", res);
+                return OLAP_ERR_DATA_EOF;
+            }
+        }
+
+        uint64_t num = std::min(num_values, static_cast<uint64_t>(_num_literals - _used));
+
+        if (_repeat) {
+            memset(values, _literals[0], num);
+        } else {
+            memcpy(values, &_literals[_used], num);
+        }
+
+        values += num;
+        num_values -= num;
+        _used += num;
+    }
+
+    return res;
+}
+
 OLAPStatus RunLengthByteReader::seek(PositionProvider* position) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -40,6 +40,8 @@ public:
     bool has_next() const;
     // 获取下一条数据, 如果没有更多的数据了, 返回OLAP_ERR_DATA_EOF
     OLAPStatus next(char* value);
+    // 批量读取num_values个数据, 重复的run用memset填充, 字面值直接memcpy
+    OLAPStatus next_batch(char* values, uint64_t num_values);
     OLAPStatus seek(PositionProvider* position);
     OLAPStatus skip(uint64_t num_values);
 
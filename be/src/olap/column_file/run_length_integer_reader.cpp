@@ -19,6 +19,10 @@
 
 #include "olap/column_file/run_length_integer_reader.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "olap/column_file/column_reader.h"
 #include "olap/column_file/in_stream.h"
 #include "olap/column_file/serialize.h"
@@ -26,6 +30,34 @@
 namespace palo {
 namespace column_file {
 
+// Replace values[i] by base + values[0] + ... + values[i]. Two values are
+// summed per SSE2 register so the carried dependency is half of the scalar loop.
+static inline void prefix_sum(int64_t* values, int32_t count, int64_t base) {
+    int32_t i = 0;
+
+#ifdef __SSE2__
+    __m128i carry = _mm_set1_epi64x(base);
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i* ptr = reinterpret_cast<__m128i*>(values + i);
+        __m128i v = _mm_loadu_si128(ptr);
+        v = _mm_add_epi64(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi64(v, carry);
+        _mm_storeu_si128(ptr, v);
+        carry = _mm_unpackhi_epi64(v, v);
+    }
+
+    if (i > 0) {
+        base = values[i - 1];
+    }
+#endif
+
+    for (; i < count; ++i) {
+        base = static_cast<uint64_t>(base) + static_cast<uint64_t>(values[i]);
+        values[i] = base;
+    }
+}
+
 RunLengthIntegerReader::RunLengthIntegerReader(ReadOnlyFileStream* input, bool is_singed) : 
         _input(input),
         _signed(is_singed),
@@ -115,12 +147,16 @@ OLAPStatus RunLengthIntegerReader::_read_delta_values(uint8_t first_byte) {
             return res;
         }
 
-        // add fixed deltas to adjacent values
+        // add fixed deltas to adjacent values, each value only depends on
+        // the first one so the loop has no carried dependency
+        int64_t* literals = &_literals[_num_literals];
+
         for (int i = 0; i < len; i++) {
-            //_literals[_num_literals++] = _literals[_num_literals - 2] + fd;
-            _literals[_num_literals] = _literals[_num_literals - 1] + fd;
-            _num_literals++;
+            literals[i] = static_cast<uint64_t>(first_val)
+                    + static_cast<uint64_t>(fd) * static_cast<uint64_t>(i + 1);
         }
+
+        _num_literals += len;
     } else {
         int64_t delta_base = 0;
 
@@ -144,17 +180,19 @@ OLAPStatus RunLengthIntegerReader::_read_delta_values(uint8_t first_byte) {
             return res;
         }
 
-        while (len > 0) {
-            if (delta_base < 0) {
-                _literals[_num_literals] = prev_val - _literals[_num_literals];
-            } else {
-                _literals[_num_literals] = prev_val + _literals[_num_literals];
-            }
+        // prefix sum of the deltas, the sign test is hoisted out of the loop
+        // and a decreasing sequence is handled by negating the deltas first
+        int64_t* literals = &_literals[_num_literals];
 
-            prev_val = _literals[_num_literals];
-            --len;
-            ++_num_literals;
+        if (delta_base < 0) {
+            // negate in unsigned arithmetic, -INT64_MIN is undefined for int64_t
+            for (int32_t i = 0; i < len; ++i) {
+                literals[i] = 0 - static_cast<uint64_t>(literals[i]);
+            }
         }
+
+        prefix_sum(literals, len, prev_val);
+        _num_literals += len;
     }
 
     return res;
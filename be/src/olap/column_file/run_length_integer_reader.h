@@ -20,6 +20,8 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_RUN_LENGTH_INTEGER_READER_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_RUN_LENGTH_INTEGER_READER_H
 
+#include <algorithm>
+
 #include "olap/column_file/file_stream.h"
 #include "olap/column_file/run_length_integer_writer.h"
 #include "olap/column_file/stream_index_reader.h"
@@ -55,6 +57,37 @@ public:
         *value = _literals[_used++];
         return res;
     }
+    // 批量读取num_values个数据到values中, 每次拷贝一整段已解码的run,
+    // 不足num_values时返回错误码
+    template <typename T>
+    inline OLAPStatus next_batch(T* values, uint32_t num_values) {
+        OLAPStatus res = OLAP_SUCCESS;
+
+        while (num_values > 0) {
+            if (OLAP_UNLIKELY(_used == _num_literals)) {
+                _num_literals = 0;
+                _used = 0;
+
+                res = _read_values();
+                if (OLAP_SUCCESS != res) {
+                    return res;
+                }
+            }
+
+            uint32_t num = std::min(num_values, static_cast<uint32_t>(_num_literals - _used));
+            const int64_t* literals = _literals + _used;
+
+            for (uint32_t i = 0; i < num; ++i) {
+                values[i] = literals[i];
+            }
+
+            values += num;
+            num_values -= num;
+            _used += num;
+        }
+
+        return res;
+    }
     OLAPStatus seek(PositionProvider* position);
     OLAPStatus skip(uint64_t num_values);
 
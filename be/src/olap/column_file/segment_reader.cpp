@@ -23,9 +23,12 @@
 
 #include <istream>
 
+#include "common/config.h"
+
 #include "olap/column_file/file_stream.h"
 #include "olap/column_file/in_stream.h"
 #include "olap/column_file/out_stream.h"
+#include "olap/column_file/page_cache.h"
 
 namespace palo {
 namespace column_file {
@@ -63,6 +66,7 @@ SegmentReader::SegmentReader(
         _mmap_buffer(NULL),
         _include_blocks(NULL),
         _filted_rows(0),
+        _skipped_blocks(0),
         _is_using_mmap(false),
         _is_data_loaded(false),
         _buffer_size(0),
@@ -70,11 +74,14 @@ SegmentReader::SegmentReader(
         _cache_handle(NULL),
         _vectorized_info_inited(false),
         _runtime_state(runtime_state),
-        _shared_buffer(NULL) {
+        _shared_buffer(NULL),
+        _prefetcher(NULL) {
     _lru_cache = OLAPEngine::get_instance()->index_stream_lru_cache();
 }
 
 SegmentReader::~SegmentReader() {
+    // 预读线程会访问_file_handler, 必须在关闭文件之前结束
+    SAFE_DELETE(_prefetcher);
     SAFE_DELETE(_shared_buffer);
     SAFE_DELETE_ARRAY(_include_blocks);
 
@@ -169,27 +176,10 @@ OLAPStatus SegmentReader::_load_segment_file() {
 }
 
 OLAPStatus SegmentReader::_set_decompressor() {
-    switch (_header_message().compress_kind()) {
-    case COMPRESS_NONE: {
-        _decompressor = NULL;
-        break;
-    }
-
-    case COMPRESS_LZO: {
-        _decompressor = lzo_decompress;
-        break;
-    }
-
-    case COMPRESS_LZ4: {
-        _decompressor = lz4_decompress;
-        break;
-    }
-
-    default: {
+    if (OLAP_SUCCESS != get_decompressor(_header_message().compress_kind(), &_decompressor)) {
         OLAP_LOG_WARNING("unknown decompressor");
         return OLAP_ERR_PARSE_PROTOBUF_ERROR;
     }
-    }
 
     return OLAP_SUCCESS;
 }
@@ -349,6 +339,10 @@ OLAPStatus SegmentReader::seek_to_block(
         }
     }
 
+    if (NULL == _prefetcher) {
+        _prefetch_data_streams(without_filter);
+    }
+
     _current_row = first_block * _num_rows_in_block;
     OLAP_LOG_DEBUG("first %u end %u; tol %u",
         first_block, last_block,
@@ -388,7 +382,8 @@ const RowCursor* SegmentReader::get_next_row(bool without_filter) {
         }
 
         bool row_del_filter = _delete_handler.is_filter_data(
-                                    _olap_index->version().second, _cursor);
+                                    _olap_index->version().second, _cursor,
+                                    _block_delete_conditions[_current_block]);
         if (false == row_del_filter) {
             ret = &_cursor;
             break;
@@ -399,6 +394,110 @@ const RowCursor* SegmentReader::get_next_row(bool without_filter) {
     return ret;
 }
 
+OLAPStatus SegmentReader::get_block(VectorizedRowBatch* batch, bool without_filter) {
+    bool use_dictionary_filter = !without_filter && config::enable_dictionary_filter
+            && NULL != _conditions && !_conditions->columns().empty();
+
+    while (true) {
+        OLAPStatus res = _move_to_next_row(without_filter);
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+
+        if (!without_filter && NULL != _include_blocks
+                && DEL_PARTIAL_SATISFIED == _include_blocks[_current_block]) {
+            OLAP_LOG_WARNING("block needs row level delete filter, can not be read in batch. "
+                    "[block=%ld]", _current_block);
+            return OLAP_ERR_READER_READING_ERROR;
+        }
+
+        // _move_to_next_row已经越过了本批的第一行
+        uint64_t start_row = _current_row - 1;
+        uint64_t block_end_row = std::min(
+                static_cast<uint64_t>(_current_block + 1) * _num_rows_in_block,
+                static_cast<uint64_t>(_header_message().number_of_rows()));
+        uint32_t size = std::min(block_end_row - start_row,
+                static_cast<uint64_t>(batch->capacity()));
+
+        // selected记录满足字典过滤条件的行
+        bool* selected = NULL;
+        if (use_dictionary_filter) {
+            selected = reinterpret_cast<bool*>(batch->mem_pool()->allocate(sizeof(bool) * size));
+            if (NULL == selected) {
+                OLAP_LOG_WARNING("fail to malloc selected flags. [size=%u]", size);
+                return OLAP_ERR_MALLOC_ERROR;
+            }
+            memset(selected, 1, sizeof(bool) * size);
+        }
+
+        for (std::vector<ColumnReader*>::iterator it = _column_readers.begin();
+                it != _column_readers.end(); ++it) {
+            ColumnVector* column_vector = batch->column((*it)->column_id());
+            res = OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+            if (NULL != selected) {
+                res = _next_batch_with_dictionary_filter(*it, column_vector, size,
+                        batch->mem_pool(), selected);
+            }
+
+            if (OLAP_ERR_FUNC_NOT_IMPLEMENTED == res) {
+                res = (*it)->next_batch(column_vector, size, batch->mem_pool());
+            }
+
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next batch. [res=%d column=%u]",
+                        res, (*it)->column_unique_id());
+                return res;
+            }
+        }
+
+        _current_row = start_row + size;
+        batch->set_size(size);
+        if (NULL == selected) {
+            return OLAP_SUCCESS;
+        }
+
+        int* selected_rows = batch->selected();
+        int num_selected = 0;
+        for (uint32_t i = 0; i < size; ++i) {
+            if (selected[i]) {
+                selected_rows[num_selected++] = i;
+            }
+        }
+
+        _filted_rows += size - num_selected;
+        if (num_selected == size) {
+            return OLAP_SUCCESS;
+        } else if (num_selected > 0) {
+            batch->set_selected_in_use(true);
+            batch->set_size(num_selected);
+            return OLAP_SUCCESS;
+        }
+
+        // 本批数据全部被过滤, 继续读下一批
+        batch->reset();
+    }
+}
+
+OLAPStatus SegmentReader::_next_batch_with_dictionary_filter(ColumnReader* reader,
+        ColumnVector* column_vector,
+        uint32_t size,
+        MemPool* mem_pool,
+        bool* selected) {
+    Conditions::CondColumns::const_iterator cond_it =
+            _conditions->columns().find(reader->column_id());
+    if (_conditions->columns().end() == cond_it) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    const FieldInfo& field_info = tablet_schema()[reader->column_id()];
+    if (OLAP_FIELD_TYPE_CHAR != field_info.type && OLAP_FIELD_TYPE_VARCHAR != field_info.type) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    return reader->next_batch_with_filter(column_vector, size, mem_pool,
+            cond_it->second, field_info, selected);
+}
+
 void SegmentReader::_set_column_map() {
     _encodings_map.clear();
     _table_id_to_unique_id_map.clear();
@@ -470,8 +569,16 @@ OLAPStatus SegmentReader::_pick_delete_row_groups(uint32_t first_block, uint32_t
         return OLAP_SUCCESS;
     }
 
-    for (auto& delete_condition : _delete_handler.get_delete_conditions()) {
+    _block_delete_conditions.assign(_block_count, std::vector<uint32_t>());
+    // 没有参与block级别判断的删除条件, 部分满足的block逐行判断时仍需要用到
+    std::vector<uint32_t> unpicked_conditions;
+
+    const std::vector<DeleteConditions>& delete_conditions =
+            _delete_handler.get_delete_conditions();
+    for (uint32_t cond_id = 0; cond_id < delete_conditions.size(); ++cond_id) {
+        const DeleteConditions& delete_condition = delete_conditions[cond_id];
         if (delete_condition.filter_version <= _olap_index->version().first) {
+            unpicked_conditions.push_back(cond_id);
             continue;
         }
 
@@ -491,6 +598,12 @@ OLAPStatus SegmentReader::_pick_delete_row_groups(uint32_t first_block, uint32_t
                 }
                 StreamIndexReader* index_reader = _indices[unique_column_id];
                 int del_ret = i.second.del_eval(index_reader->entry(j).column_statistic());
+                // 统计信息无法确定时, 用BloomFilter排除block中一定没有的值
+                if (DEL_PARTIAL_SATISFIED == del_ret
+                        && 0 != _bloom_filters.count(unique_column_id)) {
+                    del_ret = i.second.del_eval(_bloom_filters[unique_column_id]->entry(j));
+                }
+
                 if (DEL_SATISFIED == del_ret) {
                     continue;
                 } else if (DEL_PARTIAL_SATISFIED == del_ret) {
@@ -511,6 +624,7 @@ OLAPStatus SegmentReader::_pick_delete_row_groups(uint32_t first_block, uint32_t
                 }
             } else if (true == del_partial_satisfied) {
                 _include_blocks[j] = DEL_PARTIAL_SATISFIED;
+                _block_delete_conditions[j].push_back(cond_id);
                 OLAP_LOG_DEBUG("filter block partially: %d", j);
             } else {
                 _include_blocks[j] = DEL_SATISFIED;
@@ -526,6 +640,18 @@ OLAPStatus SegmentReader::_pick_delete_row_groups(uint32_t first_block, uint32_t
         }
     }
 
+    // 部分满足的block只需逐行判断在这个block上部分满足的删除条件,
+    // 不满足的删除条件对这个block中的任何一行都不会命中
+    for (int64_t j = first_block; j <= last_block; ++j) {
+        if (DEL_PARTIAL_SATISFIED == _include_blocks[j]) {
+            _block_delete_conditions[j].insert(_block_delete_conditions[j].end(),
+                                               unpicked_conditions.begin(),
+                                               unpicked_conditions.end());
+        } else {
+            std::vector<uint32_t>().swap(_block_delete_conditions[j]);
+        }
+    }
+
     return OLAP_SUCCESS;
 
 }
@@ -591,11 +717,12 @@ OLAPStatus SegmentReader::_pick_row_groups(uint32_t first_block, uint32_t last_b
             if (!i.second.eval(index_reader->entry(j).column_statistic())) {
                 _include_blocks[j] = DEL_SATISFIED;
                 --_remain_block;
-            }
-            if (j < _block_count - 1) {
-                _filted_rows += _num_rows_in_block; 
-            } else {
-                _filted_rows += _header_message().number_of_rows() - j * _num_rows_in_block;
+                ++_skipped_blocks;
+                if (j < _block_count - 1) {
+                    _filted_rows += _num_rows_in_block; 
+                } else {
+                    _filted_rows += _header_message().number_of_rows() - j * _num_rows_in_block;
+                }
             }
         }
     }
@@ -621,6 +748,11 @@ OLAPStatus SegmentReader::_pick_row_groups(uint32_t first_block, uint32_t last_b
         if (0 == _unique_id_to_segment_id_map.count(unique_column_id)) {
             continue;
         }
+        // 只为删除条件加载的BloomFilter没有对应的查询条件
+        if (0 == _conditions->columns().count(i)) {
+            continue;
+        }
+
         BloomFilterIndexReader* bf_reader = _bloom_filters[unique_column_id];
         for (int64_t j = first_block; j <= last_block; ++j) {
             if (_include_blocks[j] == DEL_SATISFIED) {
@@ -630,6 +762,7 @@ OLAPStatus SegmentReader::_pick_row_groups(uint32_t first_block, uint32_t last_b
             if (!_conditions->columns().at(i).eval(bf_reader->entry(j))) {
                 _include_blocks[j] = DEL_SATISFIED;
                 --_remain_block;
+                ++_skipped_blocks;
                 if (j < _block_count - 1) {
                     _filted_rows += _num_rows_in_block; 
                 } else {
@@ -767,7 +900,8 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
                 return OLAP_ERR_MALLOC_ERROR;
             }
             
-            res = index_message->init(stream_buffer, stream_length, type, is_using_cache, _null_supported);
+            res = index_message->init(stream_buffer, stream_length, type, is_using_cache,
+                    _null_supported, _header_message().null_aware_statistics());
             if (OLAP_SUCCESS != res) {
                 OLAP_LOG_WARNING("init index from cahce fail");
                 return res;
@@ -865,10 +999,24 @@ void SegmentReader::_fill_has_null(std::map<ColumnId, bool>* has_null) {
     }
 }
 
+PageCache* SegmentReader::_get_page_cache() {
+    if (NULL == _runtime_state || !_runtime_state->query_options().use_page_cache) {
+        return NULL;
+    }
+
+    return OLAPEngine::get_instance()->page_cache();
+}
+
 OLAPStatus SegmentReader::_read_all_data_streams(size_t* buffer_size) {
     int64_t stream_offset = _header_length;
     uint64_t stream_length = 0;
 
+    PageCache* page_cache = _get_page_cache();
+    if (NULL != page_cache) {
+        _page_cache_key_prefix = PageCache::key_prefix(
+                _file_handler.file_name(), _olap_index->version());
+    }
+
     // 每条流就一块整的
     for (int64_t stream_index = 0; stream_index < _header_message().stream_info_size();
             ++stream_index, stream_offset += stream_length) {
@@ -885,13 +1033,22 @@ OLAPStatus SegmentReader::_read_all_data_streams(size_t* buffer_size) {
                 && message.kind() == StreamInfoMessage::BLOOM_FILTER)) {
             continue;
         } else {
+            // adaptive压缩时每条流的压缩方式可能不同
+            Decompressor decompressor = _decompressor;
+            if (message.has_compress_kind()
+                    && OLAP_SUCCESS != get_decompressor(message.compress_kind(), &decompressor)) {
+                OLAP_LOG_WARNING("unknown decompressor of stream. [column=%u kind=%d]",
+                        unique_column_id, message.compress_kind());
+                return OLAP_ERR_PARSE_PROTOBUF_ERROR;
+            }
+
             StreamName name(unique_column_id, message.kind());
             ReadOnlyFileStream* stream = new(std::nothrow) ReadOnlyFileStream(
                     &_file_handler,
                     &_shared_buffer,
                     stream_offset,
                     stream_length,
-                    _decompressor,
+                    decompressor,
                     _header_message().stream_buffer_size());
             if (NULL == stream) {
                 OLAP_LOG_WARNING("fail to create stream");
@@ -904,6 +1061,10 @@ OLAPStatus SegmentReader::_read_all_data_streams(size_t* buffer_size) {
                 return res;
             }
 
+            if (NULL != page_cache && _is_column_included(unique_column_id)) {
+                stream->set_page_cache(page_cache, &_page_cache_key_prefix);
+            }
+
             _streams[name] = stream;
             *buffer_size += stream->get_buffer_size();
         }
@@ -912,6 +1073,43 @@ OLAPStatus SegmentReader::_read_all_data_streams(size_t* buffer_size) {
     return OLAP_SUCCESS;
 }
 
+void SegmentReader::_prefetch_data_streams(bool without_filter) {
+    ThreadPool* thread_pool = OLAPEngine::get_instance()->segment_prefetch_thread_pool();
+    if (!config::enable_segment_prefetch || NULL == thread_pool || _is_using_mmap) {
+        return;
+    }
+
+    // 预读以整条流为单位, 大部分block被条件过滤掉时读取的只是流的一小部分, 不值得预读
+    if (!without_filter && _remain_block * 2 < _block_count) {
+        return;
+    }
+
+    // 同一个fragment实例的segment reader共用同时在预读的字节数限制
+    std::atomic<int64_t>* inflight_bytes = NULL != _runtime_state
+            ? _runtime_state->segment_prefetch_inflight_bytes() : NULL;
+    _prefetcher = new(std::nothrow) FilePrefetcher(&_file_handler, thread_pool, inflight_bytes);
+    if (NULL == _prefetcher) {
+        OLAP_LOG_WARNING("fail to malloc prefetcher, skip prefetching.");
+        return;
+    }
+
+    for (std::map<StreamName, ReadOnlyFileStream*>::iterator it = _streams.begin();
+            it != _streams.end(); ++it) {
+        StreamInfoMessage::Kind kind = it->first.kind();
+        if (!_is_column_included(it->first.unique_column_id())
+                || StreamInfoMessage::ROW_INDEX == kind
+                || StreamInfoMessage::BLOOM_FILTER == kind) {
+            continue;
+        }
+
+        _prefetcher->add_range(it->second->stream_offset(), it->second->stream_length());
+    }
+
+    _prefetcher->submit(config::segment_prefetch_coalesce_bytes,
+                        config::segment_prefetch_chunk_bytes,
+                        config::segment_prefetch_max_inflight_bytes);
+}
+
 OLAPStatus SegmentReader::_reader_skip(uint64_t skip_rows) {
     OLAPStatus res = OLAP_SUCCESS;
 
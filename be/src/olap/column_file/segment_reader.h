@@ -30,6 +30,7 @@
 #include "olap/column_file/bloom_filter_reader.h"
 #include "olap/column_file/column_reader.h"
 #include "olap/column_file/compress.h"
+#include "olap/column_file/file_prefetcher.h"
 #include "olap/column_file/file_stream.h"
 #include "olap/column_file/in_stream.h"
 #include "olap/column_file/stream_index_reader.h"
@@ -49,6 +50,7 @@ namespace palo {
 namespace column_file {
 
 class ColumnReader;
+class PageCache;
 
 // SegmentReader 用于读取一个Segment文件
 class SegmentReader {
@@ -89,6 +91,13 @@ public:
     // @return 绑定数据的RowCursor，失败或无数据可读则返回NULL
     const RowCursor* get_next_row(bool without_filter);
 
+    // 按列读取下一批数据至batch，不经过RowCursor，行数通过batch->size()返回。
+    // 一批数据不会跨越block，因此最多读到当前block的结尾。
+    // 只用于没有行级删除条件的情况，遇到需要逐行判断删除条件的block会返回错误
+    // 字典编码的字符串列上有查询条件时, 按字典码过滤行, 满足条件的行由batch->selected()给出
+    // @return 无数据可读时返回OLAP_ERR_DATA_EOF
+    OLAPStatus get_block(VectorizedRowBatch* batch, bool without_filter);
+
     // 返回最后一行数据
     // @return 绑定数据的RowCursor，失败或无数据可读则返回NULL
     const RowCursor* get_current_row() const {
@@ -143,6 +152,11 @@ public:
         return _filted_rows;
     }
 
+    // 根据index中的统计信息和bloom filter跳过的block数
+    uint64_t get_skipped_blocks() const {
+        return _skipped_blocks;
+    }
+
 private:
     typedef std::vector<ColumnId>::iterator ColumnIdIterator;
 
@@ -252,6 +266,20 @@ private:
     // 前进n行
     OLAPStatus _move_to_next_row(bool without_filter);
 
+    // 选出要读取的block之后, 异步预读需要的数据流
+    void _prefetch_data_streams(bool without_filter);
+
+    // 查询时使用page cache, 导入和合并等只读一次的场景不使用
+    PageCache* _get_page_cache();
+
+    // 列上有可在字典空间计算的条件时, 按条件读取一批数据并更新selected;
+    // 条件不适用时返回OLAP_ERR_FUNC_NOT_IMPLEMENTED, 由调用方改用next_batch
+    OLAPStatus _next_batch_with_dictionary_filter(ColumnReader* reader,
+            ColumnVector* column_vector,
+            uint32_t size,
+            MemPool* mem_pool,
+            bool* selected);
+
     // 跳转到某个row entry
     OLAPStatus _seek_to_row_entry(int64_t block_id);
 
@@ -356,8 +384,11 @@ private:
      * DEL_PARTIAL_SATISFIED is for block can't be filtered by the delete condition in block level.
     */
     uint8_t* _include_blocks;
+    // 部分满足删除条件的block需要逐行判断的删除条件, 是_delete_handler中的下标
+    std::vector<std::vector<uint32_t> > _block_delete_conditions;
     uint32_t _remain_block;
     uint64_t _filted_rows;
+    uint64_t _skipped_blocks;
     bool _need_block_filter;   //与include blocks组合使用，如果全不中，就不再读
     bool _is_using_mmap;                     // 这个标记为true时，使用mmap来读取文件
     bool _is_data_loaded;
@@ -372,6 +403,10 @@ private:
 
     RuntimeState* _runtime_state;  // 用于统计内存消耗等运行时信息
     ByteBuffer* _shared_buffer;
+    FilePrefetcher* _prefetcher;   // 每个segment只预读一次
+    std::string _page_cache_key_prefix;
+
+    friend class TestSegmentReader;
 
     DISALLOW_COPY_AND_ASSIGN(SegmentReader);
 };
@@ -141,6 +141,7 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
     file_header->set_magic_string("COLUMN DATA");
     file_header->set_version(1);
     file_header->set_num_rows_per_block(_table->num_rows_per_row_block());
+    file_header->set_null_aware_statistics(true);
 
     // check if has bloom filter columns
     bool has_bf_column = false;
@@ -193,6 +194,9 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
         stream_info->set_length(stream->get_stream_length());
         stream_info->set_column_unique_id(it->first.unique_column_id());
         stream_info->set_kind(it->first.kind());
+        if (stream->is_adaptive_compress()) {
+            stream_info->set_compress_kind(stream->compress_kind());
+        }
 
         if (it->first.kind() == StreamInfoMessage::ROW_INDEX || 
                 it->first.kind() == StreamInfoMessage::BLOOM_FILTER) {
@@ -19,13 +19,24 @@
 
 #include "olap/column_file/serialize.h"
 
+#include <string.h>
+#include <algorithm>
+
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
 #include "olap/column_file/file_stream.h"
 #include "olap/column_file/out_stream.h"
+#include "util/cpu_info.h"
 
 namespace palo {
 namespace column_file {
 namespace ser {
 
+// read_ints每次最多读入的字节数, 可以容纳MAX_SCOPE个64位整数
+static const uint32_t UNPACK_BUFFER_SIZE = 4096;
+
 OLAPStatus write_var_unsigned(OutStream* stream, int64_t value) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -254,40 +265,259 @@ OLAPStatus write_ints(OutStream* output, int64_t* data, uint32_t count, uint32_t
 
 OLAPStatus read_ints(ReadOnlyFileStream* input, int64_t* data, uint32_t count, uint32_t bit_width) {
     OLAPStatus res = OLAP_SUCCESS;
+
+    if (OLAP_UNLIKELY(0 == bit_width)) {
+        memset(data, 0, sizeof(int64_t) * count);
+        return res;
+    }
+
+    // 按8个数一组整批读入缓冲区再解码, 每组恰好占bit_width个字节,
+    // 避免逐字节调用input->read
+    char buffer[UNPACK_BUFFER_SIZE];
+    const uint32_t batch_count = UNPACK_BUFFER_SIZE / bit_width * 8;
+
+    while (count > 0) {
+        uint32_t num = std::min(count, batch_count);
+        uint64_t length = (static_cast<uint64_t>(num) * bit_width + 7) / 8;
+        uint64_t read_length = length;
+
+        res = input->read(buffer, &read_length);
+        if (OLAP_UNLIKELY(OLAP_SUCCESS != res || read_length != length)) {
+            OLAP_LOG_WARNING("fail to read packed ints from stream."
+                    "[res=%d length=%lu read_length=%lu]", res, length, read_length);
+            return OLAP_SUCCESS != res ? res : OLAP_ERR_COLUMN_STREAM_EOF;
+        }
+
+        unpack_ints(buffer, data, num, bit_width);
+        data += num;
+        count -= num;
+    }
+
+    return res;
+}
+
+namespace {
+
+// 定长字节的大端整数, 如8/16/24/32/40/48/56/64位
+template <uint32_t BYTES>
+inline void unpack_bytes(const uint8_t* in, int64_t* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t value = 0;
+
+        for (uint32_t j = 0; j < BYTES; ++j) {
+            value = (value << 8) | in[j];
+        }
+
+        out[i] = value;
+        in += BYTES;
+    }
+}
+
+// 不按字节对齐的位长, BITS <= 30, 因此current中最多缓存BITS + 7位
+template <uint32_t BITS>
+inline void unpack_bits(const uint8_t* in, int64_t* out, uint32_t count) {
+    const uint64_t mask = (1UL << BITS) - 1;
+    uint64_t current = 0;
     uint32_t bits_left = 0;
-    char current = '\0';
 
-    for (uint32_t i = 0; i < count; i++) {
-        int64_t result = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        while (bits_left < BITS) {
+            current = (current << 8) | *in++;
+            bits_left += 8;
+        }
+
+        bits_left -= BITS;
+        out[i] = (current >> bits_left) & mask;
+    }
+}
+
+// 不在FixedBitSize中的位长, 逐位读取
+void unpack_bits_generic(const uint8_t* in, int64_t* out, uint32_t count, uint32_t bit_width) {
+    uint32_t bits_left = 0;
+    uint8_t current = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t result = 0;
         uint32_t bits_left_to_read = bit_width;
 
         while (bits_left_to_read > bits_left) {
             result <<= bits_left;
-            result |= current & ((1 << bits_left) - 1);
+            result |= current & ((1U << bits_left) - 1);
             bits_left_to_read -= bits_left;
-            res = input->read(&current);
-
-            if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
-                OLAP_LOG_WARNING("fail to write byte to stream.[res=%d]", res);
-                return res;
-            }
-
+            current = *in++;
             bits_left = 8;
         }
 
-        // handle the left over bits
         if (bits_left_to_read > 0) {
             result <<= bits_left_to_read;
             bits_left -= bits_left_to_read;
-            result |= (current >> bits_left) & ((1 << bits_left_to_read) - 1);
+            result |= (current >> bits_left) & ((1U << bits_left_to_read) - 1);
         }
 
-        data[i] = result;
+        out[i] = result;
     }
-    
-    return res;
 }
 
+#ifdef __SSE4_1__
+// 以下SIMD版本每次处理16字节输入, 剩余不足16字节的部分交给标量版本
+void unpack_8_sse(const uint8_t* in, int64_t* out, uint32_t count) {
+    uint32_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+        __m128i* dst = reinterpret_cast<__m128i*>(out + i);
+        _mm_storeu_si128(dst, _mm_cvtepu8_epi64(v));
+        _mm_storeu_si128(dst + 1, _mm_cvtepu8_epi64(_mm_srli_si128(v, 2)));
+        _mm_storeu_si128(dst + 2, _mm_cvtepu8_epi64(_mm_srli_si128(v, 4)));
+        _mm_storeu_si128(dst + 3, _mm_cvtepu8_epi64(_mm_srli_si128(v, 6)));
+    }
+
+    unpack_bytes<1>(in + i, out + i, count - i);
+}
+
+void unpack_16_sse(const uint8_t* in, int64_t* out, uint32_t count) {
+    // 大端16位转为64位, 每个mask取出两个数
+    const __m128i mask0 = _mm_setr_epi8(1, 0, -1, -1, -1, -1, -1, -1,
+                                        3, 2, -1, -1, -1, -1, -1, -1);
+    const __m128i mask1 = _mm_setr_epi8(5, 4, -1, -1, -1, -1, -1, -1,
+                                        7, 6, -1, -1, -1, -1, -1, -1);
+    const __m128i mask2 = _mm_setr_epi8(9, 8, -1, -1, -1, -1, -1, -1,
+                                        11, 10, -1, -1, -1, -1, -1, -1);
+    const __m128i mask3 = _mm_setr_epi8(13, 12, -1, -1, -1, -1, -1, -1,
+                                        15, 14, -1, -1, -1, -1, -1, -1);
+    uint32_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+        __m128i* dst = reinterpret_cast<__m128i*>(out + i);
+        _mm_storeu_si128(dst, _mm_shuffle_epi8(v, mask0));
+        _mm_storeu_si128(dst + 1, _mm_shuffle_epi8(v, mask1));
+        _mm_storeu_si128(dst + 2, _mm_shuffle_epi8(v, mask2));
+        _mm_storeu_si128(dst + 3, _mm_shuffle_epi8(v, mask3));
+    }
+
+    unpack_bytes<2>(in + i * 2, out + i, count - i);
+}
+
+void unpack_32_sse(const uint8_t* in, int64_t* out, uint32_t count) {
+    const __m128i mask0 = _mm_setr_epi8(3, 2, 1, 0, -1, -1, -1, -1,
+                                        7, 6, 5, 4, -1, -1, -1, -1);
+    const __m128i mask1 = _mm_setr_epi8(11, 10, 9, 8, -1, -1, -1, -1,
+                                        15, 14, 13, 12, -1, -1, -1, -1);
+    uint32_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4));
+        __m128i* dst = reinterpret_cast<__m128i*>(out + i);
+        _mm_storeu_si128(dst, _mm_shuffle_epi8(v, mask0));
+        _mm_storeu_si128(dst + 1, _mm_shuffle_epi8(v, mask1));
+    }
+
+    unpack_bytes<4>(in + i * 4, out + i, count - i);
+}
+
+void unpack_64_sse(const uint8_t* in, int64_t* out, uint32_t count) {
+    const __m128i mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+                                       15, 14, 13, 12, 11, 10, 9, 8);
+    uint32_t i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi8(v, mask));
+    }
+
+    unpack_bytes<8>(in + i * 8, out + i, count - i);
+}
+#endif
+
+} // namespace
+
+#define UNPACK_BITS_CASE(n) \
+    case n: \
+        unpack_bits<n>(in, data, count); \
+        break;
+
+void unpack_ints(const char* buffer, int64_t* data, uint32_t count, uint32_t bit_width) {
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(buffer);
+
+#ifdef __SSE4_1__
+    if (CpuInfo::initialized() && CpuInfo::is_supported(CpuInfo::SSE4_1)) {
+        switch (bit_width) {
+        case 8:
+            unpack_8_sse(in, data, count);
+            return;
+        case 16:
+            unpack_16_sse(in, data, count);
+            return;
+        case 32:
+            unpack_32_sse(in, data, count);
+            return;
+        case 64:
+            unpack_64_sse(in, data, count);
+            return;
+        default:
+            break;
+        }
+    }
+#endif
+
+    switch (bit_width) {
+    UNPACK_BITS_CASE(1)
+    UNPACK_BITS_CASE(2)
+    UNPACK_BITS_CASE(3)
+    UNPACK_BITS_CASE(4)
+    UNPACK_BITS_CASE(5)
+    UNPACK_BITS_CASE(6)
+    UNPACK_BITS_CASE(7)
+    UNPACK_BITS_CASE(9)
+    UNPACK_BITS_CASE(10)
+    UNPACK_BITS_CASE(11)
+    UNPACK_BITS_CASE(12)
+    UNPACK_BITS_CASE(13)
+    UNPACK_BITS_CASE(14)
+    UNPACK_BITS_CASE(15)
+    UNPACK_BITS_CASE(17)
+    UNPACK_BITS_CASE(18)
+    UNPACK_BITS_CASE(19)
+    UNPACK_BITS_CASE(20)
+    UNPACK_BITS_CASE(21)
+    UNPACK_BITS_CASE(22)
+    UNPACK_BITS_CASE(23)
+    UNPACK_BITS_CASE(26)
+    UNPACK_BITS_CASE(28)
+    UNPACK_BITS_CASE(30)
+    case 8:
+        unpack_bytes<1>(in, data, count);
+        break;
+    case 16:
+        unpack_bytes<2>(in, data, count);
+        break;
+    case 24:
+        unpack_bytes<3>(in, data, count);
+        break;
+    case 32:
+        unpack_bytes<4>(in, data, count);
+        break;
+    case 40:
+        unpack_bytes<5>(in, data, count);
+        break;
+    case 48:
+        unpack_bytes<6>(in, data, count);
+        break;
+    case 56:
+        unpack_bytes<7>(in, data, count);
+        break;
+    case 64:
+        unpack_bytes<8>(in, data, count);
+        break;
+    default:
+        unpack_bits_generic(in, data, count, bit_width);
+        break;
+    }
+}
+
+#undef UNPACK_BITS_CASE
+
 } // namespace ser
 } // namespace column_file
 } // namespace palo
@@ -106,6 +106,10 @@ OLAPStatus write_ints(OutStream* output, int64_t* data, uint32_t count, uint32_t
 // 读取write_ints输出的数据
 OLAPStatus read_ints(ReadOnlyFileStream* input, int64_t* data, uint32_t count, uint32_t bit_width);
 
+// 从内存中解码write_ints输出的数据, buffer中至少有(count * bit_width + 7) / 8字节.
+// 每种定长比特位长都有单独展开的解码函数, 8/16/32/64位在CPU支持SSE4.1时使用SIMD解码
+void unpack_ints(const char* buffer, int64_t* data, uint32_t count, uint32_t bit_width);
+
 // Do not want to use Guava LongMath.checkedSubtract() here as it will throw
 // ArithmeticException in case of overflow
 inline bool is_safe_subtract(int64_t left, int64_t right) {
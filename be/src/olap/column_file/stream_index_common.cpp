@@ -29,7 +29,11 @@ ColumnStatistics::ColumnStatistics() :
         _minimum(NULL),
         _maximum(NULL),
          _ignored(true),
-        _null_supported(false) {
+        _null_supported(false),
+        _null_aware(false),
+        _has_null(false),
+        _all_null(false),
+        _not_null_flag(0) {
 }
 
 ColumnStatistics::~ColumnStatistics() {
@@ -59,12 +63,14 @@ OLAPStatus ColumnStatistics::init(const FieldType& type, bool null_supported) {
 }
 
 void ColumnStatistics::reset() {
+    _has_null = false;
+    _all_null = _null_supported;
     if (!_ignored) {
+        // 最大最小值只统计非NULL值，NULL的情况在输出时写入NULL标记
         _minimum->set_to_max();
         _maximum->set_to_min();
-        if (true == _null_supported) {
-            _maximum->set_null();
-        }
+        _minimum->set_not_null();
+        _maximum->set_not_null();
     }
 }
 
@@ -73,6 +79,11 @@ void ColumnStatistics::add(const Field* field) {
         return;
     }
 
+    if (field->is_null()) {
+        _has_null = true;
+        return;
+    }
+
     if (field->cmp(_maximum) > 0) {
         _maximum->copy(field);
     }
@@ -80,6 +91,7 @@ void ColumnStatistics::add(const Field* field) {
     if (field->cmp(_minimum) < 0) {
         _minimum->copy(field);
     }
+    _all_null = false;
 }
 
 void ColumnStatistics::merge(ColumnStatistics* other) {
@@ -87,6 +99,11 @@ void ColumnStatistics::merge(ColumnStatistics* other) {
         return;
     }
 
+    _has_null = _has_null || other->has_null();
+    if (other->all_null()) {
+        return;
+    }
+
     if (other->maximum()->cmp(_maximum) > 0) {
         _maximum->copy(other->maximum());
     }
@@ -94,6 +111,7 @@ void ColumnStatistics::merge(ColumnStatistics* other) {
     if (_minimum->cmp(other->minimum()) > 0) {
         _minimum->copy(other->minimum());
     }
+    _all_null = false;
 }
 
 size_t ColumnStatistics::size() const {
@@ -116,9 +134,23 @@ void ColumnStatistics::attach(char* buffer) {
     if (false == _null_supported) {
         _minimum->attach_buf(buffer);
         _maximum->attach_buf(buffer + _minimum->size());
-    } else {
+        _has_null = false;
+        _all_null = false;
+    } else if (false == _null_aware) {
+        // 旧格式中NULL被当作最小值参与统计
         _minimum->attach_field(buffer);
         _maximum->attach_field(buffer + _minimum->field_size());
+        _has_null = _minimum->is_null();
+        _all_null = _has_null && _maximum->is_null();
+    } else {
+        char* max_buffer = buffer + _minimum->field_size();
+        _has_null = (0 != buffer[0]);
+        _all_null = (0 != max_buffer[0]);
+        // 最大最小值本身总是非NULL的，NULL标记指向_not_null_flag
+        _minimum->attach_field(&_not_null_flag);
+        _minimum->attach_buf(buffer + sizeof(char));
+        _maximum->attach_field(&_not_null_flag);
+        _maximum->attach_buf(max_buffer + sizeof(char));
     }
 }
 
@@ -132,6 +164,11 @@ OLAPStatus ColumnStatistics::write_to_buffer(char* buffer, size_t size) {
     }
 
     memcpy(buffer, _buf, this->size());
+    if (true == _null_supported) {
+        // 旧版本按照NULL最小的规则解析这两个标记，得到的结果依然正确
+        buffer[0] = _has_null ? 1 : 0;
+        buffer[_minimum->field_size()] = _all_null ? 1 : 0;
+    }
     return OLAP_SUCCESS;
 }
 
@@ -47,6 +47,12 @@ public:
     // 初始化，需要给FieldType，用来初始化最大最小值
     // 使用前必须首先初始化，否则无效
     OLAPStatus init(const FieldType& type, bool null_supported);
+    // 读取时使用，表示attach的数据中最大最小值只统计了非NULL值，
+    // NULL的情况记录在最小值(有NULL)和最大值(全为NULL)的NULL标记中。
+    // 写入时总是按照这种格式输出
+    void set_null_aware(bool null_aware) {
+        _null_aware = null_aware;
+    }
     // 只是reset最大和最小值，将最小值设置为MAX，将最大值设置为MIN。
     void reset();
     // 增加一个值，根据传入值调整最大最小值
@@ -71,6 +77,18 @@ public:
     bool ignored() const {
         return _ignored;
     }
+    // block中是否有NULL值
+    bool has_null() const {
+        return _has_null;
+    }
+    // block中是否全为NULL值
+    bool all_null() const {
+        return _all_null;
+    }
+    // 为true时，minimum()和maximum()不会是NULL，只描述非NULL值的范围
+    bool null_aware() const {
+        return _null_aware;
+    }
 protected:
     Field* _minimum;
     Field* _maximum;
@@ -79,6 +97,11 @@ protected:
     // 也可以每次都分配
     bool _ignored;
     bool _null_supported;
+    bool _null_aware;
+    bool _has_null;
+    bool _all_null;
+    // null_aware格式读取时，最大最小值的NULL标记指向这里
+    char _not_null_flag;
 };
 
 }  // namespace column_file
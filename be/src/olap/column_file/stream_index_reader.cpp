@@ -31,7 +31,8 @@ PositionEntryReader::PositionEntryReader() :
 OLAPStatus PositionEntryReader::init(
         StreamIndexHeader* header, 
         FieldType type, 
-        bool null_supported) {
+        bool null_supported,
+        bool null_aware_statistics) {
     if (NULL == header) {
         return OLAP_ERR_INIT_FAILED;
     }
@@ -41,6 +42,7 @@ OLAPStatus PositionEntryReader::init(
     if (OLAP_SUCCESS != _statistics.init(type, null_supported)) {
         return OLAP_ERR_INIT_FAILED;
     }
+    _statistics.set_null_aware(null_aware_statistics);
 
     return OLAP_SUCCESS;
 }
@@ -81,6 +83,8 @@ StreamIndexReader::StreamIndexReader() :
         _start_offset(0),
         _step_size(0),
         _is_using_cache(false),
+        _null_supported(false),
+        _null_aware_statistics(false),
         _entry() {
 }
 
@@ -94,7 +98,7 @@ StreamIndexReader::~StreamIndexReader() {
 
 OLAPStatus StreamIndexReader::init(
         char* buffer, size_t buffer_size, FieldType type, 
-        bool is_using_cache, bool null_supported) {
+        bool is_using_cache, bool null_supported, bool null_aware_statistics) {
     if (NULL == buffer) {
         OLAP_LOG_WARNING("buffer given is invalid.");
         return OLAP_ERR_INPUT_PARAMETER_ERROR;
@@ -104,6 +108,7 @@ OLAPStatus StreamIndexReader::init(
     _buffer_size = buffer_size;
     _is_using_cache = is_using_cache;
     _null_supported = null_supported;
+    _null_aware_statistics = null_aware_statistics;
     OLAPStatus res = _parse_header(type);
 
     if (OLAP_SUCCESS != res) {
@@ -132,7 +137,7 @@ OLAPStatus StreamIndexReader::_parse_header(FieldType type) {
     StreamIndexHeader* header = reinterpret_cast<StreamIndexHeader*>(_buffer);
     OLAPStatus res = OLAP_SUCCESS;
 
-    res = _entry.init(header, type, _null_supported);
+    res = _entry.init(header, type, _null_supported, _null_aware_statistics);
 
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to init statistic reader");
@@ -31,7 +31,8 @@ public:
     PositionEntryReader();
     ~PositionEntryReader() {}
     // 使用前需要初始化，需要header来计算每一组position/stat的偏移量
-    OLAPStatus init(StreamIndexHeader* header, FieldType type, bool null_supported);
+    OLAPStatus init(StreamIndexHeader* header, FieldType type,
+                    bool null_supported, bool null_aware_statistics);
     // attach到一块内存上读取position和stat
     void attach(char* buffer);
     // 返回指定下标的position
@@ -45,7 +46,7 @@ public:
     // 一共有几个position
     int32_t positions_count() const;
     bool all_null() const {
-        return _statistics.minimum()->is_null() && _statistics.maximum()->is_null();
+        return _statistics.all_null();
     }
 
 private:
@@ -81,8 +82,10 @@ public:
     StreamIndexReader();
     ~StreamIndexReader();
 
+    // null_aware_statistics对应ColumnDataHeaderMessage中的同名字段
     OLAPStatus init(char* buffer, size_t buffer_size, 
-                    FieldType type, bool is_using_cache, bool null_supported);
+                    FieldType type, bool is_using_cache, bool null_supported,
+                    bool null_aware_statistics = false);
     const PositionEntryReader& entry(uint64_t entry_id);
     size_t entry_count();
 
@@ -97,6 +100,7 @@ private:
     size_t _entry_count;
     bool _is_using_cache;
     bool _null_supported;
+    bool _null_aware_statistics;
     PositionEntryReader _entry;
 };
 
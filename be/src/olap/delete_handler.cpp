@@ -413,6 +413,20 @@ bool DeleteHandler::is_filter_data(const int32_t data_version,
     return false;
 }
 
+bool DeleteHandler::is_filter_data(const int32_t data_version,
+                                   const RowCursor& row,
+                                   const vector<uint32_t>& cond_ids) const {
+    for (vector<uint32_t>::const_iterator it = cond_ids.begin(); it != cond_ids.end(); ++it) {
+        const DeleteConditions& del_cond = _del_conds[*it];
+        if (data_version <= del_cond.filter_version
+                && del_cond.del_cond->delete_conditions_eval(row)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 vector<int32_t> DeleteHandler::get_conds_version() {
     vector<int32_t> conds_version;
     vector<DeleteConditions>::const_iterator cond_iter = _del_conds.begin();
@@ -164,6 +164,12 @@ public:
     //     * false: 数据不符合删除条件
     bool is_filter_data(const int32_t data_version, const RowCursor& row) const;
 
+    // 同上, 但只用cond_ids指定的删除条件判定, cond_ids是get_delete_conditions()中的下标.
+    // 用于block级别已经确定其余删除条件都不会命中的情况
+    bool is_filter_data(const int32_t data_version,
+                        const RowCursor& row,
+                        const std::vector<uint32_t>& cond_ids) const;
+
     // 返回handler中有存有多少条删除条件
     cond_num_t conditions_num() const{
         return _del_conds.size();
@@ -0,0 +1,195 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/expansion_scheduler.h"
+
+#include <algorithm>
+
+#include "common/config.h"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace palo {
+
+ExpansionScheduler::ExpansionScheduler() {}
+
+void ExpansionScheduler::set_max_task_per_disk(ExpansionType type, uint32_t max_task_per_disk) {
+    AutoMutexLock l(&_mutex);
+    _queues[type].max_task_per_disk = max_task_per_disk;
+}
+
+void ExpansionScheduler::set_disk_used(const string& root_path, bool is_used) {
+    AutoMutexLock l(&_mutex);
+    if (is_used) {
+        _unused_disks.erase(root_path);
+    } else {
+        _unused_disks.insert(root_path);
+    }
+}
+
+void ExpansionScheduler::update_candidates(
+        ExpansionType type, const vector<ExpansionCandidate>& candidates) {
+    AutoMutexLock l(&_mutex);
+    ExpansionQueue& queue = _queues[type];
+    queue.candidates.clear();
+    for (vector<ExpansionCandidate>::const_iterator it = candidates.begin();
+            it != candidates.end(); ++it) {
+        if (!_is_running(queue, *it)) {
+            queue.candidates.push_back(*it);
+        }
+    }
+
+    std::make_heap(queue.candidates.begin(), queue.candidates.end(), CandidateComparator());
+    queue.update_time = time(NULL);
+}
+
+bool ExpansionScheduler::need_update(ExpansionType type, int64_t interval_sec) {
+    AutoMutexLock l(&_mutex);
+    const ExpansionQueue& queue = _queues[type];
+    return queue.candidates.empty() || time(NULL) - queue.update_time >= interval_sec;
+}
+
+bool ExpansionScheduler::next_candidate(ExpansionType type, ExpansionCandidate* candidate) {
+    AutoMutexLock l(&_mutex);
+    ExpansionQueue& queue = _queues[type];
+
+    // 所在磁盘已满的候选保留在队列中, 等待下一次调度
+    vector<ExpansionCandidate> skipped;
+    bool found = false;
+    while (!queue.candidates.empty()) {
+        std::pop_heap(queue.candidates.begin(), queue.candidates.end(), CandidateComparator());
+        ExpansionCandidate top = queue.candidates.back();
+        queue.candidates.pop_back();
+
+        if (_unused_disks.find(top.root_path) != _unused_disks.end()) {
+            continue;
+        }
+
+        if (queue.running_num_per_disk[top.root_path] >= queue.max_task_per_disk
+                || _is_running(queue, top)) {
+            skipped.push_back(top);
+            continue;
+        }
+
+        ++queue.running_num_per_disk[top.root_path];
+        queue.running.push_back(top);
+        *candidate = top;
+        found = true;
+        break;
+    }
+
+    for (vector<ExpansionCandidate>::iterator it = skipped.begin(); it != skipped.end(); ++it) {
+        queue.candidates.push_back(*it);
+        std::push_heap(queue.candidates.begin(), queue.candidates.end(), CandidateComparator());
+    }
+
+    return found;
+}
+
+void ExpansionScheduler::finish_candidate(
+        ExpansionType type, const ExpansionCandidate& candidate) {
+    AutoMutexLock l(&_mutex);
+    ExpansionQueue& queue = _queues[type];
+    for (list<ExpansionCandidate>::iterator it = queue.running.begin();
+            it != queue.running.end(); ++it) {
+        if (it->tablet_id == candidate.tablet_id && it->schema_hash == candidate.schema_hash) {
+            --queue.running_num_per_disk[it->root_path];
+            queue.running.erase(it);
+            return;
+        }
+    }
+
+    OLAP_LOG_WARNING("finish expansion which is not running. [tablet_id=%ld schema_hash=%d]",
+                     candidate.tablet_id, candidate.schema_hash);
+}
+
+void ExpansionScheduler::get_status(rapidjson::Document* document) {
+    static const char* type_names[EXPANSION_TYPE_NUM] = {"cumulative", "base"};
+    rapidjson::Document::AllocatorType& allocator = document->GetAllocator();
+    document->SetObject();
+
+    AutoMutexLock l(&_mutex);
+    for (int type = 0; type < EXPANSION_TYPE_NUM; ++type) {
+        const ExpansionQueue& queue = _queues[type];
+        vector<ExpansionCandidate> candidates(queue.candidates);
+        std::sort(candidates.begin(), candidates.end(), CandidateComparator());
+        std::reverse(candidates.begin(), candidates.end());
+        vector<ExpansionCandidate> running(queue.running.begin(), queue.running.end());
+
+        rapidjson::Value type_status(rapidjson::kObjectType);
+        type_status.AddMember("max_task_per_disk", queue.max_task_per_disk, allocator);
+        type_status.AddMember("update_time", static_cast<int64_t>(queue.update_time), allocator);
+        _add_candidates_to_json("candidates", candidates, &type_status, allocator);
+        _add_candidates_to_json("running", running, &type_status, allocator);
+        rapidjson::Value type_name(type_names[type], allocator);
+        document->AddMember(type_name, type_status, allocator);
+    }
+}
+
+double ExpansionScheduler::compute_score(uint32_t delta_num,
+                                         int64_t delta_bytes,
+                                         double read_amplification) {
+    double score = delta_num;
+    if (config::expansion_score_bytes_per_delta > 0) {
+        score += static_cast<double>(delta_bytes) / config::expansion_score_bytes_per_delta;
+    }
+
+    return score * (1 + read_amplification);
+}
+
+bool ExpansionScheduler::_is_running(
+        const ExpansionQueue& queue, const ExpansionCandidate& candidate) const {
+    for (list<ExpansionCandidate>::const_iterator it = queue.running.begin();
+            it != queue.running.end(); ++it) {
+        if (it->tablet_id == candidate.tablet_id && it->schema_hash == candidate.schema_hash) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ExpansionScheduler::_add_candidates_to_json(
+        const char* name,
+        const vector<ExpansionCandidate>& candidates,
+        rapidjson::Value* value,
+        rapidjson::Document::AllocatorType& allocator) {
+    rapidjson::Value array(rapidjson::kArrayType);
+    for (vector<ExpansionCandidate>::const_iterator it = candidates.begin();
+            it != candidates.end(); ++it) {
+        rapidjson::Value candidate(rapidjson::kObjectType);
+        candidate.AddMember("tablet_id", it->tablet_id, allocator);
+        candidate.AddMember("schema_hash", it->schema_hash, allocator);
+        rapidjson::Value root_path;
+        root_path.SetString(it->root_path.c_str(), it->root_path.size(), allocator);
+        candidate.AddMember("root_path", root_path, allocator);
+        candidate.AddMember("delta_num", it->delta_num, allocator);
+        candidate.AddMember("delta_bytes", it->delta_bytes, allocator);
+        candidate.AddMember("read_amplification", it->read_amplification, allocator);
+        candidate.AddMember("score", it->score, allocator);
+        array.PushBack(candidate, allocator);
+    }
+
+    rapidjson::Value array_name(name, allocator);
+    value->AddMember(array_name, array, allocator);
+}
+
+}  // namespace palo
@@ -0,0 +1,133 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_EXPANSION_SCHEDULER_H
+#define BDG_PALO_BE_SRC_OLAP_EXPANSION_SCHEDULER_H
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "olap/olap_common.h"
+#include "olap/olap_define.h"
+#include "olap/utils.h"
+
+namespace palo {
+
+enum ExpansionType {
+    CUMULATIVE_EXPANSION = 0,
+    BASE_EXPANSION = 1,
+    EXPANSION_TYPE_NUM = 2
+};
+
+// 一个等待合并的table
+struct ExpansionCandidate {
+    ExpansionCandidate() :
+            tablet_id(0),
+            schema_hash(0),
+            delta_num(0),
+            delta_bytes(0),
+            read_amplification(0),
+            score(0) {}
+
+    int64_t tablet_id;
+    SchemaHash schema_hash;
+    std::string root_path;
+    // 本次合并需要合并的版本数和数据量
+    uint32_t delta_num;
+    int64_t delta_bytes;
+    // 最近的查询平均每返回一行需要合并掉的行数
+    double read_amplification;
+    double score;
+};
+
+// 在所有table和磁盘之间调度base和cumulative expansion.
+// 每种合并维护一个按得分排序的候选队列, 每次取出得分最高且所在磁盘还有空闲的table,
+// 同一块盘上同一种合并同时执行的任务数不超过max_task_per_disk.
+// 所有接口都是线程安全的.
+class ExpansionScheduler {
+public:
+    ExpansionScheduler();
+    ~ExpansionScheduler() {}
+
+    void set_max_task_per_disk(ExpansionType type, uint32_t max_task_per_disk);
+
+    // 不可用磁盘上的table不会被选中
+    void set_disk_used(const std::string& root_path, bool is_used);
+
+    // 用新计算的候选替换原有的队列, 正在执行的table不会再次加入队列
+    void update_candidates(ExpansionType type, const std::vector<ExpansionCandidate>& candidates);
+
+    // 队列为空或者距离上次更新已经超过interval_sec秒时返回true
+    bool need_update(ExpansionType type, int64_t interval_sec);
+
+    // 取出得分最高且所在磁盘还有空闲的候选, 并记为正在执行. 没有可执行的候选时返回false
+    bool next_candidate(ExpansionType type, ExpansionCandidate* candidate);
+
+    // 合并结束(无论成功与否)后调用, 释放所在磁盘的并发额度
+    void finish_candidate(ExpansionType type, const ExpansionCandidate& candidate);
+
+    // 输出每种合并的候选队列和正在执行的任务
+    void get_status(rapidjson::Document* document);
+
+    // 得分 = (版本数 + 数据量 / expansion_score_bytes_per_delta) * (1 + 读放大)
+    static double compute_score(uint32_t delta_num,
+                                int64_t delta_bytes,
+                                double read_amplification);
+
+private:
+    struct CandidateComparator {
+        bool operator()(const ExpansionCandidate& a, const ExpansionCandidate& b) const {
+            return a.score < b.score;
+        }
+    };
+
+    struct ExpansionQueue {
+        ExpansionQueue() : max_task_per_disk(1), update_time(0) {}
+
+        // 以score为key的大根堆
+        std::vector<ExpansionCandidate> candidates;
+        std::list<ExpansionCandidate> running;
+        std::map<std::string, uint32_t> running_num_per_disk;
+        uint32_t max_task_per_disk;
+        time_t update_time;
+    };
+
+    bool _is_running(const ExpansionQueue& queue, const ExpansionCandidate& candidate) const;
+
+    void _add_candidates_to_json(const char* name,
+                                 const std::vector<ExpansionCandidate>& candidates,
+                                 rapidjson::Value* value,
+                                 rapidjson::Document::AllocatorType& allocator);
+
+    MutexLock _mutex;
+    ExpansionQueue _queues[EXPANSION_TYPE_NUM];
+    std::set<std::string> _unused_disks;
+
+    DISALLOW_COPY_AND_ASSIGN(ExpansionScheduler);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_EXPANSION_SCHEDULER_H
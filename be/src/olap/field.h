@@ -280,6 +280,45 @@ public:
 };
 
 
+// 按聚集方式特化的聚集函数，语义与上面的FieldAggregator一致。
+// BaseField::aggregate根据聚集方式直接调用，省去每行一次的虚函数调用。
+template <FieldAggregationMethod agg_method, typename T>
+struct FieldAggregateFunc {
+    static inline void aggregate(T* left, const T* right, uint32_t length) {}
+};
+
+template <typename T>
+struct FieldAggregateFunc<OLAP_FIELD_AGGREGATION_MIN, T> {
+    static inline void aggregate(T* left, const T* right, uint32_t length) {
+        if (*left > *right) {
+            *left = *right;
+        }
+    }
+};
+
+template <typename T>
+struct FieldAggregateFunc<OLAP_FIELD_AGGREGATION_MAX, T> {
+    static inline void aggregate(T* left, const T* right, uint32_t length) {
+        if (*right > *left) {
+            *left = *right;
+        }
+    }
+};
+
+template <typename T>
+struct FieldAggregateFunc<OLAP_FIELD_AGGREGATION_SUM, T> {
+    static inline void aggregate(T* left, const T* right, uint32_t length) {
+        *left += *right;
+    }
+};
+
+template <typename T>
+struct FieldAggregateFunc<OLAP_FIELD_AGGREGATION_REPLACE, T> {
+    static inline void aggregate(T* left, const T* right, uint32_t length) {
+        memcpy(left, right, length);
+    }
+};
+
 // 保存Field元信息的结构体
 struct FieldInfo {
 public:
@@ -591,7 +630,31 @@ public:
     }
 
     virtual void aggregate(const Field* field) {
-        (*_aggregator)(_value(), _value(field->buf()), field->size());
+        T* left = _value();
+        const T* right = _value(field->buf());
+
+        switch (_aggregation) {
+        case OLAP_FIELD_AGGREGATION_MIN:
+            FieldAggregateFunc<OLAP_FIELD_AGGREGATION_MIN, T>::aggregate(
+                    left, right, field->size());
+            break;
+        case OLAP_FIELD_AGGREGATION_MAX:
+            FieldAggregateFunc<OLAP_FIELD_AGGREGATION_MAX, T>::aggregate(
+                    left, right, field->size());
+            break;
+        case OLAP_FIELD_AGGREGATION_SUM:
+            FieldAggregateFunc<OLAP_FIELD_AGGREGATION_SUM, T>::aggregate(
+                    left, right, field->size());
+            break;
+        case OLAP_FIELD_AGGREGATION_REPLACE:
+            FieldAggregateFunc<OLAP_FIELD_AGGREGATION_REPLACE, T>::aggregate(
+                    left, right, field->size());
+            break;
+        default:
+            // HLL_UNION需要在_aggregator中保存中间状态
+            (*_aggregator)(left, const_cast<T*>(right), field->size());
+            break;
+        }
     }
 
     virtual void finalize_one_merge() {
@@ -38,6 +38,7 @@ class OLAPIndex;
 class RowBlock;
 class RowCursor;
 class Conditions;
+class VectorizedRowBatch;
 
 // 抽象数据访问接口
 // 提供对不同数据文件类型的统一访问接口
@@ -91,6 +92,17 @@ public:
     virtual OLAPStatus get_first_row_block(RowBlock** row_block) = 0;
     virtual OLAPStatus get_next_row_block(RowBlock** row_block) = 0;
 
+    // 按列批量读取数据至batch, 不经过RowCursor, 目前只有ColumnData支持.
+    // 调用方需保证没有设置key范围, 且没有需要逐行判断的删除条件.
+    // get_first_block定位到第一个block并读出第一批数据, 之后调用get_next_block.
+    // 读到结尾时设置eof并返回OLAP_SUCCESS, 此时batch->size()为0
+    virtual OLAPStatus get_first_block(VectorizedRowBatch* batch) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+    virtual OLAPStatus get_next_block(VectorizedRowBatch* batch) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
     // 设置读取数据的参数, 这是一个后加入的接口, IData的实现可以根据这个接口提供
     // 信息做更多的优化. OLAPData不需要这个接口, ColumnData通过这个接口获取更多
     // 的上层信息以减少不必须要的数据读取.
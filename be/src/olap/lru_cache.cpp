@@ -21,6 +21,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include <sstream>
 #include <string>
@@ -176,24 +177,29 @@ bool HandleTable::_resize() {
     return true;
 }
 
-LRUCache::LRUCache() : _usage(0), _last_id(0), _lookup_count(0),
-    _hit_count(0) {
+LRUCache::LRUCache() : _usage(0), _last_id(0), _protected_usage(0), _lookup_count(0),
+    _hit_count(0), _evict_count(0) {
         // Make empty circular linked list
         _lru.next = &_lru;
         _lru.prev = &_lru;
+        _protected_lru.next = &_protected_lru;
+        _protected_lru.prev = &_protected_lru;
         _in_use.next = &_in_use;
         _in_use.prev = &_in_use;
     }
 
 LRUCache::~LRUCache() {
     assert(_in_use.next == &_in_use);  // Error if caller has an unreleased handle
-    for (LRUHandle* e = _lru.next; e != &_lru;) {
-        LRUHandle* next = e->next;
-        assert(e->in_cache);
-        e->in_cache = false;
-        assert(e->refs == 1);  // Invariant of _lru list.
-        _unref(e);
-        e = next;
+    LRUHandle* lists[] = {&_lru, &_protected_lru};
+    for (LRUHandle* list : lists) {
+        for (LRUHandle* e = list->next; e != list;) {
+            LRUHandle* next = e->next;
+            assert(e->in_cache);
+            e->in_cache = false;
+            assert(e->refs == 1);  // Invariant of _lru list.
+            _unref(e);
+            e = next;
+        }
     }
 }
 
@@ -219,7 +225,18 @@ void LRUCache::_unref(LRUHandle* e) {
         free(e);
     } else if (e->in_cache && e->refs == 1) {  // No longer in use; move to lru_ list.
         _lru_remove(e);
-        _lru_append(&_lru, e);
+        _lru_append(e->in_protected ? &_protected_lru : &_lru, e);
+    }
+}
+
+void LRUCache::_balance_protected() {
+    size_t protected_capacity = _capacity * kProtectedPercent / 100;
+    while (_protected_usage > protected_capacity && _protected_lru.next != &_protected_lru) {
+        LRUHandle* old = _protected_lru.next;
+        _lru_remove(old);
+        old->in_protected = false;
+        _protected_usage -= old->charge;
+        _lru_append(&_lru, old);
     }
 }
 
@@ -237,22 +254,32 @@ void LRUCache::_lru_append(LRUHandle* list, LRUHandle* e) {
 }
 
 Cache::Handle* LRUCache::lookup(const CacheKey& key, uint32_t hash) {
-    AutoMutexLock l(&_mutex);
-    ++_lookup_count;
-    LRUHandle* e = _table.lookup(key, hash);
+    LRUHandle* e = NULL;
+    {
+        AutoMutexLock l(&_mutex);
+        ++_lookup_count;
+        e = _table.lookup(key, hash);
+
+        if (e != NULL) {
+            ++_hit_count;
+            _ref(e);
+
+            // 再次命中的元素进入受保护段
+            if (!e->in_protected) {
+                e->in_protected = true;
+                _protected_usage += e->charge;
+                _balance_protected();
+            }
+        }
+    }
 
+    // 全局计数器在锁外更新, 不延长分片锁的持有时间
     if (PaloMetrics::olap_lru_cache_lookup_count() != NULL) {
         PaloMetrics::olap_lru_cache_lookup_count()->increment(1);
     }
 
-    if (e != NULL) {
-        ++_hit_count;
-        _ref(e);
-
-        if (PaloMetrics::olap_lru_cache_hit_count() != NULL) {
-            PaloMetrics::olap_lru_cache_hit_count()->increment(1);
-        }
-
+    if (e != NULL && PaloMetrics::olap_lru_cache_hit_count() != NULL) {
+        PaloMetrics::olap_lru_cache_hit_count()->increment(1);
     }
 
     return reinterpret_cast<Cache::Handle*>(e);
@@ -266,8 +293,7 @@ void LRUCache::release(Cache::Handle* handle) {
 Cache::Handle* LRUCache::insert(
         const CacheKey& key, uint32_t hash, void* value, size_t charge,
         void (*deleter)(const CacheKey& key, void* value)) {
-    AutoMutexLock l(&_mutex);
-
+    uint64_t evict_count = 0;
     LRUHandle* e = reinterpret_cast<LRUHandle*>(
             malloc(sizeof(LRUHandle)-1 + key.size()));
     e->value = value;
@@ -276,9 +302,11 @@ Cache::Handle* LRUCache::insert(
     e->key_length = key.size();
     e->hash = hash;
     e->in_cache = false;
+    e->in_protected = false;
     e->refs = 1;  // for the returned handle.
     memcpy(e->key_data, key.data(), key.size());
 
+    AutoMutexLock l(&_mutex);
     if (_capacity > 0) {
         e->refs++;  // for the cache's reference.
         e->in_cache = true;
@@ -287,14 +315,25 @@ Cache::Handle* LRUCache::insert(
         _finish_erase(_table.insert(e));
     } // else don't cache.  (Tests use capacity_==0 to turn off caching.)
 
-    while (_usage > _capacity && _lru.next != &_lru) {
-        LRUHandle* old = _lru.next;
+    // 先淘汰试用段, 试用段为空时才淘汰受保护段
+    while (_usage > _capacity) {
+        LRUHandle* old = NULL;
+        if (_lru.next != &_lru) {
+            old = _lru.next;
+        } else if (_protected_lru.next != &_protected_lru) {
+            old = _protected_lru.next;
+        } else {
+            break;
+        }
+
         assert(old->refs == 1);
         bool erased = _finish_erase(_table.remove(old->key(), old->hash));
         if (!erased) {  // to avoid unused variable when compiled NDEBUG
             assert(erased);
         }
+        ++evict_count;
     }
+    _evict_count += evict_count;
 
     return reinterpret_cast<Cache::Handle*>(e);
 }
@@ -307,6 +346,10 @@ bool LRUCache::_finish_erase(LRUHandle* e) {
         _lru_remove(e);
         e->in_cache = false;
         _usage -= e->charge;
+        if (e->in_protected) {
+            e->in_protected = false;
+            _protected_usage -= e->charge;
+        }
         _unref(e);
     }
     return e != NULL;
@@ -320,14 +363,17 @@ void LRUCache::erase(const CacheKey& key, uint32_t hash) {
 int LRUCache::prune() {
     AutoMutexLock l(&_mutex);
     int num_prune = 0;
-    while (_lru.next != &_lru) {
-        LRUHandle* e = _lru.next;
-        assert(e->refs == 1);
-        bool erased = _finish_erase(_table.remove(e->key(), e->hash));
-        if (!erased) {  // to avoid unused variable when compiled NDEBUG
-            assert(erased);
+    LRUHandle* lists[] = {&_lru, &_protected_lru};
+    for (LRUHandle* list : lists) {
+        while (list->next != list) {
+            LRUHandle* e = list->next;
+            assert(e->refs == 1);
+            bool erased = _finish_erase(_table.remove(e->key(), e->hash));
+            if (!erased) {  // to avoid unused variable when compiled NDEBUG
+                assert(erased);
+            }
+            num_prune++;
         }
-        num_prune++;
     }
     return num_prune;
 }
@@ -336,19 +382,32 @@ inline uint32_t ShardedLRUCache::_hash_slice(const CacheKey& s) {
     return s.hash(s.data(), s.size(), 0);
 }
 
-uint32_t ShardedLRUCache::_shard(uint32_t hash) {
-    return hash >> (32 - kNumShardBits);
+uint32_t ShardedLRUCache::_shard(uint32_t hash) const {
+    return hash >> (32 - _num_shard_bits);
 }
 
 ShardedLRUCache::ShardedLRUCache(size_t capacity)
-    : _last_id(0) {
-        const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+    : _num_shard_bits(kMinNumShardBits), _last_id(0) {
+        long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+        while (_num_shard_bits < kMaxNumShardBits
+                && (1L << _num_shard_bits) < num_cores
+                && (capacity >> (_num_shard_bits + 1)) >= kMinShardCapacity) {
+            ++_num_shard_bits;
+        }
 
-        for (int s = 0; s < kNumShards; s++) {
+        _num_shards = 1 << _num_shard_bits;
+        _shards = new LRUCache[_num_shards];
+        const size_t per_shard = (capacity + (_num_shards - 1)) / _num_shards;
+
+        for (uint32_t s = 0; s < _num_shards; s++) {
             _shards[s].set_capacity(per_shard);
         }
     }
 
+ShardedLRUCache::~ShardedLRUCache() {
+    delete[] _shards;
+}
+
 Cache::Handle* ShardedLRUCache::insert(
         const CacheKey& key,
         void* value,
@@ -384,7 +443,7 @@ uint64_t ShardedLRUCache::new_id() {
 
 void ShardedLRUCache::prune() {
     int num_prune = 0;
-    for (int s = 0; s < kNumShards; s++) {
+    for (uint32_t s = 0; s < _num_shards; s++) {
         num_prune += _shards[s].prune();
     }
     OLAP_LOG_INFO("prune file descriptor: %d", num_prune);
@@ -392,16 +451,14 @@ void ShardedLRUCache::prune() {
 
 size_t ShardedLRUCache::get_memory_usage() {
     size_t total_usage = 0;
-    for (int s = 0; s < kNumShards; s++) {
+    for (uint32_t s = 0; s < _num_shards; s++) {
         total_usage += _shards[s].get_usage();
     }
     return total_usage;
 }
 
 void ShardedLRUCache::get_cache_status(rapidjson::Document* document) {
-    size_t shard_count = sizeof(_shards) / sizeof(LRUCache);
-
-    for (uint32_t i = 0; i < shard_count; ++i) {
+    for (uint32_t i = 0; i < _num_shards; ++i) {
         size_t capacity = _shards[i].get_capacity();
         size_t usage = _shards[i].get_usage();
         rapidjson::Value shard_info(rapidjson::kObjectType);
@@ -428,6 +485,15 @@ void ShardedLRUCache::get_cache_status(rapidjson::Document* document) {
         }
 
         shard_info.AddMember("hit_ratio", hit_ratio, document->GetAllocator());
+
+        size_t protected_usage = _shards[i].get_protected_usage();
+        size_t evict_count = _shards[i].get_evict_count();
+        shard_info.AddMember("miss_count", static_cast<double>(lookup_count - hit_count),
+                             document->GetAllocator());
+        shard_info.AddMember("evict_count", static_cast<double>(evict_count),
+                             document->GetAllocator());
+        shard_info.AddMember("protected_usage", static_cast<double>(protected_usage),
+                             document->GetAllocator());
         document->PushBack(shard_info, document->GetAllocator());
     }
 
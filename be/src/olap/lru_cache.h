@@ -247,6 +247,7 @@ namespace palo {
         size_t charge;
         size_t key_length;
         bool in_cache;      // Whether entry is in the cache.
+        bool in_protected;  // Whether entry has been hit since inserted.
         uint32_t refs;
         uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
         char key_data[1];   // Beginning of key
@@ -298,7 +299,13 @@ namespace palo {
             bool _resize();
     };
 
+    // 受保护段最多占用分片容量的百分比
+    static const size_t kProtectedPercent = 80;
+
     // A single shard of sharded cache.
+    // 分片内使用分段LRU: 新插入的元素先进入试用段, 插入后再次被lookup命中的元素
+    // 进入受保护段. 淘汰时优先淘汰试用段, 这样只访问一次的大查询不会把热点数据挤出去.
+    // 受保护段超过容量的kProtectedPercent时, 最久未访问的元素降级回试用段.
     class LRUCache {
         public:
             LRUCache();
@@ -327,14 +334,22 @@ namespace palo {
             uint64_t get_hit_count() {
                 return _hit_count;
             }
+            uint64_t get_evict_count() {
+                return _evict_count;
+            }
             size_t get_usage() {
                 return _usage;
             }
+            size_t get_protected_usage() {
+                return _protected_usage;
+            }
             size_t get_capacity() {
                 return _capacity;
             }
 
         private:
+            // 受保护段超过容量时把最久未访问的元素降级到试用段
+            void _balance_protected();
             void _lru_remove(LRUHandle* e);
             void _lru_append(LRUHandle* list, LRUHandle* e);
             void _ref(LRUHandle* e);
@@ -349,11 +364,17 @@ namespace palo {
             size_t _usage;
             uint64_t _last_id;
 
-            // Dummy head of LRU list.
+            // Dummy head of LRU list of probationary entries.
             // lru.prev is newest entry, lru.next is oldest entry.
-            // Entries have refs==1 and in_cache==true.
+            // Entries have refs==1, in_cache==true and in_protected==false.
             LRUHandle _lru;
 
+            // Dummy head of LRU list of protected entries.
+            // Entries have refs==1, in_cache==true and in_protected==true.
+            LRUHandle _protected_lru;
+            // 受保护段元素的总charge, 包括正在被使用的元素
+            size_t _protected_usage;
+
             // Dummy head of in-use list.
             // Entries are in use by clients, and have refs >= 2 and in_cache==true.
             LRUHandle _in_use;
@@ -362,16 +383,19 @@ namespace palo {
 
             uint64_t _lookup_count;    // cache查找总次数
             uint64_t _hit_count;       // 命中cache的总次数
+            uint64_t _evict_count;     // 因容量不足被淘汰的元素数
     };
 
-    static const int kNumShardBits = 4;
-    static const int kNumShards = 1 << kNumShardBits;
+    // 分片数按CPU核数取2的幂, 但不少于16个; 同时每个分片的容量不小于
+    // kMinShardCapacity, 否则分片间淘汰很不均匀
+    static const uint32_t kMinNumShardBits = 4;
+    static const uint32_t kMaxNumShardBits = 8;
+    static const size_t kMinShardCapacity = 256;
 
     class ShardedLRUCache : public Cache {
         public:
             explicit ShardedLRUCache(size_t capacity);
-            // TODO(fdy): 析构时清除所有cache元素
-            virtual ~ShardedLRUCache() {}
+            virtual ~ShardedLRUCache();
             virtual Handle* insert(
                     const CacheKey& key,
                     void* value,
@@ -388,9 +412,11 @@ namespace palo {
 
         private:
             static inline uint32_t _hash_slice(const CacheKey& s);
-            static uint32_t _shard(uint32_t hash);
+            uint32_t _shard(uint32_t hash) const;
 
-            LRUCache _shards[kNumShards];
+            uint32_t _num_shard_bits;
+            uint32_t _num_shards;
+            LRUCache* _shards;
             MutexLock _id_mutex;
             uint64_t _last_id;
     };
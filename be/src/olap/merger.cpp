@@ -19,16 +19,22 @@
 
 #include "olap/merger.h"
 
+#include <stdio.h>
+
 #include <memory>
 #include <vector>
 
+#include "common/config.h"
 #include "olap/i_data.h"
 #include "olap/olap_define.h"
+#include "olap/olap_engine.h"
 #include "olap/olap_index.h"
 #include "olap/olap_table.h"
 #include "olap/reader.h"
 #include "olap/row_cursor.h"
 #include "olap/writer.h"
+#include "util/count_down_latch.hpp"
+#include "util/thread_pool.hpp"
 
 using std::list;
 using std::string;
@@ -38,13 +44,33 @@ using std::vector;
 
 namespace palo {
 
+struct Merger::SubMerge {
+    SubMerge() :
+            merger(NULL),
+            index(NULL),
+            merged_rows(0),
+            filted_rows(0),
+            res(OLAP_SUCCESS),
+            latch(NULL) {}
+
+    Merger* merger;
+    OLAPIndex* index;
+    vector<IData*> olap_data_arr;
+    uint64_t merged_rows;
+    uint64_t filted_rows;
+    OLAPStatus res;
+    CountDownLatch* latch;
+};
+
 Merger::Merger(SmartOLAPTable table, OLAPIndex* index, ReaderType type) : 
         _table(table),
         _index(index),
         _reader_type(type),
         _row_count(0),
         _uniq_keys(table->num_key_fields(), 1),
-        _selectivities(table->num_key_fields(), 1) {}
+        _selectivities(table->num_key_fields(), 1),
+        _start_key(NULL),
+        _end_key(NULL) {}
 
 OLAPStatus Merger::merge(
         const vector<IData*>& olap_data_arr,
@@ -55,9 +81,20 @@ OLAPStatus Merger::merge(
         *merged_rows = 0;
         *filted_rows = 0;
         return _create_hard_link();
-    } else {
+    }
+
+    vector<RowCursor*> split_keys;
+    _split_key_range(olap_data_arr, &split_keys);
+    if (split_keys.empty()) {
         return _merge(olap_data_arr, merged_rows, filted_rows);
     }
+
+    OLAPStatus res = _parallel_merge(olap_data_arr, split_keys, merged_rows, filted_rows);
+    for (size_t i = 0; i < split_keys.size(); ++i) {
+        SAFE_DELETE(split_keys[i]);
+    }
+
+    return res;
 }
 
 bool Merger::_check_simple_merge(const vector<IData*>& olap_data_arr) {
@@ -170,6 +207,15 @@ OLAPStatus Merger::_merge(
         reader_params.version = _index->version();
     }
 
+    if (_start_key != NULL) {
+        reader_params.range = "ge";
+        reader_params.start_key_cursors.push_back(_start_key);
+        if (_end_key != NULL) {
+            reader_params.end_range = "lt";
+            reader_params.end_key_cursors.push_back(_end_key);
+        }
+    }
+
     if (OLAP_SUCCESS != reader.init(reader_params)) {
         OLAP_LOG_WARNING("fail to initiate reader. [table='%s']",
                 _table->full_name().c_str());
@@ -285,5 +331,306 @@ OLAPStatus Merger::_merge(
     return has_error ? OLAP_ERR_OTHER_ERROR : OLAP_SUCCESS;
 }
 
+void Merger::_split_key_range(
+        const vector<IData*>& olap_data_arr,
+        vector<RowCursor*>* split_keys) {
+    if (OLAPEngine::get_instance()->expansion_merge_thread_pool() == NULL
+            || config::expansion_merge_min_row_blocks <= 0
+            || _start_key != NULL) {
+        return;
+    }
+
+    // 整个版本满足删除条件时, 每个子merge都会把这个版本的行数计入filted_rows,
+    // 行数校验会失败, 因此有删除条件时不切分
+    _table->obtain_header_rdlock();
+    int delete_data_conditions_size = _table->delete_data_conditions_size();
+    _table->release_header_lock();
+    if (delete_data_conditions_size > 0) {
+        return;
+    }
+
+    OLAPIndex* largest_index = NULL;
+    for (vector<IData*>::const_iterator it = olap_data_arr.begin();
+            it != olap_data_arr.end(); ++it) {
+        OLAPIndex* index = (*it)->olap_index();
+        if (!index->index_loaded() || index->empty()) {
+            continue;
+        }
+
+        if (largest_index == NULL
+                || index->num_index_entries() > largest_index->num_index_entries()) {
+            largest_index = index;
+        }
+    }
+
+    uint32_t min_row_blocks = config::expansion_merge_min_row_blocks;
+    if (largest_index == NULL || largest_index->num_index_entries() < 2 * min_row_blocks) {
+        return;
+    }
+
+    // 每次用find_mid_point对分最长的区间, 直到区间数达到并行线程数加上当前线程,
+    // 或者区间已经不够长
+    size_t max_range_num = config::expansion_merge_thread_num + 1;
+    vector<RowBlockPosition> points(2);
+    if (largest_index->find_first_row_block(&points[0]) != OLAP_SUCCESS
+            || largest_index->find_last_row_block(&points[1]) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to find row block range. [table='%s']",
+                         _table->full_name().c_str());
+        return;
+    }
+
+    while (points.size() - 1 < max_range_num) {
+        size_t widest = 0;
+        uint32_t widest_distance = 0;
+        for (size_t i = 0; i + 1 < points.size(); ++i) {
+            uint32_t distance = largest_index->compute_distance(points[i], points[i + 1]);
+            if (distance > widest_distance) {
+                widest = i;
+                widest_distance = distance;
+            }
+        }
+
+        if (widest_distance < 2 * min_row_blocks) {
+            break;
+        }
+
+        RowBlockPosition mid_point;
+        uint32_t distance = 0;
+        if (largest_index->find_mid_point(
+                points[widest], points[widest + 1], &mid_point, &distance) != OLAP_SUCCESS) {
+            break;
+        }
+
+        points.insert(points.begin() + widest + 1, mid_point);
+    }
+
+    RowCursor entry_key;
+    if (entry_key.init(_table->tablet_schema(), _table->num_short_key_fields()) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init split key. [table='%s']", _table->full_name().c_str());
+        return;
+    }
+
+    bool has_error = false;
+    for (size_t i = 1; i + 1 < points.size(); ++i) {
+        Slice entry;
+        if (largest_index->get_row_block_entry(points[i], &entry) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to get row block entry. [table='%s' pos='%s']",
+                             _table->full_name().c_str(),
+                             points[i].to_string().c_str());
+            has_error = true;
+            break;
+        }
+        entry_key.attach(entry.data, entry.length);
+
+        // 相同key的行可能跨越多个数据块, 重复的分界key只保留一个
+        if (!split_keys->empty() && entry_key.cmp(*split_keys->back()) <= 0) {
+            continue;
+        }
+
+        RowCursor* split_key = new(std::nothrow) RowCursor();
+        if (split_key == NULL
+                || split_key->init(_table->tablet_schema(),
+                                   _table->num_short_key_fields()) != OLAP_SUCCESS
+                || split_key->copy(entry_key) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to copy split key. [table='%s']",
+                             _table->full_name().c_str());
+            SAFE_DELETE(split_key);
+            has_error = true;
+            break;
+        }
+        split_keys->push_back(split_key);
+    }
+
+    // 出错时不切分
+    if (has_error) {
+        for (size_t i = 0; i < split_keys->size(); ++i) {
+            SAFE_DELETE((*split_keys)[i]);
+        }
+        split_keys->clear();
+    }
+}
+
+OLAPStatus Merger::_parallel_merge(
+        const vector<IData*>& olap_data_arr,
+        const vector<RowCursor*>& split_keys,
+        uint64_t* merged_rows,
+        uint64_t* filted_rows) {
+    OLAPStatus res = OLAP_SUCCESS;
+    size_t range_num = split_keys.size() + 1;
+
+    // 第一个区间从最小的key开始, 可以为NULL的列最小的值是NULL
+    RowCursor min_key;
+    if (min_key.init(_table->tablet_schema(), _table->num_short_key_fields()) != OLAP_SUCCESS
+            || min_key.build_min_key() != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init min key. [table='%s']", _table->full_name().c_str());
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    for (size_t i = 0; i < min_key.field_count(); ++i) {
+        if (_table->tablet_schema()[i].is_allow_null) {
+            min_key.set_null(i);
+        } else {
+            min_key.set_not_null(i);
+        }
+    }
+
+    OLAP_LOG_INFO("start parallel merge. [table='%s' version=%d-%d range_num=%lu]",
+                  _table->full_name().c_str(),
+                  _index->version().first,
+                  _index->version().second,
+                  range_num);
+
+    // 每个子merge写入一个临时的index, 用不同的version_hash区分文件名
+    CountDownLatch latch(range_num);
+    vector<SubMerge*> sub_merges(range_num, NULL);
+    for (size_t i = 0; i < range_num; ++i) {
+        SubMerge* sub_merge = new(std::nothrow) SubMerge();
+        if (sub_merge == NULL) {
+            OLAP_LOG_WARNING("fail to malloc sub merge.");
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+        sub_merges[i] = sub_merge;
+        sub_merge->latch = &latch;
+
+        sub_merge->index = new(std::nothrow) OLAPIndex(_table.get(),
+                                                       _index->version(),
+                                                       _index->version_hash() + i + 1,
+                                                       _index->delete_flag(),
+                                                       0, 0);
+        if (sub_merge->index == NULL) {
+            OLAP_LOG_WARNING("fail to malloc sub merge index.");
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+
+        sub_merge->merger = new(std::nothrow) Merger(_table, sub_merge->index, _reader_type);
+        if (sub_merge->merger == NULL) {
+            OLAP_LOG_WARNING("fail to malloc sub merger.");
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+        sub_merge->merger->_start_key = (i == 0 ? &min_key : split_keys[i - 1]);
+        if (i < split_keys.size()) {
+            sub_merge->merger->_end_key = split_keys[i];
+        }
+
+        // 每个子merge读取各自的IData, 它们的读取状态相互独立
+        for (vector<IData*>::const_iterator it = olap_data_arr.begin();
+                it != olap_data_arr.end(); ++it) {
+            IData* olap_data = IData::create((*it)->olap_index());
+            if (olap_data == NULL) {
+                OLAP_LOG_WARNING("fail to malloc data. [table='%s']",
+                                 _table->full_name().c_str());
+                res = OLAP_ERR_MALLOC_ERROR;
+                break;
+            }
+
+            sub_merge->olap_data_arr.push_back(olap_data);
+            if ((res = olap_data->init()) != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to init data. [table='%s' res=%d]",
+                                 _table->full_name().c_str(), res);
+                break;
+            }
+        }
+
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+    }
+
+    if (res == OLAP_SUCCESS) {
+        // 当前线程执行第一个区间, 其余的交给线程池; 线程池已经关闭时在当前线程执行
+        ThreadPool* thread_pool = OLAPEngine::get_instance()->expansion_merge_thread_pool();
+        for (size_t i = 1; i < range_num; ++i) {
+            if (thread_pool == NULL
+                    || !thread_pool->offer(boost::bind(&Merger::_run_sub_merge, sub_merges[i]))) {
+                _run_sub_merge(sub_merges[i]);
+            }
+        }
+
+        _run_sub_merge(sub_merges[0]);
+        latch.await();
+
+        *merged_rows = 0;
+        *filted_rows = 0;
+        for (size_t i = 0; i < range_num; ++i) {
+            if (sub_merges[i]->res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to merge key range. [table='%s' range=%lu res=%d]",
+                                 _table->full_name().c_str(), i, sub_merges[i]->res);
+                res = sub_merges[i]->res;
+                break;
+            }
+
+            *merged_rows += sub_merges[i]->merged_rows;
+            *filted_rows += sub_merges[i]->filted_rows;
+        }
+    }
+
+    if (res == OLAP_SUCCESS) {
+        res = _stitch_sub_merges(sub_merges);
+    }
+
+    if (res == OLAP_SUCCESS) {
+        // 区间分界处相同前缀的key会被重复计数, 对selectivity的影响可以忽略
+        bool has_rows = false;
+        for (size_t i = 0; i < range_num; ++i) {
+            Merger* merger = sub_merges[i]->merger;
+            if (merger->_row_count == 0) {
+                continue;
+            }
+
+            for (size_t j = 0; j < _uniq_keys.size(); ++j) {
+                _uniq_keys[j] = (has_rows ? _uniq_keys[j] : 0) + merger->_uniq_keys[j];
+            }
+            _row_count += merger->_row_count;
+            has_rows = true;
+        }
+
+        if (_index->version().first == 0) {
+            for (size_t i = 0; i < _uniq_keys.size(); ++i) {
+                _selectivities[i] = static_cast<uint32_t>(_row_count / _uniq_keys[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < range_num; ++i) {
+        if (sub_merges[i] == NULL) {
+            continue;
+        }
+
+        // 改名后的segment已经从子merge的index中移除, 这里只删除失败时残留的文件
+        if (sub_merges[i]->index != NULL) {
+            sub_merges[i]->index->delete_all_files();
+        }
+        _table->release_data_sources(&sub_merges[i]->olap_data_arr);
+        SAFE_DELETE(sub_merges[i]->merger);
+        SAFE_DELETE(sub_merges[i]->index);
+        SAFE_DELETE(sub_merges[i]);
+    }
+
+    return res;
+}
+
+void Merger::_run_sub_merge(SubMerge* sub_merge) {
+    sub_merge->res = sub_merge->merger->_merge(
+            sub_merge->olap_data_arr, &sub_merge->merged_rows, &sub_merge->filted_rows);
+    sub_merge->latch->count_down();
+}
+
+OLAPStatus Merger::_stitch_sub_merges(const vector<SubMerge*>& sub_merges) {
+    vector<OLAPIndex*> sub_indices;
+    for (size_t i = 0; i < sub_merges.size(); ++i) {
+        // 没有数据的区间不保留, 但全部为空时保留最后一个区间, 和串行merge的结果一致
+        if (sub_merges[i]->merger->_row_count == 0
+                && (!sub_indices.empty() || i + 1 < sub_merges.size())) {
+            continue;
+        }
+
+        sub_indices.push_back(sub_merges[i]->index);
+    }
+
+    return _index->stitch_sub_indices(sub_indices);
+}
 
 }  // namespace palo
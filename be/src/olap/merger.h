@@ -20,6 +20,9 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_MERGER_H
 #define BDG_PALO_BE_SRC_OLAP_MERGER_H
 
+#include <string>
+#include <vector>
+
 #include "olap/olap_define.h"
 #include "olap/olap_table.h"
 
@@ -27,6 +30,7 @@ namespace palo {
 
 class OLAPIndex;
 class IData;
+class RowCursor;
 
 class Merger {
 public:
@@ -37,6 +41,8 @@ public:
 
     // @brief read from multiple OLAPData and OLAPIndex, then write into single OLAPData and
     // OLAPIndex. When use_simple_merge is true, check weather to create hard link.
+    // Large inputs are split into key ranges which are merged in parallel, the segments
+    // written for each range are then renamed into the output index in key order.
     // @return  OLAPStatus: OLAP_SUCCESS or FAIL
     // @note it will take long time to finish.
     OLAPStatus merge(
@@ -55,11 +61,31 @@ public:
     }
 
 private:
+    // 一个key区间的子merge
+    struct SubMerge;
+
     OLAPStatus _merge(
             const std::vector<IData*>& olap_data_arr,
             uint64_t* merged_rows,
             uint64_t* filted_rows);
 
+    // 用最大的输入版本的short key索引把key空间切分成若干区间, 返回区间的分界key,
+    // 不需要切分时返回空. 分界key直接取自索引项, 由调用者释放
+    void _split_key_range(
+            const std::vector<IData*>& olap_data_arr,
+            std::vector<RowCursor*>* split_keys);
+
+    OLAPStatus _parallel_merge(
+            const std::vector<IData*>& olap_data_arr,
+            const std::vector<RowCursor*>& split_keys,
+            uint64_t* merged_rows,
+            uint64_t* filted_rows);
+
+    static void _run_sub_merge(SubMerge* sub_merge);
+
+    // 把各个子merge的segment按key的顺序改名为_index的segment
+    OLAPStatus _stitch_sub_merges(const std::vector<SubMerge*>& sub_merges);
+
     bool _check_simple_merge(const std::vector<IData*>& olap_data_arr);
 
     OLAPStatus _create_hard_link();
@@ -71,6 +97,9 @@ private:
     std::vector<uint64_t> _uniq_keys;      // 存储每一种前缀组合的独特值个数
     std::vector<uint32_t> _selectivities;  // 保存每一种前缀组合的selectivity
     Version _simple_merge_version;
+    // 子merge读取的key区间[_start_key, _end_key), 为NULL时表示不限制
+    const RowCursor* _start_key;
+    const RowCursor* _end_key;
 
     DISALLOW_COPY_AND_ASSIGN(Merger);
 };
@@ -126,6 +126,7 @@ enum OLAPCompressionType {
     OLAP_COMP_TRANSPORT = 1,    // 用于网络传输的压缩算法，压缩率低，cpu开销低
     OLAP_COMP_STORAGE = 2,      // 用于硬盘数据的压缩算法，压缩率高，cpu开销大
     OLAP_COMP_LZ4 = 3,          // 用于储存的压缩算法，压缩率低，cpu开销低
+    OLAP_COMP_ZSTD = 4,         // 用于储存的压缩算法，压缩率高，解压速度较快
 };
 
 // hll数据存储格式,优化存储结构减少多余空间的占用
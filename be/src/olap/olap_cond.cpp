@@ -198,8 +198,14 @@ bool Cond::eval(const ColumnStatistics& statistic) const {
         return true;
     }
 
-    if (OP_IS != op && statistic.minimum()->is_null()) {
-        return true;
+    if (OP_IS != op) {
+        if (statistic.all_null()) {
+            //任何operand和NULL的运算都是false
+            return false;
+        } else if (!statistic.null_aware() && statistic.has_null()) {
+            //旧格式中有NULL时最小值为NULL，无法根据最小值过滤
+            return true;
+        }
     }
 
     switch (op) {
@@ -235,17 +241,9 @@ bool Cond::eval(const ColumnStatistics& statistic) const {
     }
     case OP_IS: {
         if (operand_field->is_null()) {
-            if (statistic.minimum()->is_null()) {
-                return true;
-            } else {
-                return false;
-            }
+            return statistic.has_null();
         } else {
-            if (!statistic.maximum()->is_null()) {
-                return true;
-            } else {
-                return false;
-            }
+            return !statistic.all_null();
         }
     }
     default:
@@ -264,9 +262,9 @@ int Cond::del_eval(const ColumnStatistics& stat) const {
     }
 
     if (OP_IS != op) {
-        if (stat.minimum()->is_null() && stat.maximum()->is_null()) {
+        if (stat.all_null()) {
             return DEL_NOT_SATISFIED;
-        } else if (stat.minimum()->is_null() && !stat.maximum()->is_null()) {
+        } else if (stat.has_null()) {
             return DEL_PARTIAL_SATISFIED;
         }
     }
@@ -359,18 +357,17 @@ int Cond::del_eval(const ColumnStatistics& stat) const {
     }
     case OP_IS: {
         if (operand_field->is_null()) {
-            if (stat.minimum()->is_null() && stat.maximum()->is_null()) {
+            if (stat.all_null()) {
                 ret = DEL_SATISFIED;
-            } else if (stat.minimum()->is_null() && !stat.maximum()->is_null()) {
+            } else if (stat.has_null()) {
                 ret = DEL_PARTIAL_SATISFIED;
             } else {
-                //不会出现min不为NULL，max为NULL
                 ret = DEL_NOT_SATISFIED;
             }
         } else {
-            if (stat.minimum()->is_null() && stat.maximum()->is_null()) {
+            if (stat.all_null()) {
                 ret = DEL_NOT_SATISFIED;
-            } else if (stat.minimum()->is_null() && !stat.maximum()->is_null()) {
+            } else if (stat.has_null()) {
                 ret = DEL_PARTIAL_SATISFIED;
             } else {
                 ret = DEL_SATISFIED;
@@ -704,7 +701,10 @@ bool CondColumn::add_condition(Cond* condition) {
 
 bool CondColumn::eval(const RowCursor& row) const {
     //通过一列上的所有查询条件对单行数据进行过滤
-    const Field* field = row.get_field_by_index(_col_index);
+    return eval(row.get_field_by_index(_col_index));
+}
+
+bool CondColumn::eval(const Field* field) const {
     vector<Cond>::const_iterator each_cond = _conds.begin();
     for (; each_cond != _conds.end(); ++each_cond) {
         // As long as there is one condition not satisfied, we can return false
@@ -818,6 +818,38 @@ bool CondColumn::eval(const column_file::BloomFilter& bf) const {
     return true;
 }
 
+int CondColumn::del_eval(const column_file::BloomFilter& bf) const {
+    //各条件之间是AND关系, 任一等值或IN条件在block中不可能满足时, 整个删除条件都不满足
+    vector<Cond>::const_iterator each_cond = _conds.begin();
+    for (; each_cond != _conds.end(); ++each_cond) {
+        if (each_cond->op == OP_EQ) {
+            if (each_cond->operand_field->is_null()) {
+                continue;
+            }
+        } else if (each_cond->op == OP_IN) {
+            bool has_null = false;
+            Cond::FieldSet::const_iterator it = each_cond->operand_set.begin();
+            for (; it != each_cond->operand_set.end(); ++it) {
+                if ((*it)->is_null()) {
+                    has_null = true;
+                    break;
+                }
+            }
+            if (has_null) {
+                continue;
+            }
+        } else {
+            continue;
+        }
+
+        if (!each_cond->eval(bf)) {
+            return DEL_NOT_SATISFIED;
+        }
+    }
+
+    return DEL_PARTIAL_SATISFIED;
+}
+
 void CondColumn::finalize() {
     for (vector<Cond>::iterator it = _conds.begin(); it != _conds.end(); ++it) {
         it->finalize();
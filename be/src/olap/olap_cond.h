@@ -120,6 +120,9 @@ public:
 
     // 对一行数据中的指定列，用所有过滤条件进行比较，如果所有条件都满足，则过滤此行
     bool eval(const RowCursor& row) const;
+
+    // 用所有过滤条件对本列的一个值进行比较，所有条件都满足时返回true
+    bool eval(const Field* field) const;
     
     bool eval(const column_file::ColumnStatistics& statistic) const;
     int del_eval(const column_file::ColumnStatistics& col_stat) const;
@@ -128,6 +131,9 @@ public:
     int del_eval(const std::pair<Field *, Field *>& statistic) const;
 
     bool eval(const column_file::BloomFilter& bf) const;
+    // 用BloomFilter判断block中是否一定没有满足删除条件的数据, 只有等值和IN条件
+    // 能得出DEL_NOT_SATISFIED, 其余情况返回DEL_PARTIAL_SATISFIED
+    int del_eval(const column_file::BloomFilter& bf) const;
 
     void finalize();
 
@@ -48,9 +48,20 @@ static const uint32_t OLAP_DEFAULT_COLUMN_DICT_KEY_SIZE_THRESHOLD = 80; // 30%
 // LRU Cache Key的大小
 static const size_t OLAP_LRU_CACHE_MAX_KEY_LENTH = OLAP_MAX_PATH_LEN * 2;
 
+// 每个预读线程在队列中最多等待的预读任务数
+static const uint32_t SEGMENT_PREFETCH_QUEUE_SIZE_PER_THREAD = 64;
+
+// 并行merge, push转换和schema change排序等线程池中, 每个线程在队列中最多等待的任务数.
+// 任务提交失败时由提交者自己执行, 因此队列不需要很长
+static const uint32_t PARALLEL_TASK_QUEUE_SIZE_PER_THREAD = 4;
+
+// 每个tablet缓存的版本路径数, 超过后清空重新缓存
+static const size_t MAX_CACHED_SPAN_PATHS = 16;
+
+// 每个启动加载线程在队列中最多等待的tablet数
+static const uint32_t LOAD_TABLET_QUEUE_SIZE_PER_THREAD = 64;
+
 static const uint64_t OLAP_FIX_HEADER_MAGIC_NUMBER = 0;
-// 执行be/ce时默认的候选集大小
-static constexpr uint32_t OLAP_EXPANSION_DEFAULT_CANDIDATE_SIZE = 10;
 
 enum OLAPDataVersion {
     OLAP_V1 = 0,
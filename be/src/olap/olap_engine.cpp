@@ -33,6 +33,7 @@
 #include <rapidjson/document.h>
 
 #include "olap/base_expansion_handler.h"
+#include "olap/column_file/page_cache.h"
 #include "olap/cumulative_handler.h"
 #include "olap/lru_cache.h"
 #include "olap/olap_header.h"
@@ -42,6 +43,8 @@
 #include "olap/schema_change.h"
 #include "olap/utils.h"
 #include "olap/writer.h"
+#include "util/count_down_latch.hpp"
+#include "util/thread_pool.hpp"
 
 using boost::filesystem::canonical;
 using boost::filesystem::directory_iterator;
@@ -53,7 +56,6 @@ using std::list;
 using std::map;
 using std::nothrow;
 using std::pair;
-using std::priority_queue;
 using std::set;
 using std::set_difference;
 using std::string;
@@ -74,18 +76,26 @@ bool _sort_table_by_create_time(const SmartOLAPTable& a, const SmartOLAPTable& b
 OLAPEngine::OLAPEngine() :
         _global_table_id(0),
         _file_descriptor_lru_cache(NULL),
-        _index_stream_lru_cache(NULL) {}
+        _index_stream_lru_cache(NULL),
+        _segment_prefetch_thread_pool(NULL),
+        _expansion_merge_thread_pool(NULL),
+        _push_convert_thread_pool(NULL),
+        _schema_change_sort_thread_pool(NULL),
+        _page_cache(NULL) {}
 
 OLAPEngine::~OLAPEngine() {
     clear();
 }
 
-OLAPStatus OLAPEngine::_load_tables(const string& tablet_root_path) {
+void OLAPEngine::_list_tablets(const string& tablet_root_path,
+                               vector<TabletLoadTask>* tasks,
+                               CountDownLatch* latch) {
     // 遍历跟目录寻找所有的shard
     set<string> shards;
     if (dir_walk(tablet_root_path + DATA_PREFIX, &shards, NULL) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to walk dir. [root=%s]", tablet_root_path.c_str());
-        return OLAP_ERR_INIT_FAILED;
+        latch->count_down();
+        return;
     }
 
     for (const auto& shard : shards) {
@@ -107,23 +117,31 @@ OLAPStatus OLAPEngine::_load_tables(const string& tablet_root_path) {
             }
 
             for (const auto& schema_hash : schema_hashes) {
-                TTabletId tablet_id = strtoul(tablet.c_str(), NULL, 10);
-                TSchemaHash tablet_schema_hash = strtoul(schema_hash.c_str(), NULL, 10);
-
-                // 遍历schema_hash目录寻找此index的所有schema
-                // 加载失败依然加载下一个Table
-                if (load_one_tablet(
-                        tablet_id,
-                        tablet_schema_hash,
-                        one_tablet_path + '/' + schema_hash) != OLAP_SUCCESS) {
-                    OLAP_LOG_WARNING("fail to load one table, but continue. [path='%s']",
-                                     (one_tablet_path + '/' + schema_hash).c_str());
-                }
+                TabletLoadTask task;
+                task.tablet_id = strtoul(tablet.c_str(), NULL, 10);
+                task.schema_hash = strtoul(schema_hash.c_str(), NULL, 10);
+                task.schema_hash_path = one_tablet_path + '/' + schema_hash;
+                tasks->push_back(task);
             }
         }
     }
 
-    return OLAP_SUCCESS;
+    latch->count_down();
+}
+
+void OLAPEngine::_load_tablet(const TabletLoadTask& task,
+                               std::atomic<uint32_t>* failed_num,
+                               CountDownLatch* latch) {
+    // 加载失败依然加载下一个Table
+    if (load_one_tablet(task.tablet_id,
+                        task.schema_hash,
+                        task.schema_hash_path) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to load one table, but continue. [path='%s']",
+                         task.schema_hash_path.c_str());
+        ++(*failed_num);
+    }
+
+    latch->count_down();
 }
 
 OLAPStatus OLAPEngine::load_one_tablet(
@@ -189,59 +207,71 @@ OLAPStatus OLAPEngine::load_one_tablet(
     return OLAP_SUCCESS;
 }
 
-void* load_root_path_thread_callback(void* arg) {
-    OLAPStatus res = OLAP_SUCCESS;
-    string root_path = (char*)arg;
-
-    if ((res = OLAPEngine::get_instance()->_load_tables(root_path.c_str())) != OLAP_SUCCESS) {
-        OLAP_LOG_WARNING("io error when init load tables. [res=%d root='%s']",
-                         res,
-                         root_path.c_str());
+// 所有root path上的tablet共用一个线程池加载, 空闲的线程总是取下一个待加载的tablet,
+// 不会因为某块盘上的tablet特别多而让其他盘的线程空等. 这里只加载header,
+// 索引在第一次get_table时才加载
+void OLAPEngine::load_root_paths(const OLAPRootPath::RootPathVec& root_paths) {
+    if (root_paths.empty()) {
+        return;
     }
 
-    return NULL;
-}
-
-// @static
-OLAPStatus OLAPEngine::_spawn_load_root_path_thread(pthread_t* thread, const string& root_path) {
-    sigset_t mask;
-    sigset_t omask;
-
-    sigemptyset(&mask);
-    sigaddset(&mask, SIGCHLD);
-    sigaddset(&mask, SIGHUP);
-    sigaddset(&mask, SIGPIPE);
-    pthread_sigmask(SIG_SETMASK, &mask, &omask);
+    uint32_t thread_num = config::load_tablet_thread_num > 0 ? config::load_tablet_thread_num : 1;
+    ThreadPool* thread_pool = new(std::nothrow) ThreadPool(
+            thread_num, thread_num * LOAD_TABLET_QUEUE_SIZE_PER_THREAD);
+    if (thread_pool == NULL) {
+        OLAP_LOG_WARNING("fail to init load tablet thread pool, load tablets serially.");
+    }
 
-    OLAP_LOG_TRACE("spawn a schema_change thread.");
+    OlapStopWatch watch;
+    vector<vector<TabletLoadTask> > root_path_tasks(root_paths.size());
+    CountDownLatch latch(root_paths.size());
+    for (uint32_t i = 0; i < root_paths.size(); ++i) {
+        if (thread_pool == NULL
+                || !thread_pool->offer(boost::bind(&OLAPEngine::_list_tablets, this,
+                                                   root_paths[i], &root_path_tasks[i], &latch))) {
+            _list_tablets(root_paths[i], &root_path_tasks[i], &latch);
+        }
+    }
+    latch.await();
 
-    int err = 0;
-    while ((err = pthread_create(thread,
-                                 NULL,
-                                 load_root_path_thread_callback,
-                                 reinterpret_cast<void*>(const_cast<char*>(
-                                         root_path.c_str())))) != 0) {
-        OLAP_LOG_WARNING("failed to spawn load root path thread.");
-        // Sleep 1s before next try
-        usleep(1000000);
+    size_t task_num = 0;
+    for (uint32_t i = 0; i < root_path_tasks.size(); ++i) {
+        task_num += root_path_tasks[i].size();
     }
 
-    pthread_sigmask(SIG_SETMASK, &omask, NULL);
-    return OLAP_SUCCESS;
-}
+    // 按root path轮流提交, 让所有盘同时参与加载
+    std::atomic<uint32_t> failed_num(0);
+    CountDownLatch load_latch(task_num);
+    for (size_t offset = 0; ; ++offset) {
+        bool has_task = false;
+        for (uint32_t i = 0; i < root_path_tasks.size(); ++i) {
+            if (offset >= root_path_tasks[i].size()) {
+                continue;
+            }
 
-void OLAPEngine::load_root_paths(const OLAPRootPath::RootPathVec& root_paths) {
-    pthread_t* load_root_path_thread = new pthread_t [root_paths.size()];
+            has_task = true;
+            const TabletLoadTask& task = root_path_tasks[i][offset];
+            if (thread_pool == NULL
+                    || !thread_pool->offer(boost::bind(&OLAPEngine::_load_tablet, this,
+                                                       boost::cref(task), &failed_num,
+                                                       &load_latch))) {
+                _load_tablet(task, &failed_num, &load_latch);
+            }
+        }
 
-    for (uint32_t i = 0; i < root_paths.size(); i++) {
-        _spawn_load_root_path_thread(&load_root_path_thread[i], root_paths[i]);
+        if (!has_task) {
+            break;
+        }
     }
 
-    for (uint32_t i = 0; i < root_paths.size(); i++) {
-        pthread_join(load_root_path_thread[i], NULL);
-    }
+    // 等待所有tablet加载完成, 之后才能向FE汇报tablet
+    load_latch.await();
+    SAFE_DELETE(thread_pool);
 
-    delete [] load_root_path_thread;
+    OLAP_LOG_INFO("finish to load tablets. [root_path_num=%lu tablet_num=%lu failed_num=%u "
+                  "thread_num=%u cost=%.3fs]",
+                  root_paths.size(), task_num, failed_num.load(), thread_num,
+                  watch.get_elapse_time_us() / 1000000.0);
 }
 
 OLAPStatus OLAPEngine::init() {
@@ -263,20 +293,50 @@ OLAPStatus OLAPEngine::init() {
         return OLAP_ERR_INIT_FAILED;
     }
 
-    // 初始化CE调度器
+    if (config::page_cache_capacity > 0) {
+        _page_cache = new(std::nothrow) column_file::PageCache(
+                config::page_cache_capacity, config::page_cache_admission_capacity);
+        if (_page_cache == NULL) {
+            OLAP_LOG_WARNING("failed to init page cache");
+            _tablet_map.clear();
+            return OLAP_ERR_INIT_FAILED;
+        }
+    }
+
+    if (_init_thread_pool("segment prefetch",
+                          config::segment_prefetch_thread_num,
+                          SEGMENT_PREFETCH_QUEUE_SIZE_PER_THREAD,
+                          &_segment_prefetch_thread_pool) != OLAP_SUCCESS
+            || _init_thread_pool("expansion merge",
+                                 config::expansion_merge_thread_num,
+                                 PARALLEL_TASK_QUEUE_SIZE_PER_THREAD,
+                                 &_expansion_merge_thread_pool) != OLAP_SUCCESS
+            || _init_thread_pool("push convert",
+                                 config::push_convert_thread_num,
+                                 PARALLEL_TASK_QUEUE_SIZE_PER_THREAD,
+                                 &_push_convert_thread_pool) != OLAP_SUCCESS
+            || _init_thread_pool("schema change sort",
+                                 config::schema_change_sort_thread_num,
+                                 PARALLEL_TASK_QUEUE_SIZE_PER_THREAD,
+                                 &_schema_change_sort_thread_pool) != OLAP_SUCCESS) {
+        _tablet_map.clear();
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    // 初始化BE和CE调度器, 每块盘上同时执行的任务数不超过线程数按盘平均后的值
     vector<OLAPRootPathStat> all_root_paths_stat;
     OLAPRootPath::get_instance()->get_all_disk_stat(&all_root_paths_stat);
-    _ce_disk_stat.reserve(all_root_paths_stat.size());
     for (uint32_t i = 0; i < all_root_paths_stat.size(); i++) {
-        const OLAPRootPathStat& stat = all_root_paths_stat[i];
-        _ce_disk_stat.emplace_back(stat.root_path, i, stat.is_used);
-        _disk_id_map[stat.root_path] = i;
+        _expansion_scheduler.set_disk_used(all_root_paths_stat[i].root_path,
+                                           all_root_paths_stat[i].is_used);
     }
     int32_t ce_thread_num = config::cumulative_thread_num;
     int32_t be_thread_num = config::base_expansion_thread_num;
     uint32_t file_system_num = OLAPRootPath::get_instance()->get_file_system_count();
-    _max_ce_task_per_disk = (ce_thread_num + file_system_num - 1) / file_system_num;
-    _max_be_task_per_disk = (be_thread_num + file_system_num - 1) / file_system_num;
+    _expansion_scheduler.set_max_task_per_disk(
+            CUMULATIVE_EXPANSION, (ce_thread_num + file_system_num - 1) / file_system_num);
+    _expansion_scheduler.set_max_task_per_disk(
+            BASE_EXPANSION, (be_thread_num + file_system_num - 1) / file_system_num);
 
     // 加载所有table
     OLAPRootPath::get_instance()->get_all_available_root_path(&all_available_root_path);
@@ -288,10 +348,33 @@ OLAPStatus OLAPEngine::init() {
     return OLAP_SUCCESS;
 }
 
+OLAPStatus OLAPEngine::_init_thread_pool(const char* name,
+                                         int32_t thread_num,
+                                         uint32_t queue_size_per_thread,
+                                         ThreadPool** thread_pool) {
+    *thread_pool = NULL;
+    if (thread_num <= 0) {
+        return OLAP_SUCCESS;
+    }
+
+    *thread_pool = new(std::nothrow) ThreadPool(thread_num, thread_num * queue_size_per_thread);
+    if (*thread_pool == NULL) {
+        OLAP_LOG_WARNING("failed to init %s thread pool. [thread_num=%d]", name, thread_num);
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus OLAPEngine::clear() {
     // 删除lru中所有内容,其实进程退出这么做本身意义不大,但对单测和更容易发现问题还是有很大意义的
     SAFE_DELETE(_file_descriptor_lru_cache);
     SAFE_DELETE(_index_stream_lru_cache);
+    SAFE_DELETE(_segment_prefetch_thread_pool);
+    SAFE_DELETE(_expansion_merge_thread_pool);
+    SAFE_DELETE(_push_convert_thread_pool);
+    SAFE_DELETE(_schema_change_sort_thread_pool);
+    SAFE_DELETE(_page_cache);
 
     _tablet_map.clear();
     _global_table_id = 0;
@@ -906,7 +989,7 @@ void OLAPEngine::start_clean_fd_cache() {
     OLAP_LOG_TRACE("end clean file descritpor cache");
 }
 
-void OLAPEngine::start_base_expansion(string* last_be_fs, TTabletId* last_be_tablet_id) {
+void OLAPEngine::start_base_expansion() {
     uint64_t allow_be_excute_start_time = config::be_policy_start_time;
     uint64_t allow_be_excute_end_time = config::be_policy_end_time;
     time_t current_time = time(NULL);
@@ -934,193 +1017,159 @@ void OLAPEngine::start_base_expansion(string* last_be_fs, TTabletId* last_be_tab
         }
     }
 
-    SmartOLAPTable tablet;
-    BaseExpansionHandler base_expansion_handler;
+    if (_expansion_scheduler.need_update(BASE_EXPANSION,
+                                         config::expansion_candidate_update_interval_sec)) {
+        _update_expansion_candidates(BASE_EXPANSION);
+    }
 
-    bool do_base_expansion = false;
-    OLAP_LOG_TRACE("start_base_expansion begin.");
-    _tablet_map_lock.rdlock();
-    _fs_task_mutex.lock();
+    ExpansionCandidate candidate;
+    while (_expansion_scheduler.next_candidate(BASE_EXPANSION, &candidate)) {
+        SmartOLAPTable table = get_table(candidate.tablet_id, candidate.schema_hash);
+        BaseExpansionHandler base_expansion_handler;
+        // 跳过已经删除或者正在做schema change的table
+        if (table.get() == NULL || !_can_do_be_ce(table)
+                || base_expansion_handler.init(table, false) != OLAP_SUCCESS) {
+            _expansion_scheduler.finish_candidate(BASE_EXPANSION, candidate);
+            continue;
+        }
 
-    if (*last_be_fs != "") {
-        _fs_be_task_num_map[*last_be_fs] -= 1;
-        last_be_fs->clear();
-    }
+        OLAP_LOG_NOTICE_PUSH("request", "START_BASE_EXPANSION");
+        OLAP_LOG_INFO("start base expansion. [tablet=%s score=%f delta_num=%u]",
+                      table->full_name().c_str(), candidate.score, candidate.delta_num);
+        if (base_expansion_handler.run() != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("failed to do base expansion. [tablet='%s']",
+                             table->full_name().c_str());
+        }
 
-    for (const auto& i : _tablet_map) {
-        for (SmartOLAPTable j : i.second.table_arr) {
-            // 保证从上一次被选中进行BE的表开始轮询
-            if (i.first <= *last_be_tablet_id) {
-                continue;
-            }
+        _expansion_scheduler.finish_candidate(BASE_EXPANSION, candidate);
+        return;
+    }
 
-            if (_fs_be_task_num_map[j->storage_root_path_name()] >= _max_be_task_per_disk) {
-                continue;
-            }
+    OLAP_LOG_TRACE("no tablet selected to do base expansion this loop.");
+}
 
-            // 跳过正在做schema change的tablet
-            if (!_can_do_be_ce(j)) {
-                OLAP_LOG_DEBUG("skip tablet, it is schema changing. [tablet=%s]",
-                               j->full_name().c_str());
-                continue;
-            }
+bool OLAPEngine::_get_expansion_deltas(ExpansionType type,
+                                       SmartOLAPTable table,
+                                       uint32_t* delta_num,
+                                       int64_t* delta_bytes) {
+    // cumulative layer point之上的版本由ce合并, 之下除base以外的版本由be合并进base
+    bool base_version_exists = false;
+    const int32_t point = table->cumulative_layer_point();
+    *delta_num = 0;
+    *delta_bytes = 0;
+    for (int i = 0; i < table->file_version_size(); ++i) {
+        const FileVersionMessage& version = table->file_version(i);
+        if (version.start_version() == 0) {
+            base_version_exists = true;
+            continue;
+        }
 
-            if (base_expansion_handler.init(j, false) == OLAP_SUCCESS) {
-                tablet = j;
-                do_base_expansion = true;
-                _fs_be_task_num_map[tablet->storage_root_path_name()] += 1;
-                *last_be_fs = tablet->storage_root_path_name();
-                *last_be_tablet_id = i.first;
-                goto TRY_START_BE_OK;
-            }
+        if ((type == CUMULATIVE_EXPANSION) == (version.start_version() >= point)) {
+            ++*delta_num;
+            *delta_bytes += version.data_size();
         }
     }
 
-    // when the loop comes the end, restart from begin
-    *last_be_tablet_id = -1;
-
-TRY_START_BE_OK:
-    _fs_task_mutex.unlock();
-    _tablet_map_lock.unlock();
-    OLAP_LOG_TRACE("start_base_expansion end.");
+    // base不存在可能是tablet正在做alter table，先不选它
+    if (!base_version_exists) {
+        return false;
+    }
 
-    if (do_base_expansion) {
-        OLAP_LOG_NOTICE_PUSH("request", "START_BASE_EXPANSION");
-        OLAPStatus cmd_res = base_expansion_handler.run();
-        if (cmd_res != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("failed to do base expansion. [tablet='%s']",
-                             tablet->full_name().c_str());
-        }
+    if (type == CUMULATIVE_EXPANSION) {
+        return *delta_num >= static_cast<uint32_t>(config::ce_policy_delta_files_number);
+    } else {
+        return *delta_num > 0;
     }
 }
 
-void OLAPEngine::_select_candidate() {
-    // 这是一个小根堆，用于记录nice最大的top k个candidate tablet
-    SmartOLAPTable tablet;
-    typedef priority_queue<ExpansionCandidate, vector<ExpansionCandidate>,
-            ExpansionCandidateComparator> candidate_heap_t;
-    vector<candidate_heap_t> candidate_heap_vec(_ce_disk_stat.size());
+void OLAPEngine::_update_expansion_candidates(ExpansionType type) {
+    vector<OLAPRootPathStat> all_root_paths_stat;
+    OLAPRootPath::get_instance()->get_all_disk_stat(&all_root_paths_stat);
+    for (uint32_t i = 0; i < all_root_paths_stat.size(); i++) {
+        _expansion_scheduler.set_disk_used(all_root_paths_stat[i].root_path,
+                                           all_root_paths_stat[i].is_used);
+    }
+
+    vector<ExpansionCandidate> candidates;
+    _tablet_map_lock.rdlock();
     for (const auto& i : _tablet_map) {
-        uint32_t nice = 0;
-        // calc nice
         for (SmartOLAPTable j : i.second.table_arr) {
             if (!j->is_loaded()) {
                 continue;
             }
 
+            ExpansionCandidate candidate;
             j->obtain_header_rdlock();
-            const uint32_t curr_nice = j->get_expansion_nice_estimate();
+            bool need_expansion = _get_expansion_deltas(
+                    type, j, &candidate.delta_num, &candidate.delta_bytes);
             j->release_header_lock();
-            nice = curr_nice > nice ? curr_nice : nice;
-            tablet = j;
-        }
 
-        // save
-        if (nice > 0) {
-            uint32_t disk_id = _disk_id_map[tablet->storage_root_path_name()];
-            candidate_heap_vec[disk_id].emplace(nice, i.first, disk_id);
-            if (candidate_heap_vec[disk_id].size() > OLAP_EXPANSION_DEFAULT_CANDIDATE_SIZE) {
-                candidate_heap_vec[disk_id].pop();
+            // 读放大只用于ce的打分, 但无论是否选中都需要衰减历史统计
+            double read_amplification = type == CUMULATIVE_EXPANSION
+                                      ? j->decay_read_amplification() : 0;
+            if (!need_expansion) {
+                continue;
             }
-        }
-    }
-
-    _ce_candidate.clear();
-    for (auto& stat : _ce_disk_stat) {
-        stat.task_remaining = 0;
-    }
 
-    for (auto& candidate_heap : candidate_heap_vec) {
-        while (!candidate_heap.empty()) {
-            _ce_candidate.push_back(candidate_heap.top());
-            ++_ce_disk_stat[candidate_heap.top().disk_index].task_remaining;
-            candidate_heap.pop();
+            candidate.tablet_id = j->tablet_id();
+            candidate.schema_hash = j->schema_hash();
+            candidate.root_path = j->storage_root_path_name();
+            candidate.read_amplification = read_amplification;
+            candidate.score = ExpansionScheduler::compute_score(
+                    candidate.delta_num, candidate.delta_bytes, candidate.read_amplification);
+            candidates.push_back(candidate);
         }
     }
+    _tablet_map_lock.unlock();
 
-    // sort small to big
-    sort(_ce_candidate.rbegin(), _ce_candidate.rend(), ExpansionCandidateComparator());
+    _expansion_scheduler.update_candidates(type, candidates);
 }
 
 void OLAPEngine::start_cumulative_priority() {
-    _tablet_map_lock.rdlock();
-    _fs_task_mutex.lock();
-
-    // determine whether to select candidate or not 
-    bool is_select = false;
-    vector<OLAPRootPathStat> all_root_paths_stat;
-    OLAPRootPath::get_instance()->get_all_disk_stat(&all_root_paths_stat);
-    for (uint32_t i = 0; i < all_root_paths_stat.size(); i++) {
-        uint32_t disk_id = _disk_id_map[all_root_paths_stat[i].root_path];
-        _ce_disk_stat[disk_id].is_used = all_root_paths_stat[i].is_used;
-    }
-
-    for (auto& disk : _ce_disk_stat) {
-        if (!disk.task_remaining && disk.is_used) {
-            is_select = true;
-        }
-    }
-
-    if (is_select) {
-        _select_candidate();
-    }
-
-    // traverse _ce_candidate to start cumulative expansion
-    CumulativeHandler cumulative_handler;
-    for (auto it_cand = _ce_candidate.rbegin(); it_cand != _ce_candidate.rend(); ++it_cand) {
-        ExpansionCandidate candidate = *it_cand;
-        const auto i = _tablet_map.find(candidate.tablet_id);
-        if (i == _tablet_map.end()) {
-            // tablet已经不存在
-            _ce_candidate.erase(it_cand.base() - 1);
-            --_ce_disk_stat[candidate.disk_index].task_remaining;
+    if (_expansion_scheduler.need_update(CUMULATIVE_EXPANSION,
+                                         config::expansion_candidate_update_interval_sec)) {
+        _update_expansion_candidates(CUMULATIVE_EXPANSION);
+    }
+
+    ExpansionCandidate candidate;
+    while (_expansion_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate)) {
+        SmartOLAPTable table = get_table(candidate.tablet_id, candidate.schema_hash);
+        CumulativeHandler cumulative_handler;
+        // 跳过已经删除或者正在做schema change的table
+        if (table.get() == NULL || !_can_do_be_ce(table)
+                || cumulative_handler.init(table) != OLAP_SUCCESS) {
+            _expansion_scheduler.finish_candidate(CUMULATIVE_EXPANSION, candidate);
             continue;
         }
 
-        if (_ce_disk_stat[candidate.disk_index].task_running >= _max_ce_task_per_disk) {
-            OLAP_LOG_DEBUG("skip tablet, too much ce task on disk %s",
-                    _ce_disk_stat[candidate.disk_index].storage_path.c_str());
-            // 某个disk上任务数太多，跳过，candidate中保留这个任务
-            continue;
+        OLAP_LOG_DEBUG("start cumulative expansion. [tablet=%s score=%f delta_num=%u]",
+                       table->full_name().c_str(), candidate.score, candidate.delta_num);
+        if (cumulative_handler.run() != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("failed to do cumulative. [tablet='%s']",
+                             table->full_name().c_str());
         }
 
-        for (SmartOLAPTable j : i->second.table_arr) {
-            if (!_can_do_be_ce(j)) {
-                OLAP_LOG_DEBUG("skip tablet, it is schema changing. [tablet=%s]",
-                               j->full_name().c_str());
-                continue;
-            }
-
-            if (cumulative_handler.init(j) == OLAP_SUCCESS) {
-                _ce_candidate.erase(it_cand.base() - 1);
-                --_ce_disk_stat[candidate.disk_index].task_remaining;
-                ++_ce_disk_stat[candidate.disk_index].task_running;
-                _fs_task_mutex.unlock();
-                _tablet_map_lock.unlock();
-
-                // start cumulative
-                if (cumulative_handler.run() != OLAP_SUCCESS) {
-                    OLAP_LOG_WARNING("failed to do cumulative. [tablet='%s']",
-                                     j->full_name().c_str());
-                }
-
-                _fs_task_mutex.lock();
-                --_ce_disk_stat[candidate.disk_index].task_running;
-                _fs_task_mutex.unlock();
-                return;
-            }
-        }
-        // 这个tablet不适合做ce
-        _ce_candidate.erase(it_cand.base() - 1);
-        --_ce_disk_stat[candidate.disk_index].task_remaining;
+        _expansion_scheduler.finish_candidate(CUMULATIVE_EXPANSION, candidate);
+        return;
     }
-    _fs_task_mutex.unlock();
-    _tablet_map_lock.unlock();
+
     OLAP_LOG_TRACE("no tablet selected to do cumulative expansion this loop.");
 }
 
 void OLAPEngine::get_cache_status(rapidjson::Document* document) const {
-    return _index_stream_lru_cache->get_cache_status(document);
+    // 每个cache输出各分片的统计信息
+    rapidjson::Document::AllocatorType& allocator = document->GetAllocator();
+    document->SetObject();
+
+    rapidjson::Document index_stream_status(&allocator);
+    index_stream_status.SetArray();
+    _index_stream_lru_cache->get_cache_status(&index_stream_status);
+    document->AddMember("index_stream_cache", index_stream_status, allocator);
+
+    rapidjson::Document file_descriptor_status(&allocator);
+    file_descriptor_status.SetArray();
+    _file_descriptor_lru_cache->get_cache_status(&file_descriptor_status);
+    document->AddMember("file_descriptor_cache", file_descriptor_status, allocator);
 }
 
 OLAPStatus OLAPEngine::start_trash_sweep(double* usage) {
@@ -1254,6 +1303,13 @@ OLAPStatus OLAPEngine::_create_new_table_header_file(
     // set basic information
     header.set_num_short_key_fields(request.tablet_schema.short_key_column_count);
     header.set_compress_kind(COMPRESS_LZ4);
+    if (request.tablet_schema.storage_type == TStorageType::COLUMN) {
+        if (config::default_column_file_compress_kind == "zstd") {
+            header.set_compress_kind(COMPRESS_ZSTD);
+        } else if (config::default_column_file_compress_kind == "adaptive") {
+            header.set_compress_kind(COMPRESS_ADAPTIVE);
+        }
+    }
 
     if (request.tablet_schema.keys_type == TKeysType::DUP_KEYS) {
         header.set_keys_type(KeysType::DUP_KEYS);
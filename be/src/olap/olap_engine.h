@@ -20,6 +20,7 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_OLAP_ENGINE_H
 #define BDG_PALO_BE_SRC_OLAP_OLAP_ENGINE_H
 
+#include <atomic>
 #include <ctime>
 #include <list>
 #include <map>
@@ -32,6 +33,7 @@
 
 #include "gen_cpp/AgentService_types.h"
 #include "gen_cpp/MasterService_types.h"
+#include "olap/expansion_scheduler.h"
 #include "olap/lru_cache.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
@@ -41,17 +43,19 @@
 
 namespace palo {
 
-void* load_root_path_thread_callback(void* arg);
-
+class CountDownLatch;
 class OLAPTable;
+class ThreadPool;
+
+namespace column_file {
+class PageCache;
+}
 
 // OLAPEngine singleton to manage all Table pointers.
 // Providing add/drop/get operations.
 // OLAPEngine instance doesn't own the Table resources, just hold the pointer,
 // allocation/deallocation must be done outside.
 class OLAPEngine {
-    friend void* load_root_path_thread_callback(void* arg);
-
     DECLARE_SINGLETON(OLAPEngine)
 public:
     // Get table pointer
@@ -114,11 +118,18 @@ public:
     OLAPStatus clear();
 
     void start_clean_fd_cache();
-    void start_base_expansion(std::string* last_be_fs, TTabletId* last_be_tablet_id);
 
-    // 调度ce，优先级调度
+    // 从调度队列中选出得分最高的table执行be
+    void start_base_expansion();
+
+    // 从调度队列中选出得分最高的table执行ce
     void start_cumulative_priority();
 
+    // 获取be和ce的调度队列和正在执行的任务
+    void get_expansion_status(rapidjson::Document* document) {
+        _expansion_scheduler.get_status(document);
+    }
+
     // 获取cache的使用情况信息
     void get_cache_status(rapidjson::Document* document) const;
 
@@ -138,6 +149,31 @@ public:
         return _file_descriptor_lru_cache;
     }
 
+    // 解压后数据块的缓存, 未开启时为NULL
+    column_file::PageCache* page_cache() {
+        return _page_cache;
+    }
+
+    // segment数据流的异步预读线程池, 未初始化时为NULL
+    ThreadPool* segment_prefetch_thread_pool() {
+        return _segment_prefetch_thread_pool;
+    }
+
+    // base和cumulative expansion按key区间并行merge的线程池, 未开启时为NULL
+    ThreadPool* expansion_merge_thread_pool() {
+        return _expansion_merge_thread_pool;
+    }
+
+    // push文件按segment大小分块并行写入的线程池, 未开启时为NULL
+    ThreadPool* push_convert_thread_pool() {
+        return _push_convert_thread_pool;
+    }
+
+    // schema change带排序时并行排序RowBlock和写入临时index的线程池, 未开启时为NULL
+    ThreadPool* schema_change_sort_thread_pool() {
+        return _schema_change_sort_thread_pool;
+    }
+
     // 清理trash和snapshot文件，返回清理后的磁盘使用量
     OLAPStatus start_trash_sweep(double *usage);
 
@@ -147,36 +183,7 @@ private:
         std::list<SmartOLAPTable> table_arr;
     };
 
-    struct ExpansionCandidate {
-        ExpansionCandidate(uint32_t nice_, int64_t tablet_id_, uint32_t index_) :
-                nice(nice_), tablet_id(tablet_id_), disk_index(index_) {}
-        uint32_t nice; // 优先度
-        int64_t tablet_id;
-        uint32_t disk_index = -1;
-    };
-
-    struct ExpansionCandidateComparator {
-        bool operator()(const ExpansionCandidate& a, const ExpansionCandidate& b) {
-            return a.nice > b.nice;
-        }
-    };
-
-    struct ExpansionDiskStat {
-        ExpansionDiskStat(std::string path, uint32_t index, bool used) :
-                storage_path(path),
-                disk_index(index),
-                task_running(0),
-                task_remaining(0),
-                is_used(used){}
-        const std::string storage_path;
-        const uint32_t disk_index;
-        uint32_t task_running;
-        uint32_t task_remaining;
-        bool is_used;
-    };
-
     typedef std::map<int64_t, TableInstances> tablet_map_t;
-    typedef std::map<std::string, uint32_t> file_system_task_count_t;
 
     SmartOLAPTable _get_table_with_no_lock(TTabletId tablet_id, SchemaHash schema_hash);
 
@@ -186,7 +193,21 @@ private:
                      std::set<std::string>* files);
 
     // 扫描目录, 加载表
-    OLAPStatus _load_tables(const std::string& tables_root_path);
+    // 启动时需要加载的一个tablet
+    struct TabletLoadTask {
+        TTabletId tablet_id;
+        SchemaHash schema_hash;
+        std::string schema_hash_path;
+    };
+
+    // 遍历root path下的所有shard和tablet目录, 只收集需要加载的tablet
+    void _list_tablets(const std::string& tablet_root_path,
+                       std::vector<TabletLoadTask>* tasks,
+                       CountDownLatch* latch);
+
+    void _load_tablet(const TabletLoadTask& task,
+                      std::atomic<uint32_t>* failed_num,
+                      CountDownLatch* latch);
 
     OLAPStatus _create_new_table_header_file(const TCreateTabletReq& request,
                                              const std::string& root_path,
@@ -196,13 +217,25 @@ private:
 
     OLAPStatus _check_existed_or_else_create_dir(const std::string& path);
 
+    // 创建thread_num个线程的线程池, 队列长度为thread_num * queue_size_per_thread.
+    // thread_num不大于0时不创建, thread_pool被置为NULL
+    OLAPStatus _init_thread_pool(const char* name,
+                                 int32_t thread_num,
+                                 uint32_t queue_size_per_thread,
+                                 ThreadPool** thread_pool);
+
     bool _can_do_be_ce(SmartOLAPTable table);
 
-    void _select_candidate();
+    // 重新计算所有table的得分, 更新be或ce的调度队列
+    void _update_expansion_candidates(ExpansionType type);
 
-    void _cancel_unfinished_schema_change();
+    // 计算table本次合并的版本数和数据量, 不需要合并时返回false. 调用前需要对header加锁
+    bool _get_expansion_deltas(ExpansionType type,
+                               SmartOLAPTable table,
+                               uint32_t* delta_num,
+                               int64_t* delta_bytes);
 
-    static OLAPStatus _spawn_load_root_path_thread(pthread_t* thread, const std::string& root_path);
+    void _cancel_unfinished_schema_change();
 
     OLAPStatus _do_sweep(
             const std::string& scan_root, const time_t& local_tm_now, const uint32_t expire);
@@ -212,14 +245,12 @@ private:
     size_t _global_table_id;
     Cache* _file_descriptor_lru_cache;
     Cache* _index_stream_lru_cache;
-    uint32_t _max_be_task_per_disk;
-    uint32_t _max_ce_task_per_disk;
-
-    MutexLock _fs_task_mutex;
-    file_system_task_count_t _fs_be_task_num_map;
-    std::vector<ExpansionCandidate> _ce_candidate;
-    std::vector<ExpansionDiskStat> _ce_disk_stat;
-    std::map<std::string, uint32_t> _disk_id_map;
+    ThreadPool* _segment_prefetch_thread_pool;
+    ThreadPool* _expansion_merge_thread_pool;
+    ThreadPool* _push_convert_thread_pool;
+    ThreadPool* _schema_change_sort_thread_pool;
+    column_file::PageCache* _page_cache;
+    ExpansionScheduler _expansion_scheduler;
 
     DISALLOW_COPY_AND_ASSIGN(OLAPEngine);
 };
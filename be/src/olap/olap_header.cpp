@@ -102,6 +102,7 @@ OLAPStatus OLAPHeader::load() {
         return OLAP_ERR_PARSE_PROTOBUF_ERROR;
     }
 
+    _clear_span_path_cache();
     clear_version_graph(&_version_graph, &_vertex_helper_map);
 
     if (construct_version_graph(file_version(),
@@ -198,6 +199,7 @@ OLAPStatus OLAPHeader::add_version(
         return OLAP_ERR_HEADER_ADD_VERSION;
     }
 
+    _clear_span_path_cache();
     if (add_version_to_graph(version, &_version_graph, &_vertex_helper_map) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to add version to graph. [version='%d-%d']",
                          version.first,
@@ -242,6 +244,7 @@ OLAPStatus OLAPHeader::delete_version(Version version) {
     }
 
     // Atomic delete is not supported now.
+    _clear_span_path_cache();
     if (delete_version_from_graph(file_version(),
                                   version,
                                   &_version_graph,
@@ -257,6 +260,7 @@ OLAPStatus OLAPHeader::delete_version(Version version) {
 
 OLAPStatus OLAPHeader::delete_all_versions() {
     clear_file_version();
+    _clear_span_path_cache();
     clear_version_graph(&_version_graph, &_vertex_helper_map);
 
     if (construct_version_graph(file_version(),
@@ -270,7 +274,8 @@ OLAPStatus OLAPHeader::delete_all_versions() {
 }
 
 // This function is called when base-expansion, cumulative-expansion, quering.
-// we use BFS algorithm to get the shortest version path.
+// Most calls ask for the same few versions between two changes of the graph,
+// so the result of the BFS is cached.
 OLAPStatus OLAPHeader::select_versions_to_span(const Version& target_version,
                                            vector<Version>* span_versions) {
     if (target_version.first > target_version.second) {
@@ -285,6 +290,40 @@ OLAPStatus OLAPHeader::select_versions_to_span(const Version& target_version,
         return OLAP_ERR_INPUT_PARAMETER_ERROR;
     }
 
+    {
+        AutoMutexLock l(&_span_path_cache_lock);
+        span_path_map_t::const_iterator it = _span_path_cache.find(target_version);
+        if (it != _span_path_cache.end()) {
+            span_versions->insert(span_versions->end(), it->second.begin(), it->second.end());
+            return OLAP_SUCCESS;
+        }
+    }
+
+    vector<Version> path;
+    OLAPStatus res = _find_shortest_path(target_version, &path);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    span_versions->insert(span_versions->end(), path.begin(), path.end());
+
+    AutoMutexLock l(&_span_path_cache_lock);
+    if (_span_path_cache.size() >= MAX_CACHED_SPAN_PATHS) {
+        _span_path_cache.clear();
+    }
+    _span_path_cache[target_version].swap(path);
+
+    return OLAP_SUCCESS;
+}
+
+void OLAPHeader::_clear_span_path_cache() {
+    AutoMutexLock l(&_span_path_cache_lock);
+    _span_path_cache.clear();
+}
+
+// we use BFS algorithm to get the shortest version path.
+OLAPStatus OLAPHeader::_find_shortest_path(const Version& target_version,
+                                           vector<Version>* span_versions) {
     // bfs_queue's element is vertex_index.
     queue<int> bfs_queue;
     // predecessor[i] means the predecessor of vertex_index 'i'.
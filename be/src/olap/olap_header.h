@@ -28,6 +28,7 @@
 #include "gen_cpp/olap_file.pb.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
+#include "olap/utils.h"
 
 namespace palo {
 // Class for managing olap table header.
@@ -88,11 +89,14 @@ public:
     // support reverse version in the path.
     void set_reverse_version(bool support_reverse_version) {
         _support_reverse_version = support_reverse_version;
+        _clear_span_path_cache();
     }
 
     // Try to select the least number of data files that can span the
     // target_version and append these data versions to the span_versions.
     // Return false if the target_version cannot be spanned.
+    // The selected path is cached per target_version until the version
+    // graph changes, so repeated queries on the same version skip the BFS.
     virtual OLAPStatus select_versions_to_span(const Version& target_version,
                                            std::vector<Version>* span_versions);
 
@@ -106,6 +110,23 @@ private:
     // names) using lzo_adler32 function.
     OLAPStatus _compute_schema_hash(SchemaHash* schema_hash);
 
+    // BFS over the version graph to find the shortest version path.
+    OLAPStatus _find_shortest_path(const Version& target_version,
+                                   std::vector<Version>* span_versions);
+
+    // Must be called whenever the version graph is changed.
+    void _clear_span_path_cache();
+
+    struct HashOfVersion {
+        uint64_t operator()(const Version& version) const {
+            uint64_t hash_value = version.first;
+            hash_value = (hash_value << 32) + version.second;
+            return hash_value;
+        }
+    };
+
+    typedef std::unordered_map<Version, std::vector<Version>, HashOfVersion> span_path_map_t;
+
     // full path of olap header file
     std::string _file_name;
 
@@ -127,6 +148,15 @@ private:
     // It is easy to find vertex index according to vertex value.
     std::unordered_map<int, int> _vertex_helper_map;
 
+    // target_version --> shortest version path. Writers of the version graph
+    // hold the header write lock, but concurrent readers holding the header
+    // read lock all fill the cache, so it has a lock of its own which is
+    // only held for the lookup or insertion.
+    span_path_map_t _span_path_cache;
+    MutexLock _span_path_cache_lock;
+
+    friend class TestOLAPHeader;
+
     DISALLOW_COPY_AND_ASSIGN(OLAPHeader);
 };
 
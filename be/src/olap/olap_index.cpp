@@ -23,7 +23,9 @@
 #include <cassert>
 #include <cmath>
 #include <fstream>
+#include <sys/mman.h>
 
+#include "common/config.h"
 #include "olap/olap_data.h"
 #include "olap/olap_table.h"
 #include "olap/row_block.h"
@@ -138,6 +140,72 @@ void OLAPIndex::delete_all_files() {
     }
 }
 
+OLAPStatus OLAPIndex::stitch_sub_indices(const vector<OLAPIndex*>& sub_indices) {
+    OLAPStatus res = OLAP_SUCCESS;
+    vector<string> new_files;
+    uint32_t num_segments = 0;
+
+    for (size_t i = 0; i < sub_indices.size(); ++i) {
+        OLAPIndex* sub_index = sub_indices[i];
+        for (uint32_t seg_id = 0; seg_id < sub_index->num_segments(); ++seg_id) {
+            string old_paths[2] = {
+                _construct_index_file_path(sub_index->version(), sub_index->version_hash(), seg_id),
+                _construct_data_file_path(sub_index->version(), sub_index->version_hash(), seg_id)};
+            string new_paths[2] = {
+                _construct_index_file_path(_version, _version_hash, num_segments),
+                _construct_data_file_path(_version, _version_hash, num_segments)};
+
+            for (int j = 0; j < 2; ++j) {
+                if (0 != rename(old_paths[j].c_str(), new_paths[j].c_str())) {
+                    OLAP_LOG_WARNING("fail to rename file. [old_path=%s new_path=%s] [%m]",
+                                     old_paths[j].c_str(),
+                                     new_paths[j].c_str());
+                    res = OLAP_ERR_OS_ERROR;
+                    goto EXIT;
+                }
+
+                new_files.push_back(new_paths[j]);
+            }
+
+            ++num_segments;
+        }
+        sub_index->set_num_segments(0);
+
+        // 合并各sub index的最小值和最大值
+        if (!has_column_statistics()) {
+            res = set_column_statistics(sub_index->get_column_statistics());
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to set column statistics. [res=%d]", res);
+                goto EXIT;
+            }
+        } else {
+            vector<std::pair<Field*, Field*> >& sub_stats = sub_index->get_column_statistics();
+            for (size_t j = 0; j < _column_statistics.size(); ++j) {
+                if (_column_statistics[j].first->cmp(sub_stats[j].first) > 0) {
+                    _column_statistics[j].first->copy(sub_stats[j].first);
+                }
+
+                if (_column_statistics[j].second->cmp(sub_stats[j].second) < 0) {
+                    _column_statistics[j].second->copy(sub_stats[j].second);
+                }
+            }
+        }
+    }
+
+    set_num_segments(num_segments);
+
+EXIT:
+    if (res != OLAP_SUCCESS) {
+        for (vector<string>::iterator it = new_files.begin(); it != new_files.end(); ++it) {
+            if (0 != remove(it->c_str())) {
+                OLAP_LOG_WARNING("fail to remove renamed file.[file='%s']", it->c_str());
+            }
+        }
+    }
+
+    return res;
+}
+
 OLAPStatus OLAPIndex::set_column_statistics(
         std::vector<std::pair<Field *, Field *> > &column_statistics) {
     if (_inited_column_statistics) {
@@ -638,15 +706,218 @@ uint64_t OLAPIndex::num_index_entries() const {
     return _index.count();
 }
 
+// 释放segment的索引内容, mmap的文件需要munmap, 否则是堆上分配的内存
+static void release_segment(SegmentMetaInfo* meta) {
+    if (meta->mmap_base != NULL) {
+        munmap(meta->mmap_base, meta->mmap_length);
+        meta->mmap_base = NULL;
+        meta->mmap_length = 0;
+    } else {
+        free(meta->buffer.data);
+    }
+
+    meta->buffer.data = NULL;
+    meta->buffer.length = 0;
+    free(meta->key_prefixes);
+    meta->key_prefixes = NULL;
+}
+
+bool is_key_prefix_supported(FieldType type) {
+    switch (type) {
+    case OLAP_FIELD_TYPE_TINYINT:
+    case OLAP_FIELD_TYPE_UNSIGNED_TINYINT:
+    case OLAP_FIELD_TYPE_SMALLINT:
+    case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT:
+    case OLAP_FIELD_TYPE_INT:
+    case OLAP_FIELD_TYPE_UNSIGNED_INT:
+    case OLAP_FIELD_TYPE_BIGINT:
+    case OLAP_FIELD_TYPE_UNSIGNED_BIGINT:
+    case OLAP_FIELD_TYPE_DATE:
+    case OLAP_FIELD_TYPE_DATETIME:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// NULL为0, 比所有非NULL值都小; 非NULL值最高位为1, 有符号数翻转符号位后
+// 左对齐到高位, 再右移一位
+uint64_t normalize_key_prefix(FieldType type, bool is_null, const char* value) {
+    if (is_null) {
+        return 0;
+    }
+
+    uint64_t norm = 0;
+    switch (type) {
+    case OLAP_FIELD_TYPE_TINYINT:
+        norm = static_cast<uint64_t>(static_cast<uint8_t>(*value) ^ 0x80) << 56;
+        break;
+    case OLAP_FIELD_TYPE_UNSIGNED_TINYINT:
+        norm = static_cast<uint64_t>(static_cast<uint8_t>(*value)) << 56;
+        break;
+    case OLAP_FIELD_TYPE_SMALLINT: {
+        uint16_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        norm = static_cast<uint64_t>(v ^ 0x8000) << 48;
+        break;
+    }
+    case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT: {
+        uint16_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        norm = static_cast<uint64_t>(v) << 48;
+        break;
+    }
+    case OLAP_FIELD_TYPE_INT: {
+        uint32_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        norm = static_cast<uint64_t>(v ^ 0x80000000U) << 32;
+        break;
+    }
+    case OLAP_FIELD_TYPE_UNSIGNED_INT: {
+        uint32_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        norm = static_cast<uint64_t>(v) << 32;
+        break;
+    }
+    case OLAP_FIELD_TYPE_BIGINT:
+        memcpy(&norm, value, sizeof(norm));
+        norm ^= 0x8000000000000000ULL;
+        break;
+    case OLAP_FIELD_TYPE_UNSIGNED_BIGINT:
+    case OLAP_FIELD_TYPE_DATETIME:
+        memcpy(&norm, value, sizeof(norm));
+        break;
+    case OLAP_FIELD_TYPE_DATE: {
+        // uint24_t按小端存放在3个字节中
+        const uint8_t* v = reinterpret_cast<const uint8_t*>(value);
+        norm = (static_cast<uint64_t>(v[2]) << 56)
+                | (static_cast<uint64_t>(v[1]) << 48)
+                | (static_cast<uint64_t>(v[0]) << 40);
+        break;
+    }
+    default:
+        break;
+    }
+
+    return (1ULL << 63) | (norm >> 1);
+}
+
+// 循环内没有分支, 只依赖条件传送, 避免二分查找中难以预测的跳转
+size_t search_key_prefix(const uint64_t* prefixes,
+                                size_t count,
+                                uint64_t value,
+                                bool upper) {
+    if (count == 0) {
+        return 0;
+    }
+
+    const uint64_t* base = prefixes;
+    size_t len = count;
+    if (upper) {
+        while (len > 1) {
+            size_t half = len / 2;
+            base += (base[half - 1] <= value) ? half : 0;
+            len -= half;
+        }
+
+        return base - prefixes + (*base <= value);
+    } else {
+        while (len > 1) {
+            size_t half = len / 2;
+            base += (base[half - 1] < value) ? half : 0;
+            len -= half;
+        }
+
+        return base - prefixes + (*base < value);
+    }
+}
+
 MemIndex::~MemIndex() {
     _num_entries = 0;
     for (vector<SegmentMetaInfo>::iterator it = _meta.begin(); it != _meta.end(); ++it) {
-        free(it->buffer.data);
-        it->buffer.data = NULL;
-        it->buffer.length = 0;
+        release_segment(&*it);
     }
 }
 
+OLAPStatus MemIndex::_read_segment(FileHandler* file_handler,
+                                   bool null_supported,
+                                   size_t num_entries,
+                                   SegmentMetaInfo* meta) {
+    // 新格式的索引文件不需要转换, 直接以MAP_PRIVATE方式映射整个文件,
+    // 启动时不必把所有索引读入堆内存, 对映射内容的修改也不会写回文件
+    if (null_supported && config::short_key_index_use_mmap && meta->buffer.length > 0) {
+        size_t mmap_length = meta->file_header.file_length();
+        void* base = mmap(NULL, mmap_length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, file_handler->fd(), 0);
+        if (base != MAP_FAILED) {
+            meta->mmap_base = reinterpret_cast<char*>(base);
+            meta->mmap_length = mmap_length;
+            meta->buffer.data = meta->mmap_base + meta->file_header.size();
+            return OLAP_SUCCESS;
+        }
+
+        OLAP_LOG_WARNING("fail to mmap index file, read it instead. [file='%s' err=%m]",
+                         file_handler->file_name().c_str());
+    }
+
+    if (false == null_supported) {
+        meta->buffer.data = reinterpret_cast<char*>(
+                calloc(meta->buffer.length + num_entries * short_key_num(), 1));
+    } else {
+        meta->buffer.data = reinterpret_cast<char*>(calloc(meta->buffer.length, 1));
+    }
+
+    if (meta->buffer.data == NULL) {
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    if (file_handler->pread(meta->buffer.data,
+                            meta->buffer.length,
+                            meta->file_header.size()) != OLAP_SUCCESS) {
+        free(meta->buffer.data);
+        meta->buffer.data = NULL;
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus MemIndex::_build_key_prefixes(SegmentMetaInfo* meta) const {
+    if (_key_num == 0 || meta->count() == 0 || !is_key_prefix_supported((*_fields)[0].type)) {
+        return OLAP_SUCCESS;
+    }
+
+    void* prefixes = NULL;
+    if (0 != posix_memalign(&prefixes, 64, meta->count() * sizeof(uint64_t))) {
+        OLAP_LOG_WARNING("fail to malloc key prefixes. [count=%lu]", meta->count());
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    meta->key_prefixes = reinterpret_cast<uint64_t*>(prefixes);
+    FieldType type = (*_fields)[0].type;
+    const char* entry = meta->buffer.data;
+    // 索引项中每个字段前有一个字节的NULL标志
+    for (size_t i = 0; i < meta->count(); ++i, entry += entry_length()) {
+        meta->key_prefixes[i] = normalize_key_prefix(type, entry[0] != 0, entry + 1);
+    }
+
+    return OLAP_SUCCESS;
+}
+
+bool MemIndex::_get_key_prefix(const RowCursor& key, uint64_t* prefix) const {
+    if (_key_num == 0 || key.key_column_num() == 0) {
+        return false;
+    }
+
+    const Field* field = key.get_field_by_index(0);
+    if (field == NULL || field->type() != (*_fields)[0].type) {
+        return false;
+    }
+
+    *prefix = normalize_key_prefix(field->type(), field->is_null(), field->buf());
+    return true;
+}
+
 OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per_row_block) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -703,29 +974,14 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
     }
     if (false == null_supported) {
         num_entries = meta.buffer.length / (entry_length() - num_short_key_fields);
-        meta.buffer.data = reinterpret_cast<char*>(
-                calloc(meta.buffer.length + num_entries * num_short_key_fields, 1));
     } else {
         num_entries = meta.buffer.length / entry_length();
-        meta.buffer.data = reinterpret_cast<char*>(calloc(meta.buffer.length, 1));
-    }
-
-    if (meta.buffer.data == NULL) {
-        res = OLAP_ERR_MALLOC_ERROR;
-        OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
-        file_handler.close();
-        return res;
     }
 
     // 读取索引内容
-    // 为了启动加速，此处可使用mmap方式。
-    if (file_handler.pread(meta.buffer.data,
-                           meta.buffer.length,
-                           meta.file_header.size()) != OLAP_SUCCESS) {
-        res = OLAP_ERR_IO_ERROR;
+    if ((res = _read_segment(&file_handler, null_supported, num_entries, &meta)) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
         file_handler.close();
-        free(meta.buffer.data);
         return res;
     }
 
@@ -745,7 +1001,7 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
         OLAP_LOG_WARNING("checksum validation error.");
         OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
         file_handler.close();
-        free(meta.buffer.data);
+        release_segment(&meta);
         return res;
     }
 
@@ -773,6 +1029,14 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
 
     meta.range.first = _num_entries;
     meta.range.last = meta.range.first + num_entries;
+
+    if ((res = _build_key_prefixes(&meta)) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
+        file_handler.close();
+        release_segment(&meta);
+        return res;
+    }
+
     _num_entries = meta.range.last;
     _meta.push_back(meta);
 
@@ -849,6 +1113,18 @@ const OLAPIndexOffset MemIndex::find(const RowCursor& k,
             throw "index of of range";
         }
 
+        // 先用第一个key列的规整前缀缩小范围: 前缀小于key的索引项一定小于key,
+        // 前缀大于key的一定大于key, 只需在前缀相等的区间内做完整的比较
+        uint64_t key_prefix = 0;
+        const uint64_t* prefixes = _meta[off].key_prefixes;
+        if (prefixes != NULL && _get_key_prefix(k, &key_prefix)) {
+            size_t count = _meta[off].count();
+            index_beg = BinarySearchIterator(
+                    search_key_prefix(prefixes, count, key_prefix, false));
+            index_fin = BinarySearchIterator(
+                    search_key_prefix(prefixes, count, key_prefix, true));
+        }
+
         if (!find_last) {
             it = std::lower_bound(index_beg, index_fin, k, index_comparator);
         } else {
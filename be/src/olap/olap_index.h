@@ -153,6 +153,9 @@ struct SegmentMetaInfo {
         range.first = range.last = 0;
         buffer.length = 0;
         buffer.data = NULL;
+        mmap_base = NULL;
+        mmap_length = 0;
+        key_prefixes = NULL;
     }
 
     const size_t count() const {
@@ -162,8 +165,25 @@ struct SegmentMetaInfo {
     IDRange     range;
     Slice       buffer;
     FileHeader<OLAPIndexHeaderMessage, OLAPIndexFixedHeader>  file_header;
+    // 索引文件整个mmap到内存时的起始地址和长度, buffer指向其中的索引项;
+    // 为NULL时buffer是堆上分配的内存
+    char*       mmap_base;
+    size_t      mmap_length;
+    // 每个索引项第一个short key列规整后的64位前缀, 按cache line对齐,
+    // 可以直接比较大小, 为NULL时不使用
+    uint64_t*   key_prefixes;
 };
 
+// 只有定长整数和日期类型的列能够规整为保序的64位前缀
+bool is_key_prefix_supported(FieldType type);
+
+// 把一个字段值规整为无符号64位前缀, 前缀的大小关系和Field::index_cmp一致.
+// 64位的值会丢掉最低位, 因此前缀不等说明值不等, 前缀相等时仍需要完整比较
+uint64_t normalize_key_prefix(FieldType type, bool is_null, const char* value);
+
+// 在有序的前缀数组中查找第一个不小于(upper为true时为大于)value的位置
+size_t search_key_prefix(const uint64_t* prefixes, size_t count, uint64_t value, bool upper);
+
 // In memory index structure, all index hold here
 class MemIndex {
 public:
@@ -321,6 +341,18 @@ public:
     }
 
 private:
+    // 读取索引文件内容到meta.buffer, 新格式的文件使用mmap, 不拷贝到堆内存
+    OLAPStatus _read_segment(FileHandler* file_handler,
+                             bool null_supported,
+                             size_t num_entries,
+                             SegmentMetaInfo* meta);
+
+    // 为segment中每个索引项计算第一个short key列的规整前缀
+    OLAPStatus _build_key_prefixes(SegmentMetaInfo* meta) const;
+
+    // 计算查找key的规整前缀, key的第一列不可用时返回false
+    bool _get_key_prefix(const RowCursor& key, uint64_t* prefix) const;
+
     std::vector<SegmentMetaInfo> _meta;
     size_t _key_length;
     size_t _key_num;
@@ -534,6 +566,10 @@ public:
     // delete all files (*.idx; *.dat)
     void delete_all_files();
 
+    // 将sub_indices的segment按顺序改名为本index的segment, 并合并列统计信息,
+    // 用于拼接并行写入的多个临时index. 改名后的segment不再属于原来的sub index.
+    OLAPStatus stitch_sub_indices(const std::vector<OLAPIndex*>& sub_indices);
+
     // getters and setters.
     // get associated OLAPTable pointer
     OLAPTable* table() const {
@@ -19,6 +19,7 @@
 
 #include "olap/olap_reader.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "runtime/datetime_value.h"
@@ -39,6 +40,7 @@ void OLAPReader::init_profile(RuntimeProfile* profile) {
     ADD_TIMER(profile, "ReadDataTime");
     ADD_TIMER(profile, "ShowHintsTime");
     ADD_COUNTER(profile, "RawRowsRead", TUnit::UNIT);
+    ADD_COUNTER(profile, "BlocksSkippedByIndex", TUnit::UNIT);
 }
 
 Status OLAPShowHints::show_hints(
@@ -200,6 +202,114 @@ Status OLAPReader::next_tuple(Tuple* tuple, int64_t* raw_rows_read, bool* eof) {
     return Status::OK;
 }
 
+Status OLAPReader::next_tuples(Tuple* tuples, int max_tuples, int* num_tuples,
+                               int64_t* raw_rows_read, bool* eof) {
+    *num_tuples = 0;
+    *eof = false;
+
+    if (_block_row_index >= _block->size()) {
+        OLAPStatus res = _reader.next_block(_block.get(), raw_rows_read, eof);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to get next block.[res=%d]", res);
+            return Status("fail to get next block");
+        }
+
+        _block_row_index = 0;
+        if (*eof) {
+            return Status::OK;
+        }
+    }
+
+    int num = std::min(max_tuples, _block->size() - _block_row_index);
+    _convert_block_to_tuples(_block_row_index, num, tuples);
+    _block_row_index += num;
+    *num_tuples = num;
+
+    return Status::OK;
+}
+
+void OLAPReader::_convert_block_to_tuples(int start, int num, Tuple* tuples) {
+    int tuple_size = _tuple_desc.byte_size();
+    // Rows filtered in storage are skipped through the selection vector.
+    const int* selected = _block->selected_in_use() ? _block->selected() : NULL;
+    uint8_t* tuple_buf = reinterpret_cast<uint8_t*>(tuples);
+    for (int row = 0; row < num; ++row) {
+        reinterpret_cast<Tuple*>(tuple_buf + row * tuple_size)->init(tuple_size);
+    }
+
+    size_t slots_size = _query_slots.size();
+    for (int i = 0; i < slots_size; ++i) {
+        const SlotDescriptor* slot_desc = _query_slots[i];
+        const NullIndicatorOffset& null_offset = slot_desc->null_indicator_offset();
+        int slot_offset = slot_desc->tuple_offset();
+
+        ColumnVector* column = _block->column(_return_columns[i]);
+        const bool* is_null = column->no_nulls() ? NULL : column->is_null();
+        const char* data = reinterpret_cast<const char*>(column->col_data());
+        size_t size = _request_columns_size[i];
+        if (TYPE_VARCHAR == slot_desc->type().type || TYPE_HLL == slot_desc->type().type) {
+            size = sizeof(StringValue);
+        } else if (TYPE_DECIMAL == slot_desc->type().type) {
+            size = sizeof(int64_t) + sizeof(int32_t);
+        }
+
+        uint8_t* tuple_ptr = tuple_buf;
+        for (int row = 0; row < num; ++row, tuple_ptr += tuple_size) {
+            int index = NULL != selected ? selected[start + row] : start + row;
+            const char* value = data + index * size;
+            Tuple* tuple = reinterpret_cast<Tuple*>(tuple_ptr);
+            if (NULL != is_null && is_null[index]) {
+                tuple->set_null(null_offset);
+                continue;
+            }
+
+            switch (slot_desc->type().type) {
+            case TYPE_CHAR: {
+                StringValue* slot = tuple->get_string_slot(slot_offset);
+                slot->ptr = const_cast<char*>(value);
+                slot->len = strnlen(slot->ptr, size);
+                break;
+            }
+            case TYPE_VARCHAR:
+            case TYPE_HLL: {
+                *tuple->get_string_slot(slot_offset) = *reinterpret_cast<const StringValue*>(value);
+                break;
+            }
+            case TYPE_DECIMAL: {
+                DecimalValue* slot = tuple->get_decimal_slot(slot_offset);
+                int64_t int_value = *reinterpret_cast<const int64_t*>(value);
+                int32_t frac_value = *reinterpret_cast<const int32_t*>(value + sizeof(int64_t));
+                *slot = DecimalValue(int_value, frac_value);
+                break;
+            }
+            case TYPE_DATETIME: {
+                DateTimeValue* slot = tuple->get_datetime_slot(slot_offset);
+                if (!slot->from_olap_datetime(*reinterpret_cast<const uint64_t*>(value))) {
+                    tuple->set_null(null_offset);
+                }
+                break;
+            }
+            case TYPE_DATE: {
+                DateTimeValue* slot = tuple->get_datetime_slot(slot_offset);
+                uint64_t date_value = *reinterpret_cast<const uint8_t*>(value + 2);
+                date_value <<= 8;
+                date_value |= *reinterpret_cast<const uint8_t*>(value + 1);
+                date_value <<= 8;
+                date_value |= *reinterpret_cast<const uint8_t*>(value);
+                if (!slot->from_olap_date(date_value)) {
+                    tuple->set_null(null_offset);
+                }
+                break;
+            }
+            default: {
+                memory_copy(tuple->get_slot(slot_offset), value, size);
+                break;
+            }
+            }
+        }
+    }
+}
+
 OLAPStatus OLAPReader::_convert_row_to_tuple(Tuple* tuple) {
     RowCursor *row_cursor = NULL;
     if (_aggregation) {
@@ -320,6 +430,7 @@ OLAPStatus OLAPReader::_init_params(TFetchRequest& fetch_request, RuntimeProfile
     reader_params.conjunct_ctxs = _conjunct_ctxs;
     reader_params.profile = profile;
     reader_params.runtime_state = _runtime_state;
+    reader_params.read_by_block = (_runtime_state != NULL);
 
     if (_aggregation) {
         reader_params.return_columns = _return_columns;
@@ -347,6 +458,17 @@ OLAPStatus OLAPReader::_init_params(TFetchRequest& fetch_request, RuntimeProfile
         return res;
     }
 
+    if (_reader.is_read_by_block()) {
+        _block.reset(new (std::nothrow) VectorizedRowBatch(
+                _olap_table->tablet_schema(),
+                config::columnar_scan_batch_size,
+                _runtime_state->instance_mem_tracker()));
+        if (_block == nullptr) {
+            OLAP_LOG_WARNING("fail to malloc vectorized row batch.");
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+    }
+
     for (int i = 0; i < _tuple_desc.slots().size(); ++i) {
         if (!_tuple_desc.slots()[i]->is_materialized()) {
             continue;
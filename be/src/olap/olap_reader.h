@@ -30,6 +30,7 @@
 #include "olap/olap_engine.h"
 #include "util/palo_metrics.h"
 #include "olap/reader.h"
+#include "runtime/vectorized_row_batch.h"
 
 namespace palo {
 
@@ -55,7 +56,8 @@ public:
             _get_tablet_timer(nullptr),
             _init_reader_timer(nullptr),
             _read_data_timer(nullptr),
-            _runtime_state(nullptr) {}
+            _runtime_state(nullptr),
+            _block_row_index(0) {}
 
     OLAPReader(const TupleDescriptor &tuple_desc, RuntimeState* runtime_state) :
             _tuple_desc(tuple_desc),
@@ -66,7 +68,8 @@ public:
             _get_tablet_timer(nullptr),
             _init_reader_timer(nullptr),
             _read_data_timer(nullptr),
-            _runtime_state(runtime_state) {}
+            _runtime_state(runtime_state),
+            _block_row_index(0) {}
 
     ~OLAPReader() {
         close();
@@ -79,6 +82,18 @@ public:
     Status close();
 
     Status next_tuple(Tuple *tuple, int64_t* raw_rows_read, bool* eof);
+
+    // Whether rows should be fetched by next_tuples instead of next_tuple.
+    bool is_read_by_block() const {
+        return _reader.is_read_by_block();
+    }
+
+    // Fill at most max_tuples continuous tuples starting from tuples. Rows are read
+    // from storage column by column and converted to tuples one slot at a time.
+    // String slots point to memory owned by this reader, which is valid until
+    // the next call.
+    Status next_tuples(Tuple* tuples, int max_tuples, int* num_tuples,
+                       int64_t* raw_rows_read, bool* eof);
     
 private: 
     OLAPStatus _init_params(TFetchRequest& fetch_request, RuntimeProfile* profile);
@@ -87,6 +102,8 @@ private:
 
     OLAPStatus _convert_row_to_tuple(Tuple* tuple);
 
+    void _convert_block_to_tuples(int start, int num, Tuple* tuples);
+
     Reader _reader;
 
     const TupleDescriptor &_tuple_desc;
@@ -117,6 +134,10 @@ private:
     OlapStopWatch _read_data_watch;
     RuntimeProfile::Counter* _read_data_timer;
     RuntimeState* _runtime_state;
+
+    // Column batch used when _reader is read by block.
+    std::unique_ptr<VectorizedRowBatch> _block;
+    int _block_row_index;
 };
 
 }  // namespace palo
@@ -157,14 +157,12 @@ void* OLAPServer::_be_thread_callback(void* arg) {
         interval = 1;
     }
 
-    string last_be_fs;
-    TTabletId last_be_tablet_id = -1;
     while (true) {
         // must be here, because this thread is start on start and
         // cgroup is not initialized at this time
         // add tid to cgroup
         CgroupsMgr::apply_system_cgroup();
-        OLAPEngine::get_instance()->start_base_expansion(&last_be_fs, &last_be_tablet_id);
+        OLAPEngine::get_instance()->start_base_expansion();
 
         usleep(interval * 1000000);
     }
@@ -98,7 +98,9 @@ OLAPTable::OLAPTable(OLAPHeader* header) :
         _num_null_fields(0),
         _num_key_fields(0),
         _id(0),
-        _is_loaded(false) {
+        _is_loaded(false),
+        _query_scan_rows(0),
+        _query_merged_rows(0) {
     if (header == NULL) {
         return;  // for convenience of mock test.
     }
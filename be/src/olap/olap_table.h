@@ -20,6 +20,7 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_OLAP_TABLE_H
 #define BDG_PALO_BE_SRC_OLAP_OLAP_TABLE_H
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <set>
@@ -610,6 +611,26 @@ public:
         return _is_dropped;
     }
 
+    // 查询结束时记录读取的行数和聚合掉的行数, 用于评估合并的优先级
+    void add_query_merged_rows(uint64_t scan_rows, uint64_t merged_rows) {
+        _query_scan_rows += scan_rows;
+        _query_merged_rows += merged_rows;
+    }
+
+    // 返回最近的查询平均每返回一行需要聚合掉的行数, 并将历史统计减半,
+    // 使合并之后的查询尽快体现出来
+    double decay_read_amplification() {
+        uint64_t scan_rows = _query_scan_rows;
+        uint64_t merged_rows = _query_merged_rows;
+        _query_scan_rows -= scan_rows / 2;
+        _query_merged_rows -= merged_rows / 2;
+        if (scan_rows <= merged_rows) {
+            return 0;
+        }
+
+        return static_cast<double>(merged_rows) / (scan_rows - merged_rows);
+    }
+
 private:
     // used for hash-struct of hash_map<Version, OLAPIndex*>.
     struct HashOfVersion {
@@ -680,6 +701,8 @@ private:
     std::string _storage_root_path;
     volatile bool _is_loaded;
     MutexLock _load_lock;
+    std::atomic<uint64_t> _query_scan_rows;
+    std::atomic<uint64_t> _query_merged_rows;
 
     DISALLOW_COPY_AND_ASSIGN(OLAPTable);
 };
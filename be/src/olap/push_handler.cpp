@@ -23,11 +23,16 @@
 #include <iostream>
 #include <sstream>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
+#include "common/config.h"
 #include "olap/olap_engine.h"
 #include "olap/olap_table.h"
+#include "olap/row_block.h"
 #include "olap/schema_change.h"
+#include "util/count_down_latch.hpp"
+#include "util/thread_pool.hpp"
 
 using std::list;
 using std::map;
@@ -326,10 +331,8 @@ OLAPStatus PushHandler::_convert(
         Indices* new_olap_indices,
         AlterTabletType alter_table_type) {
     OLAPStatus res = OLAP_SUCCESS;
-    RowCursor row;
     BinaryFile raw_file;
     IBinaryReader* reader = NULL;
-    IWriter* writer = NULL;
     OLAPIndex* delta_index = NULL;
     uint32_t  num_rows = 0;
 
@@ -392,32 +395,92 @@ OLAPStatus PushHandler::_convert(
         }
         curr_olap_indices->push_back(delta_index);
 
-        // 3. New Writer to write data into OLAPIndex
+        // 3. Read data from raw file and write into OLAPIndex of curr_olap_table,
+        //    files larger than one segment are split into chunks and written in parallel.
+        if (NULL != reader
+                && NULL != OLAPEngine::get_instance()->push_convert_thread_pool()
+                && config::push_convert_chunk_num_per_push > 1
+                && raw_file.file_length() > curr_olap_table->segment_size()) {
+            res = _parallel_convert(curr_olap_table, reader, delta_index,
+                                    curr_olap_table->segment_size(), &num_rows);
+        } else {
+            res = _serial_convert(curr_olap_table, reader, delta_index, &num_rows);
+        }
+
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to convert pushed file. [res=%d table='%s' read_rows=%u]",
+                             res, curr_olap_table->full_name().c_str(), num_rows);
+            break;
+        }
+
+        OLAP_LOG_DEBUG("load the index.");
+
+        if (OLAP_SUCCESS != (res = delta_index->load())) {
+            OLAP_LOG_WARNING("fail to load index. [res=%d table='%s' version=%ld]",
+                             res, curr_olap_table->full_name().c_str(), _request.version);
+            break;
+        }
+
+        // 4. Convert data for schema change tables
+        OLAP_LOG_TRACE("load to related tables of schema_change if possible. ");
+        if (NULL != new_olap_table.get()) {
+            SchemaChangeHandler schema_change;
+            res = schema_change.schema_version_convert(
+                    curr_olap_table,
+                    new_olap_table,
+                    curr_olap_indices,
+                    new_olap_indices);
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("failed to change schema version for delta."
+                                 "[res=%d new_table='%s']",
+                                 res, new_olap_table->full_name().c_str());
+            }
+
+        }
+    } while (0);
+
+    SAFE_DELETE(reader);
+    OLAP_LOG_NOTICE_PUSH("processed_rows", "%d", num_rows);
+    OLAP_LOG_TRACE("convert delta file end. [table='%s' res=%d]",
+                   curr_olap_table->full_name().c_str(), res);
+
+    return res;
+}
+
+OLAPStatus PushHandler::_serial_convert(
+        SmartOLAPTable olap_table,
+        IBinaryReader* reader,
+        OLAPIndex* delta_index,
+        uint32_t* num_rows) {
+    OLAPStatus res = OLAP_SUCCESS;
+    RowCursor row;
+    IWriter* writer = NULL;
+
+    do {
         OLAP_LOG_DEBUG("init writer. [table='%s' block_row_size=%lu]",
-                       curr_olap_table->full_name().c_str(),
-                       curr_olap_table->num_rows_per_row_block());
+                       olap_table->full_name().c_str(),
+                       olap_table->num_rows_per_row_block());
 
-        if (NULL == (writer = IWriter::create(curr_olap_table, delta_index, true))) {
+        if (NULL == (writer = IWriter::create(olap_table, delta_index, true))) {
             OLAP_LOG_WARNING("fail to create writer. [table='%s']",
-                             curr_olap_table->full_name().c_str());
+                             olap_table->full_name().c_str());
             res = OLAP_ERR_MALLOC_ERROR;
             break;
         } else if (OLAP_SUCCESS != (res = writer->init())) {
             OLAP_LOG_WARNING(
                     "fail to init writer. [res=%d table='%s' version=%u version_hash=%lu]",
-                    res, curr_olap_table->full_name().c_str(),
+                    res, olap_table->full_name().c_str(),
                     _request.version, _request.version_hash);
             break;
         }
 
-        // 4. Init RowCursor
-        if (OLAP_SUCCESS != (res = row.init(curr_olap_table->tablet_schema()))) {
+        if (OLAP_SUCCESS != (res = row.init(olap_table->tablet_schema()))) {
             OLAP_LOG_WARNING("fail to init rowcursor. [res=%d]", res);
             break;
         }
 
-        // 5. Read data from raw file and write into OLAPIndex of curr_olap_table
-        if (_request.__isset.http_file_path) {
+        // in case of empty push and delete data, there is no reader
+        if (NULL != reader) {
             // Convert from raw to delta
             OLAP_LOG_DEBUG("start to convert row file to delta.");
 
@@ -425,18 +488,18 @@ OLAPStatus PushHandler::_convert(
                 if (OLAP_SUCCESS != (res = writer->attached_by(&row))) {
                     OLAP_LOG_WARNING(
                             "fail to attach row to writer. [res=%d table='%s' read_rows=%u]",
-                            res, curr_olap_table->full_name().c_str(), num_rows);
+                            res, olap_table->full_name().c_str(), *num_rows);
                     break;
                 }
 
                 res = reader->next(&row);
                 if (OLAP_SUCCESS != res) {
                     OLAP_LOG_WARNING("read next row failed. [res=%d read_rows=%u]",
-                                     res, num_rows);
+                                     res, *num_rows);
                     break;
                 } else {
                     writer->next(row);
-                    num_rows++;
+                    (*num_rows)++;
                 }
             }
 
@@ -453,42 +516,243 @@ OLAPStatus PushHandler::_convert(
             OLAP_LOG_WARNING("fail to finalize writer. [res=%d]", res);
             break;
         }
+    } while (0);
 
-        OLAP_LOG_DEBUG("load the index.");
+    SAFE_DELETE(writer);
+    return res;
+}
 
-        if (OLAP_SUCCESS != (res = delta_index->load())) {
-            OLAP_LOG_WARNING("fail to load index. [res=%d table='%s' version=%ld]",
-                             res, curr_olap_table->full_name().c_str(), _request.version);
+struct PushHandler::ConvertChunk {
+    ConvertChunk() : index(NULL), num_bytes(0), last_block_rows(0),
+            res(OLAP_SUCCESS), latch(1) {}
+
+    OLAPIndex* index;
+    // all blocks are full except the last one, which holds last_block_rows rows
+    std::vector<RowBlock*> row_blocks;
+    size_t num_bytes;
+    uint32_t last_block_rows;
+    OLAPStatus res;
+    CountDownLatch latch;
+};
+
+OLAPStatus PushHandler::_parallel_convert(
+        SmartOLAPTable olap_table,
+        IBinaryReader* reader,
+        OLAPIndex* delta_index,
+        size_t chunk_bytes,
+        uint32_t* num_rows) {
+    OLAPStatus res = OLAP_SUCCESS;
+    ThreadPool* thread_pool = OLAPEngine::get_instance()->push_convert_thread_pool();
+    size_t max_running_chunks = config::push_convert_chunk_num_per_push;
+    vector<ConvertChunk*> chunks;
+    // chunks before num_submitted have been handed to writing threads,
+    // and chunks before num_finished have been written.
+    size_t num_submitted = 0;
+    size_t num_finished = 0;
+    ConvertChunk* chunk = NULL;
+    RowBlock* row_block = NULL;
+    RowCursor row;
+
+    OLAP_LOG_INFO("start to convert pushed file in parallel. [table='%s' max_running_chunks=%lu]",
+                  olap_table->full_name().c_str(), max_running_chunks);
+
+    if (OLAP_SUCCESS != (res = row.init(olap_table->tablet_schema()))) {
+        OLAP_LOG_WARNING("fail to init rowcursor. [res=%d]", res);
+        return res;
+    }
+
+    while (!reader->eof()) {
+        if (NULL == chunk) {
+            // Wait for the oldest chunk to bound rows buffered in memory.
+            if (num_submitted - num_finished >= max_running_chunks) {
+                chunks[num_finished]->latch.await();
+                if (OLAP_SUCCESS != (res = chunks[num_finished]->res)) {
+                    break;
+                }
+                ++num_finished;
+            }
+
+            if (NULL == (chunk = new(std::nothrow) ConvertChunk())) {
+                OLAP_LOG_WARNING("fail to malloc convert chunk. [size=%ld]",
+                                 sizeof(ConvertChunk));
+                res = OLAP_ERR_MALLOC_ERROR;
+                break;
+            }
+            chunks.push_back(chunk);
+
+            // Each chunk is written into a temporary index distinguished by version_hash.
+            chunk->index = new(std::nothrow) OLAPIndex(olap_table.get(),
+                                                       delta_index->version(),
+                                                       delta_index->version_hash() + chunks.size(),
+                                                       delta_index->delete_flag(),
+                                                       0, 0);
+            if (NULL == chunk->index) {
+                OLAP_LOG_WARNING("fail to malloc OLAPIndex. [table='%s' size=%ld]",
+                                 olap_table->full_name().c_str(), sizeof(OLAPIndex));
+                res = OLAP_ERR_MALLOC_ERROR;
+                break;
+            }
+        }
+
+        if (NULL == row_block) {
+            if (NULL == (row_block = new(std::nothrow) RowBlock(olap_table->tablet_schema()))) {
+                OLAP_LOG_WARNING("fail to malloc RowBlock. [size=%ld]", sizeof(RowBlock));
+                res = OLAP_ERR_MALLOC_ERROR;
+                break;
+            }
+            chunk->row_blocks.push_back(row_block);
+
+            RowBlockInfo block_info(0U, olap_table->num_rows_per_row_block(), 0);
+            block_info.data_file_type = COLUMN_ORIENTED_FILE;
+            block_info.null_supported = true;
+            if (OLAP_SUCCESS != (res = row_block->init(block_info))) {
+                OLAP_LOG_WARNING("fail to init row block. [res=%d]", res);
+                break;
+            }
+            chunk->num_bytes += row_block->buf_len();
+            chunk->last_block_rows = 0;
+        }
+
+        if (OLAP_SUCCESS != (res = row_block->get_row_to_write(chunk->last_block_rows, &row))) {
+            OLAP_LOG_WARNING("fail to attach row to row block. [res=%d read_rows=%u]",
+                             res, *num_rows);
             break;
         }
 
-        // 7. Convert data for schema change tables
-        OLAP_LOG_TRACE("load to related tables of schema_change if possible. ");
-        if (NULL != new_olap_table.get()) {
-            SchemaChangeHandler schema_change;
-            res = schema_change.schema_version_convert(
-                    curr_olap_table,
-                    new_olap_table,
-                    curr_olap_indices,
-                    new_olap_indices);
-            if (res != OLAP_SUCCESS) {
-                OLAP_LOG_WARNING("failed to change schema version for delta."
-                                 "[res=%d new_table='%s']",
-                                 res, new_olap_table->full_name().c_str());
+        if (OLAP_SUCCESS != (res = reader->next(&row))) {
+            OLAP_LOG_WARNING("read next row failed. [res=%d read_rows=%u]", res, *num_rows);
+            break;
+        }
+        ++chunk->last_block_rows;
+        (*num_rows)++;
+
+        if (chunk->last_block_rows < row_block->row_block_info().row_num) {
+            continue;
+        }
+        row_block = NULL;
+
+        // Hand chunk of about chunk_bytes to thread pool, run in current thread
+        // when the thread pool has been shut down.
+        if (chunk->num_bytes >= chunk_bytes) {
+            if (!thread_pool->offer(boost::bind(&PushHandler::_convert_chunk, olap_table, chunk))) {
+                _convert_chunk(olap_table, chunk);
             }
+            ++num_submitted;
+            chunk = NULL;
+        }
+    }
+
+    if (OLAP_SUCCESS == res && NULL != chunk) {
+        _convert_chunk(olap_table, chunk);
+        ++num_submitted;
+    }
 
+    if (OLAP_SUCCESS == res) {
+        reader->finalize();
+        if (false == reader->validate_checksum()) {
+            OLAP_LOG_WARNING("pushed delta file has wrong checksum.");
+            res = OLAP_ERR_PUSH_BUILD_DELTA_ERROR;
         }
-    } while (0);
+    }
 
-    SAFE_DELETE(reader);
-    SAFE_DELETE(writer);
-    OLAP_LOG_NOTICE_PUSH("processed_rows", "%d", num_rows);
-    OLAP_LOG_TRACE("convert delta file end. [table='%s' res=%d]",
-                   curr_olap_table->full_name().c_str(), res);
+    // Wait for all submitted chunks, even in case of failure, since they hold the chunks.
+    for (size_t i = num_finished; i < num_submitted; ++i) {
+        chunks[i]->latch.await();
+        if (OLAP_SUCCESS == res && OLAP_SUCCESS != chunks[i]->res) {
+            OLAP_LOG_WARNING("fail to write chunk of pushed file. [res=%d table='%s' chunk=%lu]",
+                             chunks[i]->res, olap_table->full_name().c_str(), i);
+            res = chunks[i]->res;
+        }
+    }
 
+    if (OLAP_SUCCESS == res) {
+        vector<OLAPIndex*> sub_indices;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            sub_indices.push_back(chunks[i]->index);
+        }
+        res = delta_index->stitch_sub_indices(sub_indices);
+    }
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        // segments stitched into delta_index have been removed from the sub index,
+        // only files left by failure are deleted here
+        if (NULL != chunks[i]->index) {
+            chunks[i]->index->delete_all_files();
+        }
+        for (size_t j = 0; j < chunks[i]->row_blocks.size(); ++j) {
+            SAFE_DELETE(chunks[i]->row_blocks[j]);
+        }
+        SAFE_DELETE(chunks[i]->index);
+        SAFE_DELETE(chunks[i]);
+    }
+
+    OLAP_LOG_INFO("finish converting pushed file in parallel. [res=%d table='%s' chunks=%lu]",
+                  res, olap_table->full_name().c_str(), chunks.size());
     return res;
 }
 
+void PushHandler::_convert_chunk(SmartOLAPTable olap_table, ConvertChunk* chunk) {
+    OLAPStatus res = OLAP_SUCCESS;
+    IWriter* writer = NULL;
+    RowCursor row;
+    RowCursor read_row;
+
+    do {
+        if (NULL == (writer = IWriter::create(olap_table, chunk->index, true))) {
+            OLAP_LOG_WARNING("fail to create writer. [table='%s']",
+                             olap_table->full_name().c_str());
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        } else if (OLAP_SUCCESS != (res = writer->init())) {
+            OLAP_LOG_WARNING("fail to init writer. [res=%d table='%s']",
+                             res, olap_table->full_name().c_str());
+            break;
+        }
+
+        if (OLAP_SUCCESS != (res = row.init(olap_table->tablet_schema()))
+                || OLAP_SUCCESS != (res = read_row.init(olap_table->tablet_schema()))) {
+            OLAP_LOG_WARNING("fail to init rowcursor. [res=%d]", res);
+            break;
+        }
+
+        for (size_t i = 0; OLAP_SUCCESS == res && i < chunk->row_blocks.size(); ++i) {
+            RowBlock* row_block = chunk->row_blocks[i];
+            uint32_t block_rows = (i + 1 == chunk->row_blocks.size())
+                                  ? chunk->last_block_rows : row_block->row_block_info().row_num;
+            for (uint32_t j = 0; j < block_rows; ++j) {
+                if (OLAP_SUCCESS != (res = row_block->get_row_to_read(j, &read_row))) {
+                    OLAP_LOG_WARNING("fail to read row from row block. [res=%d]", res);
+                    break;
+                }
+
+                if (OLAP_SUCCESS != (res = writer->attached_by(&row))) {
+                    OLAP_LOG_WARNING("fail to attach row to writer. [res=%d table='%s']",
+                                     res, olap_table->full_name().c_str());
+                    break;
+                }
+                row.copy(read_row);
+                writer->next(row);
+            }
+
+            // release memory of rows as soon as they are written
+            SAFE_DELETE(chunk->row_blocks[i]);
+        }
+
+        if (OLAP_SUCCESS != res) {
+            break;
+        }
+
+        if (OLAP_SUCCESS != (res = writer->finalize())) {
+            OLAP_LOG_WARNING("fail to finalize writer. [res=%d]", res);
+            break;
+        }
+    } while (0);
+
+    SAFE_DELETE(writer);
+    chunk->res = res;
+    chunk->latch.count_down();
+}
+
 OLAPStatus PushHandler::_validate_request(
         SmartOLAPTable olap_table_for_raw,
         SmartOLAPTable olap_table_for_schema_change,
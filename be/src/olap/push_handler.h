@@ -40,6 +40,7 @@ typedef std::vector<OLAPIndex*> Indices;
 
 class BinaryFile;
 class BinaryReader;
+class IBinaryReader;
 class ColumnMapping;
 class RowCursor;
 
@@ -90,6 +91,30 @@ private:
             Indices* new_olap_indices,
             AlterTabletType alter_table_type);
 
+    // Rows of a pushed file buffered in memory and written to a temporary OLAPIndex
+    // by one thread of push convert thread pool.
+    struct ConvertChunk;
+
+    // Write rows of the pushed file by one thread, used when file is small or
+    // push convert thread pool is disabled.
+    OLAPStatus _serial_convert(
+            SmartOLAPTable olap_table,
+            IBinaryReader* reader,
+            OLAPIndex* delta_index,
+            uint32_t* num_rows);
+
+    // Split rows of the pushed file into chunks of about chunk_bytes, which is one
+    // segment when pushing, and write them in parallel, then stitch the segments
+    // into delta_index by order of chunks.
+    OLAPStatus _parallel_convert(
+            SmartOLAPTable olap_table,
+            IBinaryReader* reader,
+            OLAPIndex* delta_index,
+            size_t chunk_bytes,
+            uint32_t* num_rows);
+
+    static void _convert_chunk(SmartOLAPTable olap_table, ConvertChunk* chunk);
+
     // Update header info when new version add or dirty version removed.
     OLAPStatus _update_header(
             SmartOLAPTable olap_table,
@@ -160,6 +185,8 @@ private:
     // lock tablet header before modify tabelt header
     bool _header_locked;
 
+    friend class TestPushHandler;
+
     DISALLOW_COPY_AND_ASSIGN(PushHandler);
 };
 
@@ -23,6 +23,7 @@
 #include "olap/olap_table.h"
 #include "olap/row_block.h"
 #include "olap/row_cursor.h"
+#include "runtime/vectorized_row_batch.h"
 
 using std::nothrow;
 using std::set;
@@ -36,8 +37,9 @@ Reader::MergeSet::~MergeSet() {
 
 OLAPStatus Reader::MergeSet::init(Reader* reader, bool reverse) {
     _reader = reader;
+    _comparator = RowCursorComparator(reverse);
 
-    _heap = new (nothrow) heap_t(RowCursorComparator(reverse));
+    _heap = new (nothrow) heap_t(_comparator);
     if (_heap == NULL) {
         OLAP_LOG_FATAL("failed to malloc. [size=%ld]", sizeof(heap_t));
         return OLAP_ERR_MALLOC_ERROR;
@@ -47,39 +49,21 @@ OLAPStatus Reader::MergeSet::init(Reader* reader, bool reverse) {
 }
 
 bool Reader::MergeSet::attach(const MergeElement& merge_element, const RowCursor* row) {
-    // Use data file's end_version as data's version
-    int32_t data_version = merge_element->version().second;
-    do {
-        if (row == NULL) {
-            if (!merge_element->eof()) {
-                // Return error if merge_element isn't reach end, but row equal NULL.
-                OLAP_LOG_WARNING("internal error with IData.");
-                return false;
-            } else {
-                _reader->_filted_rows += merge_element->get_filted_rows();
-            }
-        } else {
-            _reader->_scan_rows++;
-            if (merge_element->data_file_type() == OLAP_DATA_FILE) {
-                if (_reader->_delete_handler.is_filter_data(data_version, *row)) {
-                    _reader->_filted_rows++;
-                    row = merge_element->get_next_row();
-                    continue;
-                }
-            }
-            _heap->push(merge_element);
-        }
+    if (!_skip_deleted_rows(merge_element, &row)) {
+        return false;
+    }
 
-        break;
-    } while (true);
+    if (row != NULL) {
+        _push(merge_element);
+    }
 
     return true;
 }
 
 const RowCursor* Reader::MergeSet::curr(bool* delete_flag) {
-    if (_heap->size() > 0) {
-        *delete_flag = _heap->top()->delete_flag();
-        return _heap->top()->get_current_row();
+    if (_top != NULL) {
+        *delete_flag = _top->delete_flag();
+        return _top->get_current_row();
     } else {
         return NULL;
     }
@@ -95,27 +79,75 @@ bool Reader::MergeSet::next(const RowCursor** element, bool* delete_flag) {
 }
 
 bool Reader::MergeSet::_pop_from_heap() {
-    MergeElement merge_element = _heap->top();
+    MergeElement merge_element = _top;
     const RowCursor* row = merge_element->get_next_row();
+    if (!_skip_deleted_rows(merge_element, &row)) {
+        return false;
+    }
+
+    if (row != NULL) {
+        // when Reader is used for fetch,
+        // Reader will read deltas one by one without merge sort in DUP_KEYS keys type,
+        // so we don't need to adjust the _heap.
+        if (_reader->_reader_type == READER_FETCH
+                && _reader->_olap_table->keys_type() == KeysType::DUP_KEYS) {
+            return true;
+        }
+
+        // Still the smallest one, keep reading this data version
+        // without touching the heap.
+        if (_heap->empty() || !_comparator(merge_element, _heap->top())) {
+            return true;
+        }
+
+        _heap->push(merge_element);
+    }
+
+    if (_heap->empty()) {
+        _top = NULL;
+    } else {
+        _top = _heap->top();
+        _heap->pop();
+    }
+
+    return true;
+}
 
-    // when Reader is used for fetch,
-    // Reader will read deltas one by one without merge sort in DUP_KEYS keys type,
-    // so we don't need to use pop and attach to adjust the _heap.
-    if (_reader->_reader_type == READER_FETCH
-            && _reader->_olap_table->keys_type() == KeysType::DUP_KEYS && row != NULL) {
+bool Reader::MergeSet::_skip_deleted_rows(
+        const MergeElement& merge_element,
+        const RowCursor** row) {
+    // Use data file's end_version as data's version
+    int32_t data_version = merge_element->version().second;
+    while (*row != NULL) {
         _reader->_scan_rows++;
-        if (merge_element->data_file_type() == OLAP_DATA_FILE) {
-            int32_t data_version = merge_element->version().second;
-            if (_reader->_delete_handler.is_filter_data(data_version, *row)) {
-                _reader->_filted_rows++;
-                return _pop_from_heap();
-            }
+        if (merge_element->data_file_type() != OLAP_DATA_FILE
+                || !_reader->_delete_handler.is_filter_data(data_version, **row)) {
+            return true;
         }
-        return true;
+
+        _reader->_filted_rows++;
+        *row = merge_element->get_next_row();
+    }
+
+    if (!merge_element->eof()) {
+        // Return error if merge_element isn't reach end, but row equal NULL.
+        OLAP_LOG_WARNING("internal error with IData.");
+        return false;
     }
 
-    _heap->pop();
-    return attach(merge_element, row);
+    _reader->_filted_rows += merge_element->get_filted_rows();
+    return true;
+}
+
+void Reader::MergeSet::_push(const MergeElement& merge_element) {
+    if (_top == NULL) {
+        _top = merge_element;
+    } else if (_comparator(_top, merge_element)) {
+        _heap->push(_top);
+        _top = merge_element;
+    } else {
+        _heap->push(merge_element);
+    }
 }
 
 bool Reader::MergeSet::clear() {
@@ -124,6 +156,7 @@ bool Reader::MergeSet::clear() {
             _heap->pop();
         }
     }
+    _top = NULL;
     return true;
 }
 
@@ -161,16 +194,21 @@ OLAPStatus Reader::init(const ReaderParams& read_params) {
         return res;
     }
 
-    bool eof = false;
-    if (OLAP_SUCCESS != (res = _attach_data_to_merge_set(true, &eof))) {
-        OLAP_LOG_WARNING("failed to attaching data to merge set. [res=%d]", res);
-        return res;
-    }
-
+    // Set profile before data sources are attached, so that blocks picked
+    // while seeking the first key are counted too.
     for (auto i_data: _data_sources) {
         i_data->set_profile(read_params.profile);
     }
 
+    _read_by_block = _can_read_by_block(read_params);
+    if (!_read_by_block) {
+        bool eof = false;
+        if (OLAP_SUCCESS != (res = _attach_data_to_merge_set(true, &eof))) {
+            OLAP_LOG_WARNING("failed to attaching data to merge set. [res=%d]", res);
+            return res;
+        }
+    }
+
     _is_inited = true;
     return OLAP_SUCCESS;
 }
@@ -260,11 +298,65 @@ OLAPStatus Reader::next_row_with_aggregation(
     return res;
 }
 
+OLAPStatus Reader::next_block(VectorizedRowBatch* batch, int64_t* raw_rows_read, bool* eof) {
+    OLAPStatus res = OLAP_SUCCESS;
+    *eof = false;
+
+    // DUP_KEYS data versions need not to be merged, so read them one by one.
+    while (_current_data_source < _data_sources.size()) {
+        IData* data = _data_sources[_current_data_source];
+        if (!_data_source_started) {
+            _data_source_started = true;
+            if (data->empty()) {
+                ++_current_data_source;
+                _data_source_started = false;
+                continue;
+            }
+
+            int ret = data->delete_pruning_filter();
+            if (DEL_SATISFIED == ret) {
+                _filted_rows += data->num_rows();
+                ++_current_data_source;
+                _data_source_started = false;
+                continue;
+            }
+            data->set_delete_status(DEL_NOT_SATISFIED);
+
+            res = data->get_first_block(batch);
+        } else {
+            res = data->get_next_block(batch);
+        }
+
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read block. [res=%d version=%d-%d]",
+                             res, data->version().first, data->version().second);
+            return res;
+        }
+
+        if (batch->size() > 0) {
+            *raw_rows_read += batch->size();
+            _scan_rows += batch->size();
+            return OLAP_SUCCESS;
+        }
+
+        _filted_rows += data->get_filted_rows();
+        ++_current_data_source;
+        _data_source_started = false;
+    }
+
+    *eof = true;
+    return res;
+}
+
 void Reader::close() {
     OLAP_LOG_DEBUG("scan rows:%lu, filted rows:%lu, merged rows:%lu",
                    _scan_rows, _filted_rows, _merged_rows);
     _conditions.finalize();
     _delete_handler.finalize();
+    if (_reader_type == READER_FETCH && _olap_table.get() != NULL) {
+        _olap_table->add_query_merged_rows(_scan_rows, _merged_rows);
+    }
+
     if (!_is_set_data_sources) {
         _olap_table->release_data_sources(&_data_sources);
     }
@@ -326,15 +418,15 @@ OLAPStatus Reader::_init_params(const ReaderParams& read_params) {
         return res;
     }
 
-    res = _init_load_bf_columns(read_params);
+    res = _init_delete_condition(read_params);
     if (res != OLAP_SUCCESS) {
-        OLAP_LOG_WARNING("fail to init load bloom filter columns. [res=%d]", res);
+        OLAP_LOG_WARNING("fail to init delete param. [res=%d]", res);
         return res;
     }
 
-    res = _init_delete_condition(read_params);
+    res = _init_load_bf_columns(read_params);
     if (res != OLAP_SUCCESS) {
-        OLAP_LOG_WARNING("fail to init delete param. [res=%d]", res);
+        OLAP_LOG_WARNING("fail to init load bloom filter columns. [res=%d]", res);
         return res;
     }
 
@@ -548,11 +640,33 @@ OLAPStatus Reader::_attach_data_to_merge_set(bool first, bool *eof) {
     return res;
 }
 
+bool Reader::_can_read_by_block(const ReaderParams& read_params) {
+    return read_params.read_by_block
+            && config::enable_columnar_scan
+            && read_params.reader_type == READER_FETCH
+            && _olap_table->keys_type() == KeysType::DUP_KEYS
+            && _olap_table->data_file_type() == COLUMN_ORIENTED_FILE
+            && _keys_param.start_keys.empty()
+            && _delete_handler.conditions_num() == 0;
+}
+
 OLAPStatus Reader::_init_keys_param(const ReaderParams& read_params) {
     OLAPStatus res = OLAP_SUCCESS;
 
     _current_key_index = 0;
 
+    if (!read_params.start_key_cursors.empty()) {
+        _keys_param.range = read_params.range;
+        _keys_param.end_range = read_params.end_range;
+
+        res = _copy_key_cursors(read_params.start_key_cursors, &_keys_param.start_keys);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+
+        return _copy_key_cursors(read_params.end_key_cursors, &_keys_param.end_keys);
+    }
+
     if (read_params.start_key.size() == 0) {
         return OLAP_SUCCESS;
     }
@@ -620,6 +734,32 @@ OLAPStatus Reader::_init_keys_param(const ReaderParams& read_params) {
     return OLAP_SUCCESS;
 }
 
+OLAPStatus Reader::_copy_key_cursors(const vector<const RowCursor*>& keys,
+                                     vector<RowCursor*>* copies) {
+    OLAPStatus res = OLAP_SUCCESS;
+    copies->resize(keys.size(), NULL);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (((*copies)[i] = new(nothrow) RowCursor()) == NULL) {
+            OLAP_LOG_WARNING("fail to new RowCursor!");
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        res = (*copies)[i]->init(_olap_table->tablet_schema(), keys[i]->field_count());
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to init row cursor. [res=%d]", res);
+            return res;
+        }
+
+        res = (*copies)[i]->copy(*keys[i]);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to copy key cursor. [res=%d key_index=%ld]", res, i);
+            return res;
+        }
+    }
+
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus Reader::_init_conditions_param(const ReaderParams& read_params) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -645,6 +785,18 @@ OLAPStatus Reader::_init_load_bf_columns(const ReaderParams& read_params) {
         }
     }
 
+    // columns of delete conditions, so that blocks can be pruned by their bloom filters
+    for (const auto& del_cond : _delete_handler.get_delete_conditions()) {
+        for (const auto& cond_column : del_cond.del_cond->columns()) {
+            for (const Cond& cond : cond_column.second.conds()) {
+                if (cond.op == OP_EQ
+                        || (cond.op == OP_IN && cond.operand_set.size() < MAX_OP_IN_FIELD_NUM)) {
+                    _load_bf_columns.insert(cond_column.first);
+                }
+            }
+        }
+    }
+
     // remove columns which have no bf stream
     for (int i = 0; i < _olap_table->tablet_schema().size(); ++i) {
         if (!_olap_table->tablet_schema()[i].is_bf_column) {
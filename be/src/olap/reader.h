@@ -43,6 +43,7 @@ namespace palo {
 class OLAPTable;
 class RowCursor;
 class RowBlock;
+class VectorizedRowBatch;
 
 // Params for Reader,
 // mainly include tablet, data version and fetch range.
@@ -55,6 +56,11 @@ struct ReaderParams {
     std::string end_range;
     std::vector<TFetchStartKey> start_key;
     std::vector<TFetchEndKey> end_key;
+    // Keys given as row cursors are used instead of start_key and end_key when
+    // they are set, keys taken from the short key index such as NULL or the min
+    // value can not always be restored from strings. Reader copies them.
+    std::vector<const RowCursor*> start_key_cursors;
+    std::vector<const RowCursor*> end_key_cursors;
     std::vector<TCondition> conditions;
     std::vector<ExprContext*>* conjunct_ctxs;
     // The IData will be set when using Merger, eg Cumulative, BE.
@@ -62,13 +68,17 @@ struct ReaderParams {
     std::vector<uint32_t> return_columns;
     RuntimeProfile* profile;
     RuntimeState* runtime_state;
+    // Caller is able to consume data by Reader::next_block.
+    // Reader decides whether to use it, see Reader::is_read_by_block.
+    bool read_by_block;
 
     ReaderParams() :
             reader_type(READER_FETCH),
             aggregation(true),
             conjunct_ctxs(NULL),
             profile(NULL),
-            runtime_state(NULL) {
+            runtime_state(NULL),
+            read_by_block(false) {
         start_key.clear();
         end_key.clear();
         conditions.clear();
@@ -83,7 +93,8 @@ struct ReaderParams {
            << " aggregation=" << aggregation
            << " version=" << version.first << "-" << version.second
            << " range=" << range
-           << " end_range=" << end_range;
+           << " end_range=" << end_range
+           << " read_by_block=" << read_by_block;
 
         for (int i = 0, size = start_key.size(); i < size; ++i) {
             ss << " keys=" << apache::thrift::ThriftDebugString(start_key[i]);
@@ -93,6 +104,14 @@ struct ReaderParams {
             ss << " end_keys=" << apache::thrift::ThriftDebugString(end_key[i]);
         }
 
+        for (int i = 0, size = start_key_cursors.size(); i < size; ++i) {
+            ss << " key_cursors=" << start_key_cursors[i]->to_string();
+        }
+
+        for (int i = 0, size = end_key_cursors.size(); i < size; ++i) {
+            ss << " end_key_cursors=" << end_key_cursors[i]->to_string();
+        }
+
         for (int i = 0, size = conditions.size(); i < size; ++i) {
             ss << " conditions=" << apache::thrift::ThriftDebugString(conditions[i]);
         }
@@ -108,10 +127,13 @@ public:
             _aggregation(false),
             _version_locked(false),
             _reader_type(READER_FETCH),
+            _read_by_block(false),
             _is_set_data_sources(false),
             _current_key_index(0),
             _next_key(NULL),
             _next_delete_flag(false),
+            _current_data_source(0),
+            _data_source_started(false),
             _scan_rows(0),
             _filted_rows(0),
             _merged_rows(0) {}
@@ -128,6 +150,17 @@ public:
     // Reader next row with aggregation.
     OLAPStatus next_row_with_aggregation(RowCursor *row_cursor, int64_t* raw_rows_read, bool *eof);
 
+    // Read next batch of rows column by column, without merging data versions.
+    // Only valid when is_read_by_block() returns true.
+    OLAPStatus next_block(VectorizedRowBatch* batch, int64_t* raw_rows_read, bool* eof);
+
+    // Data is returned by next_block only when versions need not to be merged
+    // (duplicate keys), no key range is given and no delete condition has to be
+    // evaluated row by row. Otherwise next_row_with_aggregation should be used.
+    bool is_read_by_block() const {
+        return _read_by_block;
+    }
+
     uint64_t merged_rows() const {
         return _merged_rows;
     }
@@ -173,9 +206,14 @@ private:
     typedef IData* MergeElement;
 
     // Use priority_queue as heap to merge multiple data versions.
+    // The smallest element is kept out of the heap, so a run of rows from one
+    // data version that does not overlap the others costs a single comparison
+    // per row; the heap is only rebuilt when key ranges of versions overlap.
+    // Runs are detected row by row against the heap top instead of from the short
+    // key index, so a run may start or end anywhere inside a row block.
     class MergeSet {
     public:
-        MergeSet() : _heap(NULL) {}
+        MergeSet() : _heap(NULL), _top(NULL), _comparator(false), _reader(NULL) {}
         ~MergeSet();
 
         // Hold reader point to get reader params, 
@@ -212,9 +250,19 @@ private:
         
         bool _pop_from_heap();
 
+        // Skip rows filtered by delete conditions, row is set to the first
+        // remaining row, or NULL if merge_element reaches end.
+        bool _skip_deleted_rows(const MergeElement& merge_element, const RowCursor** row);
+
+        // Put merge_element to _top if it is the smallest, otherwise into heap.
+        void _push(const MergeElement& merge_element);
+
         heap_t* _heap;
 
-        uint64_t _merge_count;
+        // Element with the smallest row, not stored in _heap.
+        MergeElement _top;
+
+        RowCursorComparator _comparator;
 
         // Hold reader point to access read params, such as fetch conditions.
         Reader* _reader;
@@ -228,6 +276,9 @@ private:
 
     OLAPStatus _init_keys_param(const ReaderParams& read_params);
 
+    OLAPStatus _copy_key_cursors(const std::vector<const RowCursor*>& keys,
+                                 std::vector<RowCursor*>* copies);
+
     OLAPStatus _init_conditions_param(const ReaderParams& read_params);
 
     OLAPStatus _init_delete_condition(const ReaderParams& read_params);
@@ -238,10 +289,13 @@ private:
 
     OLAPStatus _attach_data_to_merge_set(bool first, bool *eof);
 
+    bool _can_read_by_block(const ReaderParams& read_params);
+
     bool _is_inited;
     bool _aggregation;
     bool _version_locked;
     ReaderType _reader_type;
+    bool _read_by_block;
 
     Version _version;
 
@@ -268,6 +322,10 @@ private:
     const RowCursor* _next_key;
     bool _next_delete_flag;
 
+    // Data source being read by next_block.
+    size_t _current_data_source;
+    bool _data_source_started;
+
     std::set<uint32_t> _load_bf_columns;
     std::vector<uint32_t> _return_columns;
 
@@ -160,6 +160,10 @@ public:
     // 比较两个cursor，获取第一个值不同的column的id，用于selectivity的计算当中
     OLAPStatus get_first_different_column_id(const RowCursor& other, size_t* first_diff_id) const;
 
+    size_t key_column_num() const {
+        return _key_column_num;
+    }
+
     const Field* get_field_by_index(size_t index) const {
         if (false == _is_inited || index >= _field_array_size) {
             return NULL;
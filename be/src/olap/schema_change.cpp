@@ -23,8 +23,11 @@
 #include <signal.h>
 
 #include <algorithm>
+#include <deque>
 #include <vector>
 
+#include <boost/bind.hpp>
+
 #include "olap/field.h"
 #include "olap/i_data.h"
 #include "olap/merger.h"
@@ -35,6 +38,7 @@
 #include "olap/row_cursor.h"
 #include "olap/writer.h"
 #include "common/resource_tls.h"
+#include "util/thread_pool.hpp"
 #include "agent/cgroups_mgr.h"
 
 
@@ -450,18 +454,16 @@ RowBlockSorter::~RowBlockSorter() {
     }
 }
 
-bool RowBlockSorter::sort(RowBlock** row_block) {
-    uint32_t row_num = (*row_block)->row_block_info().row_num;
-    DataFileType data_file_type = (*row_block)->row_block_info().data_file_type;
-    bool null_supported = (*row_block)->row_block_info().null_supported;
-
-    if (_swap_row_block == NULL || _swap_row_block->allocated_row_num() < row_num) {
+bool RowBlockSorter::reserve(size_t num_rows,
+                             DataFileType data_file_type,
+                             bool null_supported) {
+    if (_swap_row_block == NULL || _swap_row_block->allocated_row_num() < num_rows) {
         if (_swap_row_block != NULL) {
             _row_block_allocator->release(_swap_row_block);
             _swap_row_block = NULL;
         }
 
-        if (_row_block_allocator->allocate(&_swap_row_block, row_num, 
+        if (_row_block_allocator->allocate(&_swap_row_block, num_rows, 
                                     data_file_type, null_supported) != OLAP_SUCCESS
                 || _swap_row_block == NULL) {
             OLAP_LOG_WARNING("fail to allocate memory.");
@@ -469,6 +471,16 @@ bool RowBlockSorter::sort(RowBlock** row_block) {
         }
     }
 
+    return true;
+}
+
+bool RowBlockSorter::sort(RowBlock** row_block) {
+    if (!reserve((*row_block)->row_block_info().row_num,
+                 (*row_block)->row_block_info().data_file_type,
+                 (*row_block)->row_block_info().null_supported)) {
+        return false;
+    }
+
     RowBlock* temp = NULL;
     vector<RowCursor*> row_cursor_list((*row_block)->row_block_info().row_num, NULL);
 
@@ -549,19 +561,26 @@ OLAPStatus RowBlockAllocator::allocate(RowBlock** row_block,
                                        bool null_supported) {
     size_t row_block_size = _row_len * num_rows;
 
+    // 先占用内存额度再分配, 分配失败时归还
+    _mutex.lock();
     if (_memory_limitation > 0
             && _memory_allocated + row_block_size > _memory_limitation) {
         OLAP_LOG_DEBUG("RowBlockAllocator::alocate() memory exceeded. [m_memory_allocated=%ld]",
                        _memory_allocated);
+        _mutex.unlock();
         *row_block = NULL;
         return OLAP_SUCCESS;
     }
+    _memory_allocated += row_block_size;
+    _mutex.unlock();
 
     // TODO(lijiao) : 为什么舍弃原有的m_row_block_buffer
     *row_block = new(nothrow) RowBlock(_tablet_schema);
 
     if (*row_block == NULL) {
         OLAP_LOG_WARNING("failed to malloc RowBlock. [size=%ld]", sizeof(RowBlock));
+        AutoMutexLock l(&_mutex);
+        _memory_allocated -= row_block_size;
         return OLAP_ERR_MALLOC_ERROR;
     }
 
@@ -573,10 +592,11 @@ OLAPStatus RowBlockAllocator::allocate(RowBlock** row_block,
     if ((res = (*row_block)->init(row_block_info)) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("failed to init row block.");
         SAFE_DELETE(*row_block);
+        AutoMutexLock l(&_mutex);
+        _memory_allocated -= row_block_size;
         return res;
     }
 
-    _memory_allocated += row_block_size;
     OLAP_LOG_DEBUG("RowBlockAllocator::allocate() "
                    "[this=%p num_rows=%ld m_memory_allocated=%ld p=%p]",
                    this,
@@ -592,7 +612,9 @@ void RowBlockAllocator::release(RowBlock* row_block) {
         return;
     }
 
+    _mutex.lock();
     _memory_allocated -= row_block->allocated_row_num() * _row_len;
+    _mutex.unlock();
 
     OLAP_LOG_DEBUG("RowBlockAllocator::release() "
                    "[this=%p num_rows=%ld m_memory_allocated=%ld p=%p]",
@@ -978,7 +1000,12 @@ SchemaChangeWithSorting::SchemaChangeWithSorting(SmartOLAPTable olap_table,
         _olap_table(olap_table),
         _row_block_changer(row_block_changer),
         _memory_limitation(memory_limitation),
-        _row_block_allocator(NULL) {
+        _row_block_allocator(NULL),
+        _thread_pool(OLAPEngine::get_instance()->schema_change_sort_thread_pool()),
+        _running_run(NULL),
+        _sort_time_us(0),
+        _wait_write_time_us(0),
+        _num_runs(0) {
     // 每次SchemaChange做外排的时候，会写一些临时版本（比如999,1000,1001），为避免Cache冲突，临时
     // 版本进行2个处理：
     // 1. 随机值作为VersionHash
@@ -1031,7 +1058,13 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
         return result;
     }
 
-    RowBlockSorter row_block_sorter(_row_block_allocator);
+    // 每个排序线程一个sorter, 提前占用交换RowBlock的内存.
+    // 使用线程池时, 一批RowBlock最多占用一半内存, 另一半留给正在写入的上一批.
+    size_t sorter_num = (NULL == _thread_pool) ? 1 : config::schema_change_sort_thread_num + 1;
+    size_t max_run_bytes = (NULL == _thread_pool) ? 0 : _memory_limitation / 2;
+    size_t run_bytes = 0;
+    OlapStopWatch watch;
+    uint64_t merge_time_us = 0;
 
     // for internal sorting
     RowBlock* new_row_block = NULL;
@@ -1041,12 +1074,46 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
     vector<OLAPIndex*> olap_index_arr;
 
     _temp_delta_versions.first = _temp_delta_versions.second;
+    _sort_time_us = 0;
+    _wait_write_time_us = 0;
+    _num_runs = 0;
 
     // Reset filted_rows and merged_rows statistic
     reset_merged_rows();
     reset_filted_rows();
 
+    for (size_t i = 0; i < sorter_num; ++i) {
+        RowBlockSorter* sorter = new(nothrow) RowBlockSorter(_row_block_allocator);
+        if (NULL == sorter) {
+            OLAP_LOG_WARNING("failed to malloc RowBlockSorter. [size=%ld]",
+                             sizeof(RowBlockSorter));
+            result = false;
+            goto SORTING_PROCESS_ERR;
+        }
+        _row_block_sorters.push_back(sorter);
+
+        if (!sorter->reserve(ref_row_block->row_block_info().row_num,
+                             data_file_type, null_supported)) {
+            OLAP_LOG_WARNING("Memory limitation is too small for Schema Change. "
+                             "[memory_limitation=%ld sorter_num=%lu]",
+                             _memory_limitation, sorter_num);
+            result = false;
+            goto SORTING_PROCESS_ERR;
+        }
+    }
+
     while (NULL != ref_row_block) {
+        if (max_run_bytes > 0 && run_bytes >= max_run_bytes) {
+            if (!_submit_sorted_run(&row_block_arr, &olap_index_arr)) {
+                OLAP_LOG_WARNING("failed to sorting internally.");
+                result = false;
+                goto SORTING_PROCESS_ERR;
+            }
+
+            run_bytes = 0;
+            continue;
+        }
+
         if (OLAP_SUCCESS != _row_block_allocator->allocate(
                     &new_row_block, ref_row_block->row_block_info().row_num, 
                     data_file_type, null_supported)) {
@@ -1056,36 +1123,32 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
         }
 
         if (NULL == new_row_block) {
+            // 正在写入的上一批释放内存后重试
+            if (NULL != _running_run) {
+                if (!_wait_sorted_run(&olap_index_arr)) {
+                    OLAP_LOG_WARNING("failed to sorting internally.");
+                    result = false;
+                    goto SORTING_PROCESS_ERR;
+                }
+                continue;
+            }
+
             if (row_block_arr.size() < 1) {
                 OLAP_LOG_WARNING("Memory limitation is too small for Schema Change. "
                                  "[memory_limitation=%ld]",
                                  _memory_limitation);
-                return false;
+                result = false;
+                goto SORTING_PROCESS_ERR;
             }
 
             // enter here while memory limitation is reached.
-            OLAPIndex* olap_index = NULL;
-
-            if (!_internal_sorting(row_block_arr,
-                                   Version(_temp_delta_versions.second,
-                                           _temp_delta_versions.second),
-                                   &olap_index)) {
+            if (!_submit_sorted_run(&row_block_arr, &olap_index_arr)) {
                 OLAP_LOG_WARNING("failed to sorting internally.");
                 result = false;
                 goto SORTING_PROCESS_ERR;
             }
 
-            olap_index_arr.push_back(olap_index);
-
-            for (vector<RowBlock*>::iterator it = row_block_arr.begin();
-                    it != row_block_arr.end(); ++it) {
-                _row_block_allocator->release(*it);
-            }
-
-            row_block_arr.clear();
-
-            // increase temp version
-            ++_temp_delta_versions.second;
+            run_bytes = 0;
             continue;
         }
 
@@ -1103,52 +1166,56 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
         add_filted_rows(filted_rows);
 
         if (new_row_block->row_block_info().row_num > 0) {
-            if (!row_block_sorter.sort(&new_row_block)) {
-                OLAP_LOG_WARNING("failed to sort row block.");
-                result = false;
-                OLAP_GOTO(SORTING_PROCESS_ERR);
-            }
-
             row_block_arr.push_back(new_row_block);
+            run_bytes += new_row_block->buf_len();
         } else {
             _row_block_allocator->release(new_row_block);
-            new_row_block = NULL;
         }
+        new_row_block = NULL;
 
         olap_data->get_next_row_block(&ref_row_block);
     }
 
-    if (!row_block_arr.empty()) {
-        // enter here while memory limitation is reached.
-        OLAPIndex* olap_index = NULL;
-
-        if (!_internal_sorting(row_block_arr,
-                               Version(_temp_delta_versions.second, _temp_delta_versions.second),
-                               &olap_index)) {
-            OLAP_LOG_WARNING("failed to sorting internally.");
-            result = false;
-            goto SORTING_PROCESS_ERR;
-        }
-
-        olap_index_arr.push_back(olap_index);
-
-        for (vector<RowBlock*>::iterator it = row_block_arr.begin();
-                it != row_block_arr.end(); ++it) {
-            _row_block_allocator->release(*it);
-        }
+    if (!row_block_arr.empty()
+            && !_submit_sorted_run(&row_block_arr, &olap_index_arr)) {
+        OLAP_LOG_WARNING("failed to sorting internally.");
+        result = false;
+        goto SORTING_PROCESS_ERR;
+    }
 
-        row_block_arr.clear();
+    if (NULL != _running_run && !_wait_sorted_run(&olap_index_arr)) {
+        OLAP_LOG_WARNING("failed to sorting internally.");
+        result = false;
+        goto SORTING_PROCESS_ERR;
+    }
 
-        // increase temp version
-        ++_temp_delta_versions.second;
+    // 排序线程的交换RowBlock不再需要, 在外排之前释放
+    for (size_t i = 0; i < _row_block_sorters.size(); ++i) {
+        SAFE_DELETE(_row_block_sorters[i]);
     }
+    _row_block_sorters.clear();
 
     // TODO(zyh): 如果_temp_delta_versions只有一个，不需要再外排
+    merge_time_us = watch.get_elapse_time_us();
     if (!_external_sorting(olap_index_arr, new_olap_index)) {
         OLAP_LOG_WARNING("failed to sorting externally.");
         result = false;
         goto SORTING_PROCESS_ERR;
     }
+    merge_time_us = watch.get_elapse_time_us() - merge_time_us;
+
+    OLAP_LOG_INFO("finish sorting schema change. [table='%s' version=%d-%d runs=%lu "
+                  "sorter_num=%lu total_time_us=%lu sort_time_us=%lu "
+                  "wait_write_time_us=%lu merge_time_us=%lu]",
+                  _olap_table->full_name().c_str(),
+                  new_olap_index->version().first,
+                  new_olap_index->version().second,
+                  _num_runs,
+                  sorter_num,
+                  watch.get_elapse_time_us(),
+                  _sort_time_us,
+                  _wait_write_time_us,
+                  merge_time_us);
 
     if (olap_data->data_file_type() == COLUMN_ORIENTED_FILE) {
         reset_filted_rows();
@@ -1173,6 +1240,15 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
     }
 
 SORTING_PROCESS_ERR:
+    // 失败时也要等待正在写入的一批结束, 它持有的RowBlock在这里释放
+    if (NULL != _running_run) {
+        _wait_sorted_run(&olap_index_arr);
+    }
+
+    if (NULL != new_row_block) {
+        _row_block_allocator->release(new_row_block);
+    }
+
     for (vector<OLAPIndex*>::iterator it = olap_index_arr.begin();
             it != olap_index_arr.end(); ++it) {
         (*it)->delete_all_files();
@@ -1185,14 +1261,132 @@ SORTING_PROCESS_ERR:
     }
 
     row_block_arr.clear();
+
+    for (size_t i = 0; i < _row_block_sorters.size(); ++i) {
+        SAFE_DELETE(_row_block_sorters[i]);
+    }
+    _row_block_sorters.clear();
+
+    return result;
+}
+
+bool SchemaChangeWithSorting::_submit_sorted_run(vector<RowBlock*>* row_block_arr,
+                                                 vector<OLAPIndex*>* olap_index_arr) {
+    // 同一时刻只有一批在写入, 先等待上一批结束
+    if (NULL != _running_run && !_wait_sorted_run(olap_index_arr)) {
+        return false;
+    }
+
+    OlapStopWatch watch;
+    size_t block_num = row_block_arr->size();
+    size_t step = (block_num + _row_block_sorters.size() - 1) / _row_block_sorters.size();
+    size_t task_num = (block_num + step - 1) / step;
+
+    // 每个sorter负责连续的一段RowBlock, 第一段在当前线程中排序
+    deque<bool> results(task_num, false);
+    CountDownLatch latch(task_num);
+    for (size_t i = 1; i < task_num; ++i) {
+        size_t begin = i * step;
+        size_t end = std::min(begin + step, block_num);
+        if (NULL == _thread_pool
+                || !_thread_pool->offer(boost::bind(&SchemaChangeWithSorting::_sort_row_blocks,
+                                                   _row_block_sorters[i], row_block_arr,
+                                                   begin, end, &results[i], &latch))) {
+            _sort_row_blocks(_row_block_sorters[i], row_block_arr,
+                             begin, end, &results[i], &latch);
+        }
+    }
+
+    _sort_row_blocks(_row_block_sorters[0], row_block_arr,
+                     0, std::min(step, block_num), &results[0], &latch);
+    latch.await();
+    _sort_time_us += watch.get_elapse_time_us();
+
+    for (size_t i = 0; i < task_num; ++i) {
+        if (!results[i]) {
+            OLAP_LOG_WARNING("failed to sort row block.");
+            return false;
+        }
+    }
+
+    SortedRun* run = new(nothrow) SortedRun();
+    if (NULL == run) {
+        OLAP_LOG_WARNING("failed to malloc SortedRun. [size=%ld]", sizeof(SortedRun));
+        return false;
+    }
+
+    run->schema_change = this;
+    run->row_block_arr.swap(*row_block_arr);
+    run->version = Version(_temp_delta_versions.second, _temp_delta_versions.second);
+    _running_run = run;
+
+    // increase temp version
+    ++_temp_delta_versions.second;
+    ++_num_runs;
+
+    if (NULL == _thread_pool
+            || !_thread_pool->offer(boost::bind(&SchemaChangeWithSorting::_write_sorted_run, run))) {
+        _write_sorted_run(run);
+    }
+
+    return true;
+}
+
+bool SchemaChangeWithSorting::_wait_sorted_run(vector<OLAPIndex*>* olap_index_arr) {
+    OlapStopWatch watch;
+    SortedRun* run = _running_run;
+    _running_run = NULL;
+
+    run->latch.await();
+    _wait_write_time_us += watch.get_elapse_time_us();
+
+    for (vector<RowBlock*>::iterator it = run->row_block_arr.begin();
+            it != run->row_block_arr.end(); ++it) {
+        _row_block_allocator->release(*it);
+    }
+
+    bool result = run->result;
+    if (result) {
+        olap_index_arr->push_back(run->olap_index);
+        add_merged_rows(run->merged_rows);
+        OLAP_LOG_INFO("sorted run is written. [table='%s' run=%lu rows=%lu]",
+                      _olap_table->full_name().c_str(),
+                      olap_index_arr->size(),
+                      run->olap_index->num_rows());
+    }
+
+    SAFE_DELETE(run);
     return result;
 }
 
+void SchemaChangeWithSorting::_write_sorted_run(SortedRun* run) {
+    run->result = run->schema_change->_internal_sorting(
+            run->row_block_arr, run->version, &run->olap_index, &run->merged_rows);
+    run->latch.count_down();
+}
+
+void SchemaChangeWithSorting::_sort_row_blocks(RowBlockSorter* sorter,
+                                               vector<RowBlock*>* row_block_arr,
+                                               size_t begin,
+                                               size_t end,
+                                               bool* result,
+                                               CountDownLatch* latch) {
+    *result = true;
+    for (size_t i = begin; i < end; ++i) {
+        if (!sorter->sort(&(*row_block_arr)[i])) {
+            *result = false;
+            break;
+        }
+    }
+
+    latch->count_down();
+}
+
 bool SchemaChangeWithSorting::_internal_sorting(const vector<RowBlock*>& row_block_arr,
                                                 const Version& temp_delta_versions,
-                                                OLAPIndex** temp_olap_index) {
+                                                OLAPIndex** temp_olap_index,
+                                                uint64_t* merged_rows) {
     IWriter* writer = NULL;
-    uint64_t merged_rows = 0;
     RowBlockMerger merger(_olap_table);
 
     (*temp_olap_index) = new(nothrow) OLAPIndex(_olap_table.get(),
@@ -1221,11 +1415,10 @@ bool SchemaChangeWithSorting::_internal_sorting(const vector<RowBlock*>& row_blo
         goto INTERNAL_SORTING_ERR;
     }
 
-    if (!merger.merge(row_block_arr, writer, &merged_rows)) {
+    if (!merger.merge(row_block_arr, writer, merged_rows)) {
         OLAP_LOG_WARNING("failed to merge row blocks.");
         goto INTERNAL_SORTING_ERR;
     }
-    add_merged_rows(merged_rows);
 
     if (OLAP_SUCCESS != (*temp_olap_index)->load()) {
         OLAP_LOG_WARNING("failed to reload olap index.");
@@ -1989,6 +2182,28 @@ OLAPStatus SchemaChangeHandler::_alter_table(SchemaChangeParams* sc_params) {
                 sc_params->new_olap_table, rb_changer);
     } else {
         OLAP_LOG_INFO("doing linked schema change.");
+        // 只修改header: 旧数据直接链接到新表, 新增的列在读取时补齐, 删除的列被忽略,
+        // 直到新表做base expansion时才按新的schema重写. 链接的数据仍需按删除条件过滤,
+        // 因此删除条件也复制到新表中.
+        if (sc_params->ref_olap_table->delete_data_conditions_size() != 0) {
+            sc_params->ref_olap_table->obtain_header_rdlock();
+            sc_params->new_olap_table->obtain_header_wrlock();
+            res = _copy_delete_conditions(sc_params->ref_olap_table,
+                                          sc_params->new_olap_table,
+                                          end_version);
+            if (OLAP_SUCCESS == res) {
+                res = sc_params->new_olap_table->save_header();
+            }
+            sc_params->new_olap_table->release_header_lock();
+            sc_params->ref_olap_table->release_header_lock();
+
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to copy delete conditions. [res=%d table='%s']",
+                                 res, sc_params->new_olap_table->full_name().c_str());
+                goto PROCESS_ALTER_EXIT;
+            }
+        }
+
         sc_procedure = new(nothrow) LinkedSchemaChange(
                                 sc_params->ref_olap_table,
                                 sc_params->new_olap_table);
@@ -2249,6 +2464,12 @@ OLAPStatus SchemaChangeHandler::_parse_request(SmartOLAPTable ref_olap_table,
                 *sc_directly = true;
             }
 
+            // 链接的旧数据中没有这一列, 读取时由DefaultValueReader或NullValueReader补齐,
+            // 两者都不可用时只能重写数据
+            if (!new_column_schema.has_default_value && !new_column_schema.is_allow_null) {
+                *sc_directly = true;
+            }
+
             if (OLAP_SUCCESS != (res = _init_column_mapping(
                                          column_mapping,
                                          new_column_schema,
@@ -2323,15 +2544,17 @@ OLAPStatus SchemaChangeHandler::_parse_request(SmartOLAPTable ref_olap_table,
                 *sc_directly = true;
                 return OLAP_SUCCESS;
 
-            } else if (new_table_schema[i].is_bf_column != ref_table_schema[i].is_bf_column) {
+            } else if (new_table_schema[i].is_bf_column
+                    != ref_table_schema[column_mapping->ref_column].is_bf_column) {
                 *sc_directly = true;
                 return OLAP_SUCCESS;
             }
         }
     }
 
-    if (ref_olap_table->delete_data_conditions_size() != 0){
-        //there exists delete condtion in header, can't do linked schema change
+    if (ref_olap_table->delete_data_conditions_size() != 0
+            && !_is_delete_conditions_kept(ref_olap_table, new_olap_table, rb_changer)) {
+        //there exists delete condtion on changed column, can't do linked schema change
         *sc_directly = true;
     }
 
@@ -2343,6 +2566,65 @@ OLAPStatus SchemaChangeHandler::_parse_request(SmartOLAPTable ref_olap_table,
     return OLAP_SUCCESS;
 }
 
+bool SchemaChangeHandler::_is_delete_conditions_kept(SmartOLAPTable ref_olap_table,
+                                                     SmartOLAPTable new_olap_table,
+                                                     RowBlockChanger* rb_changer) {
+    // 转换新导入的delta时没有初始化删除条件, 保持原来重写数据的做法
+    const DeleteHandler& delete_handler = rb_changer->delete_handler();
+    if (!delete_handler.get_init_status()) {
+        return false;
+    }
+
+    const vector<DeleteConditions>& del_conds = delete_handler.get_delete_conditions();
+    for (size_t i = 0; i < del_conds.size(); ++i) {
+        const Conditions::CondColumns& columns = del_conds[i].del_cond->columns();
+        for (Conditions::CondColumns::const_iterator it = columns.begin();
+                it != columns.end(); ++it) {
+            // 删除条件以列名保存, 新表中同名的列必须直接引用原来的列
+            const string& column_name = ref_olap_table->tablet_schema()[it->first].name;
+            int32_t new_column_index = new_olap_table->get_field_index(column_name);
+            if (new_column_index < 0
+                    || rb_changer->get_mutable_column_mapping(new_column_index)->ref_column
+                        != it->first) {
+                OLAP_LOG_INFO("delete condition column is changed, data will be rewritten. "
+                              "[table='%s' column='%s' version=%d]",
+                              ref_olap_table->full_name().c_str(),
+                              column_name.c_str(),
+                              del_conds[i].filter_version);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+OLAPStatus SchemaChangeHandler::_copy_delete_conditions(SmartOLAPTable ref_olap_table,
+                                                        SmartOLAPTable new_olap_table,
+                                                        int32_t end_version) {
+    const DeleteConditionHandler::del_cond_array& del_conds
+            = ref_olap_table->delete_data_conditions();
+    new_olap_table->mutable_delete_data_conditions()->Clear();
+    for (int i = 0; i < del_conds.size(); ++i) {
+        if (del_conds.Get(i).version() > end_version) {
+            continue;
+        }
+
+        DeleteDataConditionMessage* del_cond = new_olap_table->add_delete_data_conditions();
+        if (NULL == del_cond) {
+            OLAP_LOG_WARNING("fail to add delete condition. [table='%s']",
+                             new_olap_table->full_name().c_str());
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+        del_cond->CopyFrom(del_conds.Get(i));
+
+        OLAP_LOG_INFO("copy delete condition to new table. [table='%s' version=%d]",
+                      new_olap_table->full_name().c_str(), del_cond->version());
+    }
+
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus SchemaChangeHandler::_init_column_mapping(ColumnMapping* column_mapping,
                                                      const FieldInfo& column_schema,
                                                      const std::string& value) {
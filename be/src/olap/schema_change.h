@@ -27,6 +27,8 @@
 #include "gen_cpp/AgentService_types.h"
 #include "olap/delete_handler.h"
 #include "olap/i_data.h"
+#include "olap/utils.h"
+#include "util/count_down_latch.hpp"
 
 namespace palo {
 // defined in 'field.h'
@@ -42,6 +44,8 @@ class RowBlock;
 class RowCursor;
 // defined in 'writer.h'
 class IWriter;
+// defined in 'util/thread_pool.hpp'
+class ThreadPool;
 
 struct ColumnMapping {
     ColumnMapping() : ref_column(-1), default_value(NULL) {}
@@ -68,6 +72,10 @@ public:
     virtual ~RowBlockChanger();
 
     ColumnMapping* get_mutable_column_mapping(size_t column_index);
+
+    const DeleteHandler& delete_handler() const {
+        return _delete_handler;
+    }
     
     bool change_row_block(
             const DataFileType df_type,
@@ -94,6 +102,9 @@ public:
 
     bool sort(RowBlock** row_block);
 
+    // 预先分配排序用的交换RowBlock, 避免在内存已达上限时排序失败
+    bool reserve(size_t num_rows, DataFileType data_file_type, bool null_supported);
+
 private:
     static bool _row_cursor_comparator(const RowCursor* a, const RowCursor* b) {
         return a->full_key_cmp(*b) < 0;
@@ -113,6 +124,8 @@ public:
     void release(RowBlock* row_block);
 
 private:
+    // 多个排序线程和写入线程共用同一个allocator
+    MutexLock _mutex;
     const std::vector<FieldInfo>& _tablet_schema;
     size_t _memory_allocated;
     size_t _row_len;
@@ -240,10 +253,42 @@ public:
     virtual bool process(IData* olap_data, OLAPIndex* new_olap_index);
 
 private:
+    // 内存中排好序的一批RowBlock, 在线程池中归并写入一个临时index
+    struct SortedRun {
+        SortedRun() : schema_change(NULL), olap_index(NULL), merged_rows(0),
+                result(false), latch(1) {}
+
+        SchemaChangeWithSorting* schema_change;
+        std::vector<RowBlock*> row_block_arr;
+        Version version;
+        OLAPIndex* olap_index;
+        uint64_t merged_rows;
+        bool result;
+        CountDownLatch latch;
+    };
+
+    // 并行排序row_block_arr中的每个RowBlock, 交给线程池写成临时index,
+    // 写入与后续RowBlock的读取和转换同时进行
+    bool _submit_sorted_run(std::vector<RowBlock*>* row_block_arr,
+                            std::vector<OLAPIndex*>* olap_index_arr);
+
+    // 等待正在写入的SortedRun结束, 释放它的RowBlock并收集临时index
+    bool _wait_sorted_run(std::vector<OLAPIndex*>* olap_index_arr);
+
+    static void _write_sorted_run(SortedRun* run);
+
+    static void _sort_row_blocks(RowBlockSorter* sorter,
+                                 std::vector<RowBlock*>* row_block_arr,
+                                 size_t begin,
+                                 size_t end,
+                                 bool* result,
+                                 CountDownLatch* latch);
+
     bool _internal_sorting(
             const std::vector<RowBlock*>& row_block_arr,
             const Version& temp_delta_versions,
-            OLAPIndex** temp_olap_index);
+            OLAPIndex** temp_olap_index,
+            uint64_t* merged_rows);
 
     bool _external_sorting(
             std::vector<OLAPIndex*>& src_olap_index_arr,
@@ -254,6 +299,19 @@ private:
     size_t _memory_limitation;
     Version _temp_delta_versions;
     RowBlockAllocator* _row_block_allocator;
+    // 每个排序线程一个sorter, 第一个在当前线程中使用
+    std::vector<RowBlockSorter*> _row_block_sorters;
+    // 排序和写入SortedRun的线程池, 为NULL时在当前线程中串行执行
+    ThreadPool* _thread_pool;
+    // 正在线程池中写入的SortedRun, 同一时刻最多一个
+    SortedRun* _running_run;
+
+    // 各阶段耗时, 在处理完成时打印
+    uint64_t _sort_time_us;
+    uint64_t _wait_write_time_us;
+    size_t _num_runs;
+
+    friend class TestSchemaChange;
 
     DISALLOW_COPY_AND_ASSIGN(SchemaChangeWithSorting);
 };
@@ -351,6 +409,17 @@ private:
                                      bool* sc_sorting, 
                                      bool* sc_directly);
 
+    // 链接的数据在新表上读取时仍需按删除条件过滤, 删除条件引用的列在新表中
+    // 都原样保留时返回true, 此时可以把删除条件复制到新表而不必重写数据
+    static bool _is_delete_conditions_kept(SmartOLAPTable ref_olap_table,
+                                           SmartOLAPTable new_olap_table,
+                                           RowBlockChanger* rb_changer);
+
+    // 将ref_olap_table中不大于end_version的删除条件复制到new_olap_table的header中
+    static OLAPStatus _copy_delete_conditions(SmartOLAPTable ref_olap_table,
+                                              SmartOLAPTable new_olap_table,
+                                              int32_t end_version);
+
     // 需要新建default_value时的初始化设置
     static OLAPStatus _init_column_mapping(ColumnMapping* column_mapping,
                                            const FieldInfo& column_schema,
@@ -34,7 +34,9 @@
 #include <lzo/lzo1c.h>
 #include <lzo/lzo1x.h>
 #include <stdarg.h>
+#include <zstd/zstd.h>
 
+#include "common/config.h"
 #include "common/logging.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
@@ -334,6 +336,22 @@ OLAPStatus olap_compress(const char* src_buf,
         }
         break;
     }
+    case OLAP_COMP_ZSTD: {
+        size_t zstd_res = ZSTD_compress(dest_buf, dest_len, src_buf, src_len,
+                                        config::zstd_compression_level);
+        if (ZSTD_isError(zstd_res)) {
+            // 输出空间不足时也会返回错误, 调用方会改为不压缩输出
+            OLAP_LOG_DEBUG("compress failed."
+                           "[src_len=%lu; dest_len=%lu; zstd_res=%s]",
+                           src_len,
+                           dest_len,
+                           ZSTD_getErrorName(zstd_res));
+
+            return OLAP_ERR_BUFFER_OVERFLOW;
+        }
+        *written_len = zstd_res;
+        break;
+    }
     default:
         OLAP_LOG_WARNING("unknown compression type. [type=%d]", compression_type);
         break;
@@ -421,6 +439,20 @@ OLAPStatus olap_decompress(const char* src_buf,
         }
         break;
     }
+    case OLAP_COMP_ZSTD: {
+        size_t zstd_res = ZSTD_decompress(dest_buf, dest_len, src_buf, src_len);
+        if (ZSTD_isError(zstd_res)) {
+            OLAP_LOG_WARNING("decompress failed."
+                             "[src_len=%lu; dest_len=%lu; zstd_res=%s]",
+                             src_len,
+                             dest_len,
+                             ZSTD_getErrorName(zstd_res));
+
+            return OLAP_ERR_DECOMPRESS_ERROR;
+        }
+        *written_len = zstd_res;
+        break;
+    }
     default: 
         break;
     }
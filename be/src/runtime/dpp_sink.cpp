@@ -19,10 +19,12 @@
 
 #include "runtime/dpp_sink.h"
 
+#include <atomic>
 #include <memory>
 #include <sstream>
 
 #include "agent/cgroups_mgr.h"
+#include "common/config.h"
 #include "common/object_pool.h"
 #include "exprs/expr.h"
 #include "exprs/slot_ref.h"
@@ -33,9 +35,15 @@
 #include "runtime/row_batch.h"
 #include "runtime/qsorter.h"
 #include "runtime/descriptors.h"
+#include "runtime/exec_env.h"
+#include "runtime/sorted_run_merger.h"
+#include "runtime/tmp_file_mgr.h"
+#include "gen_cpp/Data_types.h"
 #include "gen_cpp/Types_types.h"
 #include "util/count_down_latch.hpp"
 #include "util/debug_util.h"
+#include "util/thrift_util.h"
+#include "util/tuple_row_compare.h"
 #include "olap/field.h"
 
 namespace palo {
@@ -121,6 +129,137 @@ private:
     std::vector<HllMergeValue*> _hll_last_row;
 };
 
+// Sorted rows spilled to one tmp file of TmpFileMgr.
+// Every batch of the run is serialized as TRowBatch and stored as
+// 'length(uint32_t) + bytes', batches are read back in the same order.
+class SpilledRun {
+public:
+    SpilledRun(const RowDescriptor& row_desc, MemTracker* mem_tracker) :
+        _row_desc(row_desc),
+        _mem_tracker(mem_tracker),
+        _serializer(false, 0),
+        _file_size(0),
+        _read_offset(0) {
+    }
+
+    ~SpilledRun() {
+        close();
+    }
+
+    // Create tmp file on one of the active tmp devices
+    Status open(RuntimeState* state);
+
+    // Append one batch of sorted rows to this run,
+    // 'written_bytes' is set to bytes written to file.
+    Status add_batch(RowBatch* batch, int64_t* written_bytes);
+
+    // Read next batch of this run, '*batch' is set to nullptr when there is no data.
+    // Batch returned is owned by this run and valid until next call.
+    Status get_next(RowBatch** batch);
+
+    // Remove tmp file
+    void close();
+
+private:
+    Status open_file();
+
+    const RowDescriptor& _row_desc;
+    MemTracker* _mem_tracker;
+    ThriftSerializer _serializer;
+    std::unique_ptr<TmpFileMgr::File> _file;
+    FileHandler _file_handler;
+    int64_t _file_size;
+    int64_t _read_offset;
+    std::vector<uint8_t> _read_buf;
+    std::unique_ptr<RowBatch> _read_batch;
+
+    // used to spread runs of all translators on tmp devices
+    static std::atomic<uint32_t> _s_next_device;
+};
+
+std::atomic<uint32_t> SpilledRun::_s_next_device(0);
+
+Status SpilledRun::open(RuntimeState* state) {
+    TmpFileMgr* tmp_file_mgr = state->exec_env()->tmp_file_mgr();
+    std::vector<TmpFileMgr::DeviceId> devices = tmp_file_mgr->active_tmp_devices();
+    if (devices.empty()) {
+        return Status("no active tmp device to spill sorted run.");
+    }
+    TmpFileMgr::File* file = nullptr;
+    RETURN_IF_ERROR(tmp_file_mgr->get_file(
+            devices[_s_next_device.fetch_add(1) % devices.size()], state->query_id(), &file));
+    _file.reset(file);
+    return Status::OK;
+}
+
+Status SpilledRun::open_file() {
+    if (_file_handler.open(_file->path(), O_RDWR) != OLAP_SUCCESS) {
+        std::stringstream ss;
+        ss << "open spilled run file failed. [file=" << _file->path() << "]";
+        return Status(ss.str());
+    }
+    return Status::OK;
+}
+
+Status SpilledRun::add_batch(RowBatch* batch, int64_t* written_bytes) {
+    TRowBatch t_batch;
+    batch->serialize(&t_batch);
+    uint32_t len = 0;
+    uint8_t* buf = nullptr;
+    RETURN_IF_ERROR(_serializer.serialize(&t_batch, &len, &buf));
+
+    int64_t offset = 0;
+    RETURN_IF_ERROR(_file->allocate_space(sizeof(len) + len, &offset));
+    if (offset == 0) {
+        // file is created by the first allocation
+        RETURN_IF_ERROR(open_file());
+    }
+    if (_file_handler.pwrite(&len, sizeof(len), offset) != OLAP_SUCCESS
+            || _file_handler.pwrite(buf, len, offset + sizeof(len)) != OLAP_SUCCESS) {
+        std::stringstream ss;
+        ss << "write spilled run file failed. [file=" << _file->path() << "]";
+        _file->report_io_error(ss.str());
+        return Status(ss.str());
+    }
+    _file_size = offset + sizeof(len) + len;
+    *written_bytes = sizeof(len) + len;
+    return Status::OK;
+}
+
+Status SpilledRun::get_next(RowBatch** batch) {
+    *batch = nullptr;
+    if (_read_offset >= _file_size) {
+        return Status::OK;
+    }
+
+    uint32_t len = 0;
+    if (_file_handler.pread(&len, sizeof(len), _read_offset) != OLAP_SUCCESS) {
+        return Status("read length of spilled batch failed.");
+    }
+    _read_buf.resize(len);
+    if (_file_handler.pread(_read_buf.data(), len, _read_offset + sizeof(len)) != OLAP_SUCCESS) {
+        return Status("read spilled batch failed.");
+    }
+    _read_offset += sizeof(len) + len;
+
+    TRowBatch t_batch;
+    RETURN_IF_ERROR(deserialize_thrift_msg(_read_buf.data(), &len, false, &t_batch));
+    // Merger may hold data of last batch by transfer_resource_ownership,
+    // so always create a new one.
+    _read_batch.reset(new RowBatch(_row_desc, t_batch, _mem_tracker));
+    *batch = _read_batch.get();
+    return Status::OK;
+}
+
+void SpilledRun::close() {
+    _read_batch.reset();
+    if (_file.get() != nullptr) {
+        _file_handler.close();
+        _file->remove();
+        _file.reset();
+    }
+}
+
 // same tablet which (partition, rollup, bucket) all equals
 // this is used by next steps
 //  1. new one Translator
@@ -149,6 +288,13 @@ public:
 
     Status add_batch(RowBatch* batch);
 
+    // Return true if rows buffered in sorter exceed the spill threshold
+    bool need_spill() const;
+
+    // Sort rows buffered in sorter and spill them to tmp file as one run,
+    // the sorter is empty after this call.
+    Status spill(RuntimeState* state);
+
     // NOTE: called when all data is added by 'add_batch'
     Status process(RuntimeState* state);
 
@@ -183,6 +329,16 @@ private:
     // Create value updaters
     Status create_value_updaters();
 
+    // Create merger to merge spilled runs and rows left in sorter
+    Status create_merger(RuntimeState* state);
+
+    // Supply rows left in sorter to merger, '*batch' is nullptr when there is no data.
+    Status get_next_in_memory_batch(RuntimeState* state, RowBatch** batch);
+
+    // Get next batch of sorted rows, from merger if there are spilled runs,
+    // otherwise from sorter directly.
+    Status get_next_sorted(RowBatch* batch, bool* eos);
+
     // Following function is used to process batch
 
     // Check if this two rows are equal with each other
@@ -214,6 +370,15 @@ private:
     // not owned
     ObjectPool* _obj_pool;
 
+    // Runs spilled when buffered rows exceed 'etl_sort_spill_threshold_bytes',
+    // they are merged with rows left in '_sorter' by '_merger'.
+    std::vector<std::unique_ptr<SpilledRun>> _spilled_runs;
+    std::unique_ptr<SortedRunMerger> _merger;
+    std::vector<ExprContext*> _merge_lhs_expr_ctxs;
+    std::vector<ExprContext*> _merge_rhs_expr_ctxs;
+    std::unique_ptr<RowBatch> _in_memory_batch;
+    bool _in_memory_eos;
+
     // used to compare between two tuple_row after sorted.
     // Same rows will be aggregate to one row
     std::vector<ExprContext*> _last_row_expr_ctxs;
@@ -243,6 +408,10 @@ private:
     RuntimeProfile::Counter* _sort_timer;
     RuntimeProfile::Counter* _agg_timer;
     RuntimeProfile::Counter* _writer_timer;
+    RuntimeProfile::Counter* _spill_timer;
+    RuntimeProfile::Counter* _spilled_runs_counter;
+    RuntimeProfile::Counter* _spilled_bytes_counter;
+    RuntimeProfile::Counter* _merge_timer;
     HllDppSinkMerge _hll_merge;
 };
 
@@ -259,12 +428,17 @@ Translator::Translator(
         _rollup_schema(rollup_schema),
         _sorter(nullptr),
         _obj_pool(obj_pool),
+        _in_memory_eos(false),
         _writer(nullptr),
         _profile(nullptr),
         _add_batch_timer(nullptr),
         _sort_timer(nullptr),
         _agg_timer(nullptr),
-        _writer_timer(nullptr) {
+        _writer_timer(nullptr),
+        _spill_timer(nullptr),
+        _spilled_runs_counter(nullptr),
+        _spilled_bytes_counter(nullptr),
+        _merge_timer(nullptr) {
 }
 
 Translator::~Translator() {
@@ -280,6 +454,10 @@ Status Translator::create_sorter(RuntimeState* state) {
 Status Translator::create_comparetor(RuntimeState* state) {
     RETURN_IF_ERROR(Expr::clone_if_not_exists(_rollup_schema.keys(), state, &_last_row_expr_ctxs));
     RETURN_IF_ERROR(Expr::clone_if_not_exists(_rollup_schema.keys(), state, &_cur_row_expr_ctxs));
+    RETURN_IF_ERROR(Expr::clone_if_not_exists(
+            _rollup_schema.keys(), state, &_merge_lhs_expr_ctxs));
+    RETURN_IF_ERROR(Expr::clone_if_not_exists(
+            _rollup_schema.keys(), state, &_merge_rhs_expr_ctxs));
     return Status::OK;
 }
 
@@ -540,6 +718,10 @@ Status Translator::create_profile(RuntimeState* state) {
     _sort_timer = ADD_TIMER(_profile, "sort time");
     _agg_timer = ADD_TIMER(_profile, "aggregate time");
     _writer_timer = ADD_TIMER(_profile, "write to file time");
+    _spill_timer = ADD_TIMER(_profile, "spill time");
+    _spilled_runs_counter = ADD_COUNTER(_profile, "spilled runs", TUnit::UNIT);
+    _spilled_bytes_counter = ADD_COUNTER(_profile, "spilled bytes", TUnit::BYTES);
+    _merge_timer = ADD_TIMER(_profile, "merge time");
     return Status::OK;
 }
 
@@ -583,6 +765,74 @@ Status Translator::add_batch(RowBatch* batch) {
     return _sorter->add_batch(batch);
 }
 
+bool Translator::need_spill() const {
+    return ((QSorter*)_sorter)->mem_usage() >= config::etl_sort_spill_threshold_bytes;
+}
+
+Status Translator::spill(RuntimeState* state) {
+    SCOPED_TIMER(_spill_timer);
+    RETURN_IF_ERROR(_sorter->input_done());
+
+    std::unique_ptr<SpilledRun> run(new SpilledRun(_row_desc, state->instance_mem_tracker()));
+    RETURN_IF_ERROR(run->open(state));
+    bool eos = false;
+    while (!eos) {
+        RowBatch batch(_row_desc, state->batch_size(), state->instance_mem_tracker());
+        RETURN_IF_ERROR(_sorter->get_next(&batch, &eos));
+        if (batch.num_rows() == 0) {
+            continue;
+        }
+        int64_t written_bytes = 0;
+        RETURN_IF_ERROR(run->add_batch(&batch, &written_bytes));
+        COUNTER_UPDATE(_spilled_bytes_counter, written_bytes);
+    }
+    ((QSorter*)_sorter)->reset();
+
+    _spilled_runs.push_back(std::move(run));
+    COUNTER_UPDATE(_spilled_runs_counter, 1);
+    return Status::OK;
+}
+
+Status Translator::get_next_in_memory_batch(RuntimeState* state, RowBatch** batch) {
+    *batch = nullptr;
+    // Merger may hold data of last batch by transfer_resource_ownership,
+    // so always create a new one.
+    _in_memory_batch.reset(
+            new RowBatch(_row_desc, state->batch_size(), state->instance_mem_tracker()));
+    while (!_in_memory_eos && _in_memory_batch->num_rows() == 0) {
+        RETURN_IF_ERROR(_sorter->get_next(_in_memory_batch.get(), &_in_memory_eos));
+    }
+    if (_in_memory_batch->num_rows() > 0) {
+        *batch = _in_memory_batch.get();
+    }
+    return Status::OK;
+}
+
+Status Translator::create_merger(RuntimeState* state) {
+    // Same order with QSorter: ascending and NULL is the first
+    TupleRowComparator less_than(_merge_lhs_expr_ctxs, _merge_rhs_expr_ctxs, true, true);
+    // All rows are deep copied to '_batch_to_write' when aggregating,
+    // so there is no need to deep copy them in merger.
+    _merger.reset(new SortedRunMerger(
+            less_than, const_cast<RowDescriptor*>(&_row_desc), _profile, false));
+
+    std::vector<SortedRunMerger::RunBatchSupplier> runs;
+    for (auto& run : _spilled_runs) {
+        runs.push_back(boost::bind<Status>(&SpilledRun::get_next, run.get(), _1));
+    }
+    runs.push_back(boost::bind<Status>(
+            &Translator::get_next_in_memory_batch, this, state, _1));
+    return _merger->prepare(runs);
+}
+
+Status Translator::get_next_sorted(RowBatch* batch, bool* eos) {
+    if (_merger == nullptr) {
+        return _sorter->get_next(batch, eos);
+    }
+    SCOPED_TIMER(_merge_timer);
+    return _merger->get_next(batch, eos);
+}
+
 bool Translator::eq_tuple_row(TupleRow* last, TupleRow* cur) {
     int num_exprs = _last_row_expr_ctxs.size();
     for (int i = 0; i < num_exprs; ++i) {
@@ -787,6 +1037,11 @@ Status Translator::process(RuntimeState* state) {
         SCOPED_TIMER(_sort_timer);
         RETURN_IF_ERROR(_sorter->input_done());
     }
+    // k-way merge spilled runs and rows left in sorter
+    if (!_spilled_runs.empty()) {
+        SCOPED_TIMER(_merge_timer);
+        RETURN_IF_ERROR(create_merger(state));
+    }
 
     // 2. read data from sorter and aggregate them
     {
@@ -795,7 +1050,7 @@ Status Translator::process(RuntimeState* state) {
         while (!eos) {
             RowBatch batch(_row_desc, state->batch_size(), state->instance_mem_tracker());
 
-            RETURN_IF_ERROR(_sorter->get_next(&batch, &eos));
+            RETURN_IF_ERROR(get_next_sorted(&batch, &eos));
 
             int num_rows = batch.num_rows();
             for (int i = 0; i < num_rows; ++i) {
@@ -828,6 +1083,11 @@ Status Translator::process(RuntimeState* state) {
 }
 
 Status Translator::close(RuntimeState* state) {
+    _merger.reset();
+    _in_memory_batch.reset();
+    _spilled_runs.clear();
+    Expr::close(_merge_lhs_expr_ctxs, state);
+    Expr::close(_merge_rhs_expr_ctxs, state);
     if (_sorter != nullptr) {
         _sorter->close(state);
     }
@@ -879,10 +1139,45 @@ Status DppSink::add_batch(
     std::vector<Translator*>* trans_vec = nullptr;
     RETURN_IF_ERROR(get_or_create_translator(obj_pool, state, desc, &trans_vec));
     // add for every one
+    std::vector<Translator*> spill_trans_vec;
     for (auto& trans : *trans_vec) {
         RETURN_IF_ERROR(trans->add_batch(batch));
+        if (trans->need_spill()) {
+            spill_trans_vec.push_back(trans);
+        }
     }
     // add this batch to appoint translator
+    return spill(state, spill_trans_vec);
+}
+
+void DppSink::spill_one(
+        RuntimeState* state, Translator* trans, Status* status, CountDownLatch* latch) {
+    // add dpp into cgroups
+    CgroupsMgr::apply_system_cgroup();
+    *status = trans->spill(state);
+    latch->count_down();
+}
+
+Status DppSink::spill(RuntimeState* state, const std::vector<Translator*>& trans_vec) {
+    if (trans_vec.empty()) {
+        return Status::OK;
+    }
+    if (trans_vec.size() == 1) {
+        return trans_vec[0]->spill(state);
+    }
+
+    // sort and write runs of different rollups in parallel
+    std::vector<Status> status_vec(trans_vec.size());
+    CountDownLatch latch(trans_vec.size());
+    for (int i = 0; i < trans_vec.size(); ++i) {
+        state->etl_thread_pool()->offer(boost::bind<void>(
+                &DppSink::spill_one, this, state, trans_vec[i], &status_vec[i], &latch));
+    }
+    latch.await();
+
+    for (auto& status : status_vec) {
+        RETURN_IF_ERROR(status);
+    }
     return Status::OK;
 }
 
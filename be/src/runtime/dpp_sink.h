@@ -41,6 +41,9 @@ class CountDownLatch;
 // This class swallow data which is splited by partition and rollup.
 // Sort input data and then aggregate data contains same key,
 // then wirte new data into dpp writer for next push operation.
+// When rows buffered by one translator exceed 'etl_sort_spill_threshold_bytes',
+// they are sorted and spilled to tmp dirs as one run, all runs are merged
+// when data are aggregated in 'finish'.
 class DppSink {
 public:
     DppSink(const RowDescriptor& row_desc,
@@ -76,6 +79,10 @@ private:
             std::vector<Translator*>** trans_vec);
     void process(RuntimeState* state, Translator* trans, CountDownLatch* latch);
 
+    // Spill buffered rows of translators in 'trans_vec' to tmp files as sorted runs
+    Status spill(RuntimeState* state, const std::vector<Translator*>& trans_vec);
+    void spill_one(RuntimeState* state, Translator* trans, Status* status, CountDownLatch* latch);
+
     // description of batch added
     const RowDescriptor& _row_desc;
     // map from 'rollup name' to 'rollup schema'
@@ -30,6 +30,7 @@
 #include "runtime/data_stream_mgr.h"
 #include "runtime/disk_io_mgr.h"
 #include "runtime/result_buffer_mgr.h"
+#include "runtime/runtime_filter_mgr.h"
 #include "runtime/mem_tracker.h"
 #include "runtime/thread_resource_mgr.h"
 #include "runtime/fragment_mgr.h"
@@ -44,6 +45,7 @@
 #include "util/debug_util.h"
 #include "http/action/mini_load.h"
 #include "http/action/checksum_action.h"
+#include "http/action/expansion_action.h"
 #include "http/action/health_action.h"
 #include "http/action/reload_tablet_action.h"
 #include "http/action/snapshot_action.h"
@@ -68,6 +70,7 @@ ExecEnv* ExecEnv::_exec_env = nullptr;
 ExecEnv::ExecEnv() :
         _stream_mgr(new DataStreamMgr()),
         _result_mgr(new ResultBufferMgr()),
+        _runtime_filter_mgr(new RuntimeFilterMgr(this)),
         _client_cache(new BackendServiceClientCache()),
         _frontend_client_cache(new FrontendServiceClientCache()),
         _broker_client_cache(new BrokerServiceClientCache()),
@@ -96,6 +99,12 @@ ExecEnv::ExecEnv() :
         _broker_mgr(new BrokerMgr(this)),
         _enable_webserver(true),
         _tz_database(TimezoneDatabase()) {
+    if (config::aggregation_parallel_threads > 1
+            && config::aggregation_thread_pool_thread_num > 0) {
+        _aggregation_thread_pool.reset(new ThreadPool(
+                config::aggregation_thread_pool_thread_num,
+                config::aggregation_thread_pool_queue_size));
+    }
     get_local_ip(_local_ip.get());
     _client_cache->init_metrics(_metrics.get(), "palo.backends");
     //_frontend_client_cache->init_metrics(_metrics.get(), "frontend-server.backends");
@@ -201,6 +210,10 @@ Status ExecEnv::start_services() {
         // Register BE snapshot action
         SnapshotAction* snapshot_action = new SnapshotAction(this);
         _webserver->register_handler(HttpMethod::GET, "/api/snapshot", snapshot_action);
+
+        // Register BE expansion scheduler status action
+        ExpansionAction* expansion_action = new ExpansionAction(this);
+        _webserver->register_handler(HttpMethod::GET, "/api/expansion/show", expansion_action);
 #endif
 
         RETURN_IF_ERROR(_webserver->start());
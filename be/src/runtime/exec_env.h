@@ -40,6 +40,7 @@ namespace palo {
 
 class DataStreamMgr;
 class ResultBufferMgr;
+class RuntimeFilterMgr;
 class TestExecEnv;
 class Webserver;
 class WebPageHandler;
@@ -80,6 +81,9 @@ public:
     ResultBufferMgr* result_mgr() {
         return _result_mgr.get();
     }
+    RuntimeFilterMgr* runtime_filter_mgr() {
+        return _runtime_filter_mgr.get();
+    }
     BackendServiceClientCache* client_cache() {
         return _client_cache.get();
     }
@@ -113,6 +117,10 @@ public:
     ThreadPool* etl_thread_pool() {
         return _etl_thread_pool.get();
     }
+    // NULL if parallel aggregation is disabled.
+    ThreadPool* aggregation_thread_pool() {
+        return _aggregation_thread_pool.get();
+    }
     CgroupsMgr* cgroups_mgr() {
         return _cgroups_mgr.get();
     }
@@ -169,6 +177,7 @@ private:
     // Leave protected so that subclasses can override
     boost::scoped_ptr<DataStreamMgr> _stream_mgr;
     boost::scoped_ptr<ResultBufferMgr> _result_mgr;
+    boost::scoped_ptr<RuntimeFilterMgr> _runtime_filter_mgr;
     boost::scoped_ptr<BackendServiceClientCache> _client_cache;
     boost::scoped_ptr<FrontendServiceClientCache> _frontend_client_cache;
     std::unique_ptr<BrokerServiceClientCache>_broker_client_cache;
@@ -180,6 +189,7 @@ private:
     boost::scoped_ptr<ThreadResourceMgr> _thread_mgr;
     boost::scoped_ptr<PriorityThreadPool> _thread_pool;
     boost::scoped_ptr<ThreadPool> _etl_thread_pool;
+    boost::scoped_ptr<ThreadPool> _aggregation_thread_pool;
     boost::scoped_ptr<CgroupsMgr> _cgroups_mgr;
     boost::scoped_ptr<FragmentMgr> _fragment_mgr;
     boost::scoped_ptr<TMasterInfo> _master_info;
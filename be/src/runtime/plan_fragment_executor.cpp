@@ -31,6 +31,9 @@
 #include "exec/data_sink.h"
 #include "exec/exec_node.h"
 #include "exec/exchange_node.h"
+#include "exec/hash_join_node.h"
+#include "exec/olap_scan_node.h"
+#include "exec/partitioned_hash_join_node.h"
 #include "exec/scan_node.h"
 #include "exprs/expr.h"
 #include "runtime/descriptors.h"
@@ -163,6 +166,30 @@ Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
         static_cast<ExchangeNode*>(exch_node)->set_num_senders(num_senders);
     }
 
+    // set the other ends of runtime filters before calling Prepare()
+    if (params.__isset.runtime_filter_destinations) {
+        std::vector<ExecNode*> join_nodes;
+        _plan->collect_nodes(TPlanNodeType::HASH_JOIN_NODE, &join_nodes);
+        BOOST_FOREACH(ExecNode * join_node, join_nodes) {
+            HashJoinNode* hash_join_node = dynamic_cast<HashJoinNode*>(join_node);
+            if (hash_join_node != NULL) {
+                hash_join_node->set_runtime_filter_destinations(
+                    params.runtime_filter_destinations);
+            } else {
+                static_cast<PartitionedHashJoinNode*>(join_node)->set_runtime_filter_destinations(
+                    params.runtime_filter_destinations);
+            }
+        }
+    }
+    if (params.__isset.runtime_filter_num_producers) {
+        std::vector<ExecNode*> olap_scan_nodes;
+        _plan->collect_nodes(TPlanNodeType::OLAP_SCAN_NODE, &olap_scan_nodes);
+        BOOST_FOREACH(ExecNode * olap_scan_node, olap_scan_nodes) {
+            static_cast<OlapScanNode*>(olap_scan_node)->set_runtime_filter_num_producers(
+                params.runtime_filter_num_producers);
+        }
+    }
+
     RETURN_IF_ERROR(_plan->prepare(_runtime_state.get()));
 
     // set scan ranges
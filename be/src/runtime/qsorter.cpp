@@ -50,13 +50,13 @@ TupleRowLessThan::TupleRowLessThan(
 }
 
 // Return true only when lhs less than rhs
-// nullptr is the positive infinite
+// nullptr is the negative infinite
 bool TupleRowLessThan::operator()(TupleRow* const& lhs, TupleRow* const& rhs) const {
     for (int i = 0; i < _lhs_expr_ctxs.size(); ++i) {
         void* lhs_value = _lhs_expr_ctxs[i]->get_value(lhs);
         void* rhs_value = _rhs_expr_ctxs[i]->get_value(rhs);
 
-        // NULL's always go at the end regardless of asc/desc
+        // NULL's always go at the beginning
         if (lhs_value == nullptr && rhs_value == nullptr) {
             continue;
         }
@@ -137,6 +137,16 @@ Status QSorter::get_next(RowBatch* batch, bool* eos) {
     return Status::OK;
 }
 
+int64_t QSorter::mem_usage() const {
+    return _tuple_pool->total_allocated_bytes() + _sorted_rows.capacity() * sizeof(TupleRow*);
+}
+
+void QSorter::reset() {
+    _sorted_rows.clear();
+    _next_iter = _sorted_rows.begin();
+    _tuple_pool->clear();
+}
+
 Status QSorter::close(RuntimeState* state) {
     _tuple_pool.reset();
     Expr::close(_lhs_expr_ctxs, state);
@@ -62,6 +62,14 @@ public:
     virtual Status get_next(RowBatch* batch, bool* eos);
 
     virtual Status close(RuntimeState* state);
+
+    // Bytes of row data and row pointers held by this sorter.
+    int64_t mem_usage() const;
+
+    // Drop all the rows added, memory chunks are kept to sort the next run.
+    // Rows returned by 'get_next' before are invalid after this call.
+    void reset();
+
     // hll merge will create
     MemPool* get_mem_pool() { 
         return _tuple_pool.get(); 
@@ -0,0 +1,157 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/runtime_filter_mgr.h"
+
+#include "common/config.h"
+#include "gen_cpp/BackendService.h"
+#include "runtime/client_cache.h"
+#include "runtime/exec_env.h"
+#include "util/debug_util.h"
+
+namespace palo {
+
+// Filters unregistered or never registered for this long are no longer expected.
+static const int RUNTIME_FILTER_STATE_EXPIRE_SECONDS = 600;
+
+RuntimeFilterMgr::RuntimeFilterMgr(ExecEnv* exec_env) : _exec_env(exec_env) {
+}
+
+RuntimeFilterMgr::~RuntimeFilterMgr() {
+}
+
+void RuntimeFilterMgr::register_filter(
+        const TUniqueId& fragment_instance_id, int filter_id, int num_producers) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    gc_states();
+    FilterState& state = _states[std::make_pair(fragment_instance_id, filter_id)];
+    state.num_producers = num_producers;
+}
+
+void RuntimeFilterMgr::publish(
+        const TUniqueId& fragment_instance_id, int filter_id, const TRuntimeFilter& filter) {
+    {
+        boost::lock_guard<boost::mutex> l(_lock);
+        FilterKey key = std::make_pair(fragment_instance_id, filter_id);
+        FilterMap::iterator iter = _states.find(key);
+        if (iter == _states.end()) {
+            gc_states();
+            iter = _states.insert(std::make_pair(key, FilterState())).first;
+        }
+        if (iter->second.is_done) {
+            VLOG(1) << "drop runtime filter " << filter_id << " published too late to "
+                    << print_id(fragment_instance_id);
+            return;
+        }
+        iter->second.filters.push_back(filter);
+    }
+    _filter_published_cv.notify_all();
+}
+
+bool RuntimeFilterMgr::wait_for(
+        const TUniqueId& fragment_instance_id, int filter_id,
+        const boost::system_time& deadline, std::vector<TRuntimeFilter>* filters) {
+    boost::unique_lock<boost::mutex> l(_lock);
+    FilterKey key = std::make_pair(fragment_instance_id, filter_id);
+    while (true) {
+        FilterMap::iterator iter = _states.find(key);
+        if (iter == _states.end() || iter->second.num_producers < 0
+                || iter->second.is_done) {
+            return false;
+        }
+        if (iter->second.filters.size() >= iter->second.num_producers) {
+            *filters = iter->second.filters;
+            return true;
+        }
+        if (boost::get_system_time() >= deadline) {
+            return false;
+        }
+        _filter_published_cv.timed_wait(l, deadline);
+    }
+}
+
+void RuntimeFilterMgr::unregister_filter(const TUniqueId& fragment_instance_id, int filter_id) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    FilterState& state = _states[std::make_pair(fragment_instance_id, filter_id)];
+    state.is_done = true;
+    state.update_time = time(NULL);
+    state.filters.clear();
+}
+
+void RuntimeFilterMgr::send(int filter_id, const TRuntimeFilter& filter,
+                            const std::vector<TPlanFragmentDestination>& destinations) {
+    TPublishRuntimeFilterParams params;
+    params.protocol_version = PaloInternalServiceVersion::V1;
+    params.filter_id = filter_id;
+    params.filter = filter;
+    for (int i = 0; i < destinations.size(); ++i) {
+        params.dest_fragment_instance_id = destinations[i].fragment_instance_id;
+        send(destinations[i], params);
+    }
+}
+
+void RuntimeFilterMgr::send(const TPlanFragmentDestination& destination,
+                            const TPublishRuntimeFilterParams& params) {
+    const TNetworkAddress& address = destination.server;
+    if (address.hostname == *_exec_env->local_ip() && address.port == config::be_port) {
+        publish(params.dest_fragment_instance_id, params.filter_id, params.filter);
+        return;
+    }
+
+    Status status;
+    BackendServiceConnection client(_exec_env->client_cache(), address, 500, &status);
+    if (!status.ok()) {
+        LOG(WARNING) << "Failed to connect to " << address.hostname << ":" << address.port
+                     << " to publish runtime filter: " << status.get_error_msg();
+        return;
+    }
+    TPublishRuntimeFilterResult result;
+    try {
+        try {
+            client->publish_runtime_filter(result, params);
+        } catch (apache::thrift::transport::TTransportException& e) {
+            status = client.reopen(500);
+            if (!status.ok()) {
+                LOG(WARNING) << "Failed to reconnect to " << address.hostname << ":"
+                             << address.port << " to publish runtime filter: "
+                             << status.get_error_msg();
+                return;
+            }
+            client->publish_runtime_filter(result, params);
+        }
+    } catch (apache::thrift::TException& e) {
+        LOG(WARNING) << "Failed to publish runtime filter to " << address.hostname << ":"
+                     << address.port << ": " << e.what();
+    }
+}
+
+void RuntimeFilterMgr::gc_states() {
+    time_t expire_time = time(NULL) - RUNTIME_FILTER_STATE_EXPIRE_SECONDS;
+    FilterMap::iterator iter = _states.begin();
+    while (iter != _states.end()) {
+        const FilterState& state = iter->second;
+        if ((state.is_done || state.num_producers < 0) && state.update_time < expire_time) {
+            _states.erase(iter++);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_RUNTIME_FILTER_MGR_H
+#define BDG_PALO_BE_RUNTIME_RUNTIME_FILTER_MGR_H
+
+#include <time.h>
+
+#include <map>
+#include <vector>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread_time.hpp>
+
+#include "common/status.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "gen_cpp/Types_types.h"
+
+namespace palo {
+
+class ExecEnv;
+
+// Collects the runtime filters published by the instances of partitioned hash joins
+// for the scan nodes of this backend, by fragment instance id and filter id.
+//
+// A scan node registers the filter with the number of hash join instances building
+// it, waits until all of them published their filter or a timeout passed, and
+// unregisters the filter. As the fragments of a query start independently, a
+// filter may be published before the scan node registers it, it is kept until
+// then. Filters published after the scan node unregistered are dropped.
+//
+// It also sends the filters of the hash joins of this backend to the others.
+class RuntimeFilterMgr {
+public:
+    RuntimeFilterMgr(ExecEnv* exec_env);
+    ~RuntimeFilterMgr();
+
+    // Sends the filter built by one hash join instance to the instances applying it.
+    // Best effort, failures are only logged as the scan nodes do not wait longer than
+    // config::runtime_filter_wait_time_ms for the filter anyway.
+    void send(int filter_id, const TRuntimeFilter& filter,
+              const std::vector<TPlanFragmentDestination>& destinations);
+
+    void register_filter(const TUniqueId& fragment_instance_id, int filter_id,
+                         int num_producers);
+
+    // Adds the filter of one hash join instance, called by RPC.
+    void publish(const TUniqueId& fragment_instance_id, int filter_id,
+                 const TRuntimeFilter& filter);
+
+    // Waits until all the instances of the registered filter published it or
+    // 'deadline' passed. Returns true and the published filters in 'filters' in
+    // the former case.
+    bool wait_for(const TUniqueId& fragment_instance_id, int filter_id,
+                  const boost::system_time& deadline, std::vector<TRuntimeFilter>* filters);
+
+    // Frees the published filters, later ones are dropped.
+    void unregister_filter(const TUniqueId& fragment_instance_id, int filter_id);
+
+private:
+    struct FilterState {
+        FilterState() : num_producers(-1), is_done(false), update_time(time(NULL)) {}
+
+        // -1 until the scan node registered the filter.
+        int num_producers;
+        // Set once the scan node unregistered the filter.
+        bool is_done;
+        // When the state was created or unregistered.
+        time_t update_time;
+        std::vector<TRuntimeFilter> filters;
+    };
+
+    typedef std::pair<TUniqueId, int> FilterKey;
+
+    // less-than ordering for FilterKey
+    struct ComparisonOp {
+        bool operator()(const FilterKey& a, const FilterKey& b) const {
+            if (a.first.hi != b.first.hi) {
+                return a.first.hi < b.first.hi;
+            }
+            if (a.first.lo != b.first.lo) {
+                return a.first.lo < b.first.lo;
+            }
+            return a.second < b.second;
+        }
+    };
+
+    typedef std::map<FilterKey, FilterState, ComparisonOp> FilterMap;
+
+    // Erases the states which were never registered, e.g. because the scan node was
+    // cancelled before, or were unregistered, once they are old enough not to get
+    // any filter any more. Assumes _lock is held.
+    void gc_states();
+
+    // Publishes the filter to one instance by RPC, or directly if it runs here.
+    void send(const TPlanFragmentDestination& destination,
+              const TPublishRuntimeFilterParams& params);
+
+    ExecEnv* _exec_env;
+
+    boost::mutex _lock;
+    // Notified whenever a filter is published.
+    boost::condition_variable _filter_published_cv;
+    FilterMap _states;
+};
+
+}
+
+#endif
@@ -56,6 +56,7 @@ RuntimeState::RuntimeState(
             _root_node_id(-1),
             _num_rows_load_success(0),
             _num_rows_load_filtered(0),
+            _segment_prefetch_inflight_bytes(0),
             _normal_row_number(0),
             _error_row_number(0),
             _error_log_file(nullptr) {
@@ -79,6 +80,7 @@ RuntimeState::RuntimeState(
             _root_node_id(-1),
             _num_rows_load_success(0),
             _num_rows_load_filtered(0),
+            _segment_prefetch_inflight_bytes(0),
             _normal_row_number(0),
             _error_row_number(0),
             _error_log_file(nullptr) {
@@ -91,7 +93,8 @@ RuntimeState::RuntimeState(const std::string& now)
       _data_stream_recvrs_pool(new ObjectPool()),
       _unreported_error_idx(0),
       _profile(_obj_pool.get(), "<unnamed>"),
-      _per_fragment_instance_idx(0) {
+      _per_fragment_instance_idx(0),
+      _segment_prefetch_inflight_bytes(0) {
     _query_options.batch_size = DEFAULT_BATCH_SIZE;
     _now.reset(new DateTimeValue());
     _now->from_date_str(now.c_str(), now.size());
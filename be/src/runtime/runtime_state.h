@@ -450,6 +450,12 @@ public:
     void update_num_rows_load_filtered(int64_t num_rows) {
         _num_rows_load_filtered.fetch_add(num_rows);
     }
+
+    // Bytes being prefetched by all segment readers of this fragment instance,
+    // bounded by config::segment_prefetch_max_inflight_bytes.
+    std::atomic<int64_t>* segment_prefetch_inflight_bytes() {
+        return &_segment_prefetch_inflight_bytes;
+    }
     void export_load_error(const std::string& error_msg);
 
     void set_per_fragment_instance_idx(int idx) {
@@ -564,6 +570,7 @@ private:
     std::vector<std::string> _output_files;
     std::atomic<int64_t> _num_rows_load_success;
     std::atomic<int64_t> _num_rows_load_filtered;
+    std::atomic<int64_t> _segment_prefetch_inflight_bytes;
 
     std::vector<std::string> _export_output_files;
 
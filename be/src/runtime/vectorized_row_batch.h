@@ -47,11 +47,7 @@ struct BackupInfo {
 
 class ColumnVector {
 public:
-    virtual ~ColumnVector() {
-        //if (NULL == _is_null) {
-            //delete _is_null;
-        //}
-    }
+    virtual ~ColumnVector() {}
 
     inline bool is_repeating() {
         return _is_repeating;
@@ -81,11 +77,27 @@ public:
     void set_byte_size(int byte_size) {
         _byte_size = byte_size;
     }
+
+    // _is_null is only valid when _no_nulls is false, it is allocated
+    // from the batch's mem pool and has one entry per row.
+    inline bool no_nulls() const {
+        return _no_nulls;
+    }
+    void set_no_nulls(bool no_nulls) {
+        _no_nulls = no_nulls;
+    }
+
+    inline bool* is_null() const {
+        return _is_null;
+    }
+    void set_is_null(bool* is_null) {
+        _is_null = is_null;
+    }
 private:
     ColumnVector(int size) {
         _is_repeating = false;
-        //_no_nulls = true;
-        //_is_null = new bool[size];
+        _no_nulls = true;
+        _is_null = NULL;
         _col_data = NULL;
         _col_string_data = NULL;
         _byte_size = 0;
@@ -95,9 +107,8 @@ private:
     void* _col_string_data;
     int _byte_size;
     bool _is_repeating;
-    // this is no null in palo now
-    //bool _no_nulls;
-    //bool* _is_null;
+    bool _no_nulls;
+    bool* _is_null;
 };
 
 class VectorizedRowBatch : public RowBatchInterface {
@@ -207,6 +218,10 @@ public:
         _selected_in_use = false;
         _row_iter = 0;
         _columns.erase(_columns.begin() + _num_cols, _columns.end());
+        for (int i = 0; i < _num_cols; ++i) {
+            _columns[i]->set_no_nulls(true);
+            _columns[i]->set_is_null(NULL);
+        }
         _mem_pool.clear();
         _selected = reinterpret_cast<int*>(_mem_pool.allocate(sizeof(int) * _capacity));
     }
@@ -34,6 +34,7 @@
 #include "runtime/pull_load_task_mgr.h"
 #include "runtime/export_task_mgr.h"
 #include "runtime/result_buffer_mgr.h"
+#include "runtime/runtime_filter_mgr.h"
 #include "service/receiver_dispatcher.h"
 
 namespace palo {
@@ -166,6 +167,15 @@ void BackendService::transmit_data(TTransmitDataResult& return_val,
     }
 }
 
+void BackendService::publish_runtime_filter(TPublishRuntimeFilterResult& return_val,
+                                            const TPublishRuntimeFilterParams& params) {
+    VLOG_ROW << "publish_runtime_filter(): instance_id=" << params.dest_fragment_instance_id
+             << " filter_id=" << params.filter_id;
+    _exec_env->runtime_filter_mgr()->publish(
+            params.dest_fragment_instance_id, params.filter_id, params.filter);
+    Status::OK.set_t_status(&return_val);
+}
+
 void BackendService::fetch_data(TFetchDataResult& return_val,
                                 const TFetchDataParams& params) {
     // maybe hang in this function
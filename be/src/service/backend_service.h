@@ -126,6 +126,9 @@ public:
     virtual void transmit_data(TTransmitDataResult& return_val,
                                const TTransmitDataParams& params);
 
+    virtual void publish_runtime_filter(TPublishRuntimeFilterResult& return_val,
+                                        const TPublishRuntimeFilterParams& params);
+
     virtual void fetch_data(TFetchDataResult& return_val,
                             const TFetchDataParams& params);
 
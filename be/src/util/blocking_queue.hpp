@@ -126,6 +126,21 @@ public:
         return true;
     }
 
+    // Puts an element into the queue only if there is space, never waits.
+    // Returns false if the queue is full or shut down.
+    bool try_put(const T& val) {
+        boost::unique_lock<boost::mutex> unique_lock(_lock);
+
+        if (_list.size() >= _max_elements || _shutdown) {
+            return false;
+        }
+
+        _list.push_back(val);
+        unique_lock.unlock();
+        _get_cv.notify_one();
+        return true;
+    }
+
     // Shut down the queue. Wakes up all threads waiting on BlockingGet or BlockingPut.
     void shutdown() {
         {
@@ -49,6 +49,12 @@ public:
     // Initialize CpuInfo.
     static void init();
 
+    // Returns whether init() has been called. Code that may run before init(),
+    // e.g. in unit tests, checks this before querying hardware flags.
+    static bool initialized() {
+        return _s_initialized;
+    }
+
     // Returns all the flags for this cpu
     static int64_t hardware_flags() {
         DCHECK(_s_initialized);
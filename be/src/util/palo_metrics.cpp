@@ -36,6 +36,8 @@ const char* MEM_POOL_TOTAL_BYTES = "palo_be.mem_pool.total_bytes";
 const char* HASH_TABLE_TOTAL_BYTES = "palo_be.hash_table.total_bytes";
 const char* OLAP_LRU_CACHE_LOOKUP_COUNT = "palo_be.olap.lru_cache.lookup_count";
 const char* OLAP_LRU_CACHE_HIT_COUNT = "palo_be.olap.lru_cache.hit_count";
+const char* PAGE_CACHE_LOOKUP_COUNT = "palo_be.olap.page_cache.lookup_count";
+const char* PAGE_CACHE_HIT_COUNT = "palo_be.olap.page_cache.hit_count";
 const char* PALO_PUSH_COUNT = "palo_be.olap.push_count";
 const char* PALO_FETCH_COUNT = "palo_be.olap.fetch_count";
 const char* PALO_REQUEST_COUNT = "palo_be.olap.request_count";
@@ -73,6 +75,8 @@ IntGauge* PaloMetrics::_s_mem_pool_total_bytes = NULL;
 IntGauge* PaloMetrics::_s_hash_table_total_bytes = NULL;
 IntCounter* PaloMetrics::_s_olap_lru_cache_lookup_count = NULL;
 IntCounter* PaloMetrics::_s_olap_lru_cache_hit_count = NULL;
+IntCounter* PaloMetrics::_s_page_cache_lookup_count = NULL;
+IntCounter* PaloMetrics::_s_page_cache_hit_count = NULL;
 IntCounter* PaloMetrics::_s_palo_push_count = NULL;
 IntCounter* PaloMetrics::_s_palo_fetch_count = NULL;
 IntCounter* PaloMetrics::_s_palo_request_count = NULL;
@@ -118,6 +122,8 @@ void PaloMetrics::create_metrics(MetricGroup* m) {
     // Initialize olap metrics
     _s_olap_lru_cache_lookup_count = m->AddCounter(OLAP_LRU_CACHE_LOOKUP_COUNT, 0L);
     _s_olap_lru_cache_hit_count = m->AddCounter(OLAP_LRU_CACHE_HIT_COUNT, 0L);
+    _s_page_cache_lookup_count = m->AddCounter(PAGE_CACHE_LOOKUP_COUNT, 0L);
+    _s_page_cache_hit_count = m->AddCounter(PAGE_CACHE_HIT_COUNT, 0L);
 
     // Initialize push_count, fetch_count, request_count metrics
     _s_palo_push_count = m->AddCounter(PALO_PUSH_COUNT, 0L);
@@ -64,6 +64,12 @@ public:
     static IntCounter* olap_lru_cache_hit_count() {
         return _s_olap_lru_cache_hit_count;
     }
+    static IntCounter* page_cache_lookup_count() {
+        return _s_page_cache_lookup_count;
+    }
+    static IntCounter* page_cache_hit_count() {
+        return _s_page_cache_hit_count;
+    }
     static IntCounter* palo_push_count() {
         return _s_palo_push_count;
     }
@@ -133,6 +139,8 @@ private:
     static IntGauge* _s_hash_table_total_bytes;
     static IntCounter* _s_olap_lru_cache_lookup_count;
     static IntCounter* _s_olap_lru_cache_hit_count;
+    static IntCounter* _s_page_cache_lookup_count;
+    static IntCounter* _s_page_cache_hit_count;
     static IntCounter* _s_palo_push_count;
     static IntCounter* _s_palo_fetch_count;
     static IntCounter* _s_palo_request_count;
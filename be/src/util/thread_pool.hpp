@@ -75,6 +75,12 @@ public:
         return _work_queue.blocking_put(func);
     }
 
+    // Non-blocking version of offer. Returns false if the queue is full or the thread
+    // pool has been shut down, in which case the work item is not queued.
+    bool try_offer(WorkFunction func) {
+        return _work_queue.try_put(func);
+    }
+
     // Shuts the thread pool down, causing the work queue to cease accepting offered work
     // and the worker threads to terminate once they have processed their current work item.
     // Returns once the shutdown flag has been set, does not wait for the threads to
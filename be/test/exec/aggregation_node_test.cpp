@@ -0,0 +1,541 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/aggregation_node.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "common/object_pool.h"
+#include "exec/hash_table.hpp"
+#include "gen_cpp/Exprs_types.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "gen_cpp/PlanNodes_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/exec_env.h"
+#include "runtime/lib_cache.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "runtime/test_env.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "testutil/desc_tbl_builder.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
+#include "util/logging.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+using boost::scoped_ptr;
+
+namespace palo {
+
+// Mangled names of the builtin aggregate functions, as FunctionSet of FE sends them.
+static const string AGG_FN_PREFIX = "_ZN4palo18AggregateFunctions";
+static const string INIT_NULL_SYMBOL =
+    "9init_nullEPN8palo_udf15FunctionContextEPNS1_6AnyValE";
+static const string INIT_ZERO_SYMBOL =
+    "9init_zeroIN8palo_udf9BigIntValEEEvPNS2_15FunctionContextEPT_";
+static const string SUM_SYMBOL =
+    "3sumIN8palo_udf9BigIntValES3_EEvPNS2_15FunctionContextERKT_PT0_";
+static const string COUNT_UPDATE_SYMBOL =
+    "12count_updateEPN8palo_udf15FunctionContextERKNS1_6AnyValEPNS1_9BigIntValE";
+static const string COUNT_MERGE_SYMBOL =
+    "11count_mergeEPN8palo_udf15FunctionContextERKNS1_9BigIntValEPS4_";
+static const string AVG_INIT_SYMBOL =
+    "8avg_initEPN8palo_udf15FunctionContextEPNS1_9StringValE";
+static const string AVG_UPDATE_SYMBOL =
+    "10avg_updateIN8palo_udf9BigIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE";
+static const string AVG_MERGE_SYMBOL =
+    "9avg_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_";
+static const string AVG_SERIALIZE_SYMBOL =
+    "32string_val_serialize_or_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE";
+static const string AVG_FINALIZE_SYMBOL =
+    "12avg_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE";
+
+// An input row: a grouping key, which may be NULL, and a value.
+struct AggTestRow {
+    bool null_key;
+    int32_t key;
+    int64_t value;
+};
+
+// Expected sum(value), count(value) and avg(value) of a group.
+struct AggTestResult {
+    int64_t sum;
+    int64_t count;
+    double avg;
+};
+
+// Groups by (is NULL, key), a NULL key has key 0.
+typedef std::pair<bool, int32_t> AggTestKey;
+
+// Returns the given rows, each row has one tuple of (key, value). Every batch is
+// created from scratch, like the batches of olap scan node. If 'cancel_after_rows' is
+// not negative, the query is cancelled once that many rows are returned.
+class AggTestDataNode : public ExecNode {
+public:
+    AggTestDataNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs,
+                    const vector<AggTestRow>* rows, int64_t cancel_after_rows) :
+            ExecNode(pool, tnode, descs),
+            _tuple_desc(descs.get_tuple_descriptor(tnode.row_tuples[0])),
+            _rows(rows),
+            _next_row(0),
+            _cancel_after_rows(cancel_after_rows) {
+    }
+
+    virtual Status open(RuntimeState* state) {
+        RETURN_IF_ERROR(ExecNode::open(state));
+        _next_row = 0;
+        return Status::OK;
+    }
+
+    virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+        const SlotDescriptor* key_slot = _tuple_desc->slots()[0];
+        const SlotDescriptor* value_slot = _tuple_desc->slots()[1];
+        while (!row_batch->at_capacity() && _next_row < _rows->size()) {
+            const AggTestRow& test_row = (*_rows)[_next_row++];
+            Tuple* tuple = Tuple::create(_tuple_desc->byte_size(), row_batch->tuple_data_pool());
+            if (test_row.null_key) {
+                tuple->set_null(key_slot->null_indicator_offset());
+            } else {
+                *reinterpret_cast<int32_t*>(tuple->get_slot(key_slot->tuple_offset())) =
+                    test_row.key;
+            }
+            *reinterpret_cast<int64_t*>(tuple->get_slot(value_slot->tuple_offset())) =
+                test_row.value;
+
+            int row_idx = row_batch->add_row();
+            row_batch->get_row(row_idx)->set_tuple(0, tuple);
+            row_batch->commit_last_row();
+        }
+        *eos = (_next_row == _rows->size());
+        if (_cancel_after_rows >= 0 && _next_row >= _cancel_after_rows) {
+            state->set_is_cancelled(true);
+        }
+        return Status::OK;
+    }
+
+private:
+    const TupleDescriptor* _tuple_desc;
+    const vector<AggTestRow>* _rows;
+    size_t _next_row;
+    int64_t _cancel_after_rows;
+};
+
+// The child is attached directly instead of creating the plan tree from thrift.
+class TestAggregationNode : public AggregationNode {
+public:
+    TestAggregationNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
+            AggregationNode(pool, tnode, descs) {
+    }
+
+    void add_child(ExecNode* child) {
+        _children.push_back(child);
+    }
+};
+
+// select key, sum(value), count(value), avg(value) from input group by key
+class AggregationNodeTest : public testing::Test {
+public:
+    AggregationNodeTest() : _desc_tbl(NULL), _agg_node(NULL) {}
+    // a null dtor to pass codestyle check
+    ~AggregationNodeTest() {}
+
+protected:
+    virtual void SetUp() {
+        _parallel_threads = config::aggregation_parallel_threads;
+        _pool_thread_num = config::aggregation_thread_pool_thread_num;
+        _pool_queue_size = config::aggregation_thread_pool_queue_size;
+
+        // tuple 0 is the input, tuple 1 the intermediate and tuple 2 the output tuple
+        DescriptorTblBuilder builder(&_pool);
+        builder.declare_tuple() << TYPE_INT << TYPE_BIGINT;
+        builder.declare_tuple() << TYPE_INT << TYPE_BIGINT << TYPE_BIGINT
+            << TypeDescriptor::create_varchar_type(16);
+        builder.declare_tuple() << TYPE_INT << TYPE_BIGINT << TYPE_BIGINT << TYPE_DOUBLE;
+        _desc_tbl = builder.build();
+    }
+
+    virtual void TearDown() {
+        _agg_node = NULL;
+        _runtime_state.reset();
+        _pool.clear();
+        _test_env.reset();
+        config::aggregation_parallel_threads = _parallel_threads;
+        config::aggregation_thread_pool_thread_num = _pool_thread_num;
+        config::aggregation_thread_pool_queue_size = _pool_queue_size;
+    }
+
+    // The aggregation thread pool of ExecEnv is created from the config, so the config
+    // is set before the test env is created.
+    void init_env(int parallel_threads, int pool_thread_num, int pool_queue_size,
+                  int64_t mem_limit) {
+        config::aggregation_parallel_threads = parallel_threads;
+        config::aggregation_thread_pool_thread_num = pool_thread_num;
+        config::aggregation_thread_pool_queue_size = pool_queue_size;
+        _test_env.reset(new TestEnv());
+
+        TExecPlanFragmentParams params;
+        params.params.query_id.hi = 0;
+        params.params.query_id.lo = 0;
+        TQueryOptions query_options;
+        if (mem_limit > 0) {
+            query_options.__set_mem_limit(mem_limit);
+        }
+        _runtime_state.reset(
+            new RuntimeState(params, query_options, "", _test_env->exec_env()));
+        ASSERT_TRUE(_runtime_state->init_mem_trackers(TUniqueId()).ok());
+        _runtime_state->set_desc_tbl(_desc_tbl);
+    }
+
+    // 'num_rows' rows over 'num_groups' keys, every 97th row has a NULL key.
+    static void generate_rows(int num_rows, int num_groups, vector<AggTestRow>* rows) {
+        for (int i = 0; i < num_rows; ++i) {
+            AggTestRow row = { i % 97 == 0, i % num_groups, i };
+            rows->push_back(row);
+        }
+    }
+
+    static void expected_results(const vector<AggTestRow>& rows,
+                                 map<AggTestKey, AggTestResult>* results) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            AggTestKey key(rows[i].null_key, rows[i].null_key ? 0 : rows[i].key);
+            AggTestResult& result = (*results)[key];
+            result.sum += rows[i].value;
+            result.count += 1;
+        }
+        for (map<AggTestKey, AggTestResult>::iterator it = results->begin();
+                it != results->end(); ++it) {
+            it->second.avg = static_cast<double>(it->second.sum) / it->second.count;
+        }
+    }
+
+    static TExpr slot_ref(const SlotDescriptor* slot_desc) {
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::SLOT_REF);
+        node.__set_type(slot_desc->type().to_thrift());
+        node.__set_num_children(0);
+        TSlotRef slot_ref;
+        slot_ref.__set_slot_id(slot_desc->id());
+        slot_ref.__set_tuple_id(slot_desc->parent());
+        node.__set_slot_ref(slot_ref);
+
+        TExpr expr;
+        expr.nodes.push_back(node);
+        return expr;
+    }
+
+    // Aggregate function 'name' over 'input', serialize and finalize are optional.
+    static TExpr agg_fn(const string& name, const SlotDescriptor* input,
+                        const TypeDescriptor& intermediate_type,
+                        const TypeDescriptor& ret_type,
+                        const string& init_fn, const string& update_fn,
+                        const string& merge_fn, const string& serialize_fn,
+                        const string& finalize_fn) {
+        TAggregateFunction aggregate_fn;
+        aggregate_fn.__set_intermediate_type(intermediate_type.to_thrift());
+        aggregate_fn.__set_init_fn_symbol(AGG_FN_PREFIX + init_fn);
+        aggregate_fn.__set_update_fn_symbol(AGG_FN_PREFIX + update_fn);
+        aggregate_fn.__set_merge_fn_symbol(AGG_FN_PREFIX + merge_fn);
+        if (!serialize_fn.empty()) {
+            aggregate_fn.__set_serialize_fn_symbol(AGG_FN_PREFIX + serialize_fn);
+        }
+        if (!finalize_fn.empty()) {
+            aggregate_fn.__set_finalize_fn_symbol(AGG_FN_PREFIX + finalize_fn);
+        }
+
+        TFunctionName fn_name;
+        fn_name.__set_function_name(name);
+        TFunction fn;
+        fn.__set_name(fn_name);
+        fn.__set_binary_type(TFunctionBinaryType::BUILTIN);
+        fn.__set_arg_types(vector<TTypeDesc>(1, input->type().to_thrift()));
+        fn.__set_ret_type(ret_type.to_thrift());
+        fn.__set_has_var_args(false);
+        fn.__set_aggregate_fn(aggregate_fn);
+
+        TAggregateExpr agg_expr;
+        agg_expr.__set_is_merge_agg(false);
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::AGG_EXPR);
+        node.__set_type(ret_type.to_thrift());
+        node.__set_num_children(1);
+        node.__set_fn(fn);
+        node.__set_agg_expr(agg_expr);
+
+        TExpr expr;
+        expr.nodes.push_back(node);
+        TExpr input_expr = slot_ref(input);
+        expr.nodes.push_back(input_expr.nodes[0]);
+        return expr;
+    }
+
+    static TPlanNode plan_node(int node_id, TPlanNodeType::type node_type, TTupleId tuple_id) {
+        TPlanNode tnode;
+        tnode.__set_node_id(node_id);
+        tnode.__set_node_type(node_type);
+        tnode.__set_num_children(0);
+        tnode.__set_limit(-1);
+        tnode.__set_row_tuples(vector<TTupleId>(1, tuple_id));
+        tnode.__set_nullable_tuples(vector<bool>(1, false));
+        tnode.__set_compact_data(false);
+        return tnode;
+    }
+
+    // Creates, prepares and opens the aggregation node over 'rows', returns the status
+    // of open(). The child cancels the query after 'cancel_after_rows' rows if it is not
+    // negative.
+    Status open_agg_node(const vector<AggTestRow>& rows, int64_t cancel_after_rows = -1) {
+        // Parallel aggregation is only used over olap scan node.
+        TPlanNode child_tnode = plan_node(0, TPlanNodeType::OLAP_SCAN_NODE, 0);
+        ExecNode* child = _pool.add(new AggTestDataNode(
+                    &_pool, child_tnode, *_desc_tbl, &rows, cancel_after_rows));
+
+        const TupleDescriptor* input_desc = _desc_tbl->get_tuple_descriptor(0);
+        const SlotDescriptor* key_slot = input_desc->slots()[0];
+        const SlotDescriptor* value_slot = input_desc->slots()[1];
+        TAggregationNode agg_node;
+        agg_node.grouping_exprs.push_back(slot_ref(key_slot));
+        agg_node.__isset.grouping_exprs = true;
+        agg_node.aggregate_functions.push_back(agg_fn(
+                "sum", value_slot, TYPE_BIGINT, TYPE_BIGINT,
+                INIT_NULL_SYMBOL, SUM_SYMBOL, SUM_SYMBOL, "", ""));
+        agg_node.aggregate_functions.push_back(agg_fn(
+                "count", value_slot, TYPE_BIGINT, TYPE_BIGINT,
+                INIT_ZERO_SYMBOL, COUNT_UPDATE_SYMBOL, COUNT_MERGE_SYMBOL, "", ""));
+        agg_node.aggregate_functions.push_back(agg_fn(
+                "avg", value_slot, TypeDescriptor::create_varchar_type(16), TYPE_DOUBLE,
+                AVG_INIT_SYMBOL, AVG_UPDATE_SYMBOL, AVG_MERGE_SYMBOL,
+                AVG_SERIALIZE_SYMBOL, AVG_FINALIZE_SYMBOL));
+        agg_node.__set_intermediate_tuple_id(1);
+        agg_node.__set_output_tuple_id(2);
+        agg_node.__set_need_finalize(true);
+
+        TPlanNode tnode = plan_node(1, TPlanNodeType::AGGREGATION_NODE, 2);
+        tnode.__set_num_children(1);
+        tnode.__set_agg_node(agg_node);
+
+        TestAggregationNode* node = _pool.add(new TestAggregationNode(&_pool, tnode, *_desc_tbl));
+        node->add_child(child);
+        _agg_node = node;
+
+        RETURN_IF_ERROR(child->init(child_tnode));
+        RETURN_IF_ERROR(node->init(tnode));
+        RETURN_IF_ERROR(node->prepare(_runtime_state.get()));
+        return node->open(_runtime_state.get());
+    }
+
+    void get_results(map<AggTestKey, AggTestResult>* results) {
+        const TupleDescriptor* output_desc = _desc_tbl->get_tuple_descriptor(2);
+        const vector<SlotDescriptor*>& slots = output_desc->slots();
+        RowBatch batch(_agg_node->row_desc(), _runtime_state->batch_size(),
+                       _runtime_state->instance_mem_tracker());
+        bool eos = false;
+        while (!eos) {
+            Status status = _agg_node->get_next(_runtime_state.get(), &batch, &eos);
+            ASSERT_TRUE(status.ok()) << status.get_error_msg();
+            for (int i = 0; i < batch.num_rows(); ++i) {
+                Tuple* tuple = batch.get_row(i)->get_tuple(0);
+                bool null_key = tuple->is_null(slots[0]->null_indicator_offset());
+                AggTestKey key(null_key, null_key ?
+                        0 : *reinterpret_cast<int32_t*>(tuple->get_slot(slots[0]->tuple_offset())));
+                ASSERT_EQ(0, results->count(key));
+                AggTestResult& result = (*results)[key];
+                result.sum = *reinterpret_cast<int64_t*>(tuple->get_slot(slots[1]->tuple_offset()));
+                result.count = *reinterpret_cast<int64_t*>(
+                        tuple->get_slot(slots[2]->tuple_offset()));
+                result.avg = *reinterpret_cast<double*>(tuple->get_slot(slots[3]->tuple_offset()));
+            }
+            batch.reset();
+        }
+    }
+
+    void check_results(const vector<AggTestRow>& rows) {
+        map<AggTestKey, AggTestResult> expected;
+        expected_results(rows, &expected);
+        map<AggTestKey, AggTestResult> results;
+        get_results(&results);
+        ASSERT_EQ(expected.size(), results.size());
+        for (map<AggTestKey, AggTestResult>::iterator it = expected.begin();
+                it != expected.end(); ++it) {
+            ASSERT_EQ(1, results.count(it->first));
+            const AggTestResult& result = results[it->first];
+            EXPECT_EQ(it->second.sum, result.sum);
+            EXPECT_EQ(it->second.count, result.count);
+            EXPECT_DOUBLE_EQ(it->second.avg, result.avg);
+        }
+    }
+
+    // Aggregates 'rows' and checks the output, then closes the node and checks that all
+    // memory charged to its mem tracker is released.
+    void check_aggregation(const vector<AggTestRow>& rows) {
+        Status status = open_agg_node(rows);
+        ASSERT_TRUE(status.ok()) << status.get_error_msg();
+        check_results(rows);
+        ASSERT_TRUE(_agg_node->close(_runtime_state.get()).ok());
+        EXPECT_EQ(0, _agg_node->mem_tracker()->consumption());
+    }
+
+    ObjectPool _pool;
+    scoped_ptr<TestEnv> _test_env;
+    scoped_ptr<RuntimeState> _runtime_state;
+    DescriptorTbl* _desc_tbl;
+    TestAggregationNode* _agg_node;
+
+    int32_t _parallel_threads;
+    int32_t _pool_thread_num;
+    int32_t _pool_queue_size;
+};
+
+TEST_F(AggregationNodeTest, Serial) {
+    init_env(0, 16, 64, -1);
+    vector<AggTestRow> rows;
+    generate_rows(50000, 1000, &rows);
+    check_aggregation(rows);
+    EXPECT_TRUE(_agg_node->_parallel_states.empty());
+}
+
+// Every thread aggregates into its own hash table, the tables are merged partition by
+// partition, and the result is the same as the serial aggregation.
+TEST_F(AggregationNodeTest, ThreadLocalTablesMergedByPartition) {
+    const int num_threads = 4;
+    init_env(num_threads, 16, 64, -1);
+    vector<AggTestRow> rows;
+    generate_rows(100000, 5000, &rows);
+    map<AggTestKey, AggTestResult> expected;
+    expected_results(rows, &expected);
+
+    Status status = open_agg_node(rows);
+    ASSERT_TRUE(status.ok()) << status.get_error_msg();
+    ASSERT_EQ(num_threads, _agg_node->_parallel_states.size());
+
+    int64_t num_input_rows = 0;
+    int64_t num_merged_rows = 0;
+    int64_t bytes = 0;
+    for (int i = 0; i < num_threads; ++i) {
+        AggregationNode::ParallelAggState* agg_state = _agg_node->_parallel_states[i];
+        EXPECT_TRUE(agg_state->status.ok());
+        num_input_rows += agg_state->num_input_rows;
+        // Each thread local table has at most one tuple per group.
+        EXPECT_LE(agg_state->hash_tbl->size(), expected.size());
+        int64_t num_partitioned_rows = 0;
+        for (int j = 0; j < num_threads; ++j) {
+            num_partitioned_rows += agg_state->partitions[j].size();
+        }
+        EXPECT_EQ(agg_state->hash_tbl->size(), num_partitioned_rows);
+
+        // Merged table i only holds the groups of partition i.
+        HashTable* merged_tbl = agg_state->merged_tbl.get();
+        ASSERT_TRUE(merged_tbl != NULL);
+        for (HashTable::Iterator it = merged_tbl->begin(); !it.at_end(); it.next<false>()) {
+            EXPECT_EQ(i, _agg_node->partition_of(it.get_row()->get_tuple(0)));
+        }
+        num_merged_rows += merged_tbl->size();
+        bytes += agg_state->hash_tbl->byte_size() + merged_tbl->byte_size()
+            + agg_state->tuple_pool->total_allocated_bytes();
+    }
+    EXPECT_EQ(rows.size(), num_input_rows);
+    EXPECT_EQ(expected.size(), num_merged_rows);
+    // Thread local tables and pools are charged to the mem tracker of the node.
+    EXPECT_GE(_agg_node->mem_tracker()->consumption(), bytes);
+
+    check_results(rows);
+    ASSERT_TRUE(_agg_node->close(_runtime_state.get()).ok());
+    EXPECT_EQ(0, _agg_node->mem_tracker()->consumption());
+}
+
+// With a pool of one thread and a queue of one task, most tasks do not fit in the
+// pool, their states get no input and their partitions are merged by the fragment
+// thread.
+TEST_F(AggregationNodeTest, SmallThreadPool) {
+    init_env(4, 1, 1, -1);
+    ASSERT_TRUE(_test_env->exec_env()->aggregation_thread_pool() != NULL);
+    vector<AggTestRow> rows;
+    generate_rows(100000, 5000, &rows);
+    check_aggregation(rows);
+}
+
+// Without the pool the fragment thread aggregates into the first state.
+TEST_F(AggregationNodeTest, NoThreadPool) {
+    init_env(4, 0, 64, -1);
+    ASSERT_TRUE(_test_env->exec_env()->aggregation_thread_pool() == NULL);
+    vector<AggTestRow> rows;
+    generate_rows(100000, 5000, &rows);
+    check_aggregation(rows);
+    EXPECT_EQ(rows.size(), _agg_node->_parallel_states[0]->num_input_rows);
+}
+
+// Exceeding the memory limit in an aggregation thread fails open() with the error,
+// and close() still releases all memory.
+TEST_F(AggregationNodeTest, MemLimitExceeded) {
+    init_env(4, 16, 64, 4 * 1024 * 1024);
+    vector<AggTestRow> rows;
+    generate_rows(500000, 500000, &rows);
+    Status status = open_agg_node(rows);
+    ASSERT_FALSE(status.ok());
+    EXPECT_TRUE(status.is_mem_limit_exceeded()) << status.get_error_msg();
+    ASSERT_TRUE(_agg_node->close(_runtime_state.get()).ok());
+    EXPECT_EQ(0, _agg_node->mem_tracker()->consumption());
+}
+
+// Cancelling the query while the threads aggregate stops them and fails open().
+TEST_F(AggregationNodeTest, Cancelled) {
+    init_env(4, 16, 64, -1);
+    vector<AggTestRow> rows;
+    generate_rows(100000, 1000, &rows);
+    Status status = open_agg_node(rows, 20000);
+    EXPECT_TRUE(status.is_cancelled()) << status.get_error_msg();
+    int64_t num_input_rows = 0;
+    for (int i = 0; i < _agg_node->_parallel_states.size(); ++i) {
+        num_input_rows += _agg_node->_parallel_states[i]->num_input_rows;
+    }
+    EXPECT_LT(num_input_rows, rows.size());
+    ASSERT_TRUE(_agg_node->close(_runtime_state.get()).ok());
+    EXPECT_EQ(0, _agg_node->mem_tracker()->consumption());
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    palo::config::query_scratch_dirs = "/tmp";
+    palo::config::read_size = 8388608;
+    palo::config::min_buffer_size = 1024;
+
+    palo::config::disable_mem_pools = false;
+
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+
+    palo::CpuInfo::init();
+    palo::DiskInfo::init();
+    // Builtin aggregate functions are looked up in the test binary by symbol.
+    palo::LibCache::init();
+
+    return RUN_ALL_TESTS();
+}
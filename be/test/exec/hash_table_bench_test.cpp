@@ -0,0 +1,207 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "common/object_pool.h"
+#include "exec/hash_table.hpp"
+#include "exec/swiss_hash_table.h"
+#include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "exprs/slot_ref.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "util/cpu_info.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+// Compares build and probe throughput of HashTable (chained buckets over
+// TupleRows) and SwissHashTable (open addressing over int64 keys).
+// Number of rows is read from env PALO_HASH_TABLE_BENCH_ROWS, default 1M;
+// set it to e.g. 1000000000 on a machine with enough memory for 1B rows.
+class HashTableBenchTest : public testing::Test {
+public:
+    HashTableBenchTest() : _mem_pool(&_tracker) {}
+    virtual ~HashTableBenchTest() {}
+
+protected:
+    virtual void SetUp() {
+        RowDescriptor desc;
+        Expr* expr = _pool.add(new SlotRef(TYPE_BIGINT, 0));
+        _build_expr_ctxs.push_back(_pool.add(new ExprContext(expr)));
+        ASSERT_TRUE(Expr::prepare(_build_expr_ctxs, NULL, desc, &_tracker).ok());
+        ASSERT_TRUE(Expr::open(_build_expr_ctxs, NULL).ok());
+
+        expr = _pool.add(new SlotRef(TYPE_BIGINT, 0));
+        _probe_expr_ctxs.push_back(_pool.add(new ExprContext(expr)));
+        ASSERT_TRUE(Expr::prepare(_probe_expr_ctxs, NULL, desc, &_tracker).ok());
+        ASSERT_TRUE(Expr::open(_probe_expr_ctxs, NULL).ok());
+
+        _num_rows = 1024 * 1024;
+        const char* rows = getenv("PALO_HASH_TABLE_BENCH_ROWS");
+        if (rows != NULL && atoll(rows) > 0) {
+            _num_rows = atoll(rows);
+        }
+
+        // Build keys are distinct, half of the probe keys hit.
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        _build_keys.resize(_num_rows);
+        _probe_keys.resize(_num_rows);
+        for (int64_t i = 0; i < _num_rows; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            _build_keys[i] = i * 2;
+            _probe_keys[i] = (seed >> 1) % (_num_rows * 2);
+        }
+        for (int64_t i = _num_rows - 1; i > 0; --i) {
+            std::swap(_build_keys[i], _build_keys[(_probe_keys[i] >> 1) % (i + 1)]);
+        }
+    }
+
+    virtual void TearDown() {
+        Expr::close(_build_expr_ctxs, NULL);
+        Expr::close(_probe_expr_ctxs, NULL);
+        _mem_pool.free_all();
+    }
+
+    TupleRow* create_tuple_row(int64_t val) {
+        uint8_t* tuple_row_mem = _mem_pool.allocate(sizeof(int64_t*));
+        Tuple* tuple_mem = Tuple::create(sizeof(int64_t), &_mem_pool);
+        *reinterpret_cast<int64_t*>(tuple_mem) = val;
+        TupleRow* row = reinterpret_cast<TupleRow*>(tuple_row_mem);
+        row->set_tuple(0, tuple_mem);
+        return row;
+    }
+
+    void report(const char* name, int64_t build_ns, int64_t probe_ns,
+                int64_t matched, int64_t byte_size) {
+        printf("%-16s rows=%ld build=%.2fM rows/s probe=%.2fM rows/s "
+               "matched=%ld memory=%ldMB\n",
+               name, _num_rows,
+               _num_rows * 1000.0 / build_ns, _num_rows * 1000.0 / probe_ns,
+               matched, byte_size >> 20);
+    }
+
+    ObjectPool _pool;
+    MemTracker _tracker;
+    MemPool _mem_pool;
+    std::vector<ExprContext*> _build_expr_ctxs;
+    std::vector<ExprContext*> _probe_expr_ctxs;
+    int64_t _num_rows;
+    std::vector<int64_t> _build_keys;
+    std::vector<int64_t> _probe_keys;
+};
+
+TEST_F(HashTableBenchTest, ChainedHashTable) {
+    std::vector<TupleRow*> build_rows(_num_rows);
+    std::vector<TupleRow*> probe_rows(_num_rows);
+    for (int64_t i = 0; i < _num_rows; ++i) {
+        build_rows[i] = create_tuple_row(_build_keys[i]);
+        probe_rows[i] = create_tuple_row(_probe_keys[i]);
+    }
+
+    MemTracker tracker;
+    HashTable table(_build_expr_ctxs, _probe_expr_ctxs, 1, false, 0, &tracker, 1024);
+
+    MonotonicStopWatch watch;
+    watch.start();
+    for (int64_t i = 0; i < _num_rows; ++i) {
+        table.insert(build_rows[i]);
+    }
+    watch.stop();
+    int64_t build_ns = watch.elapsed_time();
+
+    int64_t matched = 0;
+    MonotonicStopWatch probe_watch;
+    probe_watch.start();
+    for (int64_t i = 0; i < _num_rows; ++i) {
+        HashTable::Iterator iter = table.find(probe_rows[i]);
+        while (iter.has_next()) {
+            ++matched;
+            iter.next<false>();
+        }
+    }
+    probe_watch.stop();
+
+    EXPECT_EQ(_num_rows, table.size());
+    report("HashTable", build_ns, probe_watch.elapsed_time(), matched, table.byte_size());
+    table.close();
+}
+
+TEST_F(HashTableBenchTest, SwissHashTable) {
+    typedef SwissHashTable<int64_t, int64_t> Table;
+    MemTracker tracker;
+    Table table(&tracker);
+    ASSERT_TRUE(table.init());
+
+    MonotonicStopWatch watch;
+    watch.start();
+    for (int64_t i = 0; i < _num_rows; ++i) {
+        bool inserted = false;
+        table.insert(_build_keys[i], &inserted)->value = i;
+    }
+    watch.stop();
+    int64_t build_ns = watch.elapsed_time();
+
+    int64_t matched = 0;
+    MonotonicStopWatch probe_watch;
+    probe_watch.start();
+    for (int64_t i = 0; i < _num_rows; ++i) {
+        matched += (table.find(_probe_keys[i]) != NULL);
+    }
+    probe_watch.stop();
+
+    EXPECT_EQ(_num_rows, table.size());
+    report("SwissHashTable", build_ns, probe_watch.elapsed_time(), matched, table.byte_size());
+
+    // Probe with software prefetch, batch by batch.
+    const int batch_size = 1024;
+    std::vector<Table::Entry*> entries(batch_size);
+    int64_t batch_matched = 0;
+    MonotonicStopWatch batch_watch;
+    batch_watch.start();
+    for (int64_t i = 0; i < _num_rows; i += batch_size) {
+        int num_keys = std::min(static_cast<int64_t>(batch_size), _num_rows - i);
+        table.find_batch(&_probe_keys[i], num_keys, &entries[0]);
+        for (int j = 0; j < num_keys; ++j) {
+            batch_matched += (entries[j] != NULL);
+        }
+    }
+    batch_watch.stop();
+
+    EXPECT_EQ(matched, batch_matched);
+    report("SwissBatch", build_ns, batch_watch.elapsed_time(), batch_matched, table.byte_size());
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    palo::CpuInfo::init();
+    return RUN_ALL_TESTS();
+}
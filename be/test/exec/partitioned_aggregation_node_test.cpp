@@ -0,0 +1,449 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/partitioned_aggregation_node.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "common/object_pool.h"
+#include "gen_cpp/Exprs_types.h"
+#include "gen_cpp/PlanNodes_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/lib_cache.h"
+#include "runtime/mem_pool.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "runtime/string_value.h"
+#include "runtime/test_env.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "testutil/desc_tbl_builder.h"
+#include "udf/udf_internal.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
+#include "util/logging.h"
+#include "util/runtime_profile.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+using boost::scoped_ptr;
+
+namespace palo {
+
+// Mangled names of the builtin aggregate functions, as FunctionSet of FE sends them.
+static const string AGG_FN_PREFIX = "_ZN4palo18AggregateFunctions";
+static const string AVG_INIT_SYMBOL =
+    "8avg_initEPN8palo_udf15FunctionContextEPNS1_9StringValE";
+static const string AVG_UPDATE_SYMBOL =
+    "10avg_updateIN8palo_udf9BigIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE";
+static const string AVG_MERGE_SYMBOL =
+    "9avg_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_";
+static const string INIT_NULL_STRING_SYMBOL =
+    "16init_null_stringEPN8palo_udf15FunctionContextEPNS1_9StringValE";
+static const string STRING_MAX_SYMBOL =
+    "3maxIN8palo_udf9StringValEEEvPNS2_15FunctionContextERKT_PS6_";
+static const string STRING_VAL_SERIALIZE_SYMBOL =
+    "32string_val_serialize_or_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE";
+
+// Intermediate state of avg(), see AggregateFunctions::avg_init().
+struct AvgTestState {
+    double sum;
+    int64_t count;
+};
+
+// An input row: a grouping key, a value and a name.
+struct AggTestRow {
+    int32_t key;
+    int64_t value;
+    string name;
+};
+
+// avg(value) and max(name) of a group, the avg as the sum and count of its state.
+struct AggTestResult {
+    AggTestResult() : sum(0), count(0) {}
+
+    double sum;
+    int64_t count;
+    string max_name;
+};
+
+// Returns the given rows, each row has one tuple of (key, value, name).
+class AggTestDataNode : public ExecNode {
+public:
+    AggTestDataNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs,
+                    const vector<AggTestRow>* rows) :
+            ExecNode(pool, tnode, descs),
+            _tuple_desc(descs.get_tuple_descriptor(tnode.row_tuples[0])),
+            _rows(rows),
+            _next_row(0) {
+    }
+
+    virtual Status open(RuntimeState* state) {
+        RETURN_IF_ERROR(ExecNode::open(state));
+        _next_row = 0;
+        return Status::OK;
+    }
+
+    virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+        const SlotDescriptor* key_slot = _tuple_desc->slots()[0];
+        const SlotDescriptor* value_slot = _tuple_desc->slots()[1];
+        const SlotDescriptor* name_slot = _tuple_desc->slots()[2];
+        MemPool* pool = row_batch->tuple_data_pool();
+        while (!row_batch->at_capacity() && _next_row < _rows->size()) {
+            const AggTestRow& test_row = (*_rows)[_next_row++];
+            Tuple* tuple = Tuple::create(_tuple_desc->byte_size(), pool);
+            *reinterpret_cast<int32_t*>(tuple->get_slot(key_slot->tuple_offset())) =
+                test_row.key;
+            *reinterpret_cast<int64_t*>(tuple->get_slot(value_slot->tuple_offset())) =
+                test_row.value;
+            StringValue* name = reinterpret_cast<StringValue*>(
+                    tuple->get_slot(name_slot->tuple_offset()));
+            name->len = test_row.name.size();
+            name->ptr = reinterpret_cast<char*>(pool->allocate(name->len));
+            memcpy(name->ptr, test_row.name.data(), name->len);
+
+            int row_idx = row_batch->add_row();
+            row_batch->get_row(row_idx)->set_tuple(0, tuple);
+            row_batch->commit_last_row();
+        }
+        *eos = (_next_row == _rows->size());
+        return Status::OK;
+    }
+
+private:
+    const TupleDescriptor* _tuple_desc;
+    const vector<AggTestRow>* _rows;
+    size_t _next_row;
+};
+
+// The child is attached directly instead of creating the plan tree from thrift.
+class TestPartitionedAggregationNode : public PartitionedAggregationNode {
+public:
+    TestPartitionedAggregationNode(
+            ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
+            PartitionedAggregationNode(pool, tnode, descs) {
+    }
+
+    void add_child(ExecNode* child) {
+        _children.push_back(child);
+    }
+};
+
+// select key, avg(value), max(name) from input group by key, as the first phase of a
+// two phase aggregation: the output is the serialized intermediate tuple.
+class PartitionedAggregationNodeTest : public testing::Test {
+public:
+    PartitionedAggregationNodeTest() :
+            _runtime_state(NULL), _desc_tbl(NULL), _agg_node(NULL) {}
+    // a null dtor to pass codestyle check
+    ~PartitionedAggregationNodeTest() {}
+
+protected:
+    virtual void SetUp() {
+        _enable_streaming = config::enable_streaming_preaggregation;
+        _test_env.reset(new TestEnv());
+        // tuple 0 is the input, tuple 1 the intermediate and output tuple
+        DescriptorTblBuilder builder(&_pool);
+        builder.declare_tuple() << TYPE_INT << TYPE_BIGINT
+            << TypeDescriptor::create_varchar_type(16);
+        builder.declare_tuple() << TYPE_INT << TypeDescriptor::create_varchar_type(16)
+            << TypeDescriptor::create_varchar_type(16);
+        _desc_tbl = builder.build();
+    }
+
+    virtual void TearDown() {
+        _agg_node = NULL;
+        _pool.clear();
+        _runtime_state = NULL;
+        _test_env.reset();
+        config::enable_streaming_preaggregation = _enable_streaming;
+    }
+
+    // 'num_rows' rows over 'num_groups' keys.
+    static void generate_rows(int num_rows, int num_groups, vector<AggTestRow>* rows) {
+        for (int i = 0; i < num_rows; ++i) {
+            char name[16];
+            snprintf(name, sizeof(name), "name_%d", (i * 7) % 1000);
+            AggTestRow row = { i % num_groups, i, name };
+            rows->push_back(row);
+        }
+    }
+
+    static void expected_results(const vector<AggTestRow>& rows,
+                                 map<int32_t, AggTestResult>* results) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            AggTestResult& result = (*results)[rows[i].key];
+            result.sum += rows[i].value;
+            result.count += 1;
+            if (rows[i].name > result.max_name) {
+                result.max_name = rows[i].name;
+            }
+        }
+    }
+
+    static TExpr slot_ref(const SlotDescriptor* slot_desc) {
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::SLOT_REF);
+        node.__set_type(slot_desc->type().to_thrift());
+        node.__set_num_children(0);
+        TSlotRef slot_ref;
+        slot_ref.__set_slot_id(slot_desc->id());
+        slot_ref.__set_tuple_id(slot_desc->parent());
+        node.__set_slot_ref(slot_ref);
+
+        TExpr expr;
+        expr.nodes.push_back(node);
+        return expr;
+    }
+
+    // Aggregate function 'name' over 'input' with a serialize function and no finalize.
+    static TExpr agg_fn(const string& name, const SlotDescriptor* input,
+                        const TypeDescriptor& intermediate_type,
+                        const TypeDescriptor& ret_type,
+                        const string& init_fn, const string& update_fn,
+                        const string& merge_fn, const string& serialize_fn) {
+        TAggregateFunction aggregate_fn;
+        aggregate_fn.__set_intermediate_type(intermediate_type.to_thrift());
+        aggregate_fn.__set_init_fn_symbol(AGG_FN_PREFIX + init_fn);
+        aggregate_fn.__set_update_fn_symbol(AGG_FN_PREFIX + update_fn);
+        aggregate_fn.__set_merge_fn_symbol(AGG_FN_PREFIX + merge_fn);
+        aggregate_fn.__set_serialize_fn_symbol(AGG_FN_PREFIX + serialize_fn);
+
+        TFunctionName fn_name;
+        fn_name.__set_function_name(name);
+        TFunction fn;
+        fn.__set_name(fn_name);
+        fn.__set_binary_type(TFunctionBinaryType::BUILTIN);
+        fn.__set_arg_types(vector<TTypeDesc>(1, input->type().to_thrift()));
+        fn.__set_ret_type(ret_type.to_thrift());
+        fn.__set_has_var_args(false);
+        fn.__set_aggregate_fn(aggregate_fn);
+
+        TAggregateExpr agg_expr;
+        agg_expr.__set_is_merge_agg(false);
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::AGG_EXPR);
+        node.__set_type(ret_type.to_thrift());
+        node.__set_num_children(1);
+        node.__set_fn(fn);
+        node.__set_agg_expr(agg_expr);
+
+        TExpr expr;
+        expr.nodes.push_back(node);
+        TExpr input_expr = slot_ref(input);
+        expr.nodes.push_back(input_expr.nodes[0]);
+        return expr;
+    }
+
+    static TPlanNode plan_node(int node_id, TPlanNodeType::type node_type, TTupleId tuple_id) {
+        TPlanNode tnode;
+        tnode.__set_node_id(node_id);
+        tnode.__set_node_type(node_type);
+        tnode.__set_num_children(0);
+        tnode.__set_limit(-1);
+        tnode.__set_row_tuples(vector<TTupleId>(1, tuple_id));
+        tnode.__set_nullable_tuples(vector<bool>(1, false));
+        tnode.__set_compact_data(false);
+        return tnode;
+    }
+
+    // Creates, prepares and opens the aggregation node over 'rows'.
+    void open_agg_node(const vector<AggTestRow>& rows) {
+        ASSERT_TRUE(_test_env->create_query_state(
+                    0, -1, 1024 * 1024, &_runtime_state).ok());
+        ASSERT_TRUE(_runtime_state->init_mem_trackers(TUniqueId()).ok());
+        _runtime_state->set_desc_tbl(_desc_tbl);
+
+        TPlanNode child_tnode = plan_node(0, TPlanNodeType::EMPTY_SET_NODE, 0);
+        ExecNode* child = _pool.add(new AggTestDataNode(&_pool, child_tnode, *_desc_tbl, &rows));
+
+        const TupleDescriptor* input_desc = _desc_tbl->get_tuple_descriptor(0);
+        const SlotDescriptor* key_slot = input_desc->slots()[0];
+        const SlotDescriptor* value_slot = input_desc->slots()[1];
+        const SlotDescriptor* name_slot = input_desc->slots()[2];
+        const TypeDescriptor varchar_type = TypeDescriptor::create_varchar_type(16);
+        TAggregationNode agg_node;
+        agg_node.grouping_exprs.push_back(slot_ref(key_slot));
+        agg_node.__isset.grouping_exprs = true;
+        agg_node.aggregate_functions.push_back(agg_fn(
+                "avg", value_slot, varchar_type, varchar_type,
+                AVG_INIT_SYMBOL, AVG_UPDATE_SYMBOL, AVG_MERGE_SYMBOL,
+                STRING_VAL_SERIALIZE_SYMBOL));
+        agg_node.aggregate_functions.push_back(agg_fn(
+                "max", name_slot, varchar_type, varchar_type,
+                INIT_NULL_STRING_SYMBOL, STRING_MAX_SYMBOL, STRING_MAX_SYMBOL,
+                STRING_VAL_SERIALIZE_SYMBOL));
+        agg_node.__set_intermediate_tuple_id(1);
+        agg_node.__set_output_tuple_id(1);
+        agg_node.__set_need_finalize(false);
+
+        TPlanNode tnode = plan_node(1, TPlanNodeType::AGGREGATION_NODE, 1);
+        tnode.__set_num_children(1);
+        tnode.__set_agg_node(agg_node);
+
+        TestPartitionedAggregationNode* node =
+            _pool.add(new TestPartitionedAggregationNode(&_pool, tnode, *_desc_tbl));
+        node->add_child(child);
+        _agg_node = node;
+
+        ASSERT_TRUE(child->init(child_tnode).ok());
+        ASSERT_TRUE(node->init(tnode).ok());
+        Status status = node->prepare(_runtime_state);
+        ASSERT_TRUE(status.ok()) << status.get_error_msg();
+        status = node->open(_runtime_state);
+        ASSERT_TRUE(status.ok()) << status.get_error_msg();
+    }
+
+    // Merges the serialized output rows by key, as the second phase would. The local
+    // allocations of the function contexts must not outlive a child batch.
+    void get_results(map<int32_t, AggTestResult>* results) {
+        const vector<SlotDescriptor*>& slots = _desc_tbl->get_tuple_descriptor(1)->slots();
+        RowBatch batch(_agg_node->row_desc(), _runtime_state->batch_size(),
+                       _runtime_state->instance_mem_tracker());
+        bool eos = false;
+        while (!eos) {
+            Status status = _agg_node->get_next(_runtime_state, &batch, &eos);
+            ASSERT_TRUE(status.ok()) << status.get_error_msg();
+            for (int i = 0; i < _agg_node->_agg_fn_ctxs.size(); ++i) {
+                EXPECT_TRUE(_agg_node->_agg_fn_ctxs[i]->impl()->_local_allocations.empty());
+            }
+            for (int i = 0; i < batch.num_rows(); ++i) {
+                Tuple* tuple = batch.get_row(i)->get_tuple(0);
+                int32_t key = *reinterpret_cast<int32_t*>(
+                        tuple->get_slot(slots[0]->tuple_offset()));
+                AggTestResult& result = (*results)[key];
+
+                ASSERT_FALSE(tuple->is_null(slots[1]->null_indicator_offset()));
+                const StringValue* avg = reinterpret_cast<const StringValue*>(
+                        tuple->get_slot(slots[1]->tuple_offset()));
+                ASSERT_EQ(sizeof(AvgTestState), avg->len);
+                const AvgTestState* avg_state = reinterpret_cast<const AvgTestState*>(avg->ptr);
+                result.sum += avg_state->sum;
+                result.count += avg_state->count;
+
+                ASSERT_FALSE(tuple->is_null(slots[2]->null_indicator_offset()));
+                const StringValue* max = reinterpret_cast<const StringValue*>(
+                        tuple->get_slot(slots[2]->tuple_offset()));
+                string max_name(max->ptr, max->len);
+                if (max_name > result.max_name) {
+                    result.max_name = max_name;
+                }
+            }
+            batch.reset();
+        }
+    }
+
+    void check_aggregation(const vector<AggTestRow>& rows) {
+        open_agg_node(rows);
+        map<int32_t, AggTestResult> expected;
+        expected_results(rows, &expected);
+        map<int32_t, AggTestResult> results;
+        get_results(&results);
+        ASSERT_EQ(expected.size(), results.size());
+        for (map<int32_t, AggTestResult>::iterator it = expected.begin();
+                it != expected.end(); ++it) {
+            ASSERT_EQ(1, results.count(it->first));
+            const AggTestResult& result = results[it->first];
+            EXPECT_DOUBLE_EQ(it->second.sum, result.sum);
+            EXPECT_EQ(it->second.count, result.count);
+            EXPECT_EQ(it->second.max_name, result.max_name);
+        }
+    }
+
+    int64_t counter_value(const string& name) {
+        RuntimeProfile::Counter* counter = _agg_node->runtime_profile()->get_counter(name);
+        return counter == NULL ? 0 : counter->value();
+    }
+
+    ObjectPool _pool;
+    scoped_ptr<TestEnv> _test_env;
+    RuntimeState* _runtime_state;
+    DescriptorTbl* _desc_tbl;
+    TestPartitionedAggregationNode* _agg_node;
+    bool _enable_streaming;
+};
+
+// Few groups are reduced well, every row is aggregated in the hash tables.
+TEST_F(PartitionedAggregationNodeTest, StreamingAggregatesReducingInput) {
+    config::enable_streaming_preaggregation = true;
+    vector<AggTestRow> rows;
+    generate_rows(50000, 100, &rows);
+    check_aggregation(rows);
+    ASSERT_TRUE(_agg_node->_is_streaming_preagg);
+    EXPECT_EQ(0, counter_value("RowsPassedThrough"));
+    ASSERT_TRUE(_agg_node->close(_runtime_state).ok());
+}
+
+// Distinct keys do not reduce the input, so most rows are passed through as serialized
+// avg and max states. Their strings are copied into the output batches, and the memory
+// of the function contexts stays bounded by one batch instead of growing with the rows.
+TEST_F(PartitionedAggregationNodeTest, PassThroughAvgAndStringMax) {
+    config::enable_streaming_preaggregation = true;
+    const int num_rows = 200000;
+    vector<AggTestRow> rows;
+    generate_rows(num_rows, num_rows, &rows);
+    check_aggregation(rows);
+    ASSERT_TRUE(_agg_node->_is_streaming_preagg);
+    EXPECT_GT(counter_value("StreamingPartitions"), 0);
+    EXPECT_GT(counter_value("RowsPassedThrough"), num_rows / 2);
+    EXPECT_LT(_agg_node->_agg_fn_pool->total_allocated_bytes(), 1024 * 1024);
+    ASSERT_TRUE(_agg_node->close(_runtime_state).ok());
+}
+
+// Without streaming the same input is aggregated in open().
+TEST_F(PartitionedAggregationNodeTest, StreamingDisabled) {
+    config::enable_streaming_preaggregation = false;
+    vector<AggTestRow> rows;
+    generate_rows(20000, 20000, &rows);
+    check_aggregation(rows);
+    ASSERT_FALSE(_agg_node->_is_streaming_preagg);
+    EXPECT_EQ(0, counter_value("RowsPassedThrough"));
+    ASSERT_TRUE(_agg_node->close(_runtime_state).ok());
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    palo::config::query_scratch_dirs = "/tmp";
+    palo::config::read_size = 8388608;
+    palo::config::min_buffer_size = 1024;
+
+    palo::config::disable_mem_pools = false;
+
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+
+    palo::CpuInfo::init();
+    palo::DiskInfo::init();
+    // Builtin aggregate functions are looked up in the test binary by symbol.
+    palo::LibCache::init();
+
+    return RUN_ALL_TESTS();
+}
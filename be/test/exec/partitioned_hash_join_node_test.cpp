@@ -0,0 +1,437 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/partitioned_hash_join_node.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "common/object_pool.h"
+#include "gen_cpp/PlanNodes_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "runtime/test_env.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "testutil/desc_tbl_builder.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
+#include "util/logging.h"
+#include "util/runtime_profile.h"
+
+using std::map;
+using std::pair;
+using std::vector;
+
+using boost::scoped_ptr;
+
+namespace palo {
+
+// A row of the probe or the build input: a join key, which may be NULL, and a value
+// which identifies the row.
+struct JoinTestRow {
+    bool null_key;
+    int32_t key;
+    int32_t value;
+};
+
+// Values of the probe and the build row of an output row, -1 for a NULL tuple.
+typedef pair<int32_t, int32_t> JoinResult;
+
+// Returns the given rows, each row has one tuple of (key, value).
+class JoinTestDataNode : public ExecNode {
+public:
+    JoinTestDataNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs,
+                     const vector<JoinTestRow>* rows) :
+            ExecNode(pool, tnode, descs),
+            _tuple_desc(descs.get_tuple_descriptor(tnode.row_tuples[0])),
+            _rows(rows),
+            _next_row(0) {
+    }
+
+    virtual Status open(RuntimeState* state) {
+        RETURN_IF_ERROR(ExecNode::open(state));
+        _next_row = 0;
+        return Status::OK;
+    }
+
+    virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+        const SlotDescriptor* key_slot = _tuple_desc->slots()[0];
+        const SlotDescriptor* value_slot = _tuple_desc->slots()[1];
+        while (!row_batch->at_capacity() && _next_row < _rows->size()) {
+            const JoinTestRow& test_row = (*_rows)[_next_row++];
+            Tuple* tuple = Tuple::create(_tuple_desc->byte_size(), row_batch->tuple_data_pool());
+            if (test_row.null_key) {
+                tuple->set_null(key_slot->null_indicator_offset());
+            } else {
+                *reinterpret_cast<int32_t*>(tuple->get_slot(key_slot->tuple_offset())) =
+                    test_row.key;
+            }
+            *reinterpret_cast<int32_t*>(tuple->get_slot(value_slot->tuple_offset())) =
+                test_row.value;
+
+            int row_idx = row_batch->add_row();
+            row_batch->get_row(row_idx)->set_tuple(0, tuple);
+            row_batch->commit_last_row();
+        }
+        *eos = (_next_row == _rows->size());
+        return Status::OK;
+    }
+
+private:
+    const TupleDescriptor* _tuple_desc;
+    const vector<JoinTestRow>* _rows;
+    size_t _next_row;
+};
+
+// The children are attached directly instead of creating the plan tree from thrift.
+class TestPartitionedHashJoinNode : public PartitionedHashJoinNode {
+public:
+    TestPartitionedHashJoinNode(
+            ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
+            PartitionedHashJoinNode(pool, tnode, descs) {
+    }
+
+    void add_child(ExecNode* child) {
+        _children.push_back(child);
+    }
+};
+
+class PartitionedHashJoinNodeTest : public testing::Test {
+public:
+    PartitionedHashJoinNodeTest() : _runtime_state(NULL), _desc_tbl(NULL), _join_node(NULL) {}
+    // a null dtor to pass codestyle check
+    ~PartitionedHashJoinNodeTest() {}
+
+protected:
+    virtual void SetUp() {
+        _test_env.reset(new TestEnv());
+        // tuple 0 is the probe input, tuple 1 is the build input
+        DescriptorTblBuilder builder(&_pool);
+        builder.declare_tuple() << TYPE_INT << TYPE_INT;
+        builder.declare_tuple() << TYPE_INT << TYPE_INT;
+        _desc_tbl = builder.build();
+    }
+
+    virtual void TearDown() {
+        _pool.clear();
+        _runtime_state = NULL;
+        _test_env.reset();
+    }
+
+    // Probe keys are [n / 2, 3 * n / 2), each build key in [0, n) appears twice, so half
+    // of the rows of both sides match. Both sides have a few rows with NULL keys.
+    static void generate_rows(int n, vector<JoinTestRow>* probe_rows,
+                              vector<JoinTestRow>* build_rows) {
+        for (int i = 0; i < n; ++i) {
+            JoinTestRow row = { false, n / 2 + i, i };
+            probe_rows->push_back(row);
+        }
+        for (int i = 0; i < 2 * n; ++i) {
+            JoinTestRow row = { false, i / 2, i };
+            build_rows->push_back(row);
+        }
+        for (int i = 0; i < 3; ++i) {
+            JoinTestRow probe_row = { true, 0, n + i };
+            probe_rows->push_back(probe_row);
+            JoinTestRow build_row = { true, 0, 2 * n + i };
+            build_rows->push_back(build_row);
+        }
+    }
+
+    // Joins the rows with nested loops.
+    static void expected_results(TJoinOp::type join_op,
+                                 const vector<JoinTestRow>& probe_rows,
+                                 const vector<JoinTestRow>& build_rows,
+                                 vector<JoinResult>* results) {
+        map<int32_t, vector<int32_t> > build_values;
+        for (size_t i = 0; i < build_rows.size(); ++i) {
+            if (!build_rows[i].null_key) {
+                build_values[build_rows[i].key].push_back(build_rows[i].value);
+            }
+        }
+
+        map<int32_t, bool> build_matched;
+        for (size_t i = 0; i < probe_rows.size(); ++i) {
+            const JoinTestRow& probe_row = probe_rows[i];
+            map<int32_t, vector<int32_t> >::const_iterator it = build_values.end();
+            if (!probe_row.null_key) {
+                it = build_values.find(probe_row.key);
+            }
+            if (it == build_values.end()) {
+                if (join_op == TJoinOp::LEFT_OUTER_JOIN || join_op == TJoinOp::FULL_OUTER_JOIN
+                        || join_op == TJoinOp::LEFT_ANTI_JOIN) {
+                    results->push_back(JoinResult(probe_row.value, -1));
+                }
+                continue;
+            }
+
+            const vector<int32_t>& values = it->second;
+            for (size_t j = 0; j < values.size(); ++j) {
+                build_matched[values[j]] = true;
+                if (join_op == TJoinOp::INNER_JOIN || join_op == TJoinOp::LEFT_OUTER_JOIN
+                        || join_op == TJoinOp::RIGHT_OUTER_JOIN
+                        || join_op == TJoinOp::FULL_OUTER_JOIN) {
+                    results->push_back(JoinResult(probe_row.value, values[j]));
+                }
+            }
+            if (join_op == TJoinOp::LEFT_SEMI_JOIN) {
+                results->push_back(JoinResult(probe_row.value, -1));
+            }
+        }
+
+        for (size_t i = 0; i < build_rows.size(); ++i) {
+            bool matched = build_matched.count(build_rows[i].value) > 0;
+            if ((matched && join_op == TJoinOp::RIGHT_SEMI_JOIN)
+                    || (!matched && (join_op == TJoinOp::RIGHT_OUTER_JOIN
+                            || join_op == TJoinOp::FULL_OUTER_JOIN
+                            || join_op == TJoinOp::RIGHT_ANTI_JOIN))) {
+                results->push_back(JoinResult(-1, build_rows[i].value));
+            }
+        }
+        std::sort(results->begin(), results->end());
+    }
+
+    static TExpr slot_ref(const SlotDescriptor* slot_desc) {
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::SLOT_REF);
+        node.__set_type(slot_desc->type().to_thrift());
+        node.__set_num_children(0);
+        TSlotRef slot_ref;
+        slot_ref.__set_slot_id(slot_desc->id());
+        slot_ref.__set_tuple_id(slot_desc->parent());
+        node.__set_slot_ref(slot_ref);
+
+        TExpr expr;
+        expr.nodes.push_back(node);
+        return expr;
+    }
+
+    static TPlanNode plan_node(int node_id, TPlanNodeType::type node_type,
+                               const vector<TTupleId>& row_tuples) {
+        TPlanNode tnode;
+        tnode.__set_node_id(node_id);
+        tnode.__set_node_type(node_type);
+        tnode.__set_num_children(0);
+        tnode.__set_limit(-1);
+        tnode.__set_row_tuples(row_tuples);
+        tnode.__set_nullable_tuples(vector<bool>(row_tuples.size(), false));
+        tnode.__set_compact_data(false);
+        return tnode;
+    }
+
+    // Joins the rows by a PartitionedHashJoinNode, with a block manager limited to
+    // 'max_buffers' buffers of 'block_size' bytes, -1 means no limit.
+    void join(TJoinOp::type join_op,
+              const vector<JoinTestRow>& probe_rows,
+              const vector<JoinTestRow>& build_rows,
+              int max_buffers,
+              int block_size,
+              vector<JoinResult>* results) {
+        ASSERT_TRUE(_test_env->create_query_state(
+                    0, max_buffers, block_size, &_runtime_state).ok());
+        ASSERT_TRUE(_runtime_state->init_mem_trackers(TUniqueId()).ok());
+        _runtime_state->set_desc_tbl(_desc_tbl);
+
+        ExecNode* probe_node = _pool.add(new JoinTestDataNode(&_pool,
+                    plan_node(0, TPlanNodeType::EMPTY_SET_NODE, vector<TTupleId>(1, 0)),
+                    *_desc_tbl, &probe_rows));
+        ExecNode* build_node = _pool.add(new JoinTestDataNode(&_pool,
+                    plan_node(1, TPlanNodeType::EMPTY_SET_NODE, vector<TTupleId>(1, 1)),
+                    *_desc_tbl, &build_rows));
+
+        vector<TTupleId> row_tuples;
+        row_tuples.push_back(0);
+        row_tuples.push_back(1);
+        TPlanNode tnode = plan_node(2, TPlanNodeType::HASH_JOIN_NODE, row_tuples);
+        tnode.__set_num_children(2);
+        tnode.__set_nullable_tuples(vector<bool>(2, true));
+        THashJoinNode hash_join_node;
+        hash_join_node.__set_join_op(join_op);
+        TEqJoinCondition eq_join_conjunct;
+        eq_join_conjunct.__set_left(slot_ref(_desc_tbl->get_tuple_descriptor(0)->slots()[0]));
+        eq_join_conjunct.__set_right(slot_ref(_desc_tbl->get_tuple_descriptor(1)->slots()[0]));
+        hash_join_node.eq_join_conjuncts.push_back(eq_join_conjunct);
+        tnode.__set_hash_join_node(hash_join_node);
+
+        TestPartitionedHashJoinNode* join_node =
+            _pool.add(new TestPartitionedHashJoinNode(&_pool, tnode, *_desc_tbl));
+        join_node->add_child(probe_node);
+        join_node->add_child(build_node);
+        _join_node = join_node;
+
+        ASSERT_TRUE(probe_node->init(plan_node(0, TPlanNodeType::EMPTY_SET_NODE,
+                        vector<TTupleId>(1, 0))).ok());
+        ASSERT_TRUE(build_node->init(plan_node(1, TPlanNodeType::EMPTY_SET_NODE,
+                        vector<TTupleId>(1, 1))).ok());
+        ASSERT_TRUE(join_node->init(tnode).ok());
+        ASSERT_TRUE(join_node->prepare(_runtime_state).ok());
+        Status status = join_node->open(_runtime_state);
+        ASSERT_TRUE(status.ok()) << status.get_error_msg();
+
+        const TupleDescriptor* probe_desc = _desc_tbl->get_tuple_descriptor(0);
+        const TupleDescriptor* build_desc = _desc_tbl->get_tuple_descriptor(1);
+        RowBatch batch(join_node->row_desc(), _runtime_state->batch_size(),
+                       _runtime_state->instance_mem_tracker());
+        bool eos = false;
+        while (!eos) {
+            status = join_node->get_next(_runtime_state, &batch, &eos);
+            ASSERT_TRUE(status.ok()) << status.get_error_msg();
+            for (int i = 0; i < batch.num_rows(); ++i) {
+                TupleRow* row = batch.get_row(i);
+                int32_t probe_value = value_of(row->get_tuple(0), probe_desc);
+                int32_t build_value = value_of(row->get_tuple(1), build_desc);
+                // semi and anti joins return the tuples of one side only
+                if (join_op == TJoinOp::LEFT_SEMI_JOIN || join_op == TJoinOp::LEFT_ANTI_JOIN) {
+                    build_value = -1;
+                } else if (join_op == TJoinOp::RIGHT_SEMI_JOIN
+                        || join_op == TJoinOp::RIGHT_ANTI_JOIN) {
+                    probe_value = -1;
+                }
+                results->push_back(JoinResult(probe_value, build_value));
+            }
+            batch.reset();
+        }
+        ASSERT_TRUE(join_node->close(_runtime_state).ok());
+        std::sort(results->begin(), results->end());
+    }
+
+    static int32_t value_of(Tuple* tuple, const TupleDescriptor* tuple_desc) {
+        if (tuple == NULL) {
+            return -1;
+        }
+        return *reinterpret_cast<int32_t*>(
+                tuple->get_slot(tuple_desc->slots()[1]->tuple_offset()));
+    }
+
+    int64_t counter_value(const std::string& name) {
+        RuntimeProfile::Counter* counter = _join_node->runtime_profile()->get_counter(name);
+        return counter == NULL ? 0 : counter->value();
+    }
+
+    void check_join(TJoinOp::type join_op, int n, int max_buffers, int block_size) {
+        vector<JoinTestRow> probe_rows;
+        vector<JoinTestRow> build_rows;
+        generate_rows(n, &probe_rows, &build_rows);
+
+        vector<JoinResult> expected;
+        expected_results(join_op, probe_rows, build_rows, &expected);
+        vector<JoinResult> results;
+        join(join_op, probe_rows, build_rows, max_buffers, block_size, &results);
+        ASSERT_EQ(expected.size(), results.size());
+        ASSERT_TRUE(expected == results);
+    }
+
+    ObjectPool _pool;
+    scoped_ptr<TestEnv> _test_env;
+    RuntimeState* _runtime_state;
+    DescriptorTbl* _desc_tbl;
+    ExecNode* _join_node;
+};
+
+// Small blocks disable the small buffers of streams, so every partition pins whole
+// blocks and the limit is reached with fewer rows.
+static const int BLOCK_SIZE = 8 * 1024;
+
+TEST_F(PartitionedHashJoinNodeTest, InnerJoin) {
+    check_join(TJoinOp::INNER_JOIN, 1000, -1, BLOCK_SIZE);
+    ASSERT_EQ(0, counter_value("SpilledPartitions"));
+}
+
+TEST_F(PartitionedHashJoinNodeTest, LeftOuterJoin) {
+    check_join(TJoinOp::LEFT_OUTER_JOIN, 1000, -1, BLOCK_SIZE);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, RightOuterJoin) {
+    check_join(TJoinOp::RIGHT_OUTER_JOIN, 1000, -1, BLOCK_SIZE);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, FullOuterJoin) {
+    check_join(TJoinOp::FULL_OUTER_JOIN, 1000, -1, BLOCK_SIZE);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, LeftSemiJoin) {
+    check_join(TJoinOp::LEFT_SEMI_JOIN, 1000, -1, BLOCK_SIZE);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, LeftAntiJoin) {
+    check_join(TJoinOp::LEFT_ANTI_JOIN, 1000, -1, BLOCK_SIZE);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, RightSemiJoin) {
+    check_join(TJoinOp::RIGHT_SEMI_JOIN, 1000, -1, BLOCK_SIZE);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, RightAntiJoin) {
+    check_join(TJoinOp::RIGHT_ANTI_JOIN, 1000, -1, BLOCK_SIZE);
+}
+
+// 80000 build rows do not fit in 48 blocks, some partitions are spilled, and are
+// small enough to be joined in memory afterwards.
+TEST_F(PartitionedHashJoinNodeTest, SpillInnerJoin) {
+    check_join(TJoinOp::INNER_JOIN, 40000, 48, BLOCK_SIZE);
+    ASSERT_GT(counter_value("SpilledPartitions"), 0);
+}
+
+// Unmatched build rows of spilled partitions are returned after they are probed.
+TEST_F(PartitionedHashJoinNodeTest, SpillFullOuterJoin) {
+    check_join(TJoinOp::FULL_OUTER_JOIN, 40000, 48, BLOCK_SIZE);
+    ASSERT_GT(counter_value("SpilledPartitions"), 0);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, SpillRightAntiJoin) {
+    check_join(TJoinOp::RIGHT_ANTI_JOIN, 40000, 48, BLOCK_SIZE);
+    ASSERT_GT(counter_value("SpilledPartitions"), 0);
+}
+
+// Spilled partitions of 400000 build rows still do not fit, so they are repartitioned.
+TEST_F(PartitionedHashJoinNodeTest, RepartitionInnerJoin) {
+    check_join(TJoinOp::INNER_JOIN, 200000, 48, BLOCK_SIZE);
+    ASSERT_GT(counter_value("NumRepartitions"), 0);
+    ASSERT_GT(counter_value("MaxPartitionLevel"), 0);
+}
+
+TEST_F(PartitionedHashJoinNodeTest, RepartitionRightOuterJoin) {
+    check_join(TJoinOp::RIGHT_OUTER_JOIN, 200000, 48, BLOCK_SIZE);
+    ASSERT_GT(counter_value("NumRepartitions"), 0);
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    palo::config::query_scratch_dirs = "/tmp";
+    palo::config::read_size = 8388608;
+    palo::config::min_buffer_size = 1024;
+
+    palo::config::disable_mem_pools = false;
+
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+
+    palo::CpuInfo::init();
+    palo::DiskInfo::init();
+
+    return RUN_ALL_TESTS();
+}
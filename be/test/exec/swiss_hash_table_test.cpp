@@ -0,0 +1,238 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/swiss_hash_table.h"
+
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "runtime/mem_tracker.h"
+#include "runtime/string_value.h"
+
+namespace palo {
+
+class SwissHashTableTest : public testing::Test {
+public:
+    SwissHashTableTest() {}
+    virtual ~SwissHashTableTest() {}
+
+protected:
+    MemTracker _tracker;
+};
+
+TEST_F(SwissHashTableTest, InsertAndFind) {
+    SwissHashTable<int64_t, int64_t> table(&_tracker);
+    ASSERT_TRUE(table.init());
+    EXPECT_EQ(0, table.size());
+    EXPECT_TRUE(table.find(1) == NULL);
+
+    for (int64_t i = 0; i < 1000; ++i) {
+        bool inserted = false;
+        SwissHashTable<int64_t, int64_t>::Entry* entry = table.insert(i * 7, &inserted);
+        ASSERT_TRUE(entry != NULL);
+        EXPECT_TRUE(inserted);
+        entry->value = i;
+    }
+    EXPECT_EQ(1000, table.size());
+
+    for (int64_t i = 0; i < 1000; ++i) {
+        SwissHashTable<int64_t, int64_t>::Entry* entry = table.find(i * 7);
+        ASSERT_TRUE(entry != NULL);
+        EXPECT_EQ(i * 7, entry->key);
+        EXPECT_EQ(i, entry->value);
+        if (i % 7 != 0) {
+            EXPECT_TRUE(table.find(i) == NULL);
+        }
+    }
+
+    // Inserting an existing key returns the old entry.
+    bool inserted = true;
+    SwissHashTable<int64_t, int64_t>::Entry* entry = table.insert(14, &inserted);
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(2, entry->value);
+    EXPECT_EQ(1000, table.size());
+}
+
+// Start from the smallest table and compare with std::map while growing.
+TEST_F(SwissHashTableTest, Grow) {
+    std::map<int64_t, int64_t> expected;
+    {
+        SwissHashTable<int64_t, int64_t> table(&_tracker);
+        ASSERT_TRUE(table.init());
+        int64_t initial_capacity = table.capacity();
+        srand(0);
+        for (int i = 0; i < 200000; ++i) {
+            int64_t key = rand() % 50000;
+            bool inserted = false;
+            table.insert(key, &inserted)->value += 1;
+            EXPECT_EQ(expected.find(key) == expected.end(), inserted);
+            expected[key] += 1;
+        }
+        EXPECT_GT(table.capacity(), initial_capacity);
+        EXPECT_EQ(expected.size(), table.size());
+        EXPECT_EQ(table.byte_size(), _tracker.consumption());
+
+        for (std::map<int64_t, int64_t>::iterator it = expected.begin();
+                it != expected.end(); ++it) {
+            SwissHashTable<int64_t, int64_t>::Entry* entry = table.find(it->first);
+            ASSERT_TRUE(entry != NULL);
+            EXPECT_EQ(it->second, entry->value);
+        }
+    }
+    // All memory is released with the table.
+    EXPECT_EQ(0, _tracker.consumption());
+}
+
+TEST_F(SwissHashTableTest, StringKey) {
+    std::vector<std::string> strs;
+    for (int i = 0; i < 5000; ++i) {
+        strs.push_back("key_" + std::to_string(i));
+    }
+
+    SwissHashTable<StringValue, int> table(&_tracker, strs.size());
+    ASSERT_TRUE(table.init());
+    int64_t capacity = table.capacity();
+    for (int i = 0; i < strs.size(); ++i) {
+        StringValue key(const_cast<char*>(strs[i].data()), strs[i].size());
+        bool inserted = false;
+        table.insert(key, &inserted)->value = i;
+        EXPECT_TRUE(inserted);
+    }
+    // Sized by expected_size, no resize happens.
+    EXPECT_EQ(capacity, table.capacity());
+
+    for (int i = 0; i < strs.size(); ++i) {
+        std::string copy = strs[i];
+        StringValue key(const_cast<char*>(copy.data()), copy.size());
+        SwissHashTable<StringValue, int>::Entry* entry = table.find(key);
+        ASSERT_TRUE(entry != NULL);
+        EXPECT_EQ(i, entry->value);
+    }
+    std::string missing = "key_";
+    EXPECT_TRUE(table.find(StringValue(const_cast<char*>(missing.data()), missing.size())) == NULL);
+}
+
+TEST_F(SwissHashTableTest, LargeIntKey) {
+    SwissHashTable<__int128, int> table(&_tracker);
+    ASSERT_TRUE(table.init());
+    for (int i = 0; i < 1000; ++i) {
+        bool inserted = false;
+        table.insert(static_cast<__int128>(i) << 64, &inserted);
+        EXPECT_TRUE(inserted);
+    }
+    EXPECT_EQ(1000, table.size());
+    EXPECT_TRUE(table.find(static_cast<__int128>(5) << 64) != NULL);
+    EXPECT_TRUE(table.find(5) == NULL);
+}
+
+TEST_F(SwissHashTableTest, FindBatch) {
+    SwissHashTable<int32_t, int32_t> table(&_tracker);
+    ASSERT_TRUE(table.init());
+    for (int32_t i = 0; i < 10000; i += 2) {
+        bool inserted = false;
+        table.insert(i, &inserted)->value = -i;
+    }
+
+    // More than one batch, with a partial last batch.
+    std::vector<int32_t> keys;
+    for (int32_t i = 0; i < 1001; ++i) {
+        keys.push_back(i);
+    }
+    std::vector<SwissHashTable<int32_t, int32_t>::Entry*> entries(keys.size());
+    table.find_batch(&keys[0], keys.size(), &entries[0]);
+    for (int i = 0; i < keys.size(); ++i) {
+        if (keys[i] % 2 == 0) {
+            ASSERT_TRUE(entries[i] != NULL);
+            EXPECT_EQ(-keys[i], entries[i]->value);
+        } else {
+            EXPECT_TRUE(entries[i] == NULL);
+        }
+    }
+}
+
+TEST_F(SwissHashTableTest, ForEach) {
+    SwissHashTable<int64_t, int64_t> table(&_tracker);
+    ASSERT_TRUE(table.init());
+    int64_t expected_sum = 0;
+    for (int64_t i = 1; i <= 3000; ++i) {
+        bool inserted = false;
+        table.insert(i, &inserted)->value = i;
+        expected_sum += i;
+    }
+
+    int64_t count = 0;
+    int64_t sum = 0;
+    table.for_each([&count, &sum](SwissHashTable<int64_t, int64_t>::Entry* entry) {
+        ++count;
+        sum += entry->value;
+    });
+    EXPECT_EQ(table.size(), count);
+    EXPECT_EQ(expected_sum, sum);
+}
+
+// Growing fails when the memory limit would be exceeded, the table stays usable.
+TEST_F(SwissHashTableTest, MemLimit) {
+    typedef SwissHashTable<int64_t, int64_t> Table;
+    // Room for the initial 4 groups but not for the 8 groups to grow to.
+    const int64_t limit = 4 * Table::GROUP_SIZE * (1 + sizeof(Table::Entry)) + 1;
+    MemTracker tracker(limit);
+    {
+        Table table(&tracker, 3 * Table::GROUP_SIZE);
+        ASSERT_TRUE(table.init());
+        EXPECT_EQ(4 * Table::GROUP_SIZE, table.capacity());
+
+        int64_t num_keys = 0;
+        bool inserted = false;
+        Table::Entry* entry = NULL;
+        while ((entry = table.insert(num_keys, &inserted)) != NULL) {
+            EXPECT_TRUE(inserted);
+            entry->value = num_keys;
+            ++num_keys;
+        }
+        EXPECT_EQ(num_keys, table.size());
+        EXPECT_EQ(4 * Table::GROUP_SIZE, table.capacity());
+        EXPECT_EQ(table.byte_size(), tracker.consumption());
+
+        // Existing keys are still found and inserted without growing.
+        for (int64_t i = 0; i < num_keys; ++i) {
+            entry = table.insert(i, &inserted);
+            ASSERT_TRUE(entry != NULL);
+            EXPECT_FALSE(inserted);
+            EXPECT_EQ(i, entry->value);
+        }
+    }
+    EXPECT_EQ(0, tracker.consumption());
+
+    // Nothing is consumed when init() fails.
+    Table big_table(&tracker, 1024);
+    EXPECT_FALSE(big_table.init());
+    EXPECT_EQ(0, tracker.consumption());
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,393 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/runtime_filter_predicate.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "common/object_pool.h"
+#include "exprs/expr_context.h"
+#include "exprs/slot_ref.h"
+#include "gen_cpp/Exprs_types.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "runtime/datetime_value.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/string_value.h"
+#include "runtime/types.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "util/logging.h"
+
+namespace palo {
+
+// Rows have one tuple, the value of the probe expr is at offset 8 of the tuple.
+class RuntimeFilterPredicateTest : public testing::Test {
+public:
+    RuntimeFilterPredicateTest() {
+        _node.node_type = TExprNodeType::RUNTIME_FILTER_PRED;
+        _node.type = TypeDescriptor(TYPE_BOOLEAN).to_thrift();
+        _node.num_children = 0;
+    }
+
+protected:
+    virtual void SetUp() {
+        memset(_tuple_buf, 0, sizeof(_tuple_buf));
+        _row.set_tuple(0, reinterpret_cast<Tuple*>(_tuple_buf));
+    }
+
+    RuntimeFilterPredicate* create_filter(PrimitiveType type, int64_t expected_values,
+                                          MemTracker* mem_tracker) {
+        RuntimeFilterPredicate* filter = _pool.add(new RuntimeFilterPredicate(_node));
+        Status status = filter->prepare(NULL, TypeDescriptor(type), expected_values, mem_tracker);
+        EXPECT_TRUE(status.ok());
+        filter->add_child(_pool.add(new SlotRef(TypeDescriptor(type), 8)));
+        return filter;
+    }
+
+    // Evaluates filter on a row whose probe value is 'value', NULL for a NULL tuple.
+    BooleanVal eval(RuntimeFilterPredicate* filter, const void* value, size_t len) {
+        if (value == NULL) {
+            _row.set_tuple(0, NULL);
+        } else {
+            _row.set_tuple(0, reinterpret_cast<Tuple*>(_tuple_buf));
+            memcpy(_tuple_buf + 8, value, len);
+        }
+        ExprContext context(filter);
+        return filter->get_boolean_val(&context, &_row);
+    }
+
+    bool passes(RuntimeFilterPredicate* filter, int32_t value) {
+        BooleanVal result = eval(filter, &value, sizeof(value));
+        EXPECT_FALSE(result.is_null);
+        return result.val;
+    }
+
+    bool passes(RuntimeFilterPredicate* filter, const std::string& value) {
+        StringValue string_value(const_cast<char*>(value.data()), value.size());
+        BooleanVal result = eval(filter, &string_value, sizeof(string_value));
+        EXPECT_FALSE(result.is_null);
+        return result.val;
+    }
+
+    // Serializes a filter of 'expected_values' holding 'values' like a hash join
+    // instance publishing it.
+    TRuntimeFilter publish_filter(int64_t expected_values, const std::vector<int32_t>& values) {
+        RuntimeFilterPredicate* filter = create_filter(TYPE_INT, expected_values, &_mem_tracker);
+        for (int i = 0; i < values.size(); ++i) {
+            filter->insert(const_cast<int32_t*>(&values[i]));
+        }
+        TRuntimeFilter t_filter;
+        filter->to_thrift(&t_filter);
+        filter->release_bloom_filter();
+        return t_filter;
+    }
+
+    int num_bloom_filters(RuntimeFilterPredicate* filter) {
+        return filter->_filter->bloom_filters.size();
+    }
+
+    TExprNode _node;
+    ObjectPool _pool;
+    MemTracker _mem_tracker;
+    uint8_t _tuple_buf[32];
+    TupleRow _row;
+};
+
+TEST_F(RuntimeFilterPredicateTest, BloomFilterHasNoFalseNegatives) {
+    RuntimeFilterPredicate* filter = create_filter(TYPE_INT, 10000, &_mem_tracker);
+    ASSERT_TRUE(filter->has_bloom_filter());
+    for (int32_t i = 0; i < 10000; ++i) {
+        int32_t value = i * 7;
+        filter->insert(&value);
+    }
+
+    for (int32_t i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(passes(filter, i * 7));
+    }
+
+    // values between min and max are only rejected by the bloom filter
+    int false_positives = 0;
+    int not_inserted = 0;
+    for (int32_t value = 0; value < 70000; ++value) {
+        if (value % 7 != 0) {
+            ++not_inserted;
+            if (passes(filter, value)) {
+                ++false_positives;
+            }
+        }
+    }
+    LOG(INFO) << "false positives: " << false_positives << " of " << not_inserted;
+    ASSERT_LT(false_positives, not_inserted / 10);
+}
+
+TEST_F(RuntimeFilterPredicateTest, MinMaxBounds) {
+    RuntimeFilterPredicate* filter = create_filter(TYPE_INT, 0, &_mem_tracker);
+    ASSERT_FALSE(filter->has_bloom_filter());
+    ASSERT_TRUE(filter->min_value() == NULL);
+    // nothing matches an empty build side
+    ASSERT_FALSE(passes(filter, 0));
+
+    int32_t values[] = { 10, -5, 30, 20 };
+    for (int i = 0; i < 4; ++i) {
+        filter->insert(&values[i]);
+    }
+    filter->insert(NULL);
+    ASSERT_EQ(-5, *reinterpret_cast<const int32_t*>(filter->min_value()));
+    ASSERT_EQ(30, *reinterpret_cast<const int32_t*>(filter->max_value()));
+
+    ASSERT_TRUE(passes(filter, -5));
+    ASSERT_TRUE(passes(filter, 30));
+    // without bloom filter any value in [min, max] passes
+    ASSERT_TRUE(passes(filter, 0));
+    ASSERT_FALSE(passes(filter, -6));
+    ASSERT_FALSE(passes(filter, 31));
+    // NULL never matches in a join
+    ASSERT_TRUE(eval(filter, NULL, 0).is_null);
+}
+
+TEST_F(RuntimeFilterPredicateTest, StringValues) {
+    RuntimeFilterPredicate* filter = create_filter(TYPE_VARCHAR, 100, &_mem_tracker);
+    const char* values[] = { "banana", "apple", "pear" };
+    for (int i = 0; i < 3; ++i) {
+        // the filter keeps its own copy of min and max
+        std::string value(values[i]);
+        StringValue string_value(const_cast<char*>(value.data()), value.size());
+        filter->insert(&string_value);
+    }
+    const StringValue* min_value = reinterpret_cast<const StringValue*>(filter->min_value());
+    const StringValue* max_value = reinterpret_cast<const StringValue*>(filter->max_value());
+    ASSERT_EQ(std::string("apple"), std::string(min_value->ptr, min_value->len));
+    ASSERT_EQ(std::string("pear"), std::string(max_value->ptr, max_value->len));
+
+    ASSERT_TRUE(passes(filter, std::string("apple")));
+    ASSERT_TRUE(passes(filter, std::string("banana")));
+    ASSERT_TRUE(passes(filter, std::string("pear")));
+    ASSERT_FALSE(passes(filter, std::string("aardvark")));
+    ASSERT_FALSE(passes(filter, std::string("zebra")));
+}
+
+TEST_F(RuntimeFilterPredicateTest, MinMaxOfTypes) {
+    RuntimeFilterPredicate* bigint_filter = create_filter(TYPE_BIGINT, 0, &_mem_tracker);
+    int64_t bigint_values[] = { 1L << 40, -(1L << 40), 3 };
+    for (int i = 0; i < 3; ++i) {
+        bigint_filter->insert(&bigint_values[i]);
+    }
+    ASSERT_EQ(-(1L << 40), *reinterpret_cast<const int64_t*>(bigint_filter->min_value()));
+    ASSERT_EQ(1L << 40, *reinterpret_cast<const int64_t*>(bigint_filter->max_value()));
+
+    RuntimeFilterPredicate* double_filter = create_filter(TYPE_DOUBLE, 0, &_mem_tracker);
+    double double_values[] = { 0.5, -2.25, 1e10 };
+    for (int i = 0; i < 3; ++i) {
+        double_filter->insert(&double_values[i]);
+    }
+    ASSERT_EQ(-2.25, *reinterpret_cast<const double*>(double_filter->min_value()));
+    ASSERT_EQ(1e10, *reinterpret_cast<const double*>(double_filter->max_value()));
+
+    RuntimeFilterPredicate* datetime_filter = create_filter(TYPE_DATETIME, 0, &_mem_tracker);
+    DateTimeValue datetime_values[] = {
+        DateTimeValue(20171017120000L), DateTimeValue(20170101000000L),
+        DateTimeValue(20171231235959L) };
+    for (int i = 0; i < 3; ++i) {
+        datetime_filter->insert(&datetime_values[i]);
+    }
+    ASSERT_TRUE(datetime_values[1]
+            == *reinterpret_cast<const DateTimeValue*>(datetime_filter->min_value()));
+    ASSERT_TRUE(datetime_values[2]
+            == *reinterpret_cast<const DateTimeValue*>(datetime_filter->max_value()));
+
+    RuntimeFilterPredicate unsupported(_node);
+    ASSERT_FALSE(unsupported.prepare(NULL, TypeDescriptor(TYPE_NULL), 0, &_mem_tracker).ok());
+}
+
+TEST_F(RuntimeFilterPredicateTest, BloomFilterMemoryIsTracked) {
+    RuntimeFilterPredicate* filter = create_filter(TYPE_INT, 100000, &_mem_tracker);
+    ASSERT_TRUE(filter->has_bloom_filter());
+    ASSERT_GT(_mem_tracker.consumption(), 0);
+
+    int32_t values[] = { 1, 100 };
+    filter->insert(&values[0]);
+    filter->insert(&values[1]);
+    RuntimeFilterPredicate* clone = static_cast<RuntimeFilterPredicate*>(filter->clone(&_pool));
+    ASSERT_FALSE(passes(clone, 50));
+
+    // the clones share the filter, min and max are still checked
+    filter->release_bloom_filter();
+    ASSERT_EQ(0, _mem_tracker.consumption());
+    ASSERT_FALSE(clone->has_bloom_filter());
+    ASSERT_TRUE(passes(clone, 50));
+    ASSERT_FALSE(passes(clone, 101));
+    filter->release_bloom_filter();
+    ASSERT_EQ(0, _mem_tracker.consumption());
+}
+
+TEST_F(RuntimeFilterPredicateTest, BloomFilterOverMemoryLimit) {
+    MemTracker mem_tracker(1024);
+    RuntimeFilterPredicate* filter = create_filter(TYPE_INT, 100000, &mem_tracker);
+    ASSERT_FALSE(filter->has_bloom_filter());
+    ASSERT_EQ(0, mem_tracker.consumption());
+
+    int32_t values[] = { 1, 100 };
+    filter->insert(&values[0]);
+    filter->insert(&values[1]);
+    ASSERT_TRUE(passes(filter, 50));
+    ASSERT_FALSE(passes(filter, 0));
+}
+
+TEST_F(RuntimeFilterPredicateTest, MergeBloomFiltersOfSameSize) {
+    std::vector<int32_t> values1;
+    std::vector<int32_t> values2;
+    for (int32_t i = 0; i < 1000; ++i) {
+        values1.push_back(i * 10);
+        values2.push_back(i * 10 + 5);
+    }
+    TRuntimeFilter t_filter1 = publish_filter(2048, values1);
+    TRuntimeFilter t_filter2 = publish_filter(2048, values2);
+    ASSERT_TRUE(t_filter1.__isset.bloom_filter_bits);
+    ASSERT_EQ(0, _mem_tracker.consumption());
+
+    RuntimeFilterPredicate* filter = create_filter(TYPE_INT, 0, &_mem_tracker);
+    ASSERT_TRUE(filter->merge(t_filter1).ok());
+    ASSERT_TRUE(filter->merge(t_filter2).ok());
+    ASSERT_EQ(1, num_bloom_filters(filter));
+    ASSERT_GT(_mem_tracker.consumption(), 0);
+    ASSERT_EQ(0, *reinterpret_cast<const int32_t*>(filter->min_value()));
+    ASSERT_EQ(9995, *reinterpret_cast<const int32_t*>(filter->max_value()));
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(passes(filter, values1[i]));
+        ASSERT_TRUE(passes(filter, values2[i]));
+    }
+    int false_positives = 0;
+    for (int32_t i = 0; i < 1000; ++i) {
+        if (passes(filter, i * 10 + 1)) {
+            ++false_positives;
+        }
+    }
+    ASSERT_LT(false_positives, 100);
+
+    filter->release_bloom_filter();
+    ASSERT_EQ(0, _mem_tracker.consumption());
+}
+
+TEST_F(RuntimeFilterPredicateTest, MergeBloomFiltersOfDifferentSizes) {
+    std::vector<int32_t> values1;
+    std::vector<int32_t> values2;
+    for (int32_t i = 0; i < 100; ++i) {
+        values1.push_back(i);
+    }
+    for (int32_t i = 0; i < 4000; ++i) {
+        values2.push_back(1000 + i * 3);
+    }
+    RuntimeFilterPredicate* filter = create_filter(TYPE_INT, 0, &_mem_tracker);
+    ASSERT_TRUE(filter->merge(publish_filter(128, values1)).ok());
+    ASSERT_TRUE(filter->merge(publish_filter(4096, values2)).ok());
+    ASSERT_EQ(2, num_bloom_filters(filter));
+
+    for (int i = 0; i < values1.size(); ++i) {
+        ASSERT_TRUE(passes(filter, values1[i]));
+    }
+    for (int i = 0; i < values2.size(); ++i) {
+        ASSERT_TRUE(passes(filter, values2[i]));
+    }
+    ASSERT_FALSE(passes(filter, -1));
+    ASSERT_FALSE(passes(filter, 1000 + 4000 * 3));
+
+    // a merged filter is not published again
+    TRuntimeFilter t_filter;
+    filter->to_thrift(&t_filter);
+    ASSERT_FALSE(t_filter.__isset.bloom_filter_bits);
+    filter->release_bloom_filter();
+    ASSERT_EQ(0, _mem_tracker.consumption());
+}
+
+TEST_F(RuntimeFilterPredicateTest, MergeEmptyAndMinMaxOnlyFilters) {
+    RuntimeFilterPredicate* filter = create_filter(TYPE_INT, 0, &_mem_tracker);
+    // an instance with an empty build side adds nothing
+    ASSERT_TRUE(filter->merge(publish_filter(0, std::vector<int32_t>())).ok());
+    ASSERT_TRUE(filter->min_value() == NULL);
+    ASSERT_FALSE(passes(filter, 0));
+
+    std::vector<int32_t> values1;
+    values1.push_back(10);
+    values1.push_back(20);
+    ASSERT_TRUE(filter->merge(publish_filter(128, values1)).ok());
+    ASSERT_TRUE(filter->has_bloom_filter());
+    ASSERT_FALSE(passes(filter, 15));
+
+    // once an instance has too many values for a bloom filter, only min and max are
+    // left to check
+    std::vector<int32_t> values2;
+    values2.push_back(30);
+    ASSERT_TRUE(filter->merge(publish_filter(0, values2)).ok());
+    ASSERT_FALSE(filter->has_bloom_filter());
+    ASSERT_EQ(0, _mem_tracker.consumption());
+    ASSERT_TRUE(passes(filter, 15));
+    ASSERT_TRUE(passes(filter, 30));
+    ASSERT_FALSE(passes(filter, 9));
+    ASSERT_FALSE(passes(filter, 31));
+
+    std::vector<int32_t> values3;
+    values3.push_back(40);
+    ASSERT_TRUE(filter->merge(publish_filter(128, values3)).ok());
+    ASSERT_FALSE(filter->has_bloom_filter());
+    ASSERT_TRUE(passes(filter, 35));
+    ASSERT_FALSE(passes(filter, 41));
+
+    TRuntimeFilter invalid;
+    invalid.__set_min_value(std::string("ab"));
+    invalid.__set_max_value(std::string("ab"));
+    ASSERT_FALSE(filter->merge(invalid).ok());
+}
+
+TEST_F(RuntimeFilterPredicateTest, MergeStringValues) {
+    RuntimeFilterPredicate* producer = create_filter(TYPE_VARCHAR, 128, &_mem_tracker);
+    const char* values[] = { "banana", "apple", "pear" };
+    for (int i = 0; i < 3; ++i) {
+        std::string value(values[i]);
+        StringValue string_value(const_cast<char*>(value.data()), value.size());
+        producer->insert(&string_value);
+    }
+    TRuntimeFilter t_filter;
+    producer->to_thrift(&t_filter);
+    producer->release_bloom_filter();
+
+    RuntimeFilterPredicate* filter = create_filter(TYPE_VARCHAR, 0, &_mem_tracker);
+    ASSERT_TRUE(filter->merge(t_filter).ok());
+    const StringValue* min_value = reinterpret_cast<const StringValue*>(filter->min_value());
+    const StringValue* max_value = reinterpret_cast<const StringValue*>(filter->max_value());
+    ASSERT_EQ(std::string("apple"), std::string(min_value->ptr, min_value->len));
+    ASSERT_EQ(std::string("pear"), std::string(max_value->ptr, max_value->len));
+    ASSERT_TRUE(passes(filter, std::string("apple")));
+    ASSERT_TRUE(passes(filter, std::string("banana")));
+    ASSERT_TRUE(passes(filter, std::string("pear")));
+    ASSERT_FALSE(passes(filter, std::string("zebra")));
+    filter->release_bloom_filter();
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,192 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/olap_main.cpp"
+#include "olap/tablet_test_util.h"
+#include "olap/utils.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_up() {
+    char buffer[MAX_PATH_LEN];
+    getcwd(buffer, MAX_PATH_LEN);
+    config::storage_root_path = string(buffer) + "/data_column_file_compress";
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+    create_dir(config::storage_root_path);
+    touch_all_singleton();
+}
+
+void tear_down() {
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+}
+
+// Writes a segment of a column tablet and reads it back, checking the codec recorded
+// for each stream in the segment header.
+class TestColumnFileCompress : public testing::Test {
+protected:
+    void SetUp() {
+        _old_compress_kind = config::default_column_file_compress_kind;
+        _index = NULL;
+    }
+
+    void TearDown() {
+        if (_index != NULL) {
+            _index->delete_all_files();
+            SAFE_DELETE(_index);
+        }
+        drop_test_table(&_table);
+        config::default_column_file_compress_kind = _old_compress_kind;
+    }
+
+    void create_table(const string& compress_kind) {
+        config::default_column_file_compress_kind = compress_kind;
+
+        TCreateTabletReq request;
+        request.tablet_id = 10020;
+        request.__set_version(1);
+        request.__set_version_hash(0);
+        request.tablet_schema.schema_hash = 1508825677;
+        request.tablet_schema.short_key_column_count = 1;
+        request.tablet_schema.keys_type = TKeysType::AGG_KEYS;
+        request.tablet_schema.storage_type = TStorageType::COLUMN;
+        add_test_column(&request, "k1", TPrimitiveType::INT, true);
+        // distinct strings with a common pattern, not dictionary encoded but compressed well
+        add_test_column(&request, "v1", TPrimitiveType::VARCHAR, false,
+                        TAggregationType::REPLACE, 64);
+        // random values, which can not be compressed
+        add_test_column(&request, "v2", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+        ASSERT_EQ(OLAP_SUCCESS, create_test_table(request, &_table));
+    }
+
+    void write_and_read() {
+        srand(1);
+        vector<TestRow> rows;
+        vector<string> expected_rows;
+        for (int32_t i = 0; i < 10000; ++i) {
+            int64_t random_value = (static_cast<int64_t>(rand()) << 33)
+                    ^ (static_cast<int64_t>(rand()) << 11) ^ rand();
+            TestRow row;
+            row.push_back(std::to_string(i));
+            row.push_back("value_of_row_" + std::to_string(i));
+            row.push_back(std::to_string(random_value));
+            rows.push_back(row);
+            expected_rows.push_back(test_row_string(row));
+        }
+
+        _index = new(std::nothrow) OLAPIndex(_table.get(), Version(2, 2), 2, false, 0, 0);
+        ASSERT_TRUE(_index != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, write_test_index(_table, rows, _index));
+
+        vector<string> read_rows;
+        ASSERT_EQ(OLAP_SUCCESS, read_test_index(_table, _index, &read_rows));
+        ASSERT_EQ(expected_rows, read_rows);
+    }
+
+    const column_file::ColumnDataHeaderMessage& segment_header() {
+        return _index->get_seg_pb(0).message();
+    }
+
+    // Returns the stream of kind for column at index of schema, or NULL.
+    const column_file::StreamInfoMessage* find_stream(
+            size_t column_index, column_file::StreamInfoMessage::Kind kind) {
+        uint32_t unique_id = _table->tablet_schema()[column_index].unique_id;
+        for (int i = 0; i < segment_header().stream_info_size(); ++i) {
+            const column_file::StreamInfoMessage& stream = segment_header().stream_info(i);
+            if (stream.column_unique_id() == unique_id && stream.kind() == kind) {
+                return &stream;
+            }
+        }
+        return NULL;
+    }
+
+    string _old_compress_kind;
+    SmartOLAPTable _table;
+    OLAPIndex* _index;
+};
+
+TEST_F(TestColumnFileCompress, ZstdSegment) {
+    create_table("zstd");
+    write_and_read();
+    ASSERT_EQ(COMPRESS_ZSTD, segment_header().compress_kind());
+
+    // streams use the codec of segment, which is not written for each stream
+    const column_file::StreamInfoMessage* stream =
+            find_stream(1, column_file::StreamInfoMessage::DATA);
+    ASSERT_TRUE(stream != NULL);
+    ASSERT_FALSE(stream->has_compress_kind());
+}
+
+TEST_F(TestColumnFileCompress, AdaptiveSegment) {
+    create_table("adaptive");
+    write_and_read();
+    ASSERT_EQ(COMPRESS_ADAPTIVE, segment_header().compress_kind());
+
+    const column_file::StreamInfoMessage* string_data =
+            find_stream(1, column_file::StreamInfoMessage::DATA);
+    ASSERT_TRUE(string_data != NULL);
+    ASSERT_TRUE(string_data->has_compress_kind());
+    ASSERT_NE(COMPRESS_NONE, string_data->compress_kind());
+
+    const column_file::StreamInfoMessage* random_data =
+            find_stream(2, column_file::StreamInfoMessage::DATA);
+    ASSERT_TRUE(random_data != NULL);
+    ASSERT_TRUE(random_data->has_compress_kind());
+    ASSERT_EQ(COMPRESS_NONE, random_data->compress_kind());
+
+    // index streams are never compressed, and have no codec of their own
+    const column_file::StreamInfoMessage* row_index =
+            find_stream(2, column_file::StreamInfoMessage::ROW_INDEX);
+    ASSERT_TRUE(row_index != NULL);
+    ASSERT_FALSE(row_index->has_compress_kind());
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::set_up();
+    int ret = RUN_ALL_TESTS();
+    palo::tear_down();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
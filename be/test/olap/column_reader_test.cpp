@@ -27,6 +27,9 @@
 #include "olap/olap_define.h"
 #include "olap/olap_common.h"
 #include "olap/row_cursor.h"
+#include "olap/utils.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/vectorized_row_batch.h"
 #include "util/logging.h"
 
 using std::string;
@@ -108,6 +111,8 @@ public:
         encodings[0] = ColumnEncodingMessage();
         encodings[0].set_kind(ColumnEncodingMessage::DIRECT);
         encodings[0].set_dictionary_size(1);
+        // string columns may be dictionary encoded, use the encoding chosen by writer
+        _column_writer->save_encoding(&encodings[0]);
         CreateColumnReader(tablet_schema, encodings);
     }
 
@@ -2974,6 +2979,568 @@ TEST_F(TestColumn, StringColumnWithoutoutPresent2) {
     ASSERT_STREQ(read_row._field_array[0]->_buf, "ddddd");    
 }
 
+TEST_F(TestColumn, IntColumnNextBatchWithPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("IntColumnNextBatchWithPresent"), 
+                 OLAP_FIELD_TYPE_INT, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 4, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+    for (int32_t i = 0; i < 10; ++i) {
+        if (i % 3 == 0) {
+            write_row.set_null(0);
+        } else {
+            write_row.set_not_null(0);
+            write_row.read(reinterpret_cast<char *>(&i), sizeof(i));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ASSERT_EQ(_column_reader->next_batch(batch.column(0), 10, batch.mem_pool()), OLAP_SUCCESS);
+
+    ColumnVector* column = batch.column(0);
+    ASSERT_FALSE(column->no_nulls());
+    int32_t* values = reinterpret_cast<int32_t*>(column->col_data());
+    for (int32_t i = 0; i < 10; ++i) {
+        if (i % 3 == 0) {
+            ASSERT_TRUE(column->is_null()[i]);
+        } else {
+            ASSERT_FALSE(column->is_null()[i]);
+            ASSERT_EQ(i, values[i]);
+        }
+    }
+}
+
+TEST_F(TestColumn, FloatColumnNextBatchWithPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("FloatColumnNextBatchWithPresent"), 
+                 OLAP_FIELD_TYPE_FLOAT, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 4, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+    for (int32_t i = 0; i < 10; ++i) {
+        if (i % 4 == 1) {
+            write_row.set_null(0);
+        } else {
+            float value = i + 0.5;
+            write_row.set_not_null(0);
+            write_row.read(reinterpret_cast<char *>(&value), sizeof(value));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ASSERT_EQ(_column_reader->next_batch(batch.column(0), 10, batch.mem_pool()), OLAP_SUCCESS);
+
+    ColumnVector* column = batch.column(0);
+    ASSERT_FALSE(column->no_nulls());
+    float* values = reinterpret_cast<float*>(column->col_data());
+    for (int32_t i = 0; i < 10; ++i) {
+        if (i % 4 == 1) {
+            ASSERT_TRUE(column->is_null()[i]);
+        } else {
+            ASSERT_FALSE(column->is_null()[i]);
+            ASSERT_FLOAT_EQ(i + 0.5, values[i]);
+        }
+    }
+}
+
+TEST_F(TestColumn, DirectVarcharColumnNextBatchWithoutPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("DirectVarcharColumnNextBatchWithoutPresent"), 
+                 OLAP_FIELD_TYPE_VARCHAR, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 10, 
+                 false,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+    
+    std::vector<string> val_string_array;
+    val_string_array.push_back("YWJjZGU="); //"abcde" base_64_encode is "YWJjZGU="
+    write_row.from_string(val_string_array);
+    ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+
+    val_string_array.clear();
+    val_string_array.push_back("ZWRjYmE="); //"edcba" base_64_encode is "ZWRjYmE="
+    write_row.from_string(val_string_array);
+    ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ASSERT_EQ(_column_reader->next_batch(batch.column(0), 2, batch.mem_pool()), OLAP_SUCCESS);
+
+    ColumnVector* column = batch.column(0);
+    ASSERT_TRUE(column->no_nulls());
+    StringValue* values = reinterpret_cast<StringValue*>(column->col_data());
+    ASSERT_EQ(std::string("YWJjZGU="), std::string(values[0].ptr, values[0].len));
+    ASSERT_EQ(std::string("ZWRjYmE="), std::string(values[1].ptr, values[1].len));
+}
+
+TEST_F(TestColumn, DictionaryVarcharColumnNextBatchWithPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("DictionaryVarcharColumnNextBatchWithPresent"), 
+                 OLAP_FIELD_TYPE_VARCHAR, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 10, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+
+    const char* keys[] = {"beijing", "shanghai", "guangzhou"};
+    std::vector<string> val_string_array;
+    for (int32_t i = 0; i < 100; ++i) {
+        if (i % 7 == 0) {
+            write_row.set_null(0);
+        } else {
+            val_string_array.clear();
+            val_string_array.push_back(keys[i % 3]);
+            write_row.set_not_null(0);
+            ASSERT_EQ(OLAP_SUCCESS, write_row.from_string(val_string_array));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+    ASSERT_EQ(ColumnEncodingMessage::DICTIONARY, header.column_encoding(0).kind());
+    ASSERT_EQ(3, header.column_encoding(0).dictionary_size());
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ASSERT_EQ(_column_reader->next_batch(batch.column(0), 100, batch.mem_pool()), OLAP_SUCCESS);
+
+    ColumnVector* column = batch.column(0);
+    ASSERT_FALSE(column->no_nulls());
+    StringValue* values = reinterpret_cast<StringValue*>(column->col_data());
+    for (int32_t i = 0; i < 100; ++i) {
+        if (i % 7 == 0) {
+            ASSERT_TRUE(column->is_null()[i]);
+        } else {
+            ASSERT_FALSE(column->is_null()[i]);
+            ASSERT_EQ(std::string(keys[i % 3]), std::string(values[i].ptr, values[i].len));
+        }
+    }
+}
+
+TEST_F(TestColumn, TinyColumnNextBatchWithPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("TinyColumnNextBatchWithPresent"), 
+                 OLAP_FIELD_TYPE_TINYINT, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 1, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+    // long runs are run length encoded, the others are literals
+    for (int32_t i = 0; i < 300; ++i) {
+        if (i % 7 == 0) {
+            write_row.set_null(0);
+        } else {
+            char value = i < 150 ? i / 50 : i % 100;
+            write_row.set_not_null(0);
+            write_row.read(&value, sizeof(value));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ColumnVector* column = batch.column(0);
+    // read in two batches so that the second one starts in the middle of a run
+    ASSERT_EQ(_column_reader->next_batch(column, 100, batch.mem_pool()), OLAP_SUCCESS);
+    char* values = reinterpret_cast<char*>(column->col_data());
+    for (int32_t i = 0; i < 100; ++i) {
+        ASSERT_EQ(i % 7 == 0, column->is_null()[i]);
+        if (i % 7 != 0) {
+            ASSERT_EQ(static_cast<char>(i / 50), values[i]);
+        }
+    }
+
+    ASSERT_EQ(_column_reader->next_batch(column, 200, batch.mem_pool()), OLAP_SUCCESS);
+    values = reinterpret_cast<char*>(column->col_data());
+    for (int32_t i = 100; i < 300; ++i) {
+        ASSERT_EQ(i % 7 == 0, column->is_null()[i - 100]);
+        if (i % 7 != 0) {
+            ASSERT_EQ(static_cast<char>(i < 150 ? i / 50 : i % 100), values[i - 100]);
+        }
+    }
+}
+
+TEST_F(TestColumn, DecimalColumnNextBatchWithPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("DecimalColumnNextBatchWithPresent"), 
+                 OLAP_FIELD_TYPE_DECIMAL, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 12, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+
+    std::vector<string> val_string_array;
+    for (int32_t i = 0; i < 10; ++i) {
+        if (i % 3 == 0) {
+            write_row.set_null(0);
+        } else {
+            val_string_array.clear();
+            val_string_array.push_back(std::to_string(i) + ".5");
+            write_row.set_not_null(0);
+            ASSERT_EQ(OLAP_SUCCESS, write_row.from_string(val_string_array));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ASSERT_EQ(_column_reader->next_batch(batch.column(0), 10, batch.mem_pool()), OLAP_SUCCESS);
+
+    ColumnVector* column = batch.column(0);
+    ASSERT_FALSE(column->no_nulls());
+    const char* data = reinterpret_cast<const char*>(column->col_data());
+    size_t value_size = sizeof(int64_t) + sizeof(int32_t);
+    for (int32_t i = 0; i < 10; ++i) {
+        const char* value = data + i * value_size;
+        if (i % 3 == 0) {
+            ASSERT_TRUE(column->is_null()[i]);
+            continue;
+        }
+
+        decimal12_t expected;
+        ASSERT_EQ(OLAP_SUCCESS, expected.from_string(std::to_string(i) + ".5"));
+        ASSERT_FALSE(column->is_null()[i]);
+        ASSERT_EQ(expected.integer, *reinterpret_cast<const int64_t*>(value));
+        ASSERT_EQ(expected.fraction, *reinterpret_cast<const int32_t*>(value + sizeof(int64_t)));
+    }
+}
+
+TEST_F(TestColumn, LargeIntColumnNextBatchWithPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("LargeIntColumnNextBatchWithPresent"), 
+                 OLAP_FIELD_TYPE_LARGEINT, 
+                 OLAP_FIELD_AGGREGATION_SUM, 
+                 16, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    string value1 = "100000000000000000000000000000000000000";
+    string value2 = "-5";
+    int128_t expected1 = static_cast<int128_t>(10000000000000000000ULL) * 10000000000000000000ULL;
+    int128_t expected2 = -5;
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+
+    std::vector<string> val_string_array;
+    for (int32_t i = 0; i < 9; ++i) {
+        if (i % 3 == 0) {
+            write_row.set_null(0);
+        } else {
+            val_string_array.clear();
+            val_string_array.push_back(i % 3 == 1 ? value1 : value2);
+            write_row.set_not_null(0);
+            ASSERT_EQ(OLAP_SUCCESS, write_row.from_string(val_string_array));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ASSERT_EQ(_column_reader->next_batch(batch.column(0), 9, batch.mem_pool()), OLAP_SUCCESS);
+
+    ColumnVector* column = batch.column(0);
+    ASSERT_FALSE(column->no_nulls());
+    int128_t* values = reinterpret_cast<int128_t*>(column->col_data());
+    for (int32_t i = 0; i < 9; ++i) {
+        if (i % 3 == 0) {
+            ASSERT_TRUE(column->is_null()[i]);
+        } else {
+            ASSERT_FALSE(column->is_null()[i]);
+            ASSERT_TRUE((i % 3 == 1 ? expected1 : expected2) == values[i]);
+        }
+    }
+}
+
+TEST_F(TestColumn, DictionaryCharColumnNextBatchWithPresent) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("DictionaryCharColumnNextBatchWithPresent"), 
+                 OLAP_FIELD_TYPE_CHAR, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 10, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+
+    const char* keys[] = {"beijing", "shanghai", "guangzhou"};
+    std::vector<string> val_string_array;
+    for (int32_t i = 0; i < 100; ++i) {
+        if (i % 7 == 0) {
+            write_row.set_null(0);
+        } else {
+            val_string_array.clear();
+            val_string_array.push_back(keys[i % 3]);
+            write_row.set_not_null(0);
+            ASSERT_EQ(OLAP_SUCCESS, write_row.from_string(val_string_array));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+    ASSERT_EQ(ColumnEncodingMessage::DICTIONARY, header.column_encoding(0).kind());
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, 1024, &tracker);
+    ASSERT_EQ(_column_reader->next_batch(batch.column(0), 100, batch.mem_pool()), OLAP_SUCCESS);
+
+    ColumnVector* column = batch.column(0);
+    ASSERT_FALSE(column->no_nulls());
+    const char* values = reinterpret_cast<const char*>(column->col_data());
+    for (int32_t i = 0; i < 100; ++i) {
+        const char* value = values + i * 10;
+        if (i % 7 == 0) {
+            ASSERT_TRUE(column->is_null()[i]);
+            continue;
+        }
+
+        // fixed length strings are padded with zero
+        std::string expected(keys[i % 3]);
+        expected.resize(10, '\0');
+        ASSERT_FALSE(column->is_null()[i]);
+        ASSERT_EQ(expected, std::string(value, 10));
+    }
+}
+
+// Compare reading a nullable dictionary varchar column row by row with
+// next_batch(). It is a benchmark and not run with the unit tests, run it by
+// --gtest_also_run_disabled_tests --gtest_filter=*NextBatchDecodeBenchmark
+TEST_F(TestColumn, DISABLED_NextBatchDecodeBenchmark) {
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("NextBatchDecodeBenchmark"), 
+                 OLAP_FIELD_TYPE_VARCHAR, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 10, 
+                 true,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+
+    // the first half is read by next() and the second half by next_batch()
+    const uint32_t num_rows = 1024 * 1024;
+    const uint32_t batch_size = 1024;
+    std::vector<string> val_string_array;
+    for (uint32_t i = 0; i < num_rows; ++i) {
+        if (i % 7 == 0) {
+            write_row.set_null(0);
+        } else {
+            val_string_array.clear();
+            val_string_array.push_back(std::to_string(i % 100));
+            write_row.set_not_null(0);
+            ASSERT_EQ(OLAP_SUCCESS, write_row.from_string(val_string_array));
+        }
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    RowCursor read_row;
+    read_row.init(tablet_schema);
+    OlapStopWatch watch;
+    for (uint32_t i = 0; i < num_rows / 2; ++i) {
+        ASSERT_EQ(_column_reader->next(), OLAP_SUCCESS);
+        ASSERT_EQ(_column_reader->attach(&read_row), OLAP_SUCCESS);
+    }
+    LOG(INFO) << "next: read " << num_rows / 2 << " rows in "
+              << watch.get_elapse_time_us() << "us";
+
+    MemTracker tracker(-1);
+    VectorizedRowBatch batch(tablet_schema, batch_size, &tracker);
+    watch.reset();
+    for (uint32_t i = num_rows / 2; i < num_rows; i += batch_size) {
+        batch.reset();
+        ASSERT_EQ(OLAP_SUCCESS,
+                _column_reader->next_batch(batch.column(0), batch_size, batch.mem_pool()));
+    }
+    LOG(INFO) << "next_batch: read " << num_rows / 2 << " rows in "
+              << watch.get_elapse_time_us() << "us";
+
+    ColumnVector* column = batch.column(0);
+    StringValue* values = reinterpret_cast<StringValue*>(column->col_data());
+    for (uint32_t i = 0; i < batch_size; ++i) {
+        uint32_t row = num_rows - batch_size + i;
+        ASSERT_EQ(row % 7 == 0, column->is_null()[i]);
+        if (row % 7 != 0) {
+            ASSERT_EQ(std::to_string(row % 100), std::string(values[i].ptr, values[i].len));
+        }
+    }
+}
+
+TEST_F(TestColumn, VarcharColumnSwitchToDirectEncoding) {
+    // 不同的值达到阈值后放弃字典编码
+    config::column_dictionary_key_size_threshold = 8;
+
+    // write data
+    std::vector<FieldInfo> tablet_schema;
+    FieldInfo field_info;
+    SetFieldInfo(field_info,
+                 std::string("VarcharColumnSwitchToDirectEncoding"), 
+                 OLAP_FIELD_TYPE_VARCHAR, 
+                 OLAP_FIELD_AGGREGATION_REPLACE, 
+                 10, 
+                 false,
+                 true);
+    tablet_schema.push_back(field_info);
+
+    CreateColumnWriter(tablet_schema);
+    
+    RowCursor write_row;
+    write_row.init(tablet_schema);
+
+    std::vector<string> val_string_array;
+    for (int32_t i = 0; i < 20; ++i) {
+        val_string_array.clear();
+        val_string_array.push_back(std::to_string(i % 10));
+        ASSERT_EQ(OLAP_SUCCESS, write_row.from_string(val_string_array));
+        ASSERT_EQ(_column_writer->write(&write_row), OLAP_SUCCESS);
+    }
+
+    ColumnDataHeaderMessage header;
+    ASSERT_EQ(_column_writer->finalize(&header), OLAP_SUCCESS);
+    ASSERT_EQ(ColumnEncodingMessage::DIRECT, header.column_encoding(0).kind());
+
+    // read data
+    CreateColumnReader(tablet_schema);
+
+    RowCursor read_row;
+    read_row.init(tablet_schema);
+    for (int32_t i = 0; i < 20; ++i) {
+        ASSERT_EQ(_column_reader->next(), OLAP_SUCCESS);
+        ASSERT_EQ(_column_reader->attach(&read_row), OLAP_SUCCESS);
+        ASSERT_EQ("0&" + std::to_string(i % 10), read_row.to_string());
+    }
+    ASSERT_NE(_column_reader->next(), OLAP_SUCCESS);
+}
+
 TEST_F(TestColumn, DirectVarcharColumnWith65533) {
     // write data
     std::vector<FieldInfo> tablet_schema;
@@ -1121,6 +1121,72 @@ TEST_F(TestDeleteHandler, FilterDataVersion) {
     _delete_handler.finalize();
 }
 
+// 测试只用指定的过滤条件过滤数据
+TEST_F(TestDeleteHandler, FilterDataByConditionIds) {
+    OLAPStatus res;
+    DeleteConditionHandler cond_handler;
+    std::vector<TCondition> conditions;
+
+    // 过滤条件1
+    TCondition condition;
+    condition.column_name = "k1";
+    condition.condition_op = "=";
+    condition.condition_values.clear();
+    condition.condition_values.push_back("1");
+    conditions.push_back(condition);
+
+    res = cond_handler.store_cond(_olap_table, 3, conditions);
+    ASSERT_EQ(OLAP_SUCCESS, res);
+    ASSERT_EQ(OLAP_SUCCESS, push_empty_delta(3));
+
+    // 过滤条件2
+    conditions.clear();
+    condition.column_name = "k1";
+    condition.condition_op = "=";
+    condition.condition_values.clear();
+    condition.condition_values.push_back("3");
+    conditions.push_back(condition);
+
+    res = cond_handler.store_cond(_olap_table, 4, conditions);
+    ASSERT_EQ(OLAP_SUCCESS, res);
+    ASSERT_EQ(OLAP_SUCCESS, push_empty_delta(4));
+
+    _delete_handler.init(_olap_table, 10);
+    ASSERT_EQ(2, _delete_handler.conditions_num());
+
+    // 找出过滤条件1在handler中的下标
+    uint32_t first_cond_id = 0;
+    uint32_t second_cond_id = 1;
+    if (_delete_handler.get_delete_conditions()[0].filter_version != 3) {
+        std::swap(first_cond_id, second_cond_id);
+    }
+
+    vector<string> data_str;
+    data_str.push_back("1");
+    data_str.push_back("6");
+    data_str.push_back("8");
+    data_str.push_back("-1");
+    data_str.push_back("16");
+    data_str.push_back("1.2");
+    data_str.push_back("2014-01-01");
+    data_str.push_back("2014-01-01 00:00:00");
+    data_str.push_back("YWFH");
+    data_str.push_back("YWFH==");
+    data_str.push_back("1");
+    res = _data_row_cursor.from_string(data_str);
+    ASSERT_EQ(OLAP_SUCCESS, res);
+
+    // 这条数据只符合过滤条件1
+    std::vector<uint32_t> cond_ids;
+    ASSERT_FALSE(_delete_handler.is_filter_data(1, _data_row_cursor, cond_ids));
+    cond_ids.push_back(second_cond_id);
+    ASSERT_FALSE(_delete_handler.is_filter_data(1, _data_row_cursor, cond_ids));
+    cond_ids.push_back(first_cond_id);
+    ASSERT_TRUE(_delete_handler.is_filter_data(1, _data_row_cursor, cond_ids));
+
+    _delete_handler.finalize();
+}
+
 }  // namespace palo
 
 int main(int argc, char** argv) {
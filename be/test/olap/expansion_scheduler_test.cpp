@@ -0,0 +1,127 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "olap/expansion_scheduler.h"
+#include "util/logging.h"
+
+namespace palo {
+
+class ExpansionSchedulerTest : public testing::Test {
+public:
+    virtual void SetUp() {
+        _scheduler.set_max_task_per_disk(CUMULATIVE_EXPANSION, 1);
+        _scheduler.set_max_task_per_disk(BASE_EXPANSION, 1);
+    }
+
+    ExpansionCandidate make_candidate(int64_t tablet_id,
+                                      const std::string& root_path,
+                                      double score) {
+        ExpansionCandidate candidate;
+        candidate.tablet_id = tablet_id;
+        candidate.schema_hash = 1;
+        candidate.root_path = root_path;
+        candidate.score = score;
+        return candidate;
+    }
+
+protected:
+    ExpansionScheduler _scheduler;
+};
+
+TEST_F(ExpansionSchedulerTest, NextCandidateByScore) {
+    std::vector<ExpansionCandidate> candidates;
+    candidates.push_back(make_candidate(1, "/disk1", 5));
+    candidates.push_back(make_candidate(2, "/disk2", 50));
+    candidates.push_back(make_candidate(3, "/disk3", 20));
+    _scheduler.update_candidates(CUMULATIVE_EXPANSION, candidates);
+
+    ExpansionCandidate candidate;
+    ASSERT_TRUE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+    ASSERT_EQ(2, candidate.tablet_id);
+    ASSERT_TRUE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+    ASSERT_EQ(3, candidate.tablet_id);
+    ASSERT_TRUE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+    ASSERT_EQ(1, candidate.tablet_id);
+    ASSERT_FALSE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+
+    // 两种合并的队列相互独立
+    ASSERT_FALSE(_scheduler.next_candidate(BASE_EXPANSION, &candidate));
+}
+
+TEST_F(ExpansionSchedulerTest, LimitTaskPerDisk) {
+    std::vector<ExpansionCandidate> candidates;
+    candidates.push_back(make_candidate(1, "/disk1", 50));
+    candidates.push_back(make_candidate(2, "/disk1", 40));
+    candidates.push_back(make_candidate(3, "/disk2", 10));
+    _scheduler.update_candidates(BASE_EXPANSION, candidates);
+
+    ExpansionCandidate first;
+    ASSERT_TRUE(_scheduler.next_candidate(BASE_EXPANSION, &first));
+    ASSERT_EQ(1, first.tablet_id);
+
+    // disk1上已经有任务在执行, 选择disk2上得分较低的table
+    ExpansionCandidate candidate;
+    ASSERT_TRUE(_scheduler.next_candidate(BASE_EXPANSION, &candidate));
+    ASSERT_EQ(3, candidate.tablet_id);
+    ASSERT_FALSE(_scheduler.next_candidate(BASE_EXPANSION, &candidate));
+
+    _scheduler.finish_candidate(BASE_EXPANSION, first);
+    ASSERT_TRUE(_scheduler.next_candidate(BASE_EXPANSION, &candidate));
+    ASSERT_EQ(2, candidate.tablet_id);
+}
+
+TEST_F(ExpansionSchedulerTest, SkipUnusedDiskAndRunningTable) {
+    std::vector<ExpansionCandidate> candidates;
+    candidates.push_back(make_candidate(1, "/disk1", 50));
+    candidates.push_back(make_candidate(2, "/disk2", 40));
+    _scheduler.set_disk_used("/disk1", false);
+    _scheduler.update_candidates(CUMULATIVE_EXPANSION, candidates);
+
+    ExpansionCandidate candidate;
+    ASSERT_TRUE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+    ASSERT_EQ(2, candidate.tablet_id);
+    ASSERT_FALSE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+
+    // 正在执行的table不会再次进入队列
+    _scheduler.set_disk_used("/disk1", true);
+    _scheduler.update_candidates(CUMULATIVE_EXPANSION, candidates);
+    ASSERT_TRUE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+    ASSERT_EQ(1, candidate.tablet_id);
+    ASSERT_FALSE(_scheduler.next_candidate(CUMULATIVE_EXPANSION, &candidate));
+    ASSERT_TRUE(_scheduler.need_update(CUMULATIVE_EXPANSION, 60));
+}
+
+TEST_F(ExpansionSchedulerTest, ComputeScore) {
+    config::expansion_score_bytes_per_delta = 100;
+    ASSERT_DOUBLE_EQ(10, ExpansionScheduler::compute_score(10, 0, 0));
+    ASSERT_DOUBLE_EQ(12, ExpansionScheduler::compute_score(10, 200, 0));
+    // 查询的读放大越大, 得分越高
+    ASSERT_DOUBLE_EQ(24, ExpansionScheduler::compute_score(10, 200, 1));
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
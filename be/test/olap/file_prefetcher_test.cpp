@@ -0,0 +1,154 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include "olap/column_file/file_prefetcher.h"
+#include "olap/file_helper.h"
+#include "olap/olap_define.h"
+#include "util/logging.h"
+#include "util/thread_pool.hpp"
+
+namespace palo {
+namespace column_file {
+
+const uint64_t FILE_SIZE = 1024 * 1024;
+
+class FilePrefetcherTest : public testing::Test {
+public:
+    virtual void SetUp() {
+        _file_name = "./file_prefetcher_test_file";
+        boost::filesystem::remove(_file_name);
+
+        FileHandler writer;
+        ASSERT_EQ(OLAP_SUCCESS, writer.open_with_mode(_file_name,
+                O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR));
+        std::string buf(FILE_SIZE, 'a');
+        ASSERT_EQ(OLAP_SUCCESS, writer.write(buf.c_str(), buf.size()));
+        ASSERT_EQ(OLAP_SUCCESS, writer.close());
+
+        ASSERT_EQ(OLAP_SUCCESS, _file_handler.open(_file_name, O_RDONLY));
+    }
+
+    virtual void TearDown() {
+        _file_handler.close();
+        boost::filesystem::remove(_file_name);
+    }
+
+    std::string _file_name;
+    FileHandler _file_handler;
+};
+
+TEST_F(FilePrefetcherTest, CoalesceRanges) {
+    FilePrefetcher prefetcher(&_file_handler, NULL, NULL);
+    prefetcher.add_range(1000, 100);
+    prefetcher.add_range(0, 100);
+    // 与[0, 100)间隔50字节, 会被合并
+    prefetcher.add_range(150, 50);
+    // 与前一个区间重叠
+    prefetcher.add_range(1050, 200);
+    prefetcher.add_range(5000, 0);
+    prefetcher.submit(64, 1024 * 1024, 1024 * 1024);
+
+    const std::vector<FilePrefetcher::Range>& chunks = prefetcher.chunks();
+    ASSERT_EQ(2, chunks.size());
+    ASSERT_EQ(0, chunks[0].offset);
+    ASSERT_EQ(200, chunks[0].length);
+    ASSERT_EQ(1000, chunks[1].offset);
+    ASSERT_EQ(250, chunks[1].length);
+
+    // 没有线程池时不做预读
+    prefetcher.cancel();
+    ASSERT_EQ(0, prefetcher.prefetched_bytes());
+}
+
+TEST_F(FilePrefetcherTest, SplitToChunks) {
+    FilePrefetcher prefetcher(&_file_handler, NULL, NULL);
+    prefetcher.add_range(0, 1000);
+    prefetcher.add_range(2000, 1000);
+    prefetcher.submit(0, 400, 1024);
+
+    const std::vector<FilePrefetcher::Range>& chunks = prefetcher.chunks();
+    ASSERT_EQ(6, chunks.size());
+    ASSERT_EQ(800, chunks[2].offset);
+    ASSERT_EQ(200, chunks[2].length);
+    ASSERT_EQ(2000, chunks[3].offset);
+    ASSERT_EQ(400, chunks[3].length);
+}
+
+TEST_F(FilePrefetcherTest, PrefetchAll) {
+    ThreadPool thread_pool(4, 64);
+    FilePrefetcher prefetcher(&_file_handler, &thread_pool, NULL);
+    prefetcher.add_range(0, FILE_SIZE / 2);
+    prefetcher.add_range(FILE_SIZE / 2 + 4096, FILE_SIZE / 2 - 4096);
+    // 同时在读的字节数比总量小, 需要在预读完成后继续提交
+    prefetcher.submit(0, 64 * 1024, 128 * 1024);
+
+    for (int i = 0; i < 100 && prefetcher.prefetched_bytes() < FILE_SIZE - 4096; ++i) {
+        usleep(10000);
+    }
+
+    prefetcher.cancel();
+    ASSERT_EQ(FILE_SIZE - 4096, prefetcher.prefetched_bytes());
+}
+
+TEST_F(FilePrefetcherTest, CancelPrefetch) {
+    ThreadPool thread_pool(1, 64);
+    FilePrefetcher* prefetcher = new FilePrefetcher(&_file_handler, &thread_pool, NULL);
+    prefetcher->add_range(0, FILE_SIZE);
+    prefetcher->submit(0, 4096, 4096);
+    // 析构时等待正在进行的预读结束, 之后不再访问文件
+    delete prefetcher;
+    ASSERT_EQ(0, thread_pool.get_queue_size());
+}
+
+TEST_F(FilePrefetcherTest, SharedInflightBytes) {
+    ThreadPool thread_pool(4, 64);
+    std::atomic<int64_t> inflight_bytes(0);
+    FilePrefetcher prefetcher1(&_file_handler, &thread_pool, &inflight_bytes);
+    FilePrefetcher prefetcher2(&_file_handler, &thread_pool, &inflight_bytes);
+    prefetcher1.add_range(0, FILE_SIZE / 2);
+    prefetcher2.add_range(FILE_SIZE / 2, FILE_SIZE / 2);
+    // 两个预读共用64K的限制, 每个仍至少有一个chunk在预读
+    prefetcher1.submit(0, 64 * 1024, 64 * 1024);
+    prefetcher2.submit(0, 64 * 1024, 64 * 1024);
+    ASSERT_GE(2 * 64 * 1024, inflight_bytes.load());
+
+    for (int i = 0; i < 100 && (prefetcher1.prefetched_bytes() < FILE_SIZE / 2
+                                || prefetcher2.prefetched_bytes() < FILE_SIZE / 2); ++i) {
+        usleep(10000);
+    }
+
+    prefetcher1.cancel();
+    prefetcher2.cancel();
+    ASSERT_EQ(FILE_SIZE / 2, prefetcher1.prefetched_bytes());
+    ASSERT_EQ(FILE_SIZE / 2, prefetcher2.prefetched_bytes());
+    ASSERT_EQ(0, inflight_bytes.load());
+}
+
+}  // namespace column_file
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
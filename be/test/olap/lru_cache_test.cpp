@@ -199,6 +199,19 @@ TEST_F(CacheTest, EvictionPolicy) {
     ASSERT_EQ(-1, Lookup(200));
 }
 
+TEST_F(CacheTest, ScanResistance) {
+    Insert(100, 101, 1);
+    ASSERT_EQ(101, Lookup(100));
+
+    // Entries inserted once by a big scan must not evict the entry that was hit before
+    for (int i = 0; i < 2 * kCacheSize; i++) {
+        Insert(1000 + i, 2000 + i, 1);
+    }
+
+    ASSERT_EQ(101, Lookup(100));
+    ASSERT_EQ(-1, Lookup(1000));
+}
+
 TEST_F(CacheTest, HeavyEntries) {
     // Add a bunch of light and heavy entries and then count the combined
     // size of items still in the cache, which must be approximately the
@@ -0,0 +1,244 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/merger.h"
+#include "olap/olap_main.cpp"
+#include "olap/tablet_test_util.h"
+#include "olap/utils.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_up() {
+    char buffer[MAX_PATH_LEN];
+    getcwd(buffer, MAX_PATH_LEN);
+    config::storage_root_path = string(buffer) + "/data_merger";
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+    create_dir(config::storage_root_path);
+    touch_all_singleton();
+}
+
+void tear_down() {
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+}
+
+// Merges the same versions serially and split into key ranges, the rows of both
+// results have to be the same.
+class TestMerger : public testing::Test {
+protected:
+    void SetUp() {
+        _old_rows_per_block = config::default_num_rows_per_column_file_block;
+        _old_min_row_blocks = config::expansion_merge_min_row_blocks;
+        // small row blocks, so that a few thousand rows are split into several ranges
+        config::default_num_rows_per_column_file_block = 16;
+
+        TCreateTabletReq request;
+        request.tablet_id = 10030;
+        request.__set_version(1);
+        request.__set_version_hash(0);
+        request.tablet_schema.schema_hash = 1508825678;
+        request.tablet_schema.short_key_column_count = 1;
+        request.tablet_schema.keys_type = TKeysType::AGG_KEYS;
+        request.tablet_schema.storage_type = TStorageType::COLUMN;
+        add_test_column(&request, "k1", TPrimitiveType::INT, true);
+        request.tablet_schema.columns[0].__set_is_allow_null(true);
+        add_test_column(&request, "k2", TPrimitiveType::INT, true);
+        add_test_column(&request, "v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+        add_test_column(&request, "v2", TPrimitiveType::INT, false, TAggregationType::REPLACE);
+        ASSERT_EQ(OLAP_SUCCESS, create_test_table(request, &_table));
+    }
+
+    void TearDown() {
+        for (size_t i = 0; i < _indices.size(); ++i) {
+            _indices[i]->delete_all_files();
+            SAFE_DELETE(_indices[i]);
+        }
+        drop_test_table(&_table);
+        config::default_num_rows_per_column_file_block = _old_rows_per_block;
+        config::expansion_merge_min_row_blocks = _old_min_row_blocks;
+    }
+
+    OLAPIndex* new_index(const Version& version, VersionHash version_hash) {
+        OLAPIndex* index = new(std::nothrow) OLAPIndex(
+                _table.get(), version, version_hash, false, 0, 0);
+        if (index != NULL) {
+            _indices.push_back(index);
+        }
+        return index;
+    }
+
+    // Writes version with rows (k1, k2) for k1 in [begin, end), each k1 has
+    // rows_per_key rows, so rows of the same short key span several row blocks.
+    // Rows with NULL and the min value of k1 are written first.
+    void write_version(int32_t version, int32_t begin, int32_t end, int32_t rows_per_key) {
+        vector<TestRow> rows;
+        for (int32_t k2 = 0; k2 < rows_per_key; ++k2) {
+            TestRow row;
+            row.push_back("NULL");
+            row.push_back(std::to_string(k2));
+            row.push_back(std::to_string(version));
+            row.push_back(std::to_string(version * 1000 + k2));
+            rows.push_back(row);
+        }
+        for (int32_t k2 = 0; k2 < rows_per_key; ++k2) {
+            TestRow row;
+            row.push_back(std::to_string(std::numeric_limits<int32_t>::min()));
+            row.push_back(std::to_string(k2));
+            row.push_back(std::to_string(version));
+            row.push_back(std::to_string(version * 1000 + k2));
+            rows.push_back(row);
+        }
+        for (int32_t k1 = begin; k1 < end; ++k1) {
+            for (int32_t k2 = 0; k2 < rows_per_key; ++k2) {
+                TestRow row;
+                row.push_back(std::to_string(k1));
+                row.push_back(std::to_string(k2));
+                row.push_back(std::to_string(version));
+                row.push_back(std::to_string(version * 1000 + k1 + k2));
+                rows.push_back(row);
+            }
+        }
+
+        OLAPIndex* index = new_index(Version(version, version), version);
+        ASSERT_TRUE(index != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, write_test_index(_table, rows, index));
+        _inputs.push_back(index);
+    }
+
+    // Merges all the versions written into a new index, which is read into rows.
+    void merge(int32_t min_row_blocks, VersionHash version_hash,
+               vector<string>* rows, uint32_t* num_segments, uint64_t* merged_rows) {
+        config::expansion_merge_min_row_blocks = min_row_blocks;
+
+        vector<IData*> olap_data_arr;
+        for (size_t i = 0; i < _inputs.size(); ++i) {
+            IData* olap_data = IData::create(_inputs[i]);
+            ASSERT_TRUE(olap_data != NULL);
+            olap_data_arr.push_back(olap_data);
+            ASSERT_EQ(OLAP_SUCCESS, olap_data->init());
+        }
+
+        Version version(_inputs.front()->version().first, _inputs.back()->version().second);
+        OLAPIndex* index = new_index(version, version_hash);
+        ASSERT_TRUE(index != NULL);
+
+        Merger merger(_table, index, READER_CUMULATIVE_EXPANSION);
+        uint64_t filted_rows = 0;
+        OLAPStatus res = merger.merge(olap_data_arr, false, merged_rows, &filted_rows);
+        for (size_t i = 0; i < olap_data_arr.size(); ++i) {
+            SAFE_DELETE(olap_data_arr[i]);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, res);
+        ASSERT_EQ(0, filted_rows);
+
+        ASSERT_EQ(OLAP_SUCCESS, index->load());
+        *num_segments = index->num_segments();
+        ASSERT_EQ(OLAP_SUCCESS, read_test_index(_table, index, rows));
+        ASSERT_EQ(merger.row_count(), rows->size());
+    }
+
+    void check_parallel_merge() {
+        vector<string> serial_rows;
+        uint32_t serial_segments = 0;
+        uint64_t serial_merged_rows = 0;
+        merge(0, 100, &serial_rows, &serial_segments, &serial_merged_rows);
+        ASSERT_EQ(1, serial_segments);
+
+        vector<string> parallel_rows;
+        uint32_t parallel_segments = 0;
+        uint64_t parallel_merged_rows = 0;
+        merge(2, 200, &parallel_rows, &parallel_segments, &parallel_merged_rows);
+        // every key range is written into its own segment
+        ASSERT_LT(1, parallel_segments);
+
+        ASSERT_EQ(serial_merged_rows, parallel_merged_rows);
+        ASSERT_EQ(serial_rows.size(), parallel_rows.size());
+        for (size_t i = 0; i < serial_rows.size(); ++i) {
+            ASSERT_EQ(serial_rows[i], parallel_rows[i]) << "row " << i;
+        }
+    }
+
+    SmartOLAPTable _table;
+    vector<OLAPIndex*> _indices;
+    vector<OLAPIndex*> _inputs;
+    int32_t _old_rows_per_block;
+    int32_t _old_min_row_blocks;
+};
+
+TEST_F(TestMerger, UniqueKeys) {
+    write_version(2, 0, 2000, 1);
+    check_parallel_merge();
+}
+
+TEST_F(TestMerger, OverlappingVersions) {
+    write_version(2, 0, 1000, 2);
+    write_version(3, 500, 1500, 2);
+    write_version(4, 200, 300, 2);
+    check_parallel_merge();
+}
+
+TEST_F(TestMerger, DuplicateKeysAcrossBlocks) {
+    // 50 rows of each k1 span about three row blocks, so most range boundaries
+    // fall inside a run of rows with the same short key
+    write_version(2, 0, 60, 50);
+    write_version(3, 30, 90, 50);
+    check_parallel_merge();
+}
+
+TEST_F(TestMerger, NullAndMinKeys) {
+    // boundaries among the leading NULL and min value keys, which strings can not restore
+    write_version(2, 0, 4, 200);
+    write_version(3, 2, 6, 200);
+    check_parallel_merge();
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::set_up();
+    int ret = RUN_ALL_TESTS();
+    palo::tear_down();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
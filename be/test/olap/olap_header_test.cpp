@@ -0,0 +1,187 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/olap_define.h"
+#include "olap/olap_header.h"
+#include "util/logging.h"
+
+using std::vector;
+
+namespace palo {
+
+// The header is not saved, only its version graph is used.
+class TestOLAPHeader : public testing::Test {
+public:
+    TestOLAPHeader() : _header("./test_olap_header.hdr") {}
+
+    virtual void SetUp() {
+        add_version(0, 1);
+        add_version(2, 2);
+        add_version(3, 3);
+        add_version(4, 4);
+        add_version(2, 4);
+        add_version(5, 5);
+    }
+
+    void add_version(int32_t start, int32_t end) {
+        ASSERT_EQ(OLAP_SUCCESS, _header.add_version(
+                Version(start, end), end, 1, 0, 100, 1000, 10));
+    }
+
+    // Selects the path of target twice, the second one is taken from the cache,
+    // both have to be the same as the path found by BFS.
+    void select(const Version& target, vector<Version>* path) {
+        path->clear();
+        ASSERT_EQ(OLAP_SUCCESS, _header.select_versions_to_span(target, path));
+        ASSERT_EQ(1, cached_paths(target));
+
+        vector<Version> cached_path;
+        ASSERT_EQ(OLAP_SUCCESS, _header.select_versions_to_span(target, &cached_path));
+        ASSERT_EQ(*path, cached_path);
+
+        vector<Version> recomputed_path;
+        ASSERT_EQ(OLAP_SUCCESS, _header._find_shortest_path(target, &recomputed_path));
+        ASSERT_EQ(*path, recomputed_path);
+
+        std::sort(path->begin(), path->end());
+    }
+
+    size_t cached_paths(const Version& target) {
+        return _header._span_path_cache.count(target);
+    }
+
+    size_t cache_size() {
+        return _header._span_path_cache.size();
+    }
+
+    static vector<Version> versions(const vector<std::pair<int32_t, int32_t>>& pairs) {
+        vector<Version> result;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            result.push_back(Version(pairs[i].first, pairs[i].second));
+        }
+        return result;
+    }
+
+    OLAPHeader _header;
+};
+
+TEST_F(TestOLAPHeader, CachedPathEqualsRecomputed) {
+    vector<Version> path;
+    select(Version(0, 5), &path);
+    ASSERT_EQ(versions({{0, 1}, {2, 4}, {5, 5}}), path);
+
+    select(Version(0, 3), &path);
+    ASSERT_EQ(versions({{0, 1}, {2, 2}, {3, 3}}), path);
+
+    select(Version(0, 4), &path);
+    ASSERT_EQ(versions({{0, 1}, {2, 4}}), path);
+    ASSERT_EQ(3, cache_size());
+
+    // the cached path is appended to the versions given
+    vector<Version> appended(1, Version(10, 10));
+    ASSERT_EQ(OLAP_SUCCESS, _header.select_versions_to_span(Version(0, 4), &appended));
+    ASSERT_EQ(3, appended.size());
+    ASSERT_EQ(Version(10, 10), appended[0]);
+}
+
+TEST_F(TestOLAPHeader, AddVersionInvalidatesCache) {
+    vector<Version> path;
+    select(Version(0, 5), &path);
+    ASSERT_EQ(3, path.size());
+
+    // base expansion of 0-5 makes a shorter path
+    add_version(0, 5);
+    ASSERT_EQ(0, cache_size());
+    select(Version(0, 5), &path);
+    ASSERT_EQ(versions({{0, 5}}), path);
+
+    // a new delta extends the versions which can be spanned
+    vector<Version> missing;
+    ASSERT_NE(OLAP_SUCCESS, _header.select_versions_to_span(Version(0, 6), &missing));
+    add_version(6, 6);
+    ASSERT_EQ(0, cache_size());
+    select(Version(0, 6), &path);
+    ASSERT_EQ(versions({{0, 5}, {6, 6}}), path);
+}
+
+TEST_F(TestOLAPHeader, DeleteVersionInvalidatesCache) {
+    add_version(0, 5);
+    vector<Version> path;
+    select(Version(0, 5), &path);
+    ASSERT_EQ(versions({{0, 5}}), path);
+
+    ASSERT_EQ(OLAP_SUCCESS, _header.delete_version(Version(0, 5)));
+    ASSERT_EQ(0, cache_size());
+    select(Version(0, 5), &path);
+    ASSERT_EQ(versions({{0, 1}, {2, 4}, {5, 5}}), path);
+
+    ASSERT_EQ(OLAP_SUCCESS, _header.delete_version(Version(2, 4)));
+    ASSERT_EQ(0, cache_size());
+    select(Version(0, 5), &path);
+    ASSERT_EQ(versions({{0, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}}), path);
+}
+
+TEST_F(TestOLAPHeader, DeleteAllVersionsInvalidatesCache) {
+    vector<Version> path;
+    select(Version(0, 5), &path);
+
+    ASSERT_EQ(OLAP_SUCCESS, _header.delete_all_versions());
+    ASSERT_EQ(0, cache_size());
+    path.clear();
+    ASSERT_NE(OLAP_SUCCESS, _header.select_versions_to_span(Version(0, 5), &path));
+    ASSERT_EQ(0, cache_size());
+
+    add_version(0, 5);
+    select(Version(0, 5), &path);
+    ASSERT_EQ(versions({{0, 5}}), path);
+}
+
+TEST_F(TestOLAPHeader, ReverseVersionInvalidatesCache) {
+    vector<Version> path;
+    select(Version(0, 5), &path);
+    _header.set_reverse_version(true);
+    ASSERT_EQ(0, cache_size());
+}
+
+TEST_F(TestOLAPHeader, CacheSizeIsBounded) {
+    for (int32_t i = 0; i < 100; ++i) {
+        add_version(6 + i, 6 + i);
+    }
+
+    vector<Version> path;
+    for (int32_t i = 0; i < 100; ++i) {
+        select(Version(0, 6 + i), &path);
+        ASSERT_LE(cache_size(), MAX_CACHED_SPAN_PATHS);
+    }
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/olap_index.h"
+#include "util/logging.h"
+
+using std::vector;
+
+namespace palo {
+
+class TestKeyPrefix : public testing::Test {
+public:
+    // Values have to be given in ascending order, their prefixes must not be in
+    // the reverse order. Prefixes of neighbours differ when strict is set.
+    template <typename T>
+    void check_order(FieldType type, const vector<T>& values, bool strict) {
+        uint64_t last = normalize_key_prefix(type, true, NULL);
+        ASSERT_EQ(0, last);
+        for (size_t i = 0; i < values.size(); ++i) {
+            char buf[sizeof(T)];
+            memcpy(buf, &values[i], sizeof(T));
+            uint64_t prefix = normalize_key_prefix(type, false, buf);
+            // NULL is smaller than all the values
+            ASSERT_LT(0, prefix);
+            if (strict) {
+                ASSERT_LT(last, prefix) << "value " << i;
+            } else {
+                ASSERT_LE(last, prefix) << "value " << i;
+            }
+            last = prefix;
+        }
+    }
+};
+
+TEST_F(TestKeyPrefix, SignedIntegersKeepOrder) {
+    vector<int8_t> tinyints = {-128, -127, -1, 0, 1, 126, 127};
+    check_order(OLAP_FIELD_TYPE_TINYINT, tinyints, true);
+
+    vector<int16_t> smallints = {-32768, -256, -1, 0, 1, 255, 256, 32767};
+    check_order(OLAP_FIELD_TYPE_SMALLINT, smallints, true);
+
+    vector<int32_t> ints = {std::numeric_limits<int32_t>::min(), -65536, -1, 0, 1,
+                            65535, 65536, std::numeric_limits<int32_t>::max()};
+    check_order(OLAP_FIELD_TYPE_INT, ints, true);
+
+    vector<int64_t> bigints = {std::numeric_limits<int64_t>::min(), -(1LL << 32), -2, 0, 2,
+                               1LL << 32, std::numeric_limits<int64_t>::max() - 1};
+    check_order(OLAP_FIELD_TYPE_BIGINT, bigints, true);
+}
+
+TEST_F(TestKeyPrefix, UnsignedIntegersKeepOrder) {
+    vector<uint8_t> tinyints = {0, 1, 127, 128, 255};
+    check_order(OLAP_FIELD_TYPE_UNSIGNED_TINYINT, tinyints, true);
+
+    vector<uint16_t> smallints = {0, 1, 255, 256, 32768, 65535};
+    check_order(OLAP_FIELD_TYPE_UNSIGNED_SMALLINT, smallints, true);
+
+    vector<uint32_t> ints = {0, 1, 65536, 0x80000000U, 0xffffffffU};
+    check_order(OLAP_FIELD_TYPE_UNSIGNED_INT, ints, true);
+
+    vector<uint64_t> bigints = {0, 2, 1ULL << 32, 1ULL << 63, 0xfffffffffffffffeULL};
+    check_order(OLAP_FIELD_TYPE_UNSIGNED_BIGINT, bigints, true);
+
+    // DATETIME is stored as an unsigned 64 bit integer
+    vector<uint64_t> datetimes = {19700101000000ULL, 20170101000000ULL, 20171231235959ULL};
+    check_order(OLAP_FIELD_TYPE_DATETIME, datetimes, true);
+}
+
+TEST_F(TestKeyPrefix, DateKeepsOrder) {
+    // DATE is stored as a little endian uint24_t of year * 16 * 32 + month * 32 + day
+    vector<uint32_t> dates = {1970 * 512 + 1 * 32 + 1,
+                              2017 * 512 + 1 * 32 + 31,
+                              2017 * 512 + 2 * 32 + 1,
+                              2018 * 512 + 1 * 32 + 1};
+    uint64_t last = 0;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        char buf[3];
+        buf[0] = dates[i] & 0xff;
+        buf[1] = (dates[i] >> 8) & 0xff;
+        buf[2] = (dates[i] >> 16) & 0xff;
+        uint64_t prefix = normalize_key_prefix(OLAP_FIELD_TYPE_DATE, false, buf);
+        ASSERT_LT(last, prefix) << "date " << i;
+        last = prefix;
+    }
+}
+
+TEST_F(TestKeyPrefix, LowestBitOf64BitValuesIsDropped) {
+    // prefixes of 64 bit values differing only in the lowest bit are equal,
+    // so the index compares such keys in full
+    vector<int64_t> bigints = {-2, -1, 0, 1, 2, 3};
+    check_order(OLAP_FIELD_TYPE_BIGINT, bigints, false);
+
+    int64_t a = 2;
+    int64_t b = 3;
+    ASSERT_EQ(normalize_key_prefix(OLAP_FIELD_TYPE_BIGINT, false, reinterpret_cast<char*>(&a)),
+              normalize_key_prefix(OLAP_FIELD_TYPE_BIGINT, false, reinterpret_cast<char*>(&b)));
+}
+
+TEST_F(TestKeyPrefix, SupportedTypes) {
+    ASSERT_TRUE(is_key_prefix_supported(OLAP_FIELD_TYPE_INT));
+    ASSERT_TRUE(is_key_prefix_supported(OLAP_FIELD_TYPE_DATE));
+    ASSERT_FALSE(is_key_prefix_supported(OLAP_FIELD_TYPE_CHAR));
+    ASSERT_FALSE(is_key_prefix_supported(OLAP_FIELD_TYPE_VARCHAR));
+    ASSERT_FALSE(is_key_prefix_supported(OLAP_FIELD_TYPE_DECIMAL));
+}
+
+TEST_F(TestKeyPrefix, SearchMatchesStdBounds) {
+    // sorted prefixes with runs of equal values, searched for present and absent values
+    for (size_t count = 0; count <= 70; ++count) {
+        vector<uint64_t> prefixes;
+        for (size_t i = 0; i < count; ++i) {
+            prefixes.push_back((i / 3) * 4 + 2);
+        }
+
+        for (uint64_t value = 0; value <= (count / 3) * 4 + 4; ++value) {
+            size_t lower = std::lower_bound(prefixes.begin(), prefixes.end(), value)
+                           - prefixes.begin();
+            size_t upper = std::upper_bound(prefixes.begin(), prefixes.end(), value)
+                           - prefixes.begin();
+            ASSERT_EQ(lower, search_key_prefix(prefixes.data(), count, value, false))
+                    << "count " << count << " value " << value;
+            ASSERT_EQ(upper, search_key_prefix(prefixes.data(), count, value, true))
+                    << "count " << count << " value " << value;
+        }
+    }
+}
+
+TEST_F(TestKeyPrefix, SearchExtremeValues) {
+    vector<uint64_t> prefixes = {0, 0, 1ULL << 63, std::numeric_limits<uint64_t>::max()};
+    ASSERT_EQ(0, search_key_prefix(prefixes.data(), prefixes.size(), 0, false));
+    ASSERT_EQ(2, search_key_prefix(prefixes.data(), prefixes.size(), 0, true));
+    ASSERT_EQ(3, search_key_prefix(prefixes.data(), prefixes.size(),
+                                   std::numeric_limits<uint64_t>::max(), false));
+    ASSERT_EQ(4, search_key_prefix(prefixes.data(), prefixes.size(),
+                                   std::numeric_limits<uint64_t>::max(), true));
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <gtest/gtest.h>
+
+#include "olap/column_file/byte_buffer.h"
+#include "olap/column_file/page_cache.h"
+#include "util/logging.h"
+
+namespace palo {
+namespace column_file {
+
+const uint32_t PAGE_SIZE = 1024;
+
+class PageCacheTest : public testing::Test {
+public:
+    virtual void SetUp() {
+        _page = ByteBuffer::create(PAGE_SIZE);
+        ASSERT_TRUE(_page != NULL);
+        for (uint32_t i = 0; i < PAGE_SIZE; ++i) {
+            ASSERT_EQ(OLAP_SUCCESS, _page->put(static_cast<char>(i)));
+        }
+        _page->flip();
+        _prefix = PageCache::key_prefix("./segment_0_1.dat", Version(0, 1));
+    }
+
+    virtual void TearDown() {
+        SAFE_DELETE(_page);
+    }
+
+    void check_page(ByteBuffer* page) {
+        ASSERT_TRUE(page != NULL);
+        ASSERT_EQ(0, page->position());
+        ASSERT_EQ(PAGE_SIZE, page->limit());
+        for (uint32_t i = 0; i < PAGE_SIZE; ++i) {
+            char value = 0;
+            ASSERT_EQ(OLAP_SUCCESS, page->get(&value));
+            ASSERT_EQ(static_cast<char>(i), value);
+        }
+    }
+
+    ByteBuffer* _page;
+    std::string _prefix;
+};
+
+TEST_F(PageCacheTest, InsertWithoutAdmission) {
+    PageCache cache(1024 * 1024, 0);
+    uint64_t compressed_length = 0;
+    ASSERT_TRUE(NULL == cache.lookup(_prefix, 100, &compressed_length));
+
+    cache.insert(_prefix, 100, 300, *_page);
+    ByteBuffer* page = cache.lookup(_prefix, 100, &compressed_length);
+    check_page(page);
+    ASSERT_EQ(300, compressed_length);
+    SAFE_DELETE(page);
+
+    // 位置或版本不同都不会命中
+    ASSERT_TRUE(NULL == cache.lookup(_prefix, 200, &compressed_length));
+    std::string other_prefix = PageCache::key_prefix("./segment_0_1.dat", Version(0, 2));
+    ASSERT_TRUE(NULL == cache.lookup(other_prefix, 100, &compressed_length));
+}
+
+TEST_F(PageCacheTest, AdmitOnSecondAccess) {
+    PageCache cache(1024 * 1024, 1024);
+    uint64_t compressed_length = 0;
+
+    // 第一次读取只记录key
+    cache.insert(_prefix, 100, 300, *_page);
+    ASSERT_TRUE(NULL == cache.lookup(_prefix, 100, &compressed_length));
+
+    cache.insert(_prefix, 100, 300, *_page);
+    ByteBuffer* page = cache.lookup(_prefix, 100, &compressed_length);
+    check_page(page);
+    SAFE_DELETE(page);
+}
+
+TEST_F(PageCacheTest, AdmissionKeysChargedBySize) {
+    const size_t admission_capacity = 64 * 1024;
+    PageCache cache(1024 * 1024, admission_capacity);
+
+    // 每个key按LRUHandle加上key本身的长度计费
+    cache.insert(_prefix, 0, 300, *_page);
+    size_t key_size = _prefix.size() + sizeof(uint64_t);
+    ASSERT_EQ(sizeof(LRUHandle) - 1 + key_size, cache.get_admission_memory_usage());
+
+    // 大量只读一次的数据块不会让记录的key超过容量
+    for (uint64_t offset = 1; offset < 100000; ++offset) {
+        cache.insert(_prefix, offset * PAGE_SIZE, 300, *_page);
+    }
+    ASSERT_GT(cache.get_admission_memory_usage(), 0);
+    // 每个分片的容量向上取整, 最多多出分片个数字节
+    ASSERT_LE(cache.get_admission_memory_usage(), admission_capacity + 256);
+    ASSERT_EQ(0, cache.get_memory_usage());
+}
+
+TEST_F(PageCacheTest, PageOutlivesCache) {
+    ByteBuffer* page = NULL;
+    {
+        PageCache cache(1024 * 1024, 0);
+        uint64_t compressed_length = 0;
+        cache.insert(_prefix, 100, 300, *_page);
+        page = cache.lookup(_prefix, 100, &compressed_length);
+        ASSERT_TRUE(page != NULL);
+    }
+
+    // 取出的引用共享缓存的内存, 数据块被淘汰后仍然可用
+    check_page(page);
+    SAFE_DELETE(page);
+}
+
+}  // namespace column_file
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
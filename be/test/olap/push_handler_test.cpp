@@ -0,0 +1,274 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/olap_main.cpp"
+#include "olap/push_handler.h"
+#include "olap/tablet_test_util.h"
+#include "olap/utils.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_up() {
+    char buffer[MAX_PATH_LEN];
+    getcwd(buffer, MAX_PATH_LEN);
+    config::storage_root_path = string(buffer) + "/data_push_handler";
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+    create_dir(config::storage_root_path);
+    touch_all_singleton();
+}
+
+void tear_down() {
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+}
+
+// Returns the given rows as a pushed file does, and fails reading row fail_row.
+// The checksum matches the empty file header unless wrong_checksum is set.
+class TestRowReader : public IBinaryReader {
+public:
+    TestRowReader(const vector<TestRow>& rows, size_t fail_row, bool wrong_checksum)
+            : _rows(rows), _fail_row(fail_row), _wrong_checksum(wrong_checksum) {}
+
+    virtual OLAPStatus init(SmartOLAPTable table, BinaryFile* file) {
+        _table = table;
+        _file = file;
+        _ready = true;
+        return OLAP_SUCCESS;
+    }
+
+    virtual OLAPStatus finalize() {
+        if (!_wrong_checksum) {
+            _adler_checksum = _file->checksum();
+        }
+        _ready = false;
+        return OLAP_SUCCESS;
+    }
+
+    virtual OLAPStatus next(RowCursor* row) {
+        if (!_ready || _curr == _fail_row) {
+            return OLAP_ERR_PUSH_INPUT_DATA_ERROR;
+        }
+        return fill_test_row(_rows[_curr++], row);
+    }
+
+    virtual bool eof() {
+        return _curr >= _rows.size();
+    }
+
+private:
+    vector<TestRow> _rows;
+    size_t _fail_row;
+    bool _wrong_checksum;
+};
+
+// Converts the same rows serially and split into chunks written by the push convert
+// thread pool, segments of chunks have to be stitched in the order of rows.
+class TestPushHandler : public testing::Test {
+protected:
+    void SetUp() {
+        _old_rows_per_block = config::default_num_rows_per_column_file_block;
+        _old_chunk_num = config::push_convert_chunk_num_per_push;
+        config::default_num_rows_per_column_file_block = 16;
+        // at most two chunks are buffered, so reading waits for written chunks
+        config::push_convert_chunk_num_per_push = 2;
+
+        TCreateTabletReq request;
+        request.tablet_id = 10040;
+        request.__set_version(1);
+        request.__set_version_hash(0);
+        request.tablet_schema.schema_hash = 1508825679;
+        request.tablet_schema.short_key_column_count = 1;
+        request.tablet_schema.keys_type = TKeysType::AGG_KEYS;
+        request.tablet_schema.storage_type = TStorageType::COLUMN;
+        add_test_column(&request, "k1", TPrimitiveType::INT, true);
+        request.tablet_schema.columns[0].__set_is_allow_null(true);
+        add_test_column(&request, "v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+        ASSERT_EQ(OLAP_SUCCESS, create_test_table(request, &_table));
+        ASSERT_TRUE(OLAPEngine::get_instance()->push_convert_thread_pool() != NULL);
+
+        // NULL is the smallest key
+        TestRow null_row;
+        null_row.push_back("NULL");
+        null_row.push_back("-1");
+        _rows.push_back(null_row);
+        for (int32_t k1 = 0; k1 < 1000; ++k1) {
+            TestRow row;
+            row.push_back(std::to_string(k1));
+            row.push_back(std::to_string(k1 * 10));
+            _rows.push_back(row);
+        }
+    }
+
+    void TearDown() {
+        for (size_t i = 0; i < _indices.size(); ++i) {
+            _indices[i]->delete_all_files();
+            SAFE_DELETE(_indices[i]);
+        }
+        drop_test_table(&_table);
+        config::default_num_rows_per_column_file_block = _old_rows_per_block;
+        config::push_convert_chunk_num_per_push = _old_chunk_num;
+    }
+
+    OLAPIndex* new_index(VersionHash version_hash) {
+        OLAPIndex* index = new(std::nothrow) OLAPIndex(
+                _table.get(), Version(2, 2), version_hash, false, 0, 0);
+        if (index != NULL) {
+            _indices.push_back(index);
+        }
+        return index;
+    }
+
+    // Converts rows into a new index, chunk_bytes of 0 converts serially and
+    // 1 makes every row block a chunk.
+    OLAPStatus convert(size_t chunk_bytes, VersionHash version_hash,
+                       size_t fail_row, bool wrong_checksum, OLAPIndex** index) {
+        *index = new_index(version_hash);
+        if (*index == NULL) {
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        PushHandler push_handler;
+        BinaryFile file;
+        TestRowReader reader(_rows, fail_row, wrong_checksum);
+        reader.init(_table, &file);
+        uint32_t num_rows = 0;
+        OLAPStatus res = OLAP_SUCCESS;
+        if (chunk_bytes == 0) {
+            res = push_handler._serial_convert(_table, &reader, *index, &num_rows);
+        } else {
+            res = push_handler._parallel_convert(_table, &reader, *index, chunk_bytes, &num_rows);
+        }
+
+        if (res == OLAP_SUCCESS) {
+            EXPECT_EQ(_rows.size(), num_rows);
+            res = (*index)->load();
+        }
+        return res;
+    }
+
+    // Files of temporary chunk indices have to be removed whether converting fails or not.
+    void check_no_chunk_files(VersionHash version_hash, size_t max_chunks) {
+        for (size_t i = 1; i <= max_chunks; ++i) {
+            string path = _table->construct_index_file_path(
+                    Version(2, 2), version_hash + i, 0);
+            ASSERT_FALSE(check_dir_existed(path)) << path;
+            path = _table->construct_data_file_path(Version(2, 2), version_hash + i, 0);
+            ASSERT_FALSE(check_dir_existed(path)) << path;
+        }
+    }
+
+    SmartOLAPTable _table;
+    vector<TestRow> _rows;
+    vector<OLAPIndex*> _indices;
+    int32_t _old_rows_per_block;
+    int32_t _old_chunk_num;
+};
+
+TEST_F(TestPushHandler, ParallelEqualsSerial) {
+    OLAPIndex* serial_index = NULL;
+    ASSERT_EQ(OLAP_SUCCESS, convert(0, 100, _rows.size(), false, &serial_index));
+    ASSERT_EQ(1, serial_index->num_segments());
+    vector<string> serial_rows;
+    ASSERT_EQ(OLAP_SUCCESS, read_test_index(_table, serial_index, &serial_rows));
+
+    OLAPIndex* parallel_index = NULL;
+    ASSERT_EQ(OLAP_SUCCESS, convert(1, 200, _rows.size(), false, &parallel_index));
+    // every row block is written as a chunk of its own segment
+    size_t num_blocks = (_rows.size() + 15) / 16;
+    ASSERT_EQ(num_blocks, parallel_index->num_segments());
+    vector<string> parallel_rows;
+    ASSERT_EQ(OLAP_SUCCESS, read_test_index(_table, parallel_index, &parallel_rows));
+
+    ASSERT_EQ(_rows.size(), serial_rows.size());
+    ASSERT_EQ(serial_rows.size(), parallel_rows.size());
+    for (size_t i = 0; i < _rows.size(); ++i) {
+        ASSERT_EQ(test_row_string(_rows[i]), serial_rows[i]) << "row " << i;
+        ASSERT_EQ(serial_rows[i], parallel_rows[i]) << "row " << i;
+    }
+    check_no_chunk_files(200, num_blocks);
+}
+
+TEST_F(TestPushHandler, LastChunkNotFull) {
+    // chunks of about three row blocks, the last chunk and its last block are not full
+    _rows.resize(16 * 7 + 5);
+    RowBlock row_block(_table->tablet_schema());
+    RowBlockInfo block_info(0U, _table->num_rows_per_row_block(), 0);
+    block_info.data_file_type = COLUMN_ORIENTED_FILE;
+    block_info.null_supported = true;
+    ASSERT_EQ(OLAP_SUCCESS, row_block.init(block_info));
+
+    OLAPIndex* index = NULL;
+    ASSERT_EQ(OLAP_SUCCESS, convert(row_block.buf_len() * 3, 300, _rows.size(), false, &index));
+    ASSERT_EQ(3, index->num_segments());
+    vector<string> rows;
+    ASSERT_EQ(OLAP_SUCCESS, read_test_index(_table, index, &rows));
+    ASSERT_EQ(_rows.size(), rows.size());
+    for (size_t i = 0; i < _rows.size(); ++i) {
+        ASSERT_EQ(test_row_string(_rows[i]), rows[i]) << "row " << i;
+    }
+}
+
+TEST_F(TestPushHandler, ReadErrorWithChunksRunning) {
+    // fails after several chunks have been handed to the thread pool
+    OLAPIndex* index = NULL;
+    ASSERT_EQ(OLAP_ERR_PUSH_INPUT_DATA_ERROR, convert(1, 400, 500, false, &index));
+    ASSERT_EQ(0, index->num_segments());
+    check_no_chunk_files(400, (_rows.size() + 15) / 16);
+}
+
+TEST_F(TestPushHandler, WrongChecksum) {
+    OLAPIndex* index = NULL;
+    ASSERT_EQ(OLAP_ERR_PUSH_BUILD_DELTA_ERROR, convert(1, 500, _rows.size(), true, &index));
+    ASSERT_EQ(0, index->num_segments());
+    check_no_chunk_files(500, (_rows.size() + 15) / 16);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::set_up();
+    int ret = RUN_ALL_TESTS();
+    palo::tear_down();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
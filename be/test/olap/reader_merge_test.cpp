@@ -0,0 +1,229 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/olap_main.cpp"
+#include "olap/tablet_test_util.h"
+#include "olap/utils.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_up() {
+    char buffer[MAX_PATH_LEN];
+    getcwd(buffer, MAX_PATH_LEN);
+    config::storage_root_path = string(buffer) + "/data_reader_merge";
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+    create_dir(config::storage_root_path);
+    touch_all_singleton();
+}
+
+void tear_down() {
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+}
+
+// Checks rows merged by Reader against rows aggregated in memory, which are in the
+// order the heap merge returned them: sorted by key, values of the same key
+// aggregated from lower versions to higher ones.
+class TestReaderMerge : public testing::Test {
+protected:
+    struct AggValue {
+        int64_t sum;
+        int32_t max;
+        int32_t min;
+        int32_t replace;
+    };
+
+    typedef std::map<std::pair<int32_t, int32_t>, AggValue> ExpectedRows;
+
+    void SetUp() {
+        TCreateTabletReq request;
+        request.tablet_id = 10010;
+        request.__set_version(1);
+        request.__set_version_hash(0);
+        request.tablet_schema.schema_hash = 1508825676;
+        request.tablet_schema.short_key_column_count = 1;
+        request.tablet_schema.keys_type = TKeysType::AGG_KEYS;
+        request.tablet_schema.storage_type = TStorageType::COLUMN;
+        add_test_column(&request, "k1", TPrimitiveType::INT, true);
+        add_test_column(&request, "k2", TPrimitiveType::INT, true);
+        add_test_column(&request, "v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+        add_test_column(&request, "v2", TPrimitiveType::INT, false, TAggregationType::MAX);
+        add_test_column(&request, "v3", TPrimitiveType::INT, false, TAggregationType::MIN);
+        add_test_column(&request, "v4", TPrimitiveType::INT, false, TAggregationType::REPLACE);
+        ASSERT_EQ(OLAP_SUCCESS, create_test_table(request, &_table));
+        _version = 1;
+    }
+
+    void TearDown() {
+        drop_test_table(&_table);
+    }
+
+    // Writes a version with rows (k1, 0) and (k1, 1) for k1 in [begin, end) by step.
+    void write_version(int32_t begin, int32_t end, int32_t step) {
+        ++_version;
+        vector<TestRow> rows;
+        for (int32_t k1 = begin; k1 < end; k1 += step) {
+            for (int32_t k2 = 0; k2 < 2; ++k2) {
+                int32_t value = (k1 * 7 + k2 * 3 + _version * 13) % 101;
+                TestRow row;
+                row.push_back(std::to_string(k1));
+                row.push_back(std::to_string(k2));
+                for (int i = 0; i < 4; ++i) {
+                    row.push_back(std::to_string(value));
+                }
+                rows.push_back(row);
+
+                std::pair<int32_t, int32_t> key(k1, k2);
+                ExpectedRows::iterator it = _expected.find(key);
+                if (it == _expected.end()) {
+                    AggValue agg = {value, value, value, value};
+                    _expected[key] = agg;
+                } else {
+                    it->second.sum += value;
+                    it->second.max = std::max(it->second.max, value);
+                    it->second.min = std::min(it->second.min, value);
+                    it->second.replace = value;
+                }
+            }
+        }
+        ASSERT_EQ(OLAP_SUCCESS, write_test_delta(_table, Version(_version, _version), rows));
+    }
+
+    // Deletes rows with k1 less than value from all versions written before.
+    void delete_less_than(int32_t value) {
+        ++_version;
+        TCondition condition;
+        condition.column_name = "k1";
+        condition.condition_op = "<";
+        condition.condition_values.push_back(std::to_string(value));
+        vector<TCondition> conditions(1, condition);
+        ASSERT_EQ(OLAP_SUCCESS, delete_test_data(_table, _version, conditions));
+
+        _expected.erase(_expected.begin(),
+                        _expected.lower_bound(std::make_pair(value, INT32_MIN)));
+    }
+
+    void check_rows() {
+        vector<string> rows;
+        ASSERT_EQ(OLAP_SUCCESS, read_test_table(_table, _version, &rows));
+
+        vector<string> expected_rows;
+        for (ExpectedRows::const_iterator it = _expected.begin(); it != _expected.end(); ++it) {
+            TestRow row;
+            row.push_back(std::to_string(it->first.first));
+            row.push_back(std::to_string(it->first.second));
+            row.push_back(std::to_string(it->second.sum));
+            row.push_back(std::to_string(it->second.max));
+            row.push_back(std::to_string(it->second.min));
+            row.push_back(std::to_string(it->second.replace));
+            expected_rows.push_back(test_row_string(row));
+        }
+
+        ASSERT_EQ(expected_rows.size(), rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            ASSERT_EQ(expected_rows[i], rows[i]) << "row " << i;
+        }
+    }
+
+    SmartOLAPTable _table;
+    int32_t _version;
+    ExpectedRows _expected;
+};
+
+TEST_F(TestReaderMerge, NonOverlappingVersions) {
+    // each version is a single run, versions are not written in key order
+    write_version(2000, 3000, 1);
+    write_version(0, 1000, 1);
+    write_version(1000, 2000, 1);
+    check_rows();
+}
+
+TEST_F(TestReaderMerge, InterleavedVersions) {
+    // no two adjacent rows come from the same version
+    write_version(0, 3000, 3);
+    write_version(1, 3000, 3);
+    write_version(2, 3000, 3);
+    check_rows();
+}
+
+TEST_F(TestReaderMerge, OverlappingVersionsWithSameKeys) {
+    write_version(0, 3000, 2);
+    write_version(0, 3000, 3);
+    write_version(0, 1000, 1);
+    check_rows();
+}
+
+TEST_F(TestReaderMerge, RunsAndOverlaps) {
+    write_version(0, 1000, 1);
+    write_version(500, 1500, 1);
+    write_version(2000, 3000, 1);
+    write_version(1400, 2100, 50);
+    write_version(2999, 4000, 1);
+    check_rows();
+}
+
+TEST_F(TestReaderMerge, DeleteVersions) {
+    write_version(0, 1000, 1);
+    write_version(500, 1500, 1);
+    delete_less_than(700);
+    // rows of versions after the delete are not deleted
+    write_version(0, 800, 4);
+    write_version(1400, 1600, 1);
+    check_rows();
+
+    delete_less_than(100);
+    write_version(50, 150, 1);
+    check_rows();
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::set_up();
+    int ret = RUN_ALL_TESTS();
+    palo::tear_down();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
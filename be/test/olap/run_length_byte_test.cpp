@@ -18,6 +18,7 @@
 // under the License.
 
 #include <gtest/gtest.h>
+#include "common/config.h"
 
 #include "olap/column_file/byte_buffer.h"
 #include "olap/column_file/out_stream.h"
@@ -275,6 +276,154 @@ TEST(TestStream, CompressOutStream2) {
 }
 
 
+TEST(TestStream, ZstdCompressOutStream) {
+    OutStream *out_stream = 
+            new(std::nothrow) OutStream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, zstd_compress);
+    ASSERT_TRUE(out_stream != NULL);
+
+    for (int32_t i = 0; i < OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE; i++) {
+        out_stream->write(static_cast<char>(i % 7));
+    }
+    out_stream->write(0x5a);
+    out_stream->flush();
+    ASSERT_LT(out_stream->get_stream_length(), OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+
+    std::vector<ByteBuffer*> inputs;
+    std::vector<uint64_t> offsets;
+    uint64_t offset = 0;
+    std::vector<ByteBuffer*>::const_iterator it = out_stream->output_buffers().begin();
+    for (; it != out_stream->output_buffers().end(); ++it) {
+        ByteBuffer *tmp_byte_buffer = ByteBuffer::reference_buffer(*it, 0, (*it)->limit());
+        inputs.push_back(tmp_byte_buffer);
+        offsets.push_back(offset);
+        offset += (*it)->limit();
+    }
+    InStream *in_stream = 
+            new (std::nothrow) InStream(&inputs, 
+                                        offsets, 
+                                        out_stream->get_stream_length(), 
+                                        zstd_decompress, 
+                                        out_stream->get_total_buffer_size());
+
+    char data;
+    for (int32_t i = 0; i < OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE; i++) {
+        ASSERT_EQ(in_stream->read(&data), OLAP_SUCCESS);
+        ASSERT_EQ(data, static_cast<char>(i % 7));
+    }
+    ASSERT_EQ(in_stream->read(&data), OLAP_SUCCESS);
+    ASSERT_EQ(data, 0x5a);
+
+    ASSERT_NE(in_stream->read(&data), OLAP_SUCCESS);
+
+    SAFE_DELETE(in_stream);
+    SAFE_DELETE(out_stream);
+}
+
+TEST(TestStream, AdaptiveCompressOutStream) {
+    // data which can not be compressed is written without compression
+    OutStream *out_stream = new(std::nothrow) OutStream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    ASSERT_TRUE(out_stream != NULL);
+    out_stream->set_adaptive_compress();
+
+    srand(1);
+    for (int32_t i = 0; i < OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE; i++) {
+        out_stream->write(static_cast<char>(rand()));
+    }
+    out_stream->flush();
+    ASSERT_EQ(COMPRESS_NONE, out_stream->compress_kind());
+
+    StreamHead head;
+    out_stream->output_buffers()[0]->get((char *)&head, sizeof(head));
+    ASSERT_EQ(head.type, StreamHead::UNCOMPRESSED);
+    SAFE_DELETE(out_stream);
+
+    // data which is compressed well chooses a compressor
+    out_stream = new(std::nothrow) OutStream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    ASSERT_TRUE(out_stream != NULL);
+    out_stream->set_adaptive_compress();
+
+    for (int32_t i = 0; i < OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE; i++) {
+        out_stream->write(0x5a);
+    }
+    out_stream->flush();
+    ASSERT_NE(COMPRESS_NONE, out_stream->compress_kind());
+
+    out_stream->output_buffers()[0]->get((char *)&head, sizeof(head));
+    ASSERT_EQ(head.type, StreamHead::COMPRESSED);
+    SAFE_DELETE(out_stream);
+}
+
+TEST(TestStream, ChooseCompressKind) {
+    int32_t old_min_saving = config::adaptive_compress_min_saving_percent;
+    int32_t old_zstd_gain = config::adaptive_compress_zstd_min_gain_percent;
+    config::adaptive_compress_min_saving_percent = 10;
+    config::adaptive_compress_zstd_min_gain_percent = 15;
+
+    // neither saves 10%
+    ASSERT_EQ(COMPRESS_NONE, OutStream::choose_compress_kind(1000, 950, 910));
+    ASSERT_EQ(COMPRESS_NONE, OutStream::choose_compress_kind(1000, 1000, 1000));
+    // only lz4 saves enough
+    ASSERT_EQ(COMPRESS_LZ4, OutStream::choose_compress_kind(1000, 900, 1000));
+    // zstd is smaller, but not 15% smaller than lz4
+    ASSERT_EQ(COMPRESS_LZ4, OutStream::choose_compress_kind(1000, 500, 430));
+    ASSERT_EQ(COMPRESS_ZSTD, OutStream::choose_compress_kind(1000, 500, 425));
+    // zstd saves enough while lz4 does not
+    ASSERT_EQ(COMPRESS_ZSTD, OutStream::choose_compress_kind(1000, 1000, 800));
+
+    config::adaptive_compress_min_saving_percent = old_min_saving;
+    config::adaptive_compress_zstd_min_gain_percent = old_zstd_gain;
+}
+
+TEST(TestStream, AdaptiveCompressIsDeterministic) {
+    // the same data always chooses the same codec, and is read back by it
+    CompressKind first_kind = COMPRESS_NONE;
+    for (int32_t round = 0; round < 3; ++round) {
+        OutStream *out_stream =
+                new(std::nothrow) OutStream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+        ASSERT_TRUE(out_stream != NULL);
+        out_stream->set_adaptive_compress();
+
+        for (int32_t i = 0; i < OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE; i++) {
+            out_stream->write(static_cast<char>(i % 7 == 0 ? i : 'a'));
+        }
+        out_stream->flush();
+        ASSERT_NE(COMPRESS_NONE, out_stream->compress_kind());
+        if (round == 0) {
+            first_kind = out_stream->compress_kind();
+        }
+        ASSERT_EQ(first_kind, out_stream->compress_kind());
+
+        Decompressor decompressor = NULL;
+        ASSERT_EQ(OLAP_SUCCESS, get_decompressor(out_stream->compress_kind(), &decompressor));
+
+        std::vector<ByteBuffer*> inputs;
+        std::vector<uint64_t> offsets;
+        uint64_t offset = 0;
+        std::vector<ByteBuffer*>::const_iterator it = out_stream->output_buffers().begin();
+        for (; it != out_stream->output_buffers().end(); ++it) {
+            inputs.push_back(ByteBuffer::reference_buffer(*it, 0, (*it)->limit()));
+            offsets.push_back(offset);
+            offset += (*it)->limit();
+        }
+        InStream *in_stream =
+                new (std::nothrow) InStream(&inputs,
+                                            offsets,
+                                            out_stream->get_stream_length(),
+                                            decompressor,
+                                            out_stream->get_total_buffer_size());
+
+        char data;
+        for (int32_t i = 0; i < OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE; i++) {
+            ASSERT_EQ(in_stream->read(&data), OLAP_SUCCESS);
+            ASSERT_EQ(data, static_cast<char>(i % 7 == 0 ? i : 'a'));
+        }
+        ASSERT_NE(in_stream->read(&data), OLAP_SUCCESS);
+
+        SAFE_DELETE(in_stream);
+        SAFE_DELETE(out_stream);
+    }
+}
+
 TEST(TestStream, CompressOutStream3) {
     // write data
     OutStream *out_stream = 
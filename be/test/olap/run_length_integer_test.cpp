@@ -19,6 +19,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "olap/column_file/byte_buffer.h"
 #include "olap/column_file/out_stream.h"
 #include "olap/column_file/in_stream.h"
@@ -26,6 +29,8 @@
 #include "olap/column_file/run_length_integer_reader.h"
 #include "olap/column_file/stream_index_writer.h"
 #include "olap/column_file/stream_index_reader.h"
+#include "olap/utils.h"
+#include "util/cpu_info.h"
 #include "util/logging.h"
 
 namespace palo {
@@ -837,6 +842,122 @@ TEST_F(TestRunLengthSignInteger, DirectEncodingForDeltaOverflows2) {
    
 }
 
+// Generate runs which are encoded as short repeat, delta with fixed delta,
+// delta, direct (with different bit widths) and patched base.
+static void make_mixed_runs(int32_t num_runs, std::vector<int64_t>* data) {
+    srand(1);
+
+    for (int32_t run = 0; run < num_runs; ++run) {
+        int32_t len = 1 + rand() % 600;
+        int64_t base = rand();
+
+        for (int32_t i = 0; i < len; ++i) {
+            switch (run % 5) {
+            case 0:
+                data->push_back(base % 100);
+                break;
+            case 1:
+                data->push_back(base + i * 7);
+                break;
+            case 2:
+                data->push_back(base);
+                base -= rand() % 1000;
+                break;
+            case 3:
+                data->push_back(rand() % (1L << (run % 40 + 1)));
+                break;
+            default:
+                data->push_back(i % 50 == 0 ? static_cast<int64_t>(rand()) << 20 : rand() % 256);
+                break;
+            }
+        }
+    }
+}
+
+TEST_F(TestRunLengthSignInteger, NextBatch) {
+    std::vector<int64_t> write_data;
+    make_mixed_runs(500, &write_data);
+
+    for (size_t i = 0; i < write_data.size(); i++) {
+        ASSERT_EQ(OLAP_SUCCESS, _writer->write(write_data[i]));
+    }
+    ASSERT_EQ(OLAP_SUCCESS, _writer->flush());
+
+    CreateReader();
+
+    std::vector<int64_t> read_data(write_data.size());
+    size_t offset = 0;
+    while (offset < write_data.size()) {
+        uint32_t num = std::min(write_data.size() - offset, 97UL);
+        ASSERT_EQ(OLAP_SUCCESS, _reader->next_batch(&read_data[offset], num));
+        offset += num;
+    }
+
+    for (size_t i = 0; i < write_data.size(); i++) {
+        ASSERT_EQ(write_data[i], read_data[i]);
+    }
+    ASSERT_FALSE(_reader->has_next());
+
+    int64_t value = 0;
+    ASSERT_NE(OLAP_SUCCESS, _reader->next_batch(&value, 1));
+}
+
+// Compare decoding by next() with next_batch(), with and without SIMD unpacking.
+// It is a benchmark and not run with the unit tests, run it by
+// --gtest_also_run_disabled_tests --gtest_filter=*BatchDecodeBenchmark
+TEST_F(TestRunLengthSignInteger, DISABLED_BatchDecodeBenchmark) {
+    const uint32_t num_values = 1024 * 1024;
+    std::vector<int64_t> write_data;
+    make_mixed_runs(5000, &write_data);
+    write_data.resize(num_values, 0);
+
+    PositionEntryWriter index_entry;
+    _writer->get_position(&index_entry, false);
+    for (uint32_t i = 0; i < num_values; i++) {
+        ASSERT_EQ(OLAP_SUCCESS, _writer->write(write_data[i]));
+    }
+    ASSERT_EQ(OLAP_SUCCESS, _writer->flush());
+
+    CreateReader();
+
+    PositionEntryReader entry;
+    entry._positions = index_entry._positions;
+    entry._positions_count = index_entry._positions_count;
+    entry._statistics.init(OLAP_FIELD_TYPE_NONE, false);
+
+    std::vector<int64_t> read_data(num_values);
+    const uint32_t batch_size = 1024;
+    const char* names[] = {"next", "next_batch scalar", "next_batch simd"};
+    // SSE4.1 can only be switched on again on a cpu that supports it
+    bool support_sse4_1 = CpuInfo::is_supported(CpuInfo::SSE4_1);
+    int32_t rounds = support_sse4_1 ? 3 : 2;
+
+    for (int32_t round = 0; round < rounds; ++round) {
+        if (support_sse4_1) {
+            CpuInfo::enable_feature(CpuInfo::SSE4_1, round == 2);
+        }
+        PositionProvider position(&entry);
+        ASSERT_EQ(OLAP_SUCCESS, _reader->seek(&position));
+
+        OlapStopWatch watch;
+        for (uint32_t i = 0; i < num_values; i += batch_size) {
+            if (round == 0) {
+                for (uint32_t j = i; j < i + batch_size; ++j) {
+                    ASSERT_EQ(OLAP_SUCCESS, _reader->next(&read_data[j]));
+                }
+            } else {
+                ASSERT_EQ(OLAP_SUCCESS, _reader->next_batch(&read_data[i], batch_size));
+            }
+        }
+        LOG(INFO) << names[round] << ": decode " << num_values << " values in "
+                  << watch.get_elapse_time_us() << "us";
+
+        for (uint32_t i = 0; i < num_values; i++) {
+            ASSERT_EQ(write_data[i], read_data[i]);
+        }
+    }
+}
+
 }
 }
 
@@ -847,6 +968,7 @@ int main(int argc, char** argv) {
         return -1;
     }
     palo::init_glog("be-test");
+    palo::CpuInfo::init();
     int ret = palo::OLAP_SUCCESS;
     testing::InitGoogleTest(&argc, argv);
     ret = RUN_ALL_TESTS();
@@ -0,0 +1,285 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/olap_main.cpp"
+#include "olap/schema_change.h"
+#include "olap/tablet_test_util.h"
+#include "olap/utils.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_up() {
+    char buffer[MAX_PATH_LEN];
+    getcwd(buffer, MAX_PATH_LEN);
+    config::storage_root_path = string(buffer) + "/data_schema_change";
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+    create_dir(config::storage_root_path);
+    touch_all_singleton();
+}
+
+void tear_down() {
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+}
+
+class TestSchemaChange : public testing::Test {
+protected:
+    void SetUp() {
+        _old_rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = 16;
+        _ref_index = NULL;
+    }
+
+    void TearDown() {
+        for (size_t i = 0; i < _indices.size(); ++i) {
+            _indices[i]->delete_all_files();
+            SAFE_DELETE(_indices[i]);
+        }
+        drop_test_table(&_new_table);
+        drop_test_table(&_ref_table);
+        config::default_num_rows_per_column_file_block = _old_rows_per_block;
+    }
+
+    // Request of a tablet without columns.
+    void init_request(TTabletId tablet_id, TSchemaHash schema_hash, TCreateTabletReq* request) {
+        request->tablet_id = tablet_id;
+        request->__set_version(1);
+        request->__set_version_hash(0);
+        request->tablet_schema.schema_hash = schema_hash;
+        request->tablet_schema.short_key_column_count = 1;
+        request->tablet_schema.keys_type = TKeysType::AGG_KEYS;
+        request->tablet_schema.storage_type = TStorageType::COLUMN;
+    }
+
+    void create_table(TTabletId tablet_id, TSchemaHash schema_hash,
+                      const vector<string>& keys, SmartOLAPTable* table) {
+        TCreateTabletReq request;
+        init_request(tablet_id, schema_hash, &request);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            add_test_column(&request, keys[i], TPrimitiveType::INT, true);
+        }
+        add_test_column(&request, "v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+        ASSERT_EQ(OLAP_SUCCESS, create_test_table(request, table));
+    }
+
+    OLAPIndex* new_index(SmartOLAPTable table, VersionHash version_hash) {
+        OLAPIndex* index = new(std::nothrow) OLAPIndex(
+                table.get(), Version(2, 2), version_hash, false, 0, 0);
+        if (index != NULL) {
+            _indices.push_back(index);
+        }
+        return index;
+    }
+
+    // Sorts rows of _ref_index into a new index of _new_table, whose keys are
+    // (k2, k1) instead of (k1, k2). The thread pool is not used unless parallel.
+    void sort_rows(bool parallel, size_t memory_limitation, VersionHash version_hash,
+                   vector<string>* rows, size_t* num_runs) {
+        RowBlockChanger changer(_new_table->tablet_schema(), _ref_table);
+        changer.get_mutable_column_mapping(0)->ref_column = 1;
+        changer.get_mutable_column_mapping(1)->ref_column = 0;
+        changer.get_mutable_column_mapping(2)->ref_column = 2;
+
+        SchemaChangeWithSorting schema_change(_new_table, changer, memory_limitation);
+        if (parallel) {
+            ASSERT_TRUE(schema_change._thread_pool != NULL);
+        } else {
+            schema_change._thread_pool = NULL;
+        }
+
+        std::unique_ptr<IData> data(IData::create(_ref_index));
+        ASSERT_TRUE(data.get() != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, data->init());
+
+        OLAPIndex* index = new_index(_new_table, version_hash);
+        ASSERT_TRUE(index != NULL);
+        ASSERT_TRUE(schema_change.process(data.get(), index));
+        *num_runs = schema_change._num_runs;
+
+        ASSERT_EQ(OLAP_SUCCESS, index->load());
+        ASSERT_EQ(OLAP_SUCCESS, read_test_index(_new_table, index, rows));
+    }
+
+    SmartOLAPTable _ref_table;
+    SmartOLAPTable _new_table;
+    OLAPIndex* _ref_index;
+    vector<OLAPIndex*> _indices;
+    int32_t _old_rows_per_block;
+};
+
+TEST_F(TestSchemaChange, ParallelSortingEqualsSerial) {
+    vector<string> ref_keys;
+    ref_keys.push_back("k1");
+    ref_keys.push_back("k2");
+    create_table(10050, 1508825680, ref_keys, &_ref_table);
+    vector<string> new_keys;
+    new_keys.push_back("k2");
+    new_keys.push_back("k1");
+    create_table(10051, 1508825681, new_keys, &_new_table);
+
+    // rows of the same k2 are spread over all the runs
+    vector<TestRow> rows;
+    vector<TestRow> expected_rows;
+    for (int32_t k1 = 0; k1 < 1000; ++k1) {
+        TestRow row;
+        row.push_back(std::to_string(k1));
+        row.push_back(std::to_string(k1 % 7));
+        row.push_back(std::to_string(k1 * 10));
+        rows.push_back(row);
+        std::swap(row[0], row[1]);
+        expected_rows.push_back(row);
+    }
+    std::sort(expected_rows.begin(), expected_rows.end(),
+              [](const TestRow& a, const TestRow& b) {
+                  return std::make_pair(std::stoi(a[0]), std::stoi(a[1]))
+                         < std::make_pair(std::stoi(b[0]), std::stoi(b[1]));
+              });
+
+    _ref_index = new_index(_ref_table, 2);
+    ASSERT_TRUE(_ref_index != NULL);
+    ASSERT_EQ(OLAP_SUCCESS, write_test_index(_ref_table, rows, _ref_index));
+
+    // a few KB of memory holds a few dozens of row blocks, so rows are sorted in several runs
+    vector<string> serial_rows;
+    size_t serial_runs = 0;
+    sort_rows(false, 8192, 100, &serial_rows, &serial_runs);
+    ASSERT_LT(1, serial_runs);
+
+    vector<string> parallel_rows;
+    size_t parallel_runs = 0;
+    sort_rows(true, 8192, 200, &parallel_rows, &parallel_runs);
+    ASSERT_LT(1, parallel_runs);
+
+    ASSERT_EQ(expected_rows.size(), serial_rows.size());
+    ASSERT_EQ(serial_rows.size(), parallel_rows.size());
+    for (size_t i = 0; i < expected_rows.size(); ++i) {
+        ASSERT_EQ(test_row_string(expected_rows[i]), serial_rows[i]) << "row " << i;
+        ASSERT_EQ(serial_rows[i], parallel_rows[i]) << "row " << i;
+    }
+}
+
+TEST_F(TestSchemaChange, LinkedSchemaChangeAddAndDropColumns) {
+    TCreateTabletReq ref_request;
+    init_request(10052, 1508825682, &ref_request);
+    add_test_column(&ref_request, "k1", TPrimitiveType::INT, true);
+    add_test_column(&ref_request, "v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+    add_test_column(&ref_request, "v2", TPrimitiveType::INT, false, TAggregationType::SUM);
+    ASSERT_EQ(OLAP_SUCCESS, create_test_table(ref_request, &_ref_table));
+
+    vector<TestRow> rows;
+    for (int32_t k1 = 0; k1 < 100; ++k1) {
+        TestRow row;
+        row.push_back(std::to_string(k1));
+        row.push_back(std::to_string(k1 * 10));
+        row.push_back(std::to_string(k1 + 1));
+        rows.push_back(row);
+    }
+    ASSERT_EQ(OLAP_SUCCESS, write_test_delta(_ref_table, Version(2, 2), rows));
+
+    // the delete condition is kept, since k1 is not changed
+    vector<TCondition> conditions;
+    TCondition condition;
+    condition.column_name = "k1";
+    condition.condition_op = "<";
+    condition.condition_values.push_back("10");
+    conditions.push_back(condition);
+    ASSERT_EQ(OLAP_SUCCESS, delete_test_data(_ref_table, 3, conditions));
+
+    // drop v2, add v3 with a default value and nullable v4
+    TCreateTabletReq new_request;
+    init_request(10052, 1508825683, &new_request);
+    add_test_column(&new_request, "k1", TPrimitiveType::INT, true);
+    add_test_column(&new_request, "v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+    add_test_column(&new_request, "v3", TPrimitiveType::INT, false, TAggregationType::SUM);
+    new_request.tablet_schema.columns.back().__set_default_value("7");
+    add_test_column(&new_request, "v4", TPrimitiveType::INT, false, TAggregationType::SUM);
+    new_request.tablet_schema.columns.back().__set_is_allow_null(true);
+
+    TAlterTabletReq request;
+    request.base_tablet_id = ref_request.tablet_id;
+    request.base_schema_hash = ref_request.tablet_schema.schema_hash;
+    request.__set_new_tablet_req(new_request);
+
+    CommandExecutor command_executor;
+    ASSERT_EQ(OLAP_SUCCESS, command_executor.schema_change(request));
+    ASSERT_EQ(ALTER_TABLE_DONE, command_executor.show_alter_table_status(
+            request.base_tablet_id, request.base_schema_hash));
+    _new_table = command_executor.get_table(
+            new_request.tablet_id, new_request.tablet_schema.schema_hash);
+    ASSERT_TRUE(_new_table.get() != NULL);
+
+    // segments are linked instead of rewritten
+    struct stat ref_stat;
+    struct stat new_stat;
+    string ref_path = _ref_table->construct_data_file_path(Version(2, 2), 2, 0);
+    string new_path = _new_table->construct_data_file_path(Version(2, 2), 2, 0);
+    ASSERT_EQ(0, stat(ref_path.c_str(), &ref_stat));
+    ASSERT_EQ(0, stat(new_path.c_str(), &new_stat));
+    ASSERT_EQ(ref_stat.st_ino, new_stat.st_ino);
+
+    vector<string> new_rows;
+    ASSERT_EQ(OLAP_SUCCESS, read_test_table(_new_table, 3, &new_rows));
+    ASSERT_EQ(90, new_rows.size());
+    for (int32_t k1 = 10; k1 < 100; ++k1) {
+        TestRow row;
+        row.push_back(std::to_string(k1));
+        row.push_back(std::to_string(k1 * 10));
+        row.push_back("7");
+        row.push_back("NULL");
+        ASSERT_EQ(test_row_string(row), new_rows[k1 - 10]);
+    }
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::set_up();
+    int ret = RUN_ALL_TESTS();
+    palo::tear_down();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
@@ -0,0 +1,263 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/column_file/segment_reader.h"
+#include "olap/delete_handler.h"
+#include "olap/olap_main.cpp"
+#include "olap/tablet_test_util.h"
+#include "olap/utils.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+
+void set_up() {
+    char buffer[MAX_PATH_LEN];
+    getcwd(buffer, MAX_PATH_LEN);
+    config::storage_root_path = string(buffer) + "/data_segment_reader";
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+    create_dir(config::storage_root_path);
+    touch_all_singleton();
+}
+
+void tear_down() {
+    remove_all_dir(config::storage_root_path);
+    remove_all_dir(string(getenv("PALO_HOME")) + UNUSED_PREFIX);
+}
+
+namespace column_file {
+
+// Rows k1 0..63 are written in 4 blocks of 16 rows, blocks are classified by
+// the min and max of k1 in each block against the delete conditions.
+class TestSegmentReader : public testing::Test {
+protected:
+    void SetUp() {
+        _old_rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = 16;
+
+        TCreateTabletReq request;
+        request.tablet_id = 10060;
+        request.__set_version(1);
+        request.__set_version_hash(0);
+        request.tablet_schema.schema_hash = 1508825684;
+        request.tablet_schema.short_key_column_count = 1;
+        request.tablet_schema.keys_type = TKeysType::AGG_KEYS;
+        request.tablet_schema.storage_type = TStorageType::COLUMN;
+        add_test_column(&request, "k1", TPrimitiveType::INT, true);
+        add_test_column(&request, "v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+        ASSERT_EQ(OLAP_SUCCESS, create_test_table(request, &_table));
+
+        vector<TestRow> rows;
+        for (int32_t k1 = 0; k1 < 64; ++k1) {
+            TestRow row;
+            row.push_back(std::to_string(k1));
+            row.push_back(std::to_string(k1));
+            rows.push_back(row);
+        }
+        ASSERT_EQ(OLAP_SUCCESS, write_test_delta(_table, Version(2, 2), rows));
+    }
+
+    void TearDown() {
+        // the reader keeps a copy of delete handler sharing its conditions
+        _reader.reset();
+        _delete_handler.finalize();
+        if (!_sources.empty()) {
+            _table->release_data_sources(&_sources);
+        }
+        drop_test_table(&_table);
+        config::default_num_rows_per_column_file_block = _old_rows_per_block;
+    }
+
+    void add_delete_condition(int64_t version, const vector<TCondition>& conditions) {
+        ASSERT_EQ(OLAP_SUCCESS, delete_test_data(_table, version, conditions));
+    }
+
+    static TCondition condition(const string& op, const string& value) {
+        TCondition condition;
+        condition.column_name = "k1";
+        condition.condition_op = op;
+        condition.condition_values.push_back(value);
+        return condition;
+    }
+
+    // Opens the only segment of version 2 with delete conditions up to version,
+    // seeks to all blocks and reads the rows not deleted.
+    void read_segment(int32_t version, vector<string>* rows) {
+        _table->obtain_header_rdlock();
+        _table->acquire_data_sources(Version(2, 2), &_sources);
+        OLAPStatus res = _delete_handler.init(_table, version);
+        _table->release_header_lock();
+        ASSERT_EQ(OLAP_SUCCESS, res);
+        ASSERT_EQ(1, _sources.size());
+
+        OLAPIndex* index = _sources[0]->olap_index();
+        vector<uint32_t> return_columns;
+        return_columns.push_back(0);
+        return_columns.push_back(1);
+        std::set<uint32_t> load_bf_columns;
+        _reader.reset(new SegmentReader(
+                _table->construct_data_file_path(index->version(), index->version_hash(), 0),
+                _table.get(), index, 0, return_columns, load_bf_columns, NULL,
+                _delete_handler, DEL_PARTIAL_SATISFIED, NULL));
+        ASSERT_EQ(OLAP_SUCCESS, _reader->init(false));
+        ASSERT_EQ(4, _reader->_block_count);
+        ASSERT_EQ(OLAP_SUCCESS, _reader->seek_to_block(0, _reader->_block_count - 1, false));
+
+        rows->clear();
+        const RowCursor* row = NULL;
+        while (NULL != (row = _reader->get_next_row(false))) {
+            rows->push_back(row->to_string());
+        }
+    }
+
+    uint8_t block_status(uint32_t block) {
+        return _reader->_include_blocks[block];
+    }
+
+    const vector<uint32_t>& block_delete_conditions(uint32_t block) {
+        return _reader->_block_delete_conditions[block];
+    }
+
+    uint64_t filted_rows() {
+        return _reader->get_filted_rows();
+    }
+
+    int32_t _old_rows_per_block;
+    SmartOLAPTable _table;
+    vector<IData*> _sources;
+    DeleteHandler _delete_handler;
+    std::unique_ptr<SegmentReader> _reader;
+};
+
+TEST_F(TestSegmentReader, ClassifyBlocksByDeleteConditions) {
+    // condition 0 covers block 0
+    vector<TCondition> conditions;
+    conditions.push_back(condition("<=", "15"));
+    add_delete_condition(3, conditions);
+
+    // condition 1 deletes a part of block 1
+    conditions.clear();
+    conditions.push_back(condition(">=", "20"));
+    conditions.push_back(condition("<=", "25"));
+    add_delete_condition(4, conditions);
+
+    // condition 2 deletes a part of block 2
+    conditions.clear();
+    conditions.push_back(condition("=", "40"));
+    add_delete_condition(5, conditions);
+
+    vector<string> rows;
+    read_segment(5, &rows);
+
+    ASSERT_EQ(DEL_SATISFIED, block_status(0));
+    ASSERT_EQ(DEL_PARTIAL_SATISFIED, block_status(1));
+    ASSERT_EQ(DEL_PARTIAL_SATISFIED, block_status(2));
+    ASSERT_EQ(DEL_NOT_SATISFIED, block_status(3));
+
+    // only conditions partially satisfied by a block are evaluated for its rows
+    ASSERT_TRUE(block_delete_conditions(0).empty());
+    ASSERT_EQ(vector<uint32_t>(1, 1), block_delete_conditions(1));
+    ASSERT_EQ(vector<uint32_t>(1, 2), block_delete_conditions(2));
+    ASSERT_TRUE(block_delete_conditions(3).empty());
+
+    vector<string> expected;
+    for (int32_t k1 = 16; k1 < 64; ++k1) {
+        if ((k1 >= 20 && k1 <= 25) || k1 == 40) {
+            continue;
+        }
+        TestRow row;
+        row.push_back(std::to_string(k1));
+        row.push_back(std::to_string(k1));
+        expected.push_back(test_row_string(row));
+    }
+    ASSERT_EQ(expected, rows);
+    // 16 rows of block 0, 6 rows of block 1 and 1 row of block 2
+    ASSERT_EQ(23, filted_rows());
+
+    // the same rows are read by a query
+    vector<string> query_rows;
+    ASSERT_EQ(OLAP_SUCCESS, read_test_table(_table, 5, &query_rows));
+    ASSERT_EQ(expected, query_rows);
+}
+
+TEST_F(TestSegmentReader, PartialBlockKeepsConditionsOfAllBlocks) {
+    // the condition 0 is partially satisfied by blocks 1 and 2, and the
+    // condition 1 by block 2 only, block 2 has to evaluate both of them
+    vector<TCondition> conditions;
+    conditions.push_back(condition(">=", "30"));
+    conditions.push_back(condition("<=", "33"));
+    add_delete_condition(3, conditions);
+
+    conditions.clear();
+    conditions.push_back(condition("=", "47"));
+    add_delete_condition(4, conditions);
+
+    vector<string> rows;
+    read_segment(4, &rows);
+
+    ASSERT_EQ(DEL_NOT_SATISFIED, block_status(0));
+    ASSERT_EQ(DEL_PARTIAL_SATISFIED, block_status(1));
+    ASSERT_EQ(DEL_PARTIAL_SATISFIED, block_status(2));
+    ASSERT_EQ(DEL_NOT_SATISFIED, block_status(3));
+
+    ASSERT_TRUE(block_delete_conditions(0).empty());
+    ASSERT_EQ(vector<uint32_t>(1, 0), block_delete_conditions(1));
+    vector<uint32_t> expected_conditions;
+    expected_conditions.push_back(0);
+    expected_conditions.push_back(1);
+    ASSERT_EQ(expected_conditions, block_delete_conditions(2));
+    ASSERT_TRUE(block_delete_conditions(3).empty());
+
+    ASSERT_EQ(59, rows.size());
+    ASSERT_EQ(5, filted_rows());
+}
+
+}  // namespace column_file
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::set_up();
+    int ret = RUN_ALL_TESTS();
+    palo::tear_down();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
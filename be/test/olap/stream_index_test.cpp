@@ -322,6 +322,61 @@ TEST_F(TestStreamIndex, test_statistic) {
     ASSERT_STREQ(stat2.maximum()->to_string().c_str(), "6");
 }
 
+TEST_F(TestStreamIndex, statistic_with_null) {
+    ColumnStatistics stat;
+    ASSERT_EQ(OLAP_SUCCESS, stat.init(OLAP_FIELD_TYPE_INT, true));
+
+    Field* field = Field::create_by_type(OLAP_FIELD_TYPE_INT);
+    ASSERT_TRUE(field->allocate());
+
+    field->set_null();
+    stat.add(field);
+    ASSERT_TRUE(stat.has_null());
+    ASSERT_TRUE(stat.all_null());
+
+    field->set_not_null();
+    field->from_string("7");
+    stat.add(field);
+    field->from_string("-3");
+    stat.add(field);
+    ASSERT_TRUE(stat.has_null());
+    ASSERT_FALSE(stat.all_null());
+
+    char buf[256];
+    ASSERT_EQ(OLAP_SUCCESS, stat.write_to_buffer(buf, sizeof(buf)));
+
+    // null values are kept out of the value range
+    ColumnStatistics stat2;
+    ASSERT_EQ(OLAP_SUCCESS, stat2.init(OLAP_FIELD_TYPE_INT, true));
+    stat2.set_null_aware(true);
+    stat2.attach(buf);
+    ASSERT_TRUE(stat2.has_null());
+    ASSERT_FALSE(stat2.all_null());
+    ASSERT_FALSE(stat2.minimum()->is_null());
+    ASSERT_STREQ(stat2.minimum()->to_string().c_str(), "-3");
+    ASSERT_STREQ(stat2.maximum()->to_string().c_str(), "7");
+
+    // readers of the old format see null as the minimum
+    ColumnStatistics stat3;
+    ASSERT_EQ(OLAP_SUCCESS, stat3.init(OLAP_FIELD_TYPE_INT, true));
+    stat3.attach(buf);
+    ASSERT_TRUE(stat3.minimum()->is_null());
+    ASSERT_FALSE(stat3.maximum()->is_null());
+    ASSERT_TRUE(stat3.has_null());
+    ASSERT_FALSE(stat3.all_null());
+
+    stat.reset();
+    field->set_null();
+    stat.add(field);
+    ASSERT_EQ(OLAP_SUCCESS, stat.write_to_buffer(buf, sizeof(buf)));
+    stat2.attach(buf);
+    ASSERT_TRUE(stat2.all_null());
+    stat3.attach(buf);
+    ASSERT_TRUE(stat3.all_null());
+
+    SAFE_DELETE(field);
+}
+
 TEST_F(TestStreamIndex, statistic) {
     StreamIndexWriter writer(OLAP_FIELD_TYPE_INT);
     PositionEntryWriter entry;
@@ -0,0 +1,268 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_TEST_OLAP_TABLET_TEST_UTIL_H
+#define BDG_PALO_BE_TEST_OLAP_TABLET_TEST_UTIL_H
+
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gen_cpp/AgentService_types.h"
+#include "olap/command_executor.h"
+#include "olap/i_data.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_index.h"
+#include "olap/olap_table.h"
+#include "olap/reader.h"
+#include "olap/row_cursor.h"
+#include "olap/writer.h"
+
+namespace palo {
+
+// Helpers for tests which need rows in a tablet. Deltas are written with IWriter
+// directly instead of pushing a file. Rows are given and returned as column values
+// in string format, "NULL" stands for a null value.
+
+typedef std::vector<std::string> TestRow;
+
+// Appends a column to the schema of request, aggregation is ignored for key columns.
+inline void add_test_column(TCreateTabletReq* request,
+                            const std::string& name,
+                            TPrimitiveType::type type,
+                            bool is_key,
+                            TAggregationType::type aggregation = TAggregationType::SUM,
+                            int32_t len = 0) {
+    TColumn column;
+    column.column_name = name;
+    column.column_type.type = type;
+    if (len > 0) {
+        column.column_type.__set_len(len);
+    }
+    column.__set_is_key(is_key);
+    if (!is_key) {
+        column.__set_aggregation_type(aggregation);
+    }
+    request->tablet_schema.columns.push_back(column);
+}
+
+inline OLAPStatus create_test_table(const TCreateTabletReq& request, SmartOLAPTable* table) {
+    CommandExecutor command_executor;
+    OLAPStatus res = command_executor.create_table(request);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    *table = command_executor.get_table(request.tablet_id, request.tablet_schema.schema_hash);
+    return table->get() == NULL ? OLAP_ERR_TABLE_NOT_FOUND : OLAP_SUCCESS;
+}
+
+// Drops table and waits until its header file is removed.
+inline void drop_test_table(SmartOLAPTable* table) {
+    if (table->get() == NULL) {
+        return;
+    }
+
+    std::string header_file_name = (*table)->header_file_name();
+    TTabletId tablet_id = (*table)->tablet_id();
+    TSchemaHash schema_hash = (*table)->schema_hash();
+    table->reset();
+    OLAPEngine::get_instance()->drop_table(tablet_id, schema_hash);
+    while (0 == access(header_file_name.c_str(), F_OK)) {
+        sleep(1);
+    }
+}
+
+// Sets row to values, row is attached to the buffer it is written to.
+inline OLAPStatus fill_test_row(const TestRow& values, RowCursor* row) {
+    TestRow not_null_values(values);
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values[i] == "NULL") {
+            not_null_values[i] = "0";
+        }
+    }
+
+    OLAPStatus res = row->from_string(not_null_values);
+    for (size_t i = 0; res == OLAP_SUCCESS && i < values.size(); ++i) {
+        res = (values[i] == "NULL") ? row->set_null(i) : row->set_not_null(i);
+    }
+    return res;
+}
+
+// Writes rows into index in the given order, index is loaded after writing.
+inline OLAPStatus write_test_index(SmartOLAPTable table,
+                                   const std::vector<TestRow>& rows,
+                                   OLAPIndex* index) {
+    std::unique_ptr<IWriter> writer(IWriter::create(table, index, true));
+    if (writer.get() == NULL) {
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    RowCursor row;
+    OLAPStatus res = writer->init();
+    if (res == OLAP_SUCCESS) {
+        res = row.init(table->tablet_schema());
+    }
+
+    for (size_t i = 0; res == OLAP_SUCCESS && i < rows.size(); ++i) {
+        res = writer->attached_by(&row);
+        if (res == OLAP_SUCCESS) {
+            res = fill_test_row(rows[i], &row);
+        }
+        if (res == OLAP_SUCCESS) {
+            writer->next(row);
+        }
+    }
+
+    if (res == OLAP_SUCCESS) {
+        res = writer->finalize();
+    }
+    if (res == OLAP_SUCCESS) {
+        res = index->load();
+    }
+    return res;
+}
+
+// Writes rows as a new data version of table, like a push without delete conditions.
+inline OLAPStatus write_test_delta(SmartOLAPTable table,
+                                   const Version& version,
+                                   const std::vector<TestRow>& rows) {
+    OLAPIndex* index = new(std::nothrow) OLAPIndex(
+            table.get(), version, version.second, false, 0, 0);
+    if (index == NULL) {
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    OLAPStatus res = write_test_index(table, rows, index);
+    if (res == OLAP_SUCCESS) {
+        table->obtain_push_lock();
+        table->obtain_header_wrlock();
+        res = table->register_data_source(index);
+        if (res == OLAP_SUCCESS) {
+            // index is owned by table now
+            index = NULL;
+            res = table->save_header();
+        }
+        table->release_header_lock();
+        table->release_push_lock();
+    }
+
+    if (index != NULL) {
+        index->delete_all_files();
+        SAFE_DELETE(index);
+    }
+    return res;
+}
+
+// Adds delete conditions with an empty delta of version, as a DELETE push does.
+inline OLAPStatus delete_test_data(SmartOLAPTable table,
+                                   int64_t version,
+                                   const std::vector<TCondition>& conditions) {
+    TPushReq request;
+    request.tablet_id = table->tablet_id();
+    request.schema_hash = table->schema_hash();
+    request.version = version;
+    request.version_hash = version;
+    request.timeout = 86400;
+    request.push_type = TPushType::DELETE;
+    request.__set_delete_conditions(conditions);
+
+    CommandExecutor command_executor;
+    std::vector<TTabletInfo> tablet_infos;
+    return command_executor.delete_data(request, &tablet_infos);
+}
+
+inline OLAPStatus read_test_rows(const ReaderParams& params, std::vector<std::string>* rows) {
+    Reader reader;
+    OLAPStatus res = reader.init(params);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    RowCursor row;
+    if ((res = row.init(params.olap_table->tablet_schema())) != OLAP_SUCCESS) {
+        return res;
+    }
+
+    rows->clear();
+    bool eof = false;
+    int64_t raw_rows_read = 0;
+    while (true) {
+        res = reader.next_row_with_aggregation(&row, &raw_rows_read, &eof);
+        if (res != OLAP_SUCCESS || eof) {
+            break;
+        }
+        rows->push_back(row.to_string());
+    }
+    return res;
+}
+
+// Reads rows of versions [0, version] of table as a query does.
+inline OLAPStatus read_test_table(SmartOLAPTable table,
+                                  int32_t version,
+                                  std::vector<std::string>* rows) {
+    ReaderParams params;
+    params.olap_table = table;
+    params.reader_type = READER_FETCH;
+    params.aggregation = true;
+    params.version = Version(0, version);
+    for (uint32_t i = 0; i < table->tablet_schema().size(); ++i) {
+        params.return_columns.push_back(i);
+    }
+    return read_test_rows(params, rows);
+}
+
+// Reads rows of index, which is not required to be registered in table.
+inline OLAPStatus read_test_index(SmartOLAPTable table,
+                                  OLAPIndex* index,
+                                  std::vector<std::string>* rows) {
+    std::unique_ptr<IData> data(IData::create(index));
+    if (data.get() == NULL) {
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+    OLAPStatus res = data->init();
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    ReaderParams params;
+    params.olap_table = table;
+    params.reader_type = READER_CUMULATIVE_EXPANSION;
+    params.olap_data_arr.push_back(data.get());
+    return read_test_rows(params, rows);
+}
+
+// Formats values as RowCursor::to_string() does, to compare with rows read.
+inline std::string test_row_string(const TestRow& values) {
+    std::string result;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            result.append("|");
+        }
+        result.append(values[i] == "NULL" ? "1&NULL" : "0&" + values[i]);
+    }
+    return result;
+}
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_TEST_OLAP_TABLET_TEST_UTIL_H
@@ -20,33 +20,51 @@
 
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <sstream>
+
 #include "runtime/dpp_sink.h"
 
+#include "common/config.h"
+#include "common/object_pool.h"
 #include "exprs/expr.h"
-#include "exprs/expr.h"
+#include "gen_cpp/Descriptors_types.h"
+#include "gen_cpp/Exprs_types.h"
 #include "runtime/descriptors.h"
-#include "runtime/runtime_state.h"
-#include "runtime/runtime_state.h"
+#include "runtime/dpp_sink_internal.h"
+#include "runtime/exec_env.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
 #include "runtime/row_batch.h"
-#include "runtime/tuple_row.h"
+#include "runtime/runtime_state.h"
+#include "runtime/tmp_file_mgr.h"
 #include "runtime/tuple.h"
-#include "runtime/mem_pool.h"
-#include "runtime/dpp_sink_internal.h"
-#include "gen_cpp/Descriptors_types.h"
-#include "common/object_pool.h"
+#include "runtime/tuple_row.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
 #include "util/file_utils.h"
+#include "util/runtime_profile.h"
 
 namespace palo {
 
 class DppSinkTest : public testing::Test {
 public:
-    DppSinkTest() {
+    DppSinkTest() : _tuple_pool(&_tracker) {
+        _exec_env.init_for_tests();
+        std::vector<std::string> tmp_dirs;
+        tmp_dirs.push_back(_load_dir);
+        FileUtils::create_dir(_load_dir);
+        _exec_env.tmp_file_mgr()->init_custom(tmp_dirs, false, _exec_env.metrics());
+
         init_desc_tbl();
         init_row_desc();
         init_runtime_state();
         init_rollups();
     }
     ~DppSinkTest() {
+        for (auto& it : _rollups) {
+            it.second->close(_state);
+        }
     }
 
     void init_desc_tbl();
@@ -59,60 +77,92 @@ public:
 
 protected:
     virtual void SetUp() {
+        _old_spill_threshold = config::etl_sort_spill_threshold_bytes;
     }
     virtual void TearDown() {
+        config::etl_sort_spill_threshold_bytes = _old_spill_threshold;
+    }
+
+    // Adds a row (col1, col2, col3) to batch, col1 is NULL if it is negative.
+    void add_row(RowBatch* batch, int col1, int col2, int col3);
+
+    // Runs num_batches batches of rows through a sink and reads the output file of
+    // rollup "base". Rows are spilled when they exceed spill_threshold bytes.
+    void run_sink(const std::string& label, int64_t spill_threshold, int num_batches,
+                  std::string* output, int64_t* spilled_runs);
+
+    SlotDescriptor* slot_desc(int id) {
+        return _desc_tbl->get_slot_descriptor(id);
     }
 
-private:
     ObjectPool _obj_pool;
+    ExecEnv _exec_env;
+    MemTracker _tracker;
     TDescriptorTable _t_desc_tbl;
     DescriptorTbl* _desc_tbl;
     RowDescriptor* _row_desc;
     RuntimeState* _state;
     MemPool _tuple_pool;
     std::map<std::string, RollupSchema*> _rollups;
-    ExecEnv _exec_env;
+    int64_t _old_spill_threshold;
+    static const std::string _load_dir;
 };
 
+const std::string DppSinkTest::_load_dir = "./tmp_data";
+
+static TExpr create_slot_ref(SlotId slot_id) {
+    TExprNode node;
+    node.node_type = TExprNodeType::SLOT_REF;
+    node.type = gen_type_desc(TPrimitiveType::INT);
+    node.num_children = 0;
+    node.__isset.slot_ref = true;
+    node.slot_ref.slot_id = slot_id;
+    node.slot_ref.tuple_id = 0;
+
+    TExpr expr;
+    expr.nodes.push_back(node);
+    return expr;
+}
+
 void DppSinkTest::init_rollups() {
+    // base: (col1, col2) -> sum(col3)
     {
+        TRollupSchema t_schema;
+        t_schema.keys.push_back(create_slot_ref(0));
+        t_schema.keys.push_back(create_slot_ref(1));
+        t_schema.values.push_back(create_slot_ref(2));
+        t_schema.value_ops.push_back(TAggregationType::SUM);
+
         RollupSchema* schema = _obj_pool.add(new RollupSchema());
-        {
-            SlotRef* ref = _obj_pool.add(new SlotRef(PrimitiveType::TYPE_INT, 1));
-            schema->_keys.push_back(ref);
-        }
-        {
-            SlotRef* ref = _obj_pool.add(new SlotRef(PrimitiveType::TYPE_INT, 5));
-            schema->_keys.push_back(ref);
-        }
-        {
-            SlotRef* ref = _obj_pool.add(new SlotRef(PrimitiveType::TYPE_INT, 9));
-            schema->_values.push_back(ref);
-            schema->_value_ops.push_back(TAggregationType::SUM);
-        }
+        ASSERT_TRUE(RollupSchema::from_thrift(&_obj_pool, t_schema, schema).ok());
+        ASSERT_TRUE(schema->prepare(_state, *_row_desc, _state->instance_mem_tracker()).ok());
+        ASSERT_TRUE(schema->open(_state).ok());
         _rollups.insert(std::make_pair("base", schema));
     }
+    // rollup: col1 -> sum(col3)
     {
+        TRollupSchema t_schema;
+        t_schema.keys.push_back(create_slot_ref(0));
+        t_schema.values.push_back(create_slot_ref(2));
+        t_schema.value_ops.push_back(TAggregationType::SUM);
+
         RollupSchema* schema = _obj_pool.add(new RollupSchema());
-        {
-            SlotRef* ref = _obj_pool.add(new SlotRef(PrimitiveType::TYPE_INT, 0));
-            schema->_keys.push_back(ref);
-        }
-        {
-            SlotRef* ref = _obj_pool.add(new SlotRef(PrimitiveType::TYPE_INT, 8));
-            schema->_values.push_back(ref);
-            schema->_value_ops.push_back(TAggregationType::SUM);
-        }
+        ASSERT_TRUE(RollupSchema::from_thrift(&_obj_pool, t_schema, schema).ok());
+        ASSERT_TRUE(schema->prepare(_state, *_row_desc, _state->instance_mem_tracker()).ok());
+        ASSERT_TRUE(schema->open(_state).ok());
         _rollups.insert(std::make_pair("rollup", schema));
     }
 }
 
 void DppSinkTest::init_runtime_state() {
-    _state = _obj_pool.add(new RuntimeState("2011-10-01 12:34:56"));
+    TQueryOptions query_options;
+    query_options.batch_size = 64;
+    _state = _obj_pool.add(new RuntimeState(
+            TUniqueId(), query_options, "2011-10-01 12:34:56", &_exec_env));
+    _state->init_mem_trackers(TUniqueId());
     _state->set_desc_tbl(_desc_tbl);
-    _state->_load_dir = "./tmp_data";
-    FileUtils::create_dir(_state->_load_dir);
-    _state->_exec_env = &_exec_env;
+    std::string load_dir = _load_dir;
+    _state->set_load_dir(load_dir);
 }
 
 void DppSinkTest::init_row_desc() {
@@ -128,51 +178,19 @@ void DppSinkTest::init_desc_tbl() {
     // slot desc
     std::vector<TSlotDescriptor> slot_descs;
 
-    // 1 byte null, 4 byte int, 4 byte int
-    // slot 0
-    {
+    // 1 byte null, 4 byte int, 4 byte int, 4 byte int
+    const char* col_names[] = {"col1", "col2", "col3"};
+    for (int i = 0; i < 3; ++i) {
         TSlotDescriptor t_slot_desc;
-        t_slot_desc.__set_id(0);
+        t_slot_desc.__set_id(i);
         t_slot_desc.__set_parent(0);
-        t_slot_desc.__set_slotType(TPrimitiveType::INT);
-        t_slot_desc.__set_columnPos(0);
-        t_slot_desc.__set_byteOffset(1);
+        t_slot_desc.__set_slotType(gen_type_desc(TPrimitiveType::INT));
+        t_slot_desc.__set_columnPos(i);
+        t_slot_desc.__set_byteOffset(1 + 4 * i);
         t_slot_desc.__set_nullIndicatorByte(0);
-        t_slot_desc.__set_nullIndicatorBit(1);
-        t_slot_desc.__set_colName("col1");
-        t_slot_desc.__set_slotIdx(0);
-        t_slot_desc.__set_isMaterialized(true);
-
-        slot_descs.push_back(t_slot_desc);
-    }
-    // slot 1
-    {
-        TSlotDescriptor t_slot_desc;
-        t_slot_desc.__set_id(1);
-        t_slot_desc.__set_parent(0);
-        t_slot_desc.__set_slotType(TPrimitiveType::INT);
-        t_slot_desc.__set_columnPos(1);
-        t_slot_desc.__set_byteOffset(5);
-        t_slot_desc.__set_nullIndicatorByte(0);
-        t_slot_desc.__set_nullIndicatorBit(2);
-        t_slot_desc.__set_colName("col2");
-        t_slot_desc.__set_slotIdx(1);
-        t_slot_desc.__set_isMaterialized(true);
-
-        slot_descs.push_back(t_slot_desc);
-    }
-    // slot 2
-    {
-        TSlotDescriptor t_slot_desc;
-        t_slot_desc.__set_id(2);
-        t_slot_desc.__set_parent(0);
-        t_slot_desc.__set_slotType(TPrimitiveType::INT);
-        t_slot_desc.__set_columnPos(2);
-        t_slot_desc.__set_byteOffset(9);
-        t_slot_desc.__set_nullIndicatorByte(0);
-        t_slot_desc.__set_nullIndicatorBit(4);
-        t_slot_desc.__set_colName("col3");
-        t_slot_desc.__set_slotIdx(2);
+        t_slot_desc.__set_nullIndicatorBit(i);
+        t_slot_desc.__set_colName(col_names[i]);
+        t_slot_desc.__set_slotIdx(i);
         t_slot_desc.__set_isMaterialized(true);
 
         slot_descs.push_back(t_slot_desc);
@@ -187,7 +205,7 @@ void DppSinkTest::init_desc_tbl() {
         TTupleDescriptor t_tuple_desc;
 
         t_tuple_desc.__set_id(0);
-        t_tuple_desc.__set_byteSize(9);
+        t_tuple_desc.__set_byteSize(13);
         t_tuple_desc.__set_numNullBytes(1);
         t_tuple_desc.__set_tableId(0);
 
@@ -203,7 +221,7 @@ void DppSinkTest::init_desc_tbl() {
 
         t_table_desc.__set_id(0);
         t_table_desc.__set_tableType(TTableType::MYSQL_TABLE);
-        t_table_desc.__set_numCols(2);
+        t_table_desc.__set_numCols(3);
         t_table_desc.__set_numClusteringCols(2);
         t_table_desc.__set_tableName("test_tbl");
         t_table_desc.__set_dbName("test_db");
@@ -218,45 +236,104 @@ void DppSinkTest::init_desc_tbl() {
     DescriptorTbl::create(&_obj_pool, _t_desc_tbl, &_desc_tbl);
 }
 
+void DppSinkTest::add_row(RowBatch* batch, int col1, int col2, int col3) {
+    int idx = batch->add_row();
+    TupleRow* row = batch->get_row(idx);
+    Tuple* tuple = Tuple::create(13, &_tuple_pool);
+    row->set_tuple(0, tuple);
+    if (col1 < 0) {
+        tuple->set_null(slot_desc(0)->null_indicator_offset());
+    } else {
+        *(int*)tuple->get_slot(slot_desc(0)->tuple_offset()) = col1;
+    }
+    *(int*)tuple->get_slot(slot_desc(1)->tuple_offset()) = col2;
+    *(int*)tuple->get_slot(slot_desc(2)->tuple_offset()) = col3;
+    batch->commit_last_row();
+}
+
+void DppSinkTest::run_sink(const std::string& label, int64_t spill_threshold, int num_batches,
+                           std::string* output, int64_t* spilled_runs) {
+    config::etl_sort_spill_threshold_bytes = spill_threshold;
+    _state->set_import_label(label);
+
+    DppSink sink(*_row_desc, _rollups);
+    ASSERT_TRUE(sink.init(_state).ok());
+    TabletDesc desc;
+    desc.partition_id = 1;
+    desc.bucket_id = 0;
+
+    // every batch covers the same keys, a NULL col1 every seventh row, so that
+    // each spilled run holds rows of NULL and non-NULL keys
+    int row_id = 0;
+    for (int i = 0; i < num_batches; ++i) {
+        RowBatch batch(*_row_desc, 100, _state->instance_mem_tracker());
+        for (int j = 0; j < 100; ++j, ++row_id) {
+            int col1 = (row_id % 7 == 0) ? -1 : (row_id * 13) % 50;
+            add_row(&batch, col1, row_id % 3, row_id);
+        }
+        ASSERT_TRUE(sink.add_batch(&_obj_pool, _state, desc, &batch).ok());
+    }
+    ASSERT_TRUE(sink.finish(_state).ok());
+
+    *spilled_runs = 0;
+    std::vector<RuntimeProfile::Counter*> counters;
+    sink.profile()->get_counters("spilled runs", &counters);
+    for (auto counter : counters) {
+        *spilled_runs += counter->value();
+    }
+
+    std::ifstream file((_load_dir + "/" + label + ".1.base.0").c_str(), std::ios::binary);
+    ASSERT_TRUE(file.good());
+    std::stringstream content;
+    content << file.rdbuf();
+    *output = content.str();
+}
+
 TEST_F(DppSinkTest, NoData) {
     DppSink sink(*_row_desc, _rollups);
     ASSERT_TRUE(sink.init(_state).ok());
-    RowBatch batch(*_row_desc, 1024);
+    RowBatch batch(*_row_desc, 1024, _state->instance_mem_tracker());
     TabletDesc desc;
     desc.partition_id = 1;
     desc.bucket_id = 0;
-    ASSERT_TRUE(sink.add_batch(_state, desc, &batch).ok());
+    ASSERT_TRUE(sink.add_batch(&_obj_pool, _state, desc, &batch).ok());
     ASSERT_TRUE(sink.finish(_state).ok());
 }
 
 TEST_F(DppSinkTest, WithData) {
     DppSink sink(*_row_desc, _rollups);
     ASSERT_TRUE(sink.init(_state).ok());
-    RowBatch batch(*_row_desc, 1024);
+    RowBatch batch(*_row_desc, 1024, _state->instance_mem_tracker());
+    add_row(&batch, 1, 10, 100);
     TabletDesc desc;
-    {
-        int idx = batch.add_row();
-        TupleRow* row = batch.get_row(idx);
-        Tuple* tuple = Tuple::create(13, &_tuple_pool);
-        row->set_tuple(0, tuple);
-        char* pos = (char*)tuple;
-        memset(pos, 0, 13);
-        *(int*)(pos + 1) = 1;
-        *(int*)(pos + 5) = 10;
-        *(int*)(pos + 9) = 100;
-        batch.commit_last_row();
-    }
     desc.partition_id = 1;
     desc.bucket_id = 1;
-    ASSERT_TRUE(sink.add_batch(_state, desc, &batch).ok());
+    ASSERT_TRUE(sink.add_batch(&_obj_pool, _state, desc, &batch).ok());
     // Add two time
-    ASSERT_TRUE(sink.add_batch(_state, desc, &batch).ok());
+    ASSERT_TRUE(sink.add_batch(&_obj_pool, _state, desc, &batch).ok());
     desc.partition_id = 1;
     desc.bucket_id = 1;
-    ASSERT_TRUE(sink.add_batch(_state, desc, &batch).ok());
+    ASSERT_TRUE(sink.add_batch(&_obj_pool, _state, desc, &batch).ok());
     ASSERT_TRUE(sink.finish(_state).ok());
 }
 
+// Rows merged from spilled runs have to come out in the order the sorter returns
+// them, NULL keys first, otherwise rows of the same key are not aggregated together.
+TEST_F(DppSinkTest, SpillWithNullKeys) {
+    std::string in_memory_output;
+    int64_t spilled_runs = 0;
+    run_sink("in_memory", 1L << 40, 20, &in_memory_output, &spilled_runs);
+    ASSERT_EQ(0, spilled_runs);
+    ASSERT_FALSE(in_memory_output.empty());
+
+    // spill every batch as a sorted run
+    std::string spilled_output;
+    run_sink("spilled", 1, 20, &spilled_output, &spilled_runs);
+    ASSERT_LT(0, spilled_runs);
+
+    ASSERT_EQ(in_memory_output, spilled_output);
+}
+
 }
 
 int main(int argc, char** argv) {
@@ -266,6 +343,7 @@ int main(int argc, char** argv) {
         return -1;
     }
     palo::CpuInfo::init();
+    palo::DiskInfo::init();
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
@@ -0,0 +1,105 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/runtime_filter_mgr.h"
+
+#include <boost/thread/thread.hpp>
+#include <gtest/gtest.h>
+
+#include "util/logging.h"
+
+namespace palo {
+
+class RuntimeFilterMgrTest : public testing::Test {
+public:
+    RuntimeFilterMgrTest() : _mgr(NULL) {
+        _instance_id.hi = 1;
+        _instance_id.lo = 2;
+    }
+
+protected:
+    static TRuntimeFilter make_filter(const std::string& value) {
+        TRuntimeFilter filter;
+        filter.__set_min_value(value);
+        filter.__set_max_value(value);
+        return filter;
+    }
+
+    static boost::system_time deadline_after(int ms) {
+        return boost::get_system_time() + boost::posix_time::milliseconds(ms);
+    }
+
+    RuntimeFilterMgr _mgr;
+    TUniqueId _instance_id;
+};
+
+TEST_F(RuntimeFilterMgrTest, WaitForAllProducers) {
+    _mgr.register_filter(_instance_id, 0, 2);
+    _mgr.publish(_instance_id, 0, make_filter("a"));
+    std::vector<TRuntimeFilter> filters;
+    ASSERT_FALSE(_mgr.wait_for(_instance_id, 0, deadline_after(10), &filters));
+
+    boost::thread producer([this] {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+        _mgr.publish(_instance_id, 0, make_filter("b"));
+    });
+    ASSERT_TRUE(_mgr.wait_for(_instance_id, 0, deadline_after(10000), &filters));
+    producer.join();
+    ASSERT_EQ(2, filters.size());
+    ASSERT_EQ("a", filters[0].min_value);
+    ASSERT_EQ("b", filters[1].min_value);
+    _mgr.unregister_filter(_instance_id, 0);
+}
+
+TEST_F(RuntimeFilterMgrTest, PublishedBeforeRegistered) {
+    // the join fragment may be faster than the scan fragment
+    _mgr.publish(_instance_id, 1, make_filter("a"));
+    std::vector<TRuntimeFilter> filters;
+    ASSERT_FALSE(_mgr.wait_for(_instance_id, 1, deadline_after(10), &filters));
+
+    _mgr.register_filter(_instance_id, 1, 1);
+    ASSERT_TRUE(_mgr.wait_for(_instance_id, 1, deadline_after(10), &filters));
+    ASSERT_EQ(1, filters.size());
+
+    // other instances and filters are separate
+    TUniqueId other_id;
+    other_id.hi = 1;
+    other_id.lo = 3;
+    _mgr.register_filter(other_id, 1, 1);
+    _mgr.register_filter(_instance_id, 2, 1);
+    ASSERT_FALSE(_mgr.wait_for(other_id, 1, deadline_after(10), &filters));
+    ASSERT_FALSE(_mgr.wait_for(_instance_id, 2, deadline_after(10), &filters));
+}
+
+TEST_F(RuntimeFilterMgrTest, PublishedAfterUnregistered) {
+    _mgr.register_filter(_instance_id, 0, 1);
+    _mgr.unregister_filter(_instance_id, 0);
+    _mgr.publish(_instance_id, 0, make_filter("a"));
+    std::vector<TRuntimeFilter> filters;
+    ASSERT_FALSE(_mgr.wait_for(_instance_id, 0, deadline_after(10), &filters));
+    ASSERT_TRUE(_mgr._states.begin()->second.filters.empty());
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
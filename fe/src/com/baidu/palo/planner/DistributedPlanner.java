@@ -26,6 +26,8 @@ import com.baidu.palo.analysis.Expr;
 import com.baidu.palo.analysis.InsertStmt;
 import com.baidu.palo.analysis.JoinOperator;
 import com.baidu.palo.analysis.QueryStmt;
+import com.baidu.palo.analysis.SlotRef;
+import com.baidu.palo.analysis.TupleId;
 import com.baidu.palo.catalog.Table;
 import com.baidu.palo.common.AnalysisException;
 import com.baidu.palo.common.InternalException;
@@ -48,6 +50,8 @@ public class DistributedPlanner {
     private final static Logger LOG = LogManager.getLogger(DistributedPlanner.class);
 
     private final PlannerContext ctx_;
+    // id of the next runtime filter of a partitioned join, unique in the query
+    private int nextRuntimeFilterId_ = 0;
 
     public DistributedPlanner(PlannerContext ctx) {
         ctx_ = ctx;
@@ -389,10 +393,67 @@ public class DistributedPlanner {
             rightChildFragment.setDestination(rhsExchange);
             rightChildFragment.setOutputPartition(rhsJoinPartition);
 
+            assignRuntimeFilters(node, leftChildFragment);
             return joinFragment;
         }
     }
 
+    /**
+     * Lets the partitioned join 'node' send the values of its build side to the olap
+     * scan nodes of 'leftChildFragment', which skip the probe rows that cannot match.
+     * This is only done for the join ops which drop unmatched probe rows, and for the
+     * eq join conjuncts whose lhs is a slot of such a scan node. Between the join and
+     * the scan node there may only be hash joins and selects without limit, which keep
+     * or drop the rows of the scan node independently of each other.
+     */
+    private void assignRuntimeFilters(HashJoinNode node, PlanFragment leftChildFragment) {
+        JoinOperator joinOp = node.getJoinOp();
+        if (joinOp != JoinOperator.INNER_JOIN && joinOp != JoinOperator.LEFT_SEMI_JOIN
+                && joinOp != JoinOperator.RIGHT_OUTER_JOIN
+                && joinOp != JoinOperator.RIGHT_SEMI_JOIN) {
+            return;
+        }
+        List<Pair<Expr, Expr>> eqJoinConjuncts = node.getEqJoinConjuncts();
+        for (int i = 0; i < eqJoinConjuncts.size(); ++i) {
+            Expr lhs = eqJoinConjuncts.get(i).first;
+            if (!(lhs instanceof SlotRef) || ((SlotRef) lhs).getDesc() == null) {
+                continue;
+            }
+            TupleId tupleId = ((SlotRef) lhs).getDesc().getParent().getId();
+            OlapScanNode scanNode = findRuntimeFilterTarget(leftChildFragment.getPlanRoot(), tupleId);
+            if (scanNode == null) {
+                continue;
+            }
+            int filterId = nextRuntimeFilterId_++;
+            node.addRuntimeFilter(filterId, i);
+            scanNode.addRuntimeFilterTarget(filterId, lhs.clone(null));
+        }
+    }
+
+    private OlapScanNode findRuntimeFilterTarget(PlanNode root, TupleId tupleId) {
+        if (root.hasLimit() || !root.getTupleIds().contains(tupleId)) {
+            return null;
+        }
+        if (root instanceof OlapScanNode) {
+            return (OlapScanNode) root;
+        }
+        if (root instanceof HashJoinNode) {
+            // removing rows of the anti side would add rows to the output
+            if (((HashJoinNode) root).getJoinOp().isAntiJoin()) {
+                return null;
+            }
+        } else if (!(root instanceof SelectNode)) {
+            return null;
+        }
+        for (PlanNode child : root.getChildren()) {
+            OlapScanNode scanNode = findRuntimeFilterTarget(child, tupleId);
+            if (scanNode != null) {
+                return scanNode;
+            }
+        }
+        return null;
+    }
+
     /**
      * Modifies the leftChildFragment to execute a cross join. The right child input is provided by an ExchangeNode,
      * which is the destination of the rightChildFragment's output.
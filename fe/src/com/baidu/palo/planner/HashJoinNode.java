@@ -37,13 +37,16 @@ import com.baidu.palo.thrift.TExplainLevel;
 import com.baidu.palo.thrift.THashJoinNode;
 import com.baidu.palo.thrift.TPlanNode;
 import com.baidu.palo.thrift.TPlanNodeType;
+import com.baidu.palo.thrift.TRuntimeFilterDesc;
 import com.google.common.base.Objects;
 import com.google.common.base.Preconditions;
 import com.google.common.collect.Lists;
+import com.google.common.collect.Maps;
 import org.apache.logging.log4j.Logger;
 import org.apache.logging.log4j.LogManager;
 
 import java.util.List;
+import java.util.Map;
 
 /**
  * Hash join between left child and right child.
@@ -61,6 +64,9 @@ public class HashJoinNode extends PlanNode {
     private  List<Expr> otherJoinConjuncts;
     private boolean isPushDown;
     private DistributionMode distrMode;
+    // runtime filters built from the build side of a partitioned join and sent to the
+    // scan nodes of the probe side, filter id -> index of the eq join conjunct
+    private Map<Integer, Integer> runtimeFilters = Maps.newTreeMap();
 
     public HashJoinNode(PlanNodeId id, PlanNode outer, PlanNode inner, TableRef innerRef,
                         List<Pair<Expr, Expr>> eqJoinConjuncts, List<Expr> otherJoinConjuncts) {
@@ -244,6 +250,14 @@ public class HashJoinNode extends PlanNode {
         this.isPushDown = isPushDown;
     }
 
+    public void addRuntimeFilter(int filterId, int eqJoinConjunctIdx) {
+        runtimeFilters.put(filterId, eqJoinConjunctIdx);
+    }
+
+    public List<Integer> getRuntimeFilterIds() {
+        return Lists.newArrayList(runtimeFilters.keySet());
+    }
+
     @Override
     protected void toThrift(TPlanNode msg) {
         msg.node_type = TPlanNodeType.HASH_JOIN_NODE;
@@ -258,6 +272,10 @@ public class HashJoinNode extends PlanNode {
             msg.hash_join_node.addToOther_join_conjuncts(e.treeToThrift());
         }
         msg.hash_join_node.setIs_push_down(isPushDown);
+        for (Map.Entry<Integer, Integer> entry : runtimeFilters.entrySet()) {
+            msg.hash_join_node.addToRuntime_filters(
+              new TRuntimeFilterDesc(entry.getKey(), entry.getValue()));
+        }
     }
 
     @Override
@@ -272,6 +290,13 @@ public class HashJoinNode extends PlanNode {
             output.append(detailPrefix + "  " +
               entry.first.toSql() + " = " + entry.second.toSql() + "\n");
         }
+        if (!runtimeFilters.isEmpty()) {
+            output.append(detailPrefix + "runtime filters:\n");
+            for (Map.Entry<Integer, Integer> entry : runtimeFilters.entrySet()) {
+                output.append(detailPrefix + "  RF" + entry.getKey() + " <- "
+                  + eqJoinConjuncts.get(entry.getValue()).second.toSql() + "\n");
+            }
+        }
         if (!otherJoinConjuncts.isEmpty()) {
             output.append(detailPrefix + "other join predicates: ").append(
               getExplainString(otherJoinConjuncts) + "\n");
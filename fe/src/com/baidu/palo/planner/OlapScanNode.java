@@ -50,6 +50,7 @@ import com.baidu.palo.thrift.TPaloScanRange;
 import com.baidu.palo.thrift.TPlanNode;
 import com.baidu.palo.thrift.TPlanNodeType;
 import com.baidu.palo.thrift.TPrimitiveType;
+import com.baidu.palo.thrift.TRuntimeFilterTargetDesc;
 import com.baidu.palo.thrift.TScanRange;
 import com.baidu.palo.thrift.TScanRangeLocation;
 import com.baidu.palo.thrift.TScanRangeLocations;
@@ -90,6 +91,9 @@ public class OlapScanNode extends ScanNode {
     private long totalTabletsNum = 0;
     private long selectedIndexId = -1;
     private int selectedPartitionNum = 0;
+    // runtime filters of the partitioned joins above, filter id -> expr of the tuple of
+    // this node which the filter is applied to
+    private Map<Integer, Expr> runtimeFilterTargets = Maps.newTreeMap();
 
     boolean isFinalized = false;
 
@@ -118,6 +122,14 @@ public class OlapScanNode extends ScanNode {
         this.canTurnOnPreAggr = canChangePreAggr;
     }
 
+    public void addRuntimeFilterTarget(int filterId, Expr targetExpr) {
+        runtimeFilterTargets.put(filterId, targetExpr);
+    }
+
+    public List<Integer> getRuntimeFilterIds() {
+        return Lists.newArrayList(runtimeFilterTargets.keySet());
+    }
+
     @Override
     protected String debugString() {
         ToStringHelper helper = Objects.toStringHelper(this);
@@ -558,6 +570,14 @@ public class OlapScanNode extends ScanNode {
             output.append(prefix).append("PREDICATES: ").append(
                     getExplainString(conjuncts)).append("\n");
         }
+        if (!runtimeFilterTargets.isEmpty()) {
+            output.append(prefix).append("RUNTIME FILTERS:");
+            for (Map.Entry<Integer, Expr> entry : runtimeFilterTargets.entrySet()) {
+                output.append(" RF").append(entry.getKey()).append(" -> ")
+                        .append(entry.getValue().toSql());
+            }
+            output.append("\n");
+        }
 
         output.append(prefix).append(String.format(
                     "partitions=%s/%s",
@@ -601,6 +621,10 @@ public class OlapScanNode extends ScanNode {
         if (null != sortColumn) {
             msg.olap_scan_node.setSort_column(sortColumn);
         }
+        for (Map.Entry<Integer, Expr> entry : runtimeFilterTargets.entrySet()) {
+            msg.olap_scan_node.addToRuntime_filters(
+                    new TRuntimeFilterTargetDesc(entry.getKey(), entry.getValue().treeToThrift()));
+        }
     }
 
     // export some tablets
@@ -31,6 +31,9 @@ import com.baidu.palo.common.util.DebugUtil;
 import com.baidu.palo.common.util.RuntimeProfile;
 import com.baidu.palo.planner.DataPartition;
 import com.baidu.palo.planner.DataSink;
+import com.baidu.palo.planner.ExchangeNode;
+import com.baidu.palo.planner.HashJoinNode;
+import com.baidu.palo.planner.OlapScanNode;
 import com.baidu.palo.planner.PlanFragment;
 import com.baidu.palo.planner.PlanFragmentId;
 import com.baidu.palo.planner.PlanNode;
@@ -703,6 +706,61 @@ public class Coordinator {
                 params.destinations.add(dest);
             }
         }
+
+        computeRuntimeFilterParams();
+    }
+
+    // Lets each instance of a partitioned join publishing a runtime filter send it to
+    // all the instances of the fragment applying it, which wait for as many filters as
+    // there are join instances.
+    private void computeRuntimeFilterParams() {
+        Map<Integer, FragmentExecParams> producerParams = Maps.newHashMap();
+        Map<Integer, FragmentExecParams> targetParams = Maps.newHashMap();
+        for (FragmentExecParams params : fragmentExecParams.values()) {
+            List<PlanNode> nodes = Lists.newArrayList();
+            collectFragmentNodes(params.fragment.getPlanRoot(), nodes);
+            for (PlanNode node : nodes) {
+                if (node instanceof HashJoinNode) {
+                    for (Integer filterId : ((HashJoinNode) node).getRuntimeFilterIds()) {
+                        producerParams.put(filterId, params);
+                    }
+                } else if (node instanceof OlapScanNode) {
+                    for (Integer filterId : ((OlapScanNode) node).getRuntimeFilterIds()) {
+                        targetParams.put(filterId, params);
+                    }
+                }
+            }
+        }
+
+        for (Map.Entry<Integer, FragmentExecParams> entry : producerParams.entrySet()) {
+            FragmentExecParams producers = entry.getValue();
+            FragmentExecParams targets = targetParams.get(entry.getKey());
+            if (targets == null) {
+                continue;
+            }
+            // filters are published by BackendService, not by the data stream port
+            List<TPlanFragmentDestination> destinations = Lists.newArrayList();
+            for (int j = 0; j < targets.hosts.size(); ++j) {
+                TPlanFragmentDestination dest = new TPlanFragmentDestination();
+                dest.fragment_instance_id = targets.instanceIds.get(j);
+                dest.server = targets.hosts.get(j);
+                destinations.add(dest);
+            }
+            producers.runtimeFilterDestinations.put(entry.getKey(), destinations);
+            targets.runtimeFilterNumProducers.put(entry.getKey(), producers.hosts.size());
+        }
+    }
+
+    // Adds the nodes of the fragment rooted at 'node' to 'nodes', without those of the
+    // fragments sending to its exchange nodes.
+    private void collectFragmentNodes(PlanNode node, List<PlanNode> nodes) {
+        nodes.add(node);
+        if (node instanceof ExchangeNode) {
+            return;
+        }
+        for (PlanNode child : node.getChildren()) {
+            collectFragmentNodes(child, nodes);
+        }
     }
 
     private TNetworkAddress toRpcHost(TNetworkAddress host) throws Exception {
@@ -1117,6 +1175,10 @@ public class Coordinator {
         public List<TUniqueId>                instanceIds       = Lists.newArrayList();
         public List<TPlanFragmentDestination> destinations      = Lists.newArrayList();
         public Map<Integer, Integer>          perExchNumSenders = Maps.newHashMap();
+        // by runtime filter id
+        public Map<Integer, List<TPlanFragmentDestination>> runtimeFilterDestinations =
+                Maps.newHashMap();
+        public Map<Integer, Integer>          runtimeFilterNumProducers = Maps.newHashMap();
 
         public FragmentExecParams(PlanFragment fragment) {
             this.fragment = fragment;
@@ -1145,6 +1207,12 @@ public class Coordinator {
                 params.params.setPer_exch_num_senders(perExchNumSenders);
                 params.params.setDestinations(destinations);
                 params.params.setSender_id(i);
+                if (!runtimeFilterDestinations.isEmpty()) {
+                    params.params.setRuntime_filter_destinations(runtimeFilterDestinations);
+                }
+                if (!runtimeFilterNumProducers.isEmpty()) {
+                    params.params.setRuntime_filter_num_producers(runtimeFilterNumProducers);
+                }
                 params.setCoord(coordAddress);
                 params.setBackend_num(backendNum++);
                 params.setQuery_globals(queryGlobals);
@@ -60,6 +60,7 @@ public class SessionVariable implements Serializable, Writable {
     public static final String SQL_SAFE_UPDATES = "sql_safe_updates";
     public static final String NET_BUFFER_LENGTH = "net_buffer_length";
     public static final String CODEGEN_LEVEL = "codegen_level";
+    public static final String USE_PAGE_CACHE = "use_page_cache";
     
     // max memory used on every backend.
     @VariableMgr.VarAttr(name = EXEC_MEM_LIMIT)
@@ -68,6 +69,10 @@ public class SessionVariable implements Serializable, Writable {
     @VariableMgr.VarAttr(name = "enable_spilling")
     public boolean enableSpilling = false;
 
+    // if false, the query does not use the page cache of decompressed column data on backends
+    @VariableMgr.VarAttr(name = USE_PAGE_CACHE)
+    public boolean usePageCache = true;
+
     // query timeout in second.
     @VariableMgr.VarAttr(name = QUERY_TIMEOUT)
     private int queryTimeoutS = 300;
@@ -373,6 +378,7 @@ public class SessionVariable implements Serializable, Writable {
         tResult.setQuery_timeout(queryTimeoutS);
         tResult.setIs_report_success(isReportSucc);
         tResult.setCodegen_level(codegenLevel);
+        tResult.setUse_page_cache(usePageCache);
         return tResult;
     }
 
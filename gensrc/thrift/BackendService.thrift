@@ -72,6 +72,11 @@ service BackendService {
     PaloInternalService.TTransmitDataResult transmit_data(
         1:PaloInternalService.TTransmitDataParams params);
 
+    // Called by a hash join instance to publish its runtime filter to an instance
+    // scanning the probe side. Filters which arrive after the scan started are dropped.
+    PaloInternalService.TPublishRuntimeFilterResult publish_runtime_filter(
+        1:PaloInternalService.TPublishRuntimeFilterParams params);
+
     // Coordinator Fetch Data From Root fragment
     PaloInternalService.TFetchDataResult fetch_data(
         1:PaloInternalService.TFetchDataParams params);
@@ -50,6 +50,9 @@ enum TExprNodeType {
   // TODO: old style compute functions. this will be deprecated
   COMPUTE_FUNCTION_CALL,
   LARGE_INT_LITERAL,
+
+  // only created and used in backend, see RuntimeFilterPredicate
+  RUNTIME_FILTER_PRED,
 }
 
 //enum TAggregationOp {
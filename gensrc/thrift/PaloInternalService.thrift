@@ -88,6 +88,8 @@ struct TQueryOptions {
   // INT64::MAX
   17: optional i64 kudu_latest_observed_ts = 9223372036854775807
   18: optional TQueryType query_type = TQueryType.SELECT
+  // if false, the query neither reads from nor fills the page cache of decompressed column data
+  19: optional bool use_page_cache = 1
 }
 
 // A scan range plus the parameters needed to execute that scan.
@@ -135,6 +137,14 @@ struct TPlanFragmentExecParams {
 
   // Id of this fragment in its role as a sender.
   9: optional i32 sender_id
+
+  // Instances which apply the runtime filters built by the hash joins of this
+  // fragment, by filter id. The server is the BackendService address.
+  10: optional map<i32, list<TPlanFragmentDestination>> runtime_filter_destinations
+
+  // Number of hash join instances publishing each runtime filter applied by the
+  // scan nodes of this fragment, by filter id.
+  11: optional map<i32, i32> runtime_filter_num_producers
 }
 
 // Global query parameters assigned by the coordinator.
@@ -251,6 +261,31 @@ struct TTransmitDataResult {
   4: optional Types.TPlanNodeId dest_node_id
 }
 
+// PublishRuntimeFilter
+
+// The runtime filter built by one hash join instance. Values are in the memory
+// layout of the filtered type.
+struct TRuntimeFilter {
+  // Not set if the build side of the instance was empty.
+  1: optional binary min_value
+  2: optional binary max_value
+
+  // Not set if only min and max are checked.
+  3: optional binary bloom_filter_bits
+  4: optional i32 bloom_filter_hash_functions
+}
+
+struct TPublishRuntimeFilterParams {
+  1: required PaloInternalServiceVersion protocol_version
+  2: required Types.TUniqueId dest_fragment_instance_id
+  3: required i32 filter_id
+  4: required TRuntimeFilter filter
+}
+
+struct TPublishRuntimeFilterResult {
+  1: optional Status.TStatus status
+}
+
 struct TFetchDataParams {
   1: required PaloInternalServiceVersion protocol_version
   // required in V1
@@ -215,12 +215,30 @@ struct TMetaScanNode {
   5: optional string user
 }
 
+// A filter on the probe side of a partitioned hash join, built by each instance of
+// the join from the build values of eq_join_conjuncts[expr_order] and published to
+// the instances of the fragment which scans the probe side.
+struct TRuntimeFilterDesc {
+  1: required i32 filter_id
+  2: required i32 expr_order
+}
+
+// The scan node side of a TRuntimeFilterDesc with the same filter_id.
+struct TRuntimeFilterTargetDesc {
+  1: required i32 filter_id
+  // The left side of the eq join conjunct, a slot of the scanned tuple.
+  2: required Exprs.TExpr target_expr
+}
+
 struct TOlapScanNode {
   1: required Types.TTupleId tuple_id
   2: required list<string> key_column_name
   3: required list<Types.TPrimitiveType> key_column_type
   4: required bool is_preaggregation
   5: optional string sort_column
+  // Runtime filters published by the hash joins of other fragments, applied to
+  // the scanned rows.
+  6: optional list<TRuntimeFilterTargetDesc> runtime_filters
 }
 struct TEqJoinCondition {
   // left-hand side of "<a> = <b>"
@@ -263,6 +281,10 @@ struct THashJoinNode {
   // If true, this join node can (but may choose not to) generate slot filters
   // after constructing the build side that can be applied to the probe side.
   5: optional bool add_probe_filters
+
+  // Filters to publish to the scan nodes of the probe side fragment once the
+  // build side is done.
+  6: optional list<TRuntimeFilterDesc> runtime_filters
 }
 
 struct TMergeJoinNode {